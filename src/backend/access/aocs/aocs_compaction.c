@@ -28,6 +28,7 @@
 #include "commands/vacuum.h"
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
+#include "optimizer/var.h"
 #include "storage/lmgr.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -275,50 +276,32 @@ AOCSMoveTuple(TupleTableSlot *slot,
 }
 
 /*
- * Assumes that the segment file lock is already held.
- * Assumes that the segment file should be compacted.
+ * Moves the visible tuples of segment file 'fsinfo' one by one, and returns
+ * the number of tuples moved.
  */
-static bool
-AOCSSegmentFileFullCompaction(Relation aorel,
-							  AOCSInsertDesc insertDesc,
-							  AOCSFileSegInfo *fsinfo)
+static int64
+AOCSSegmentFileMoveTuples(Relation aorel,
+						  AOCSInsertDesc insertDesc,
+						  AOCSFileSegInfo *fsinfo,
+						  ResultRelInfo *resultRelInfo,
+						  EState *estate)
 {
-	const char *relname;
-	AppendOnlyVisimap visiMap;
 	AOCSScanDesc scanDesc;
 	TupleDesc	tupDesc;
 	TupleTableSlot *slot;
-	int			compact_segno;
-	int64		movedTupleCount = 0;
-	ResultRelInfo *resultRelInfo;
 	MemTupleBinding *mt_bind;
-	EState	   *estate;
+	int			compact_segno = fsinfo->segno;
+	int64		movedTupleCount = 0;
 	bool	   *proj;
 	int			i;
 	AOTupleId  *aoTupleId;
 	int64		tupleCount = 0;
 	int64		tuplePerPage = INT_MAX;
 
-	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
-	Assert(RelationIsAoCols(aorel));
-	Assert(insertDesc);
-
-	compact_segno = fsinfo->segno;
 	if (fsinfo->varblockcount > 0)
 	{
 		tuplePerPage = fsinfo->total_tupcount / fsinfo->varblockcount;
 	}
-	relname = RelationGetRelationName(aorel);
-
-	AppendOnlyVisimap_Init(&visiMap,
-						   aorel->rd_appendonly->visimaprelid,
-						   aorel->rd_appendonly->visimapidxid,
-						   ShareLock,
-						   SnapshotNow);
-
-	elogif(Debug_appendonly_print_compaction,
-		   LOG, "Compact AO segfile %d, relation %sd",
-		   compact_segno, relname);
 
 	proj = palloc0(sizeof(bool) * RelationGetNumberOfAttributes(aorel));
 	for (i = 0; i < RelationGetNumberOfAttributes(aorel); ++i)
@@ -333,20 +316,6 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	slot = MakeSingleTupleTableSlot(tupDesc);
 	mt_bind = create_memtuple_binding(tupDesc);
 
-	/*
-	 * We need a ResultRelInfo and an EState so we can use the regular
-	 * executor's index-entry-making machinery.
-	 */
-	estate = CreateExecutorState();
-	resultRelInfo = makeNode(ResultRelInfo);
-	resultRelInfo->ri_RangeTableIndex = 1;	/* dummy */
-	resultRelInfo->ri_RelationDesc = aorel;
-	resultRelInfo->ri_TrigDesc = NULL;	/* we don't fire triggers */
-	ExecOpenIndices(resultRelInfo);
-	estate->es_result_relations = resultRelInfo;
-	estate->es_num_result_relations = 1;
-	estate->es_result_relation_info = resultRelInfo;
-
 	aocs_getnext(scanDesc, ForwardScanDirection, slot);
 	while (!TupIsNull(slot))
 	{
@@ -386,6 +355,184 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 
 	}
 
+	ExecDropSingleTupleTableSlot(slot);
+	destroy_memtuple_binding(mt_bind);
+
+	aocs_endscan(scanDesc);
+	pfree(proj);
+
+	return movedTupleCount;
+}
+
+/*
+ * Inserts the index entries of the rows that aocs_insert_segfile moved from
+ * segment file 'fsinfo' to the insert segment file.
+ *
+ * The moved rows keep their order, and got consecutive row numbers starting
+ * with 'firstRowNum', so the visible rows are read again from the old segment
+ * file, which stays in place until it is dropped. Only the columns the indexes
+ * need are read.
+ */
+static void
+AOCSInsertMovedIndexTuples(Relation aorel,
+						   AOCSFileSegInfo *fsinfo,
+						   int insertSegno,
+						   int64 firstRowNum,
+						   int64 rowCount,
+						   ResultRelInfo *resultRelInfo,
+						   EState *estate)
+{
+	int			natts = RelationGetNumberOfAttributes(aorel);
+	Bitmapset  *attrs = NULL;
+	bool	   *proj;
+	bool		wholeRow;
+	bool		anyProj = false;
+	int			compact_segno = fsinfo->segno;
+	AOCSScanDesc scanDesc;
+	TupleTableSlot *slot;
+	int64		rowNum = firstRowNum;
+	int			i;
+	int			j;
+
+	/* Collect the columns referenced by the indexes */
+	for (i = 0; i < resultRelInfo->ri_NumIndices; i++)
+	{
+		IndexInfo  *ii = resultRelInfo->ri_IndexRelationInfo[i];
+
+		for (j = 0; j < ii->ii_NumIndexAttrs; j++)
+		{
+			/* zero means an expression, covered by ii_Expressions below */
+			if (ii->ii_KeyAttrNumbers[j] > 0)
+				attrs = bms_add_member(attrs, ii->ii_KeyAttrNumbers[j] -
+									   FirstLowInvalidHeapAttributeNumber);
+		}
+		pull_varattnos((Node *) ii->ii_Expressions, 1, &attrs);
+		pull_varattnos((Node *) ii->ii_Predicate, 1, &attrs);
+	}
+	wholeRow = bms_is_member(InvalidAttrNumber - FirstLowInvalidHeapAttributeNumber,
+							 attrs);
+
+	proj = palloc0(sizeof(bool) * natts);
+	for (i = 0; i < natts; i++)
+	{
+		proj[i] = wholeRow ||
+			bms_is_member(i + 1 - FirstLowInvalidHeapAttributeNumber, attrs);
+		anyProj |= proj[i];
+	}
+	/* the scan needs at least one column to count rows */
+	if (!anyProj)
+		proj[0] = true;
+
+	scanDesc = aocs_beginrangescan(aorel,
+								   SnapshotNow, SnapshotNow,
+								   &compact_segno, 1, NULL, proj);
+	slot = MakeSingleTupleTableSlot(RelationGetDescr(aorel));
+
+	aocs_getnext(scanDesc, ForwardScanDirection, slot);
+	while (!TupIsNull(slot))
+	{
+		AOTupleId	newAoTupleId;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (AppendOnlyVisimap_IsVisible(&scanDesc->visibilityMap,
+										(AOTupleId *) slot_get_ctid(slot)))
+		{
+			if (rowNum >= firstRowNum + rowCount)
+				elog(ERROR, "segment file %d of relation \"%s\" has more visible rows than were moved (" INT64_FORMAT ")",
+					 compact_segno, RelationGetRelationName(aorel), rowCount);
+
+			AOTupleIdInit_Init(&newAoTupleId);
+			AOTupleIdInit_segmentFileNum(&newAoTupleId, insertSegno);
+			AOTupleIdInit_rowNum(&newAoTupleId, rowNum);
+			rowNum++;
+
+			ExecInsertIndexTuples(slot, (ItemPointer) &newAoTupleId, estate);
+			ResetPerTupleExprContext(estate);
+		}
+
+		aocs_getnext(scanDesc, ForwardScanDirection, slot);
+	}
+
+	if (rowNum != firstRowNum + rowCount)
+		elog(ERROR, "segment file %d of relation \"%s\" has " INT64_FORMAT " visible rows, but " INT64_FORMAT " were moved",
+			 compact_segno, RelationGetRelationName(aorel),
+			 rowNum - firstRowNum, rowCount);
+
+	ExecDropSingleTupleTableSlot(slot);
+	aocs_endscan(scanDesc);
+	pfree(proj);
+	bms_free(attrs);
+}
+
+/*
+ * Assumes that the segment file lock is already held.
+ * Assumes that the segment file should be compacted.
+ */
+static bool
+AOCSSegmentFileFullCompaction(Relation aorel,
+							  AOCSInsertDesc insertDesc,
+							  AOCSFileSegInfo *fsinfo)
+{
+	const char *relname;
+	AppendOnlyVisimap visiMap;
+	int			compact_segno;
+	int64		movedTupleCount;
+	ResultRelInfo *resultRelInfo;
+	EState	   *estate;
+
+	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
+	Assert(RelationIsAoCols(aorel));
+	Assert(insertDesc);
+
+	compact_segno = fsinfo->segno;
+	relname = RelationGetRelationName(aorel);
+
+	AppendOnlyVisimap_Init(&visiMap,
+						   aorel->rd_appendonly->visimaprelid,
+						   aorel->rd_appendonly->visimapidxid,
+						   ShareLock,
+						   SnapshotNow);
+
+	elogif(Debug_appendonly_print_compaction,
+		   LOG, "Compact AO segfile %d, relation %sd",
+		   compact_segno, relname);
+
+	/*
+	 * We need a ResultRelInfo and an EState so we can use the regular
+	 * executor's index-entry-making machinery.
+	 */
+	estate = CreateExecutorState();
+	resultRelInfo = makeNode(ResultRelInfo);
+	resultRelInfo->ri_RangeTableIndex = 1;	/* dummy */
+	resultRelInfo->ri_RelationDesc = aorel;
+	resultRelInfo->ri_TrigDesc = NULL;	/* we don't fire triggers */
+	ExecOpenIndices(resultRelInfo);
+	estate->es_result_relations = resultRelInfo;
+	estate->es_num_result_relations = 1;
+	estate->es_result_relation_info = resultRelInfo;
+
+	/*
+	 * Move the segment file block by block if we can, copying the blocks
+	 * without deleted rows as they are. Datums of older format versions may
+	 * have to be converted, so those segment files take the tuple path.
+	 */
+	if (gp_appendonly_compaction_reuse_blocks &&
+		fsinfo->formatversion == AORelationVersion_GetLatest())
+	{
+		int64		firstRowNum = insertDesc->lastSequence + 1;
+
+		movedTupleCount = aocs_insert_segfile(insertDesc, fsinfo, &visiMap);
+
+		if (resultRelInfo->ri_NumIndices > 0 && movedTupleCount > 0)
+			AOCSInsertMovedIndexTuples(aorel, fsinfo, insertDesc->cur_segno,
+									   firstRowNum, movedTupleCount,
+									   resultRelInfo, estate);
+	}
+	else
+		movedTupleCount = AOCSSegmentFileMoveTuples(aorel, insertDesc, fsinfo,
+													resultRelInfo, estate);
+
 	SetAOCSFileSegInfoState(aorel, compact_segno,
 							AOSEG_STATE_AWAITING_DROP);
 
@@ -411,12 +558,6 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	ExecCloseIndices(resultRelInfo);
 	FreeExecutorState(estate);
 
-	ExecDropSingleTupleTableSlot(slot);
-	destroy_memtuple_binding(mt_bind);
-
-	aocs_endscan(scanDesc);
-	pfree(proj);
-
 	return true;
 }
 
@@ -31,9 +31,11 @@
 #include "catalog/namespace.h"
 #include "catalog/pg_appendonly_fn.h"
 #include "catalog/pg_attribute_encoding.h"
+#include "commands/vacuum.h"
 #include "cdb/cdbaocsam.h"
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbappendonlyblockdirectory.h"
+#include "cdb/cdbappendonlydecompress.h"
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbappendonlystorageread.h"
 #include "cdb/cdbappendonlystoragewrite.h"
@@ -267,6 +269,8 @@ aocs_initscan(AOCSScanDesc scan)
 	ItemPointerSet(&scan->cdb_fake_ctid, 0, 0);
 	scan->cur_seg_row = 0;
 
+	scan->visimapBlockSegno = -1;
+
 	open_ds_read(scan->aos_rel, scan->ds, scan->relationTupleDesc,
 				 scan->proj_atts, scan->num_proj_atts,
 				 scan->aos_rel->rd_appendonly->checksum);
@@ -377,6 +381,117 @@ close_cur_scan_seg(AOCSScanDesc scan)
 		AppendOnlyBlockDirectory_End_forInsert(scan->blockDirectory);
 }
 
+/*
+ * Decide whether the scan decompresses blocks on helper threads. Only
+ * projected columns whose compression has a thread-safe decompressor count.
+ */
+static void
+aocs_init_decompress_threads(AOCSScanDesc scan)
+{
+	int			ncompressed = 0;
+	int			i;
+
+	scan->decompressThreads = 0;
+
+	if (gp_aocs_decompress_threads <= 0)
+		return;
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		DatumStreamRead *ds = scan->ds[scan->proj_atts[i]];
+
+		if (ds->ao_read.compressionState != NULL &&
+			ds->ao_read.compressionState->threadsafe_decompress != NULL)
+			ncompressed++;
+	}
+
+	scan->decompressThreads =
+		AppendOnlyDecompress_NumThreads(gp_aocs_decompress_threads, ncompressed);
+	if (scan->decompressThreads == 0)
+		return;
+
+	scan->decompressTasks = palloc(scan->num_proj_atts * sizeof(AppendOnlyDecompressTask));
+	scan->decompressBlockAttnos = palloc(scan->num_proj_atts * sizeof(int));
+	scan->decompressTaskAttnos = palloc(scan->num_proj_atts * sizeof(int));
+}
+
+/*
+ * Move all projected columns to their next row, like the per-column loop in
+ * aocs_getnext does, but read the next blocks of all the columns that ran out
+ * of rows together, so that their decompression can be spread over the
+ * helper threads.
+ *
+ * Returns -1 if the current segment file has no more rows.
+ */
+static int
+aocs_advance_columns(AOCSScanDesc scan)
+{
+	int			nblocks = 0;
+	int			ntasks = 0;
+	int			err;
+	int			i;
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		err = datumstreamread_advance(scan->ds[attno]);
+		Assert(err >= 0);
+		if (err == 0)
+			scan->decompressBlockAttnos[nblocks++] = attno;
+	}
+
+	if (nblocks == 0)
+		return 1;
+
+	for (i = 0; i < nblocks; i++)
+	{
+		int			attno = scan->decompressBlockAttnos[i];
+		bool		deferred;
+
+		err = datumstreamread_block_prepare(scan->ds[attno],
+											&scan->decompressTasks[ntasks],
+											&deferred);
+		if (err < 0)
+		{
+			/* Drop the blocks already set up for the other columns */
+			while (ntasks > 0)
+			{
+				ntasks--;
+				datumstreamread_block_discard(scan->ds[scan->decompressTaskAttnos[ntasks]],
+											  &scan->decompressTasks[ntasks]);
+			}
+			return -1;
+		}
+
+		if (deferred)
+			scan->decompressTaskAttnos[ntasks++] = attno;
+		else
+			datumstreamread_block_complete(scan->ds[attno], NULL,
+										   scan->blockDirectory, attno);
+	}
+
+	AppendOnlyDecompress_Run(scan->decompressTasks, ntasks,
+							 scan->decompressThreads);
+
+	for (i = 0; i < ntasks; i++)
+	{
+		int			attno = scan->decompressTaskAttnos[i];
+
+		datumstreamread_block_complete(scan->ds[attno],
+									   &scan->decompressTasks[i],
+									   scan->blockDirectory, attno);
+	}
+
+	for (i = 0; i < nblocks; i++)
+	{
+		err = datumstreamread_advance(scan->ds[scan->decompressBlockAttnos[i]]);
+		Assert(err > 0);
+	}
+
+	return 1;
+}
+
 /*
  * aocs_beginrangescan
  *
@@ -494,6 +609,8 @@ aocs_beginscan_internal(Relation relation,
 
 	aocs_initscan(scan);
 
+	aocs_init_decompress_threads(scan);
+
 	scan->blockDirectory = NULL;
 
 	AppendOnlyVisimap_Init(&scan->visibilityMap,
@@ -526,6 +643,13 @@ aocs_endscan(AOCSScanDesc scan)
 	pfree(scan->proj_atts);
 	pfree(scan->ds);
 
+	if (scan->decompressThreads > 0)
+	{
+		pfree(scan->decompressTasks);
+		pfree(scan->decompressBlockAttnos);
+		pfree(scan->decompressTaskAttnos);
+	}
+
 	for (i = 0; i < scan->total_seg; ++i)
 	{
 		if (scan->seginfo[i])
@@ -616,6 +740,44 @@ static void upgrade_datum_fetch(AOCSFetchDesc fetch, int attno, Datum values[],
 					   values, isnull, formatversion);
 }
 
+/*
+ * Checks whether the visibility map hides no row of the block of column
+ * 'attno' that contains the given row, so that the per-row check can be
+ * skipped. The whole block is checked once, when its first row comes up.
+ */
+static bool
+aocs_row_in_visible_block(AOCSScanDesc scan, int attno, AOTupleId *aoTupleId)
+{
+	int			segno = AOTupleIdGet_segmentFileNum(aoTupleId);
+	int64		rowNum = AOTupleIdGet_rowNum(aoTupleId);
+	DatumStreamRead *ds;
+
+	if (segno == scan->visimapBlockSegno &&
+		rowNum >= scan->visimapBlockFirstRowNum &&
+		rowNum < scan->visimapBlockEndRowNum)
+		return scan->visimapBlockAllVisible;
+
+	if (attno < 0)
+		return false;
+
+	ds = scan->ds[attno];
+	if (ds->blockFirstRowNum <= 0 ||
+		rowNum < ds->blockFirstRowNum ||
+		rowNum >= ds->blockFirstRowNum + ds->blockRowCount)
+		return false;
+
+	scan->visimapBlockSegno = segno;
+	scan->visimapBlockFirstRowNum = ds->blockFirstRowNum;
+	scan->visimapBlockEndRowNum = ds->blockFirstRowNum + ds->blockRowCount;
+	scan->visimapBlockAllVisible =
+		AppendOnlyVisimap_IsRangeVisible(&scan->visibilityMap,
+										 segno,
+										 ds->blockFirstRowNum,
+										 ds->blockRowCount);
+
+	return scan->visimapBlockAllVisible;
+}
+
 void
 aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
 {
@@ -624,6 +786,7 @@ aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
 	bool	   *null = slot_get_isnull(slot);
 	AOTupleId	aoTupleId;
 	int64		rowNum = INT64CONST(-1);
+	int			rowNumAttno = -1;
 	int			err = 0;
 	int			i;
 	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
@@ -655,27 +818,45 @@ ReadNext:
 		Assert(scan->cur_seg >= 0);
 		curseginfo = scan->seginfo[scan->cur_seg];
 
+		/*
+		 * With decompression helper threads, advance all columns up front
+		 * so that the blocks they run out of at the same time are
+		 * decompressed in parallel.
+		 */
+		if (scan->decompressThreads > 0)
+		{
+			err = aocs_advance_columns(scan);
+			if (err < 0)
+			{
+				close_cur_scan_seg(scan);
+				goto ReadNext;
+			}
+		}
+
 		/* Read from cur_seg */
 		for (i = 0; i < scan->num_proj_atts; i++)
 		{
 			int			attno = scan->proj_atts[i];
 
-			err = datumstreamread_advance(scan->ds[attno]);
-			Assert(err >= 0);
-			if (err == 0)
+			if (scan->decompressThreads == 0)
 			{
-				err = datumstreamread_block(scan->ds[attno], scan->blockDirectory, attno);
-				if (err < 0)
+				err = datumstreamread_advance(scan->ds[attno]);
+				Assert(err >= 0);
+				if (err == 0)
 				{
-					/*
-					 * Ha, cannot read next block, we need to go to next seg
-					 */
-					close_cur_scan_seg(scan);
-					goto ReadNext;
+					err = datumstreamread_block(scan->ds[attno], scan->blockDirectory, attno);
+					if (err < 0)
+					{
+						/*
+						 * Ha, cannot read next block, we need to go to next seg
+						 */
+						close_cur_scan_seg(scan);
+						goto ReadNext;
+					}
+
+					err = datumstreamread_advance(scan->ds[attno]);
+					Assert(err > 0);
 				}
-
-				err = datumstreamread_advance(scan->ds[attno]);
-				Assert(err > 0);
 			}
 
 			/*
@@ -699,6 +880,7 @@ ReadNext:
 				Assert(scan->ds[attno]->blockFirstRowNum > 0);
 				rowNum = scan->ds[attno]->blockFirstRowNum +
 					datumstreamread_nth(scan->ds[attno]);
+				rowNumAttno = attno;
 			}
 		}
 
@@ -715,9 +897,12 @@ ReadNext:
 			AOTupleIdInit_rowNum(&aoTupleId, rowNum);
 		}
 
-		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, &aoTupleId))
+		if (!isSnapshotAny &&
+			!aocs_row_in_visible_block(scan, rowNumAttno, &aoTupleId) &&
+			!AppendOnlyVisimap_IsVisible(&scan->visibilityMap, &aoTupleId))
 		{
 			rowNum = INT64CONST(-1);
+			rowNumAttno = -1;
 			goto ReadNext;
 		}
 		scan->cdb_fake_ctid = *((ItemPointer) &aoTupleId);
@@ -823,6 +1008,42 @@ SetBlockFirstRowNums(DatumStreamWrite **datumStreams,
 }
 
 
+/*
+ * Decide whether aocs_insert_values_multi() compresses blocks on helper
+ * threads. Only columns whose compression has a thread-safe compressor count.
+ */
+static void
+aocs_init_compress_threads(AOCSInsertDesc desc)
+{
+	int			natts = RelationGetNumberOfAttributes(desc->aoi_rel);
+	int			ncompressed = 0;
+	int			i;
+
+	desc->compressThreads = 0;
+
+	if (gp_aocs_compress_threads <= 0)
+		return;
+
+	for (i = 0; i < natts; i++)
+	{
+		AppendOnlyStorageWrite *ao_write = &desc->ds[i]->ao_write;
+
+		if (ao_write->storageAttributes.compress &&
+			ao_write->compressionState != NULL &&
+			ao_write->compressionState->threadsafe_compress != NULL)
+			ncompressed++;
+	}
+
+	desc->compressThreads =
+		AppendOnlyDecompress_NumThreads(gp_aocs_compress_threads, ncompressed);
+	if (desc->compressThreads == 0)
+		return;
+
+	desc->compressTasks = palloc(natts * sizeof(AppendOnlyDecompressTask));
+	desc->compressTaskCols = palloc(natts * sizeof(int));
+	desc->bulkRowPos = palloc(natts * sizeof(int));
+}
+
 AOCSInsertDesc
 aocs_insert_init(Relation rel, int segno, bool update_mode)
 {
@@ -872,6 +1093,8 @@ aocs_insert_init(Relation rel, int segno, bool update_mode)
 
 	SetBlockFirstRowNums(desc->ds, tupleDesc->natts, desc->lastSequence + 1);
 
+	aocs_init_compress_threads(desc);
+
 	/* Initialize the block directory. */
 	tupleDesc = RelationGetDescr(rel);
 	AppendOnlyBlockDirectory_Init_forInsert(&(desc->blockDirectory),
@@ -888,84 +1111,100 @@ aocs_insert_init(Relation rel, int segno, bool update_mode)
 }
 
 
-Oid
-aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId)
+/*
+ * Add the datum of column i with row number rowNum to the column's current
+ * block, writing out the block first if it is full.
+ *
+ * If 'task' is given and the full block can be compressed by a helper
+ * thread, the block is only set up for that in *task, and false is returned
+ * without adding the datum. The caller must complete the block with
+ * datumstreamwrite_block_complete, and then call this again.
+ */
+static bool
+aocs_insert_datum(AOCSInsertDesc idesc, int i, Datum datum, bool isnull,
+				  int64 rowNum, AppendOnlyDecompressTask *task)
 {
-	Relation	rel = idesc->aoi_rel;
-	int			i;
+	DatumStreamWrite *ds = idesc->ds[i];
+	void	   *toFree1;
+	int			err = datumstreamwrite_put(ds, datum, isnull, &toFree1);
 
-	if (rel->rd_rel->relhasoids)
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("append-only column-oriented tables do not support rows with OIDs")));
+	if (toFree1 != NULL)
+	{
+		/*
+		 * Use the de-toasted and/or de-compressed as datum instead.
+		 */
+		datum = PointerGetDatum(toFree1);
+	}
+	if (err < 0)
+	{
+		int			itemCount = datumstreamwrite_nth(ds);
+		void	   *toFree2;
 
-#ifdef FAULT_INJECTOR
-	FaultInjector_InjectFaultIfSet(
-								   AppendOnlyInsert,
-								   DDLNotSpecified,
-								   "",	/* databaseName */
-								   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
-#endif
+		/* write the block up to this one */
+		if (task != NULL && itemCount > 0)
+		{
+			bool		deferred;
 
-	/* As usual, at this moment, we assume one col per vp */
-	for (i = 0; i < RelationGetNumberOfAttributes(rel); ++i)
-	{
-		void	   *toFree1;
-		Datum		datum = d[i];
-		int			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree1);
+			datumstreamwrite_block_prepare(ds, task, &deferred,
+										   &idesc->blockDirectory, i, false);
+			if (deferred)
+			{
+				if (toFree1 != NULL)
+					pfree(toFree1);
+				return false;
+			}
+		}
+		else
+			datumstreamwrite_block(ds, &idesc->blockDirectory, i, false);
 
-		if (toFree1 != NULL)
+		if (itemCount > 0)
 		{
 			/*
-			 * Use the de-toasted and/or de-compressed as datum instead.
+			 * since we have written all up to the new tuple, the new
+			 * blockFirstRowNum is the inserted tuple's row number
 			 */
-			datum = PointerGetDatum(toFree1);
+			ds->blockFirstRowNum = rowNum;
 		}
-		if (err < 0)
-		{
-			int			itemCount = datumstreamwrite_nth(idesc->ds[i]);
-			void	   *toFree2;
 
-			/* write the block up to this one */
-			datumstreamwrite_block(idesc->ds[i], &idesc->blockDirectory, i, false);
-			if (itemCount > 0)
-			{
-				/*
-				 * since we have written all up to the new tuple, the new
-				 * blockFirstRowNum is the inserted tuple's row number
-				 */
-				idesc->ds[i]->blockFirstRowNum = idesc->lastSequence + 1;
-			}
+		Assert(ds->blockFirstRowNum == rowNum);
 
-			Assert(idesc->ds[i]->blockFirstRowNum == idesc->lastSequence + 1);
 
+		/* now write this new item to the new block */
+		err = datumstreamwrite_put(ds, datum, isnull, &toFree2);
+		Assert(toFree2 == NULL);
+		if (err < 0)
+		{
+			Assert(!isnull);
+			err = datumstreamwrite_lob(ds,
+									   datum,
+									   &idesc->blockDirectory,
+									   i,
+									   false);
+			Assert(err >= 0);
 
-			/* now write this new item to the new block */
-			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree2);
-			Assert(toFree2 == NULL);
-			if (err < 0)
-			{
-				Assert(!null[i]);
-				err = datumstreamwrite_lob(idesc->ds[i],
-										   datum,
-										   &idesc->blockDirectory,
-										   i,
-										   false);
-				Assert(err >= 0);
-
-				/*
-				 * A lob will live by itself in the block so this assignment
-				 * is for the block that contains tuples AFTER the one we are
-				 * inserting
-				 */
-				idesc->ds[i]->blockFirstRowNum = idesc->lastSequence + 2;
-			}
+			/*
+			 * A lob will live by itself in the block so this assignment
+			 * is for the block that contains tuples AFTER the one we are
+			 * inserting
+			 */
+			ds->blockFirstRowNum = rowNum + 1;
 		}
-
-		if (toFree1 != NULL)
-			pfree(toFree1);
 	}
 
+	if (toFree1 != NULL)
+		pfree(toFree1);
+
+	return true;
+}
+
+/*
+ * Account for one inserted row, and return its TID.
+ */
+static void
+aocs_insert_next_row(AOCSInsertDesc idesc, AOTupleId *aoTupleId)
+{
+	Relation	rel = idesc->aoi_rel;
+
 	idesc->insertCount++;
 	idesc->lastSequence++;
 	if (idesc->numSequences > 0)
@@ -994,10 +1233,292 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 		Assert(firstSequence == idesc->lastSequence + 1);
 		idesc->numSequences = NUM_FAST_SEQUENCES;
 	}
+}
+
+Oid
+aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId)
+{
+	Relation	rel = idesc->aoi_rel;
+	int			i;
+
+	if (rel->rd_rel->relhasoids)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("append-only column-oriented tables do not support rows with OIDs")));
+
+#ifdef FAULT_INJECTOR
+	FaultInjector_InjectFaultIfSet(
+								   AppendOnlyInsert,
+								   DDLNotSpecified,
+								   "",	/* databaseName */
+								   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
+#endif
+
+	/* As usual, at this moment, we assume one col per vp */
+	for (i = 0; i < RelationGetNumberOfAttributes(rel); ++i)
+		aocs_insert_datum(idesc, i, d[i], null[i], idesc->lastSequence + 1,
+						  NULL);
+
+	aocs_insert_next_row(idesc, aoTupleId);
 
 	return InvalidOid;
 }
 
+/*
+ * Insert a batch of rows.
+ *
+ * Equivalent to calling aocs_insert_values for each row, but the batch is
+ * encoded one column at a time, and when gp_aocs_compress_threads allows,
+ * the blocks of different columns that fill up are compressed in parallel
+ * by helper threads.
+ *
+ * values[r] and nulls[r] are the datums of row r; the TIDs of the inserted
+ * rows are returned in aoTupleIds.
+ */
+void
+aocs_insert_values_multi(AOCSInsertDesc idesc, Datum **values, bool **nulls,
+						 int nrows, AOTupleId *aoTupleIds)
+{
+	Relation	rel = idesc->aoi_rel;
+	int			natts = RelationGetNumberOfAttributes(rel);
+	int64		firstRowNum = idesc->lastSequence + 1;
+	int			i;
+	int			r;
+
+	if (nrows <= 0)
+		return;
+
+	if (rel->rd_rel->relhasoids)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("append-only column-oriented tables do not support rows with OIDs")));
+
+#ifdef FAULT_INJECTOR
+	FaultInjector_InjectFaultIfSet(
+								   AppendOnlyInsert,
+								   DDLNotSpecified,
+								   "",	/* databaseName */
+								   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
+#endif
+
+	if (idesc->compressThreads == 0)
+	{
+		for (i = 0; i < natts; i++)
+		{
+			for (r = 0; r < nrows; r++)
+				aocs_insert_datum(idesc, i, values[r][i], nulls[r][i],
+								  firstRowNum + r, NULL);
+		}
+	}
+	else
+	{
+		int		   *rowPos = idesc->bulkRowPos;
+
+		memset(rowPos, 0, natts * sizeof(int));
+
+		/*
+		 * Each round adds datums to every column until its block is full,
+		 * and then compresses all the full blocks together.
+		 */
+		for (;;)
+		{
+			int			ntasks = 0;
+			int			t;
+
+			for (i = 0; i < natts; i++)
+			{
+				while (rowPos[i] < nrows)
+				{
+					r = rowPos[i];
+					if (!aocs_insert_datum(idesc, i, values[r][i], nulls[r][i],
+										   firstRowNum + r,
+										   &idesc->compressTasks[ntasks]))
+					{
+						idesc->compressTaskCols[ntasks++] = i;
+						break;
+					}
+					rowPos[i]++;
+				}
+			}
+
+			if (ntasks == 0)
+				break;
+
+			AppendOnlyDecompress_Run(idesc->compressTasks, ntasks,
+									 idesc->compressThreads);
+
+			for (t = 0; t < ntasks; t++)
+			{
+				i = idesc->compressTaskCols[t];
+
+				datumstreamwrite_block_complete(idesc->ds[i],
+												&idesc->compressTasks[t],
+												&idesc->blockDirectory,
+												i, false);
+
+				/* the datum that didn't fit starts the next block */
+				idesc->ds[i]->blockFirstRowNum = firstRowNum + rowPos[i];
+			}
+		}
+	}
+
+	for (r = 0; r < nrows; r++)
+		aocs_insert_next_row(idesc, &aoTupleIds[r]);
+}
+
+/*
+ * Vacuum delay point for aocs_insert_segfile, after reading and writing a
+ * block of 'len' bytes.
+ *
+ * Segment files are not read and written through shared buffers, so nothing
+ * else charges that I/O to the vacuum cost balance. Charge it as page misses
+ * and dirtied pages here, so that the cost-based vacuum delay settings
+ * throttle the block copy, too.
+ */
+static void
+aocs_compaction_delay_point(int64 len)
+{
+	if (VacuumCostActive)
+	{
+		int64		npages = (len + BLCKSZ - 1) / BLCKSZ;
+
+		VacuumCostBalance += npages * (VacuumCostPageMiss + VacuumCostPageDirty);
+	}
+
+	vacuum_delay_point();
+}
+
+/*
+ * Append the rows of segment file 'segInfo' of the same relation that
+ * 'visiMap' doesn't hide, for compaction.
+ *
+ * The segment file is processed one column, and one block, at a time.
+ * Blocks in which no row is hidden are copied as they are stored, without
+ * decompressing them, see datumstreamwrite_copy_block. Only the blocks with
+ * hidden rows are decoded, and their remaining datums put into new blocks.
+ *
+ * The rows keep their order, and get consecutive row numbers starting with
+ * the next row number of the insert. Returns the number of rows appended.
+ *
+ * The segment file must be of the current format version, datums of older
+ * versions may need to be upgraded, see aocs_getnext.
+ */
+int64
+aocs_insert_segfile(AOCSInsertDesc idesc, AOCSFileSegInfo *segInfo,
+					AppendOnlyVisimap *visiMap)
+{
+	Relation	rel = idesc->aoi_rel;
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	int			natts = tupdesc->natts;
+	int64		firstRowNum = idesc->lastSequence + 1;
+	int64		rowCount = 0;
+	DatumStreamRead **ds;
+	int		   *proj_atts;
+	char	   *basepath;
+	int64		r;
+	int			i;
+
+	Assert(segInfo->segno != idesc->cur_segno);
+	Assert(segInfo->formatversion == AORelationVersion_GetLatest());
+
+	ds = (DatumStreamRead **) palloc0(natts * sizeof(DatumStreamRead *));
+	proj_atts = (int *) palloc(natts * sizeof(int));
+	for (i = 0; i < natts; i++)
+		proj_atts[i] = i;
+
+	open_ds_read(rel, ds, tupdesc, proj_atts, natts,
+				 rel->rd_appendonly->checksum);
+
+	basepath = relpathbackend(rel->rd_node, rel->rd_backend, MAIN_FORKNUM);
+
+	for (i = 0; i < natts; i++)
+	{
+		int64		nextRowNum = firstRowNum;
+		int64		copiedBlocks = 0;
+		int64		rewrittenBlocks = 0;
+
+		open_datumstreamread_segfile(basepath, rel->rd_node, segInfo, ds[i], i);
+
+		while (datumstreamread_block_header(ds[i]))
+		{
+			int64		blockFirstRowNum = ds[i]->blockFirstRowNum;
+			int			blockRowCount = ds[i]->blockRowCount;
+
+			CHECK_FOR_INTERRUPTS();
+
+			if (AppendOnlyVisimap_IsRangeVisible(visiMap, segInfo->segno,
+												 blockFirstRowNum,
+												 blockRowCount) &&
+				datumstreamwrite_copy_block(idesc->ds[i], ds[i], nextRowNum,
+											&idesc->blockDirectory, i))
+			{
+				nextRowNum += blockRowCount;
+				copiedBlocks++;
+			}
+			else
+			{
+				datumstreamread_block_content(ds[i]);
+
+				while (datumstreamread_advance(ds[i]) > 0)
+				{
+					AOTupleId	aoTupleId;
+					Datum		datum;
+					bool		isnull;
+
+					AOTupleIdInit_Init(&aoTupleId);
+					AOTupleIdInit_segmentFileNum(&aoTupleId, segInfo->segno);
+					AOTupleIdInit_rowNum(&aoTupleId,
+										 ds[i]->blockFirstRowNum +
+										 datumstreamread_nth(ds[i]));
+
+					if (!AppendOnlyVisimap_IsVisible(visiMap, &aoTupleId))
+						continue;
+
+					datumstreamread_get(ds[i], &datum, &isnull);
+					aocs_insert_datum(idesc, i, datum, isnull, nextRowNum, NULL);
+					nextRowNum++;
+				}
+				rewrittenBlocks++;
+			}
+
+			aocs_compaction_delay_point(
+				AppendOnlyStorageRead_OverallBlockLen(&ds[i]->ao_read));
+		}
+
+		datumstreamread_close_file(ds[i]);
+
+		elogif(Debug_appendonly_print_compaction, LOG,
+			   "Compaction: column %d of segno %d: copied " INT64_FORMAT " blocks, "
+			   "rewrote " INT64_FORMAT " blocks, " INT64_FORMAT " rows",
+			   i, segInfo->segno, copiedBlocks, rewrittenBlocks,
+			   nextRowNum - firstRowNum);
+
+		/* Every column has the same rows, and so the same visible ones */
+		if (i == 0)
+			rowCount = nextRowNum - firstRowNum;
+		else if (nextRowNum - firstRowNum != rowCount)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("column %d of segment file %d of relation \"%s\" has " INT64_FORMAT " visible rows, expected " INT64_FORMAT,
+							i + 1, segInfo->segno, RelationGetRelationName(rel),
+							nextRowNum - firstRowNum, rowCount)));
+	}
+
+	for (r = 0; r < rowCount; r++)
+	{
+		AOTupleId	aoTupleId;
+
+		aocs_insert_next_row(idesc, &aoTupleId);
+	}
+
+	pfree(basepath);
+	close_ds_read(ds, natts);
+	pfree(ds);
+	pfree(proj_atts);
+
+	return rowCount;
+}
+
 void
 aocs_insert_finish(AOCSInsertDesc idesc)
 {
@@ -1016,6 +1537,13 @@ aocs_insert_finish(AOCSInsertDesc idesc)
 
 	pfree(idesc->fsInfo);
 
+	if (idesc->compressThreads > 0)
+	{
+		pfree(idesc->compressTasks);
+		pfree(idesc->compressTaskCols);
+		pfree(idesc->bulkRowPos);
+	}
+
 	close_ds_write(idesc->ds, rel->rd_att->natts);
 }
 
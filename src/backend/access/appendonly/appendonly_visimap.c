@@ -214,6 +214,61 @@ AppendOnlyVisimap_IsVisible(
 											aoTupleId);
 }
 
+/*
+ * Checks if all rows of a block are visible according to the visibility
+ * map, i.e. rowCount rows from firstRowNum in segment file segno.
+ *
+ * Scans use this to apply the visibility map to a whole block at once, and
+ * skip the per-tuple AppendOnlyVisimap_IsVisible checks when it returns true.
+ *
+ * Assumes that the visibility has been initialized and not finished.
+ */
+bool
+AppendOnlyVisimap_IsRangeVisible(
+								 AppendOnlyVisimap *visiMap,
+								 int segno,
+								 int64 firstRowNum,
+								 int64 rowCount)
+{
+	AOTupleId	aoTupleId;
+
+	Assert(visiMap);
+
+	while (rowCount > 0)
+	{
+		AppendOnlyVisimapEntry *visimapEntry = &visiMap->visimapEntry;
+		int64		n;
+
+		AOTupleIdInit_Init(&aoTupleId);
+		AOTupleIdInit_segmentFileNum(&aoTupleId, segno);
+		AOTupleIdInit_rowNum(&aoTupleId, firstRowNum);
+
+		if (!AppendOnlyVisimapEntry_CoversTuple(visimapEntry, &aoTupleId))
+		{
+			/* if necessary persist the current entry before moving. */
+			if (AppendOnlyVisimapEntry_HasChanged(visimapEntry))
+			{
+				AppendOnlyVisimap_Store(visiMap);
+			}
+
+			AppendOnlyVisimap_Find(visiMap, &aoTupleId);
+		}
+
+		/* the part of the range covered by this entry */
+		n = Min(rowCount,
+				visimapEntry->firstRowNum + APPENDONLY_VISIMAP_MAX_RANGE - firstRowNum);
+
+		if (!AppendOnlyVisimapEntry_IsRangeVisible(visimapEntry,
+												   firstRowNum, n))
+			return false;
+
+		firstRowNum += n;
+		rowCount -= n;
+	}
+
+	return true;
+}
+
 /*
  * Stores the current visibility map entry information
  * in the relation either as update or delete.
@@ -0,0 +1,285 @@
+/*------------------------------------------------------------------------------
+ *
+ * appendonly_visimap_cache
+ *   shared-memory cache of decoded visibility map bitmaps.
+ *
+ * Every scan of an append-only table with deleted rows reads the visimap
+ * entries covering the rows it returns from the aovisimap relation, and
+ * decompresses each entry's bitmap. Concurrent and repeated scans of the
+ * same table do that over and over for the same entries. This cache keeps
+ * the decompressed bitmaps in shared memory, so that a backend only has to
+ * copy a bitmap that some backend has already decoded.
+ *
+ * The cache is keyed by (visimap relfilenode, segno, firstRowNum), and each
+ * cached bitmap is stored together with the on-disk (compressed) image it was
+ * decoded from. A lookup only hits if the caller's visible version of the
+ * entry has exactly the same image, so the cache never needs to be
+ * invalidated: whatever version of an entry a backend's snapshot sees, the
+ * image is its version stamp. A changed entry just replaces the cached one
+ * the next time it is decoded.
+ *
+ * The cache has gp_appendonly_visimap_cache_entries fixed-size slots,
+ * replaced in clock order, and is protected by AOVisimapCacheLock.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/access/appendonly/appendonly_visimap_cache.c
+ *
+ *------------------------------------------------------------------------------
+*/
+#include "postgres.h"
+
+#include "access/appendonly_visimap.h"
+#include "access/appendonly_visimap_cache.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+
+#define VISIMAP_CACHE_MAX_WORDS \
+	(APPENDONLY_VISIMAP_MAX_RANGE / BITS_PER_BITMAPWORD)
+
+typedef struct VisimapCacheKey
+{
+	RelFileNode node;
+	int32		segmentFileNum;
+	int64		firstRowNum;
+} VisimapCacheKey;
+
+typedef struct VisimapCacheHashEntry
+{
+	VisimapCacheKey key;
+	int			slot;
+} VisimapCacheHashEntry;
+
+typedef struct VisimapCacheSlot
+{
+	VisimapCacheKey key;
+	bool		valid;
+	bool		recentlyUsed;
+
+	/* On-disk image the bitmap was decoded from */
+	int32		dataLen;
+	char		data[APPENDONLY_VISIMAP_DATA_BUFFER_SIZE];
+
+	/* Decoded bitmap */
+	int32		nwords;
+	bitmapword	words[VISIMAP_CACHE_MAX_WORDS];
+} VisimapCacheSlot;
+
+typedef struct VisimapCacheCtl
+{
+	int			clockHand;
+	VisimapCacheSlot slots[1];	/* VARIABLE LENGTH ARRAY */
+} VisimapCacheCtl;
+
+static VisimapCacheCtl *visimapCache = NULL;
+static HTAB *visimapCacheHash = NULL;
+
+Size
+AppendOnlyVisimapCache_ShmemSize(void)
+{
+	Size		size;
+
+	if (gp_appendonly_visimap_cache_entries <= 0)
+		return 0;
+
+	size = offsetof(VisimapCacheCtl, slots);
+	size = add_size(size, mul_size(gp_appendonly_visimap_cache_entries,
+								   sizeof(VisimapCacheSlot)));
+	size = add_size(size, hash_estimate_size(gp_appendonly_visimap_cache_entries,
+											 sizeof(VisimapCacheHashEntry)));
+	return size;
+}
+
+void
+AppendOnlyVisimapCache_ShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+	int			i;
+
+	if (gp_appendonly_visimap_cache_entries <= 0)
+		return;
+
+	visimapCache = (VisimapCacheCtl *)
+		ShmemInitStruct("AO visimap cache",
+						add_size(offsetof(VisimapCacheCtl, slots),
+								 mul_size(gp_appendonly_visimap_cache_entries,
+										  sizeof(VisimapCacheSlot))),
+						&found);
+	if (!found)
+	{
+		visimapCache->clockHand = 0;
+		for (i = 0; i < gp_appendonly_visimap_cache_entries; i++)
+			visimapCache->slots[i].valid = false;
+	}
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(VisimapCacheKey);
+	info.entrysize = sizeof(VisimapCacheHashEntry);
+	info.hash = tag_hash;
+
+	visimapCacheHash = ShmemInitHash("AO visimap cache hash",
+									 gp_appendonly_visimap_cache_entries,
+									 gp_appendonly_visimap_cache_entries,
+									 &info,
+									 HASH_ELEM | HASH_FUNCTION | HASH_FIXED_SIZE);
+}
+
+static void
+make_key(VisimapCacheKey *key, const RelFileNode *visimapNode,
+		 int32 segmentFileNum, int64 firstRowNum)
+{
+	/* zero the padding, the whole struct is hashed */
+	MemSet(key, 0, sizeof(*key));
+	key->node = *visimapNode;
+	key->segmentFileNum = segmentFileNum;
+	key->firstRowNum = firstRowNum;
+}
+
+/*
+ * Looks up the decoded bitmap of a visimap entry whose on-disk image is
+ * 'data'.
+ *
+ * On a hit, returns true and a copy of the bitmap, allocated in the current
+ * memory context, in *bitmap (NULL if no row is hidden).
+ */
+bool
+AppendOnlyVisimapCache_Lookup(const RelFileNode *visimapNode,
+							  int32 segmentFileNum,
+							  int64 firstRowNum,
+							  const struct varlena *data,
+							  Bitmapset **bitmap)
+{
+	VisimapCacheKey key;
+	VisimapCacheHashEntry *hentry;
+	VisimapCacheSlot *slot;
+	bool		hit = false;
+	int32		nwords = 0;
+	bitmapword	words[VISIMAP_CACHE_MAX_WORDS];
+
+	if (visimapCache == NULL)
+		return false;
+
+	make_key(&key, visimapNode, segmentFileNum, firstRowNum);
+
+	LWLockAcquire(AOVisimapCacheLock, LW_SHARED);
+
+	hentry = (VisimapCacheHashEntry *)
+		hash_search(visimapCacheHash, &key, HASH_FIND, NULL);
+	if (hentry != NULL)
+	{
+		slot = &visimapCache->slots[hentry->slot];
+
+		if (slot->dataLen == VARSIZE(data) &&
+			memcmp(slot->data, data, slot->dataLen) == 0)
+		{
+			nwords = slot->nwords;
+			memcpy(words, slot->words, nwords * sizeof(bitmapword));
+
+			/* a lost update here only affects replacement order */
+			slot->recentlyUsed = true;
+			hit = true;
+		}
+	}
+
+	LWLockRelease(AOVisimapCacheLock);
+
+	if (!hit)
+		return false;
+
+	if (nwords > 0)
+	{
+		*bitmap = palloc(offsetof(Bitmapset, words) +
+						 nwords * sizeof(bitmapword));
+		(*bitmap)->nwords = nwords;
+		memcpy((*bitmap)->words, words, nwords * sizeof(bitmapword));
+	}
+	else
+		*bitmap = NULL;
+
+	return true;
+}
+
+/*
+ * Remembers the decoded bitmap of a visimap entry, replacing whatever was
+ * cached for the same entry before.
+ */
+void
+AppendOnlyVisimapCache_Insert(const RelFileNode *visimapNode,
+							  int32 segmentFileNum,
+							  int64 firstRowNum,
+							  const struct varlena *data,
+							  const Bitmapset *bitmap)
+{
+	VisimapCacheKey key;
+	VisimapCacheHashEntry *hentry;
+	VisimapCacheSlot *slot;
+	int32		nwords = (bitmap != NULL ? bitmap->nwords : 0);
+	bool		found;
+	int			slotno;
+
+	if (visimapCache == NULL)
+		return;
+
+	if (VARSIZE(data) > APPENDONLY_VISIMAP_DATA_BUFFER_SIZE ||
+		nwords > VISIMAP_CACHE_MAX_WORDS)
+		return;
+
+	make_key(&key, visimapNode, segmentFileNum, firstRowNum);
+
+	LWLockAcquire(AOVisimapCacheLock, LW_EXCLUSIVE);
+
+	hentry = (VisimapCacheHashEntry *)
+		hash_search(visimapCacheHash, &key, HASH_FIND, NULL);
+	if (hentry != NULL)
+		slotno = hentry->slot;
+	else
+	{
+		/* Find a victim slot, clock-sweep style */
+		for (;;)
+		{
+			slotno = visimapCache->clockHand;
+			slot = &visimapCache->slots[slotno];
+
+			if (++visimapCache->clockHand >= gp_appendonly_visimap_cache_entries)
+				visimapCache->clockHand = 0;
+
+			if (!slot->valid || !slot->recentlyUsed)
+				break;
+			slot->recentlyUsed = false;
+		}
+
+		if (slot->valid)
+		{
+			hash_search(visimapCacheHash, &slot->key, HASH_REMOVE, NULL);
+			slot->valid = false;
+		}
+
+		hentry = (VisimapCacheHashEntry *)
+			hash_search(visimapCacheHash, &key, HASH_ENTER_NULL, &found);
+		if (hentry == NULL)
+		{
+			/* can't happen, we just made room; just don't cache it */
+			LWLockRelease(AOVisimapCacheLock);
+			return;
+		}
+		Assert(!found);
+		hentry->slot = slotno;
+	}
+
+	slot = &visimapCache->slots[slotno];
+	slot->key = key;
+	slot->dataLen = VARSIZE(data);
+	memcpy(slot->data, data, slot->dataLen);
+	slot->nwords = nwords;
+	if (nwords > 0)
+		memcpy(slot->words, bitmap->words, nwords * sizeof(bitmapword));
+	slot->recentlyUsed = true;
+	slot->valid = true;
+
+	LWLockRelease(AOVisimapCacheLock);
+}
@@ -13,6 +13,7 @@
 */
 #include "postgres.h"
 #include "access/appendonly_visimap.h"
+#include "access/appendonly_visimap_cache.h"
 #include "cdb/cdbappendonlyblockdirectory.h"
 #include "utils/bitstream.h"
 #include "utils/guc.h"
@@ -181,12 +182,16 @@ AppendOnlyVisiMapEnty_ReadData(
  * Should only be called with values and nulls provides
  * by a successful read from the aovisimap table using
  * an AppendOnlyVisimapIndex data structure.
+ *
+ * If visimapNode is given, the decoded bitmap is looked up in and added to
+ * the shared visimap cache, see appendonly_visimap_cache.c.
  */
 void
 AppendOnlyVisimapEntry_Copyout(
 							   AppendOnlyVisimapEntry *visiMapEntry,
 							   HeapTuple tuple,
-							   TupleDesc tupleDesc)
+							   TupleDesc tupleDesc,
+							   const RelFileNode *visimapNode)
 {
 	struct varlena *value;
 	struct varlena *detoast_value;
@@ -236,7 +241,32 @@ AppendOnlyVisimapEntry_Copyout(
 
 		dataSize = VARSIZE(detoast_value) -
 			offsetof(AppendOnlyVisimapData, data);
-		AppendOnlyVisiMapEnty_ReadData(visiMapEntry, dataSize);
+
+		if (visimapNode == NULL)
+			AppendOnlyVisiMapEnty_ReadData(visiMapEntry, dataSize);
+		else
+		{
+			Bitmapset  *cached;
+
+			if (AppendOnlyVisimapCache_Lookup(visimapNode,
+											  visiMapEntry->segmentFileNum,
+											  visiMapEntry->firstRowNum,
+											  detoast_value,
+											  &cached))
+			{
+				bms_free(visiMapEntry->bitmap);
+				visiMapEntry->bitmap = cached;
+			}
+			else
+			{
+				AppendOnlyVisiMapEnty_ReadData(visiMapEntry, dataSize);
+				AppendOnlyVisimapCache_Insert(visimapNode,
+											  visiMapEntry->segmentFileNum,
+											  visiMapEntry->firstRowNum,
+											  detoast_value,
+											  visiMapEntry->bitmap);
+			}
+		}
 
 		MemoryContextSwitchTo(oldContext);
 
@@ -480,6 +510,61 @@ AppendOnlyVisimapEntry_IsVisible(
 	return visibilityBit;
 }
 
+/*
+ * Checks if all rows in [firstRowNum, firstRowNum + rowCount) are visible
+ * according to the bitmap. The range is checked a bitmap word at a time,
+ * instead of row by row.
+ *
+ * Should only be called if the current visimap entry covers the whole range.
+ */
+bool
+AppendOnlyVisimapEntry_IsRangeVisible(
+									  AppendOnlyVisimapEntry *visiMapEntry,
+									  int64 firstRowNum,
+									  int64 rowCount)
+{
+	Bitmapset  *bitmap = visiMapEntry->bitmap;
+	int64		startOffset;
+	int64		endOffset;
+	int			firstWord;
+	int			lastWord;
+	int			wordnum;
+
+	Assert(visiMapEntry);
+	Assert(AppendOnlyVisimapEntry_IsValid(visiMapEntry));
+	Assert(firstRowNum >= visiMapEntry->firstRowNum);
+	Assert(firstRowNum + rowCount <=
+		   visiMapEntry->firstRowNum + APPENDONLY_VISIMAP_MAX_RANGE);
+
+	if (rowCount <= 0 || AppendOnlyVisimapEntry_AreAllVisible(visiMapEntry))
+		return true;
+
+	/* offsets of the first and the last row in the range */
+	startOffset = firstRowNum - visiMapEntry->firstRowNum;
+	endOffset = startOffset + rowCount - 1;
+
+	firstWord = startOffset / BITS_PER_BITMAPWORD;
+	lastWord = endOffset / BITS_PER_BITMAPWORD;
+
+	for (wordnum = firstWord;
+		 wordnum <= lastWord && wordnum < bitmap->nwords;
+		 wordnum++)
+	{
+		bitmapword	mask = ~((bitmapword) 0);
+
+		if (wordnum == firstWord)
+			mask &= ~(((bitmapword) 1 << (startOffset % BITS_PER_BITMAPWORD)) - 1);
+		if (wordnum == lastWord &&
+			endOffset % BITS_PER_BITMAPWORD < BITS_PER_BITMAPWORD - 1)
+			mask &= ((bitmapword) 1 << (endOffset % BITS_PER_BITMAPWORD + 1)) - 1;
+
+		if ((bitmap->words[wordnum] & mask) != 0)
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * The minimal size (in uint32's elements) the entry array needs to have to
  * cover the given offset
@@ -286,7 +286,8 @@ AppendOnlyVisimapStore_GetNext(
 	if (visiMapEntry)
 	{
 		AppendOnlyVisimapEntry_Copyout(visiMapEntry, tuple,
-									   heapTupleDesc);
+									   heapTupleDesc,
+									   &visiMapStore->visimapRelation->rd_node);
 	}
 	if (tupleTid)
 	{
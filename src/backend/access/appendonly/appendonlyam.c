@@ -1332,6 +1332,13 @@ appendonlygettup(AppendOnlyScanDesc scan,
 			}
 
 			scan->bufferDone = false;
+
+			/* Apply the visibility map to the whole block, if possible */
+			scan->blockAllVisible = !isSnapshotAny &&
+				AppendOnlyVisimap_IsRangeVisible(&scan->visibilityMap,
+												 scan->executorReadBlock.segmentFileNum,
+												 scan->executorReadBlock.blockFirstRowNum,
+												 scan->executorReadBlock.rowCount);
 		}
 
 		tuple = AppendOnlyExecutorReadBlock_ScanNextTuple(
@@ -1347,7 +1354,8 @@ appendonlygettup(AppendOnlyScanDesc scan,
 			 */
 			AOTupleId  *aoTupleId = (AOTupleId *) slot_get_ctid(slot);
 
-			if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
+			if (!isSnapshotAny && !scan->blockAllVisible &&
+				!AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
 			{
 				/*
 				 * The tuple is invisible.
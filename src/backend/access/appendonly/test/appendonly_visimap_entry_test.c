@@ -74,6 +74,33 @@ test__AppendOnlyVisimapEntry_CoversTuple(void **state)
 	assert_true(result);
 }
 
+void
+test__AppendOnlyVisimapEntry_IsRangeVisible(void **state)
+{
+	AppendOnlyVisimapEntry *visiMapEntry = malloc(sizeof(AppendOnlyVisimapEntry));
+	Bitmapset  *bitmap = calloc(1, offsetof(Bitmapset, words) + 4 * sizeof(bitmapword));
+
+	/* row 100 is hidden, the bitmap covers rows 0 - 127 */
+	bitmap->nwords = 4;
+	bitmap->words[100 / BITS_PER_BITMAPWORD] =
+		(bitmapword) 1 << (100 % BITS_PER_BITMAPWORD);
+
+	visiMapEntry->segmentFileNum = 1;
+	visiMapEntry->firstRowNum = 0;
+	visiMapEntry->bitmap = bitmap;
+
+	expect_value_count(bms_is_empty, a, bitmap, 6);
+	will_return_count(bms_is_empty, false, 6);
+
+	assert_true(AppendOnlyVisimapEntry_IsRangeVisible(visiMapEntry, 0, 100));
+	assert_false(AppendOnlyVisimapEntry_IsRangeVisible(visiMapEntry, 90, 20));
+	assert_false(AppendOnlyVisimapEntry_IsRangeVisible(visiMapEntry, 96, 5));
+	assert_true(AppendOnlyVisimapEntry_IsRangeVisible(visiMapEntry, 96, 4));
+	assert_false(AppendOnlyVisimapEntry_IsRangeVisible(visiMapEntry, 100, 1));
+
+	/* rows beyond the end of the bitmap are visible */
+	assert_true(AppendOnlyVisimapEntry_IsRangeVisible(visiMapEntry, 101, 1000));
+}
 
 int
 main(int argc, char *argv[])
@@ -82,7 +109,8 @@ main(int argc, char *argv[])
 
 	const		UnitTest tests[] = {
 		unit_test(test__AppendOnlyVisimapEntry_GetFirstRowNum),
-		unit_test(test__AppendOnlyVisimapEntry_CoversTuple)
+		unit_test(test__AppendOnlyVisimapEntry_CoversTuple),
+		unit_test(test__AppendOnlyVisimapEntry_IsRangeVisible)
 	};
 
 	MemoryContextInit();
@@ -1082,6 +1082,103 @@ heap_deformtuple(HeapTuple tuple,
 	pfree(boolNulls);
 }
 
+/*
+ * create_heaptuple_deform
+ *		Build the deforming plan of a tuple descriptor: the offsets of its
+ *		leading fixed-width attributes, as heap_fill_tuple lays them out
+ *		when none of them is null.
+ */
+HeapTupleDeform *
+create_heaptuple_deform(TupleDesc tupdesc)
+{
+	HeapTupleDeform *deform;
+	Form_pg_attribute *att = tupdesc->attrs;
+	long		off = 0;
+	int			i;
+
+	deform = (HeapTupleDeform *) palloc(sizeof(HeapTupleDeform));
+	deform->attrs = (HeapTupleDeformAttr *)
+		palloc(Max(tupdesc->natts, 1) * sizeof(HeapTupleDeformAttr));
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		if (att[i]->attlen <= 0)
+			break;
+
+		off = att_align_nominal(off, att[i]->attalign);
+		deform->attrs[i].off = off;
+		deform->attrs[i].len = att[i]->attlen;
+		deform->attrs[i].byval = att[i]->attbyval;
+		off += att[i]->attlen;
+	}
+	deform->nfixed = i;
+
+	return deform;
+}
+
+void
+destroy_heaptuple_deform(HeapTupleDeform *deform)
+{
+	pfree(deform->attrs);
+	pfree(deform);
+}
+
+/*
+ * Number of leading attributes, up to n, that are not null in the null
+ * bitmap bp.
+ */
+static inline int
+heaptuple_notnull_prefix(bits8 *bp, int n)
+{
+	int			i;
+
+	for (i = 0; i < n; i += 8)
+	{
+		if (bp[i >> 3] != 0xFF)
+		{
+			while (i < n && !att_isnull(i, bp))
+				i++;
+			return i;
+		}
+	}
+	return n;
+}
+
+/*
+ * slot_deform_fixed
+ *		Fetch the leading fixed-width attributes of the slot's tuple, up to
+ *		natts, at the offsets of the slot's deforming plan.  Stops at the
+ *		first null.  Returns the number of attributes fetched, and sets *offp
+ *		to the offset just past them.
+ */
+static inline int
+slot_deform_fixed(TupleTableSlot *slot, HeapTupleHeader tup, bool hasnulls,
+				  int natts, long *offp)
+{
+	HeapTupleDeform *deform = slot->tts_heap_deform;
+	HeapTupleDeformAttr *attrs = deform->attrs;
+	Datum	   *values = slot->PRIVATE_tts_values;
+	bool	   *isnull = slot->PRIVATE_tts_isnull;
+	char	   *tp = (char *) tup + tup->t_hoff;
+	int			n = Min(natts, deform->nfixed);
+	int			attnum;
+
+	if (hasnulls)
+		n = heaptuple_notnull_prefix(tup->t_bits, n);
+	if (n == 0)
+		return 0;
+
+	for (attnum = 0; attnum < n; attnum++)
+	{
+		values[attnum] = fetch_att(tp + attrs[attnum].off,
+								   attrs[attnum].byval, attrs[attnum].len);
+		isnull[attnum] = false;
+	}
+
+	*offp = attrs[n - 1].off + attrs[n - 1].len;
+	return n;
+}
+
 /*
  * slot_deform_tuple
  *		Given a TupleTableSlot, extract data from the slot's physical tuple
@@ -1119,6 +1216,10 @@ slot_deform_tuple(TupleTableSlot *slot, int natts)
 		/* Start from the first attribute */
 		off = 0;
 		slow = false;
+
+		/* The leading fixed-width attributes are where the plan says */
+		if (slot->tts_heap_deform)
+			attnum = slot_deform_fixed(slot, tup, hasnulls, natts, &off);
 	}
 	else
 	{
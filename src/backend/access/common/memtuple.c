@@ -961,11 +961,71 @@ MemTuple memtuple_copy_to(MemTuple mtup, MemTuple dest, uint32 *destlen)
 	return dest;
 }
 
-static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull, bool use_null_saves_aligned)
+/*
+ * Deform attributes from+1 .. natts of a memtuple into datum/isnull (0 based,
+ * like a slot's values).  Does what memtuple_getattr does for each of them,
+ * with the work that only depends on the tuple done once.  A tuple without
+ * nulls has every attribute at the offset its binding says, so then there is
+ * no null bitmap to look at, nor any null saves to subtract.
+ */
+static inline void memtuple_get_values_range(MemTuple mtup, MemTupleBinding *pbind, int from, int natts,
+											 Datum *datum, bool *isnull, bool use_null_saves_aligned)
 {
+	bool hasnull = memtuple_get_hasnull(mtup);
+	MemTupleBindingCols *colbind = memtuple_get_islarge(mtup) ? &pbind->large_bind : &pbind->bind;
+	Form_pg_attribute *attrs = pbind->tupdesc->attrs;
+	char *start;
 	int i;
-	for(i=0; i<pbind->tupdesc->natts; ++i)
-		datum[i] = memtuple_getattr_by_alignment(mtup, pbind, i+1, &isnull[i], use_null_saves_aligned);
+
+	Assert(natts <= pbind->tupdesc->natts);
+
+	if (!hasnull)
+	{
+		start = (char *) mtup;
+		for (i = from; i < natts; ++i)
+		{
+			datum[i] = fetchatt(attrs[i], memtuple_get_attr_data_ptr(start, &colbind->bindings[i], NULL, NULL));
+			isnull[i] = false;
+		}
+	}
+	else
+	{
+		unsigned char *nullp = memtuple_get_nullp(mtup, pbind);
+		short *null_saves = (use_null_saves_aligned ? colbind->null_saves_aligned : colbind->null_saves);
+
+		Assert(null_saves);
+		start = (char *) mtup + pbind->null_bitmap_extra_size;
+		for (i = from; i < natts; ++i)
+		{
+			MemTupleAttrBinding *attrbind = &colbind->bindings[i];
+
+			if (nullp[attrbind->null_byte] & attrbind->null_mask)
+			{
+				datum[i] = 0;
+				isnull[i] = true;
+				continue;
+			}
+
+			datum[i] = fetchatt(attrs[i], memtuple_get_attr_data_ptr(start, attrbind, null_saves, nullp));
+			isnull[i] = false;
+		}
+	}
+}
+
+static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull, bool use_null_saves_aligned)
+{
+	memtuple_get_values_range(mtup, pbind, 0, pbind->tupdesc->natts, datum, isnull, use_null_saves_aligned);
+}
+
+/*
+ * Deform the attributes nvalid+1 .. attnum of a memtuple, for
+ * slot_getsomeattrs.  The first nvalid are already in datum/isnull.
+ */
+void memtuple_getsomeattrs(MemTuple mtup, MemTupleBinding *pbind, int nvalid, int attnum, Datum *datum, bool *isnull)
+{
+	Assert(mtup && pbind && pbind->tupdesc);
+
+	memtuple_get_values_range(mtup, pbind, nvalid, attnum, datum, isnull, true /* aligned */);
 }
 
 void memtuple_deform(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull)
@@ -0,0 +1,229 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../heaptuple.c"
+
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/memutils.h"
+
+/*
+ * Checks slot deforming of heap tuples and memtuples against
+ * heap_deform_tuple and memtuple_getattr, on a wide row of int4, int8 and
+ * float8 columns followed by text columns.
+ */
+
+#define NFIXED 32
+#define NVAR 4
+#define NATTS (NFIXED + NVAR)
+
+static TupleDesc
+make_tupdesc(void)
+{
+	TupleDesc	tupdesc = CreateTemplateTupleDesc(NATTS, false);
+	int			i;
+
+	for (i = 0; i < NATTS; i++)
+	{
+		Form_pg_attribute att = tupdesc->attrs[i];
+
+		MemSet(att, 0, ATTRIBUTE_FIXED_PART_SIZE);
+		att->attnum = i + 1;
+		att->attcacheoff = -1;
+		att->atttypmod = -1;
+		att->attstorage = 'p';
+
+		if (i >= NFIXED)
+		{
+			att->atttypid = TEXTOID;
+			att->attlen = -1;
+			att->attalign = 'i';
+			att->attstorage = 'x';
+		}
+		else if (i % 3 == 0)
+		{
+			att->atttypid = INT4OID;
+			att->attlen = 4;
+			att->attbyval = true;
+			att->attalign = 'i';
+		}
+		else if (i % 3 == 1)
+		{
+			att->atttypid = INT8OID;
+			att->attlen = 8;
+			att->attbyval = FLOAT8PASSBYVAL;
+			att->attalign = 'd';
+		}
+		else
+		{
+			att->atttypid = FLOAT8OID;
+			att->attlen = 8;
+			att->attbyval = FLOAT8PASSBYVAL;
+			att->attalign = 'd';
+		}
+	}
+
+	return tupdesc;
+}
+
+static void
+make_values(TupleDesc tupdesc, int row, int nullpct, Datum *values, bool *isnull)
+{
+	int			i;
+
+	for (i = 0; i < NATTS; i++)
+	{
+		isnull[i] = (random() % 100) < nullpct;
+		if (isnull[i])
+		{
+			values[i] = (Datum) 0;
+			continue;
+		}
+
+		switch (tupdesc->attrs[i]->atttypid)
+		{
+			case INT4OID:
+				values[i] = Int32GetDatum(row * i);
+				break;
+			case INT8OID:
+				values[i] = Int64GetDatum((int64) row * i);
+				break;
+			case FLOAT8OID:
+				values[i] = Float8GetDatum(row / (double) (i + 1));
+				break;
+			default:
+				values[i] = CStringGetTextDatum(i % 2 ? "a" : "a longer string");
+				break;
+		}
+	}
+}
+
+static void
+check_equal(TupleDesc tupdesc, Datum *expected, bool *expected_isnull,
+			TupleTableSlot *slot)
+{
+	Datum	   *values = slot_get_values(slot);
+	bool	   *isnull = slot_get_isnull(slot);
+	int			i;
+
+	for (i = 0; i < NATTS; i++)
+	{
+		Form_pg_attribute att = tupdesc->attrs[i];
+
+		assert_int_equal(isnull[i], expected_isnull[i]);
+		if (!isnull[i])
+			assert_true(datumIsEqual(values[i], expected[i], att->attbyval, att->attlen));
+	}
+}
+
+static void
+check_deform(int ntuples, int nullpct)
+{
+	TupleDesc	tupdesc = make_tupdesc();
+	TupleTableSlot *slot = MakeSingleTupleTableSlot(tupdesc);
+	HeapTupleDeform *deform = slot->tts_heap_deform;
+	HeapTuple  *htups = palloc(ntuples * sizeof(HeapTuple));
+	MemTuple   *mtups = palloc(ntuples * sizeof(MemTuple));
+	Datum		values[NATTS];
+	bool		isnull[NATTS];
+	Datum		expected[NATTS];
+	bool		expected_isnull[NATTS];
+	int			i,
+				j;
+
+	assert_int_equal(deform->nfixed, NFIXED);
+
+	for (i = 0; i < ntuples; i++)
+	{
+		make_values(tupdesc, i, nullpct, values, isnull);
+		htups[i] = heap_form_tuple(tupdesc, values, isnull);
+		mtups[i] = memtuple_form_to(slot->tts_mt_bind, values, isnull, NULL, NULL, false);
+	}
+
+	for (i = 0; i < ntuples; i++)
+	{
+		heap_deform_tuple(htups[i], tupdesc, expected, expected_isnull);
+
+		/* Heap tuples, without the deforming plan and with it */
+		slot->tts_heap_deform = NULL;
+		ExecStoreHeapTuple(htups[i], slot, InvalidBuffer, false);
+		slot_getallattrs(slot);
+		check_equal(tupdesc, expected, expected_isnull, slot);
+
+		slot->tts_heap_deform = deform;
+		ExecStoreHeapTuple(htups[i], slot, InvalidBuffer, false);
+		slot_getallattrs(slot);
+		check_equal(tupdesc, expected, expected_isnull, slot);
+
+		/* A few at a time, the way quals fetch them */
+		ExecStoreHeapTuple(htups[i], slot, InvalidBuffer, false);
+		slot_getsomeattrs(slot, 3);
+		slot_getsomeattrs(slot, NFIXED + 1);
+		slot_getallattrs(slot);
+		check_equal(tupdesc, expected, expected_isnull, slot);
+
+		/* Memtuples, an attribute at a time and all at once */
+		for (j = 0; j < NATTS; j++)
+		{
+			Form_pg_attribute att = tupdesc->attrs[j];
+
+			values[j] = memtuple_getattr(mtups[i], slot->tts_mt_bind, j + 1, &isnull[j]);
+			assert_int_equal(isnull[j], expected_isnull[j]);
+			if (!isnull[j])
+				assert_true(datumIsEqual(values[j], expected[j], att->attbyval, att->attlen));
+		}
+
+		ExecStoreMinimalTuple(mtups[i], slot, false);
+		slot_getsomeattrs(slot, NFIXED / 2);
+		slot_getallattrs(slot);
+		check_equal(tupdesc, expected, expected_isnull, slot);
+	}
+
+	ExecClearTuple(slot);
+	for (i = 0; i < ntuples; i++)
+	{
+		pfree(htups[i]);
+		pfree(mtups[i]);
+	}
+	pfree(htups);
+	pfree(mtups);
+}
+
+void
+test__slot_deform__no_nulls(void **state)
+{
+	check_deform(1000, 0);
+}
+
+void
+test__slot_deform__nulls(void **state)
+{
+	check_deform(1000, 1);
+	check_deform(1000, 5);
+	check_deform(1000, 50);
+}
+
+void
+test__slot_deform__all_nulls(void **state)
+{
+	check_deform(100, 100);
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const		UnitTest tests[] = {
+		unit_test(test__slot_deform__no_nulls),
+		unit_test(test__slot_deform__nulls),
+		unit_test(test__slot_deform__all_nulls)
+	};
+
+	MemoryContextInit();
+	srandom(1);
+
+	return run_tests(tests);
+}
@@ -31,8 +31,10 @@
 #include "access/distributedlog.h"
 #include "access/slru.h"
 #include "access/transam.h"
+#include "access/twophase.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
+#include "storage/proc.h"
 #include "storage/shmem.h"
 #include "utils/faultinjector.h"
 #include "utils/guc.h"
@@ -77,6 +79,28 @@ static SlruCtlData DistributedLogCtlData;
 
 #define DistributedLogCtl (&DistributedLogCtlData)
 
+/*
+ * Lookups by DistributedLog_CommittedCheck(), how many of them had to wait
+ * for DistributedLogControlLock, and how many had to read the page in, under
+ * an exclusive lock.
+ */
+typedef struct DistributedLogLookupCounts
+{
+	uint64		lookups;
+	uint64		lockWaits;
+	uint64		pageReads;
+} DistributedLogLookupCounts;
+
+/*
+ * The counts of each process have a cache line of their own, so that
+ * processes counting their lookups don't invalidate each other's caches.
+ */
+typedef union DistributedLogLookupCountsPadded
+{
+	DistributedLogLookupCounts counts;
+	char		pad[PG_CACHE_LINE_SIZE];
+} DistributedLogLookupCountsPadded;
+
 typedef struct DistributedLogShmem
 {
 	/*
@@ -93,6 +117,19 @@ typedef struct DistributedLogShmem
 
 static DistributedLogShmem *DistributedLogShared = NULL;
 
+/*
+ * Lookup counts of each process, by pgprocno, in shared memory.  A process
+ * only ever updates its own, so counting doesn't contend; they are added up
+ * when reported, at checkpoints with log_checkpoints.
+ */
+static DistributedLogLookupCountsPadded *DistributedLogLookupCountsArray = NULL;
+
+/* Counts of a process that has no PGPROC, which don't get reported */
+static DistributedLogLookupCounts localLookupCounts;
+
+/* Totals reported at the last checkpoint */
+static DistributedLogLookupCounts reportedLookupCounts;
+
 static void DistributedLog_SetCommitted(TransactionId localXid,
 							DistributedTransactionTimeStamp dtxStartTime,
 							DistributedTransactionId distribXid,
@@ -102,6 +139,9 @@ static void DistributedLog_Truncate(TransactionId oldestXmin);
 static bool DistributedLog_PagePrecedes(int page1, int page2);
 static void DistributedLog_WriteZeroPageXlogRec(int page);
 static void DistributedLog_WriteTruncateXlogRec(int page);
+static DistributedLogLookupCounts *DistributedLog_MyLookupCounts(void);
+static int	DistributedLog_NumLookupCounts(void);
+static void DistributedLog_SumLookupCounts(DistributedLogLookupCounts *total);
 
 /*
  * Initialize the value for oldest local XID that might still be visible
@@ -428,8 +468,18 @@ DistributedLog_CommittedCheck(
 
 	DistributedLogEntry *ptr;
 	TransactionId oldestXmin;
+	DistributedLogLookupCounts *counts = DistributedLog_MyLookupCounts();
 
-	LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
+	counts->lookups++;
+
+	/*
+	 * Heavy concurrent scans of recently modified tables look up the same few
+	 * pages over and over, so try to find the page in a buffer under a
+	 * shared lock first, like clog does.  Only if it's not there, take the
+	 * lock exclusively to read it in.
+	 */
+	if (!LWLockAcquire(DistributedLogControlLock, LW_SHARED))
+		counts->lockWaits++;
 
 	oldestXmin = DistributedLogShared->oldestXmin;
 	if (oldestXmin == InvalidTransactionId)
@@ -444,7 +494,27 @@ DistributedLog_CommittedCheck(
 		return false;
 	}
 
-	slotno = SimpleLruReadPage(DistributedLogCtl, page, true, localXid);
+	slotno = SimpleLruLookupPage(DistributedLogCtl, page);
+	if (slotno < 0)
+	{
+		LWLockRelease(DistributedLogControlLock);
+		counts->pageReads++;
+		if (!LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE))
+			counts->lockWaits++;
+
+		/* The log may have been truncated while we didn't hold the lock. */
+		oldestXmin = DistributedLogShared->oldestXmin;
+		if (TransactionIdPrecedes(localXid, oldestXmin))
+		{
+			LWLockRelease(DistributedLogControlLock);
+
+			*distribTimeStamp = 0;	// Set it to something.
+			*distribXid = 0;
+			return false;
+		}
+
+		slotno = SimpleLruReadPage(DistributedLogCtl, page, true, localXid);
+	}
 	ptr = (DistributedLogEntry *) DistributedLogCtl->shared->page_buffer[slotno];
 	ptr += entryno;
 	*distribTimeStamp = ptr->distribTimeStamp;
@@ -474,6 +544,40 @@ DistributedLog_CommittedCheck(
 	}
 }
 
+/*
+ * The lookup counts of this process.
+ */
+static DistributedLogLookupCounts *
+DistributedLog_MyLookupCounts(void)
+{
+	if (MyProc == NULL)
+		return &localLookupCounts;
+
+	return &DistributedLogLookupCountsArray[MyProc->pgprocno].counts;
+}
+
+/*
+ * Add up the lookup counts of all processes.  They are read without a lock,
+ * as they are only statistics.
+ */
+static void
+DistributedLog_SumLookupCounts(DistributedLogLookupCounts *total)
+{
+	int			nprocs = DistributedLog_NumLookupCounts();
+	int			i;
+
+	MemSet(total, 0, sizeof(DistributedLogLookupCounts));
+	for (i = 0; i < nprocs; i++)
+	{
+		volatile DistributedLogLookupCounts *counts =
+			&DistributedLogLookupCountsArray[i].counts;
+
+		total->lookups += counts->lookups;
+		total->lockWaits += counts->lockWaits;
+		total->pageReads += counts->pageReads;
+	}
+}
+
 /*
  * Find the next lowest transaction with a logged or recorded status.
  * Currently on distributed commits are recorded.
@@ -562,10 +666,43 @@ DistributedLog_ScanForPrevCommitted(
 	return false;	// We'll never reach this.
 }
 
+/*
+ * Number of shared distributed log buffers.
+ *
+ * A distributed log page covers 32 times fewer transactions than a clog page,
+ * and on a segment every tuple whose local xid isn't yet known to be
+ * distributed-committed or local-only may need one, so scale the number of
+ * buffers with shared_buffers rather than keeping a handful of them.
+ */
+Size
+DistributedLog_ShmemBuffers(void)
+{
+	return Min(128, Max(NUM_DISTRIBUTEDLOG_BUFFERS, NBuffers / 128));
+}
+
+/*
+ * Number of processes that have lookup counts: one per PGPROC.
+ */
+static int
+DistributedLog_NumLookupCounts(void)
+{
+	return MaxBackends + NUM_AUXILIARY_PROCS + max_prepared_xacts;
+}
+
+/*
+ * The shared structure, followed by the lookup counts, with room to align
+ * them to a cache line.
+ */
 static Size
 DistributedLog_SharedShmemSize(void)
 {
-	return MAXALIGN(sizeof(DistributedLogShmem));
+	Size		size;
+
+	size = add_size(sizeof(DistributedLogShmem), PG_CACHE_LINE_SIZE);
+	size = add_size(size, mul_size(DistributedLog_NumLookupCounts(),
+								   sizeof(DistributedLogLookupCountsPadded)));
+
+	return MAXALIGN(size);
 }
 
 /*
@@ -582,7 +719,7 @@ DistributedLog_ShmemSize(void)
 	}
 	else
 	{
-		size = SimpleLruShmemSize(NUM_DISTRIBUTEDLOG_BUFFERS, 0);
+		size = SimpleLruShmemSize(DistributedLog_ShmemBuffers(), 0);
 		size += DistributedLog_SharedShmemSize();
 	}
 
@@ -593,13 +730,14 @@ void
 DistributedLog_ShmemInit(void)
 {
 	bool		found;
+	char	   *counts;
 
 	if (IS_QUERY_DISPATCHER())
 		return;
 
 	/* Set up SLRU for the distributed log. */
 	DistributedLogCtl->PagePrecedes = DistributedLog_PagePrecedes;
-	SimpleLruInit(DistributedLogCtl, "DistributedLogCtl", NUM_DISTRIBUTEDLOG_BUFFERS, 0,
+	SimpleLruInit(DistributedLogCtl, "DistributedLogCtl", DistributedLog_ShmemBuffers(), 0,
 				  DistributedLogControlLock, "pg_distributedlog");
 
 	/* Create or attach to the shared structure */
@@ -613,8 +751,13 @@ DistributedLog_ShmemInit(void)
 
 	if (!found)
 	{
+		MemSet(DistributedLogShared, 0, DistributedLog_SharedShmemSize());
 		DistributedLogShared->oldestXmin = InvalidTransactionId;
 	}
+
+	counts = (char *) DistributedLogShared + sizeof(DistributedLogShmem);
+	counts += PG_CACHE_LINE_SIZE - ((uintptr_t) counts) % PG_CACHE_LINE_SIZE;
+	DistributedLogLookupCountsArray = (DistributedLogLookupCountsPadded *) counts;
 }
 
 /*
@@ -758,6 +901,8 @@ DistributedLog_Shutdown(void)
 void
 DistributedLog_CheckPoint(void)
 {
+	DistributedLogLookupCounts total;
+
 	if (IS_QUERY_DISPATCHER())
 		return;
 
@@ -766,6 +911,18 @@ DistributedLog_CheckPoint(void)
 
 	/* Flush dirty DistributedLog pages to disk */
 	SimpleLruFlush(DistributedLogCtl, true);
+
+	if (!log_checkpoints)
+		return;
+
+	/* Report what was counted since the last checkpoint */
+	DistributedLog_SumLookupCounts(&total);
+	if (total.lookups > reportedLookupCounts.lookups)
+		elog(LOG, "distributed log: " UINT64_FORMAT " lookups, " UINT64_FORMAT " waited for the control lock, " UINT64_FORMAT " read a page in",
+			 total.lookups - reportedLookupCounts.lookups,
+			 total.lockWaits - reportedLookupCounts.lockWaits,
+			 total.pageReads - reportedLookupCounts.pageReads);
+	reportedLookupCounts = total;
 }
 
 
@@ -456,6 +456,33 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 	LWLockAcquire(shared->ControlLock, LW_SHARED);
 
 	/* See if page is already in a buffer */
+	slotno = SimpleLruLookupPage(ctl, pageno);
+	if (slotno >= 0)
+		return slotno;
+
+	/* No luck, so switch to normal exclusive lock and do regular read */
+	LWLockRelease(shared->ControlLock);
+	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+
+	return SimpleLruReadPage(ctl, pageno, true, xid);
+}
+
+/*
+ * Find a page that is already in a shared buffer, without reading it in.
+ *
+ * Return value is the shared-buffer slot number holding the page, or -1 if
+ * the page isn't in a buffer.  The buffer's LRU access info is updated.
+ *
+ * Control lock must be held at entry, in shared or exclusive mode, and will
+ * be held at exit.  This is for callers that must check some state of their
+ * own under the control lock before deciding to read the page.
+ */
+int
+SimpleLruLookupPage(SlruCtl ctl, int pageno)
+{
+	SlruShared	shared = ctl->shared;
+	int			slotno;
+
 	for (slotno = 0; slotno < shared->num_slots; slotno++)
 	{
 		if (shared->page_number[slotno] == pageno &&
@@ -468,11 +495,7 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 		}
 	}
 
-	/* No luck, so switch to normal exclusive lock and do regular read */
-	LWLockRelease(shared->ControlLock);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
-	return SimpleLruReadPage(ctl, pageno, true, xid);
+	return -1;
 }
 
 /*
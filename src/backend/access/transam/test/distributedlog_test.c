@@ -83,13 +83,195 @@ test_DistributedLog_Startup_MPP_20426(void **state)
 	MPP_20426(state, PageEntryToTransactionId(0x100, 1));
 }
 
+/*
+ * Set up a distributed log with one buffer, holding the page of localXid,
+ * in which localXid committed as distributed xid 1234.
+ */
+static void
+setup_CommittedCheck(TransactionId localXid, TransactionId oldestXmin,
+					 char *page, PGPROC *proc)
+{
+	DistributedLogEntry *entry;
+
+	DistributedLogShared = (DistributedLogShmem *)
+		calloc(1, sizeof(DistributedLogShmem));
+	DistributedLogShared->oldestXmin = oldestXmin;
+	DistributedLogLookupCountsArray = (DistributedLogLookupCountsPadded *)
+		calloc(1, sizeof(DistributedLogLookupCountsPadded));
+
+	DistributedLogCtl->shared = (SlruShared) malloc(sizeof(SlruSharedData));
+	DistributedLogCtl->shared->page_buffer = (char **) malloc(sizeof(char *));
+	DistributedLogCtl->shared->page_buffer[0] = page;
+
+	memset(page, 0, BLCKSZ);
+	entry = (DistributedLogEntry *) page + TransactionIdToEntry(localXid);
+	entry->distribTimeStamp = 1;
+	entry->distribXid = 1234;
+
+	proc->pgprocno = 0;
+	MyProc = proc;
+}
+
+static void
+teardown_CommittedCheck(void)
+{
+	free(DistributedLogCtl->shared->page_buffer);
+	free(DistributedLogCtl->shared);
+	free(DistributedLogShared);
+	DistributedLogShared = NULL;
+	free(DistributedLogLookupCountsArray);
+	DistributedLogLookupCountsArray = NULL;
+	MyProc = NULL;
+}
+
+/*
+ * A page that is in a buffer is looked up under the shared lock only.
+ */
+void
+test_DistributedLog_CommittedCheck_resident(void **state)
+{
+	TransactionId localXid = PageEntryToTransactionId(5, 10);
+	char		page[BLCKSZ];
+	PGPROC		proc;
+	DistributedTransactionTimeStamp timestamp;
+	DistributedTransactionId distribXid;
+	DistributedLogLookupCounts *counts;
+
+	setup_CommittedCheck(localXid, FirstNormalTransactionId, page, &proc);
+	counts = &DistributedLogLookupCountsArray[0].counts;
+
+	expect_value(LWLockAcquire, lockid, DistributedLogControlLock);
+	expect_value(LWLockAcquire, mode, LW_SHARED);
+	will_return(LWLockAcquire, true);
+
+	expect_value(SimpleLruLookupPage, ctl, DistributedLogCtl);
+	expect_value(SimpleLruLookupPage, pageno, 5);
+	will_return(SimpleLruLookupPage, 0);
+
+	expect_value(LWLockRelease, lockid, DistributedLogControlLock);
+	will_be_called(LWLockRelease);
+
+	assert_true(DistributedLog_CommittedCheck(localXid, &timestamp, &distribXid));
+	assert_int_equal(timestamp, 1);
+	assert_int_equal(distribXid, 1234);
+
+	assert_int_equal(counts->lookups, 1);
+	assert_int_equal(counts->lockWaits, 0);
+	assert_int_equal(counts->pageReads, 0);
+
+	teardown_CommittedCheck();
+}
+
+/*
+ * A page that is not in a buffer is read in under the exclusive lock, and
+ * the waits for the lock are counted.
+ */
+void
+test_DistributedLog_CommittedCheck_read(void **state)
+{
+	TransactionId localXid = PageEntryToTransactionId(5, 10);
+	char		page[BLCKSZ];
+	PGPROC		proc;
+	DistributedTransactionTimeStamp timestamp;
+	DistributedTransactionId distribXid;
+	DistributedLogLookupCounts *counts;
+
+	setup_CommittedCheck(localXid, FirstNormalTransactionId, page, &proc);
+	counts = &DistributedLogLookupCountsArray[0].counts;
+
+	expect_value(LWLockAcquire, lockid, DistributedLogControlLock);
+	expect_value(LWLockAcquire, mode, LW_SHARED);
+	will_return(LWLockAcquire, false);
+
+	expect_value(SimpleLruLookupPage, ctl, DistributedLogCtl);
+	expect_value(SimpleLruLookupPage, pageno, 5);
+	will_return(SimpleLruLookupPage, -1);
+
+	expect_value(LWLockRelease, lockid, DistributedLogControlLock);
+	will_be_called(LWLockRelease);
+
+	expect_value(LWLockAcquire, lockid, DistributedLogControlLock);
+	expect_value(LWLockAcquire, mode, LW_EXCLUSIVE);
+	will_return(LWLockAcquire, true);
+
+	expect_value(SimpleLruReadPage, ctl, DistributedLogCtl);
+	expect_value(SimpleLruReadPage, pageno, 5);
+	expect_any(SimpleLruReadPage, write_ok);
+	expect_value(SimpleLruReadPage, xid, localXid);
+	will_return(SimpleLruReadPage, 0);
+
+	expect_value(LWLockRelease, lockid, DistributedLogControlLock);
+	will_be_called(LWLockRelease);
+
+	assert_true(DistributedLog_CommittedCheck(localXid, &timestamp, &distribXid));
+	assert_int_equal(timestamp, 1);
+	assert_int_equal(distribXid, 1234);
+
+	assert_int_equal(counts->lookups, 1);
+	assert_int_equal(counts->lockWaits, 1);
+	assert_int_equal(counts->pageReads, 1);
+
+	teardown_CommittedCheck();
+}
+
+static void
+truncate_distributed_log(void *data)
+{
+	DistributedLogShared->oldestXmin = *(TransactionId *) data;
+}
+
+/*
+ * The log is truncated past the xid while the lock is let go of to read the
+ * page in: the page is not read.
+ */
+void
+test_DistributedLog_CommittedCheck_truncated(void **state)
+{
+	TransactionId localXid = PageEntryToTransactionId(5, 10);
+	TransactionId newOldestXmin = PageEntryToTransactionId(6, 0);
+	char		page[BLCKSZ];
+	PGPROC		proc;
+	DistributedTransactionTimeStamp timestamp;
+	DistributedTransactionId distribXid;
+
+	setup_CommittedCheck(localXid, FirstNormalTransactionId, page, &proc);
+
+	expect_value(LWLockAcquire, lockid, DistributedLogControlLock);
+	expect_value(LWLockAcquire, mode, LW_SHARED);
+	will_return(LWLockAcquire, true);
+
+	expect_value(SimpleLruLookupPage, ctl, DistributedLogCtl);
+	expect_value(SimpleLruLookupPage, pageno, 5);
+	will_return(SimpleLruLookupPage, -1);
+
+	expect_value(LWLockRelease, lockid, DistributedLogControlLock);
+	will_be_called(LWLockRelease);
+
+	expect_value(LWLockAcquire, lockid, DistributedLogControlLock);
+	expect_value(LWLockAcquire, mode, LW_EXCLUSIVE);
+	will_return_with_sideeffect(LWLockAcquire, true,
+								truncate_distributed_log, &newOldestXmin);
+
+	expect_value(LWLockRelease, lockid, DistributedLogControlLock);
+	will_be_called(LWLockRelease);
+
+	assert_false(DistributedLog_CommittedCheck(localXid, &timestamp, &distribXid));
+	assert_int_equal(timestamp, 0);
+	assert_int_equal(distribXid, 0);
+
+	teardown_CommittedCheck();
+}
+
 int
 main(int argc, char* argv[])
 {
 	cmockery_parse_arguments(argc, argv);
 
 	const UnitTest tests[] = {
-		unit_test(test_DistributedLog_Startup_MPP_20426)
+		unit_test(test_DistributedLog_Startup_MPP_20426),
+		unit_test(test_DistributedLog_CommittedCheck_resident),
+		unit_test(test_DistributedLog_CommittedCheck_read),
+		unit_test(test_DistributedLog_CommittedCheck_truncated)
 	};
 	return run_tests(tests);
 }
@@ -72,6 +72,7 @@
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h" /* Gp_role, Gp_is_writer, interconnect_setup_timeout */
 #include "utils/vmem_tracker.h"
+#include "utils/workfile_mgr.h"
 #include "cdb/cdbdisp.h"
 
 /*
@@ -1195,7 +1196,9 @@ RecordTransactionCommit(void)
 	bool		RelcacheInitFileInval = false;
 	bool		wrote_xlog;
 	bool		isDtxPrepared = 0;
+	bool		isOnePhaseDtx;
 	TMGXACT_LOG gxact_log;
+	xl_xact_one_phase_distrib one_phase_distrib;
 	XLogRecPtr	recptr = {0,0};
 
 	/* Like in CommitTransaction(), treat a QE reader as if there was no XID */
@@ -1218,6 +1221,14 @@ RecordTransactionCommit(void)
 
 	isDtxPrepared = isPreparedDtxTransaction();
 
+	/*
+	 * A segment told to commit a distributed transaction in one phase must
+	 * record the distributed xid with its commit, as COMMIT PREPARED would.
+	 */
+	isOnePhaseDtx = markXidCommitted &&
+		getOnePhaseDtxCommitInfo(&one_phase_distrib.distribTimeStamp,
+								 &one_phase_distrib.distribXid);
+
 	/*
 	 * If we haven't been assigned an XID yet, we neither can, nor do we want
 	 * to write a COMMIT record.
@@ -1303,7 +1314,7 @@ RecordTransactionCommit(void)
 		// compact" WAL records when in distributed transactions. Can
 		// we use the compact one for non-DDL transactions?
 		if (nrels > 0 || nmsgs > 0 || RelcacheInitFileInval || forceSyncCommit
-				|| isDtxPrepared)
+				|| isDtxPrepared || isOnePhaseDtx)
 		{
 			XLogRecData rdata[5];
 			int			lastrdata = 0;
@@ -1317,6 +1328,8 @@ RecordTransactionCommit(void)
 				xlrec.xinfo |= XACT_COMPLETION_UPDATE_RELCACHE_FILE;
 			if (forceSyncCommit)
 				xlrec.xinfo |= XACT_COMPLETION_FORCE_SYNC_COMMIT;
+			if (isOnePhaseDtx)
+				xlrec.xinfo |= XACT_COMPLETION_ONE_PHASE_DISTRIBUTED;
 
 			xlrec.dbId = MyDatabaseId;
 			xlrec.tsId = MyDatabaseTableSpace;
@@ -1383,6 +1396,15 @@ RecordTransactionCommit(void)
 			}
 			else
 			{
+				if (isOnePhaseDtx)
+				{
+					rdata[lastrdata].next = &(rdata[4]);
+					rdata[4].data = (char *) &one_phase_distrib;
+					rdata[4].len = sizeof(one_phase_distrib);
+					rdata[4].buffer = InvalidBuffer;
+					rdata[4].next = NULL;
+				}
+
 				recptr = XLogInsert(RM_XACT_ID, XLOG_XACT_COMMIT, rdata);
 			}
 
@@ -1442,12 +1464,20 @@ RecordTransactionCommit(void)
 		 *
 		 * We do not sleep if enableFsync is not turned on, nor if there are
 		 * fewer than CommitSiblings other backends with active transactions.
+		 *
+		 * The DTM flushes distributed commit records itself, so that it can
+		 * group them.
 		 */
-		if (CommitDelay > 0 && enableFsync &&
-			MinimumActiveBackends(CommitSiblings))
-			pg_usleep(CommitDelay);
+		if (isDtxPrepared)
+			flushDistributedCommitted(recptr);
+		else
+		{
+			if (CommitDelay > 0 && enableFsync &&
+				MinimumActiveBackends(CommitSiblings))
+				pg_usleep(CommitDelay);
 
-		XLogFlush(recptr);
+			XLogFlush(recptr);
+		}
 
 #ifdef FAULT_INJECTOR
 		if (isDtxPrepared == 0 &&
@@ -1484,6 +1514,11 @@ RecordTransactionCommit(void)
 												getDtxStartTime(),
 												getDistributedTransactionId(),
 												/* isRedo */ false);
+			else if (isOnePhaseDtx)
+				DistributedLog_SetCommittedTree(xid, nchildren, children,
+												one_phase_distrib.distribTimeStamp,
+												one_phase_distrib.distribXid,
+												/* isRedo */ false);
 
 			TransactionIdCommitTree(xid, nchildren, children);
 		}
@@ -2932,6 +2967,7 @@ PrepareTransaction(void)
 	AtPrepare_PgStat();
 	AtPrepare_MultiXact();
 	AtPrepare_RelationMap();
+	AtPrepare_WorkfileReuse();
 
 	/*
 	 * Here is where we really truly prepare.
@@ -5877,6 +5913,22 @@ xact_redo_commit_internal(TransactionId xid, XLogRecPtr lsn,
 
 }
 
+/*
+ * Return the end of the regular commit information in xlrec, where any
+ * distributed transaction information follows.
+ */
+static char *
+xact_commit_trailer(xl_xact_commit *xlrec)
+{
+	TransactionId *subxacts;
+	SharedInvalidationMessage *inval_msgs;
+
+	subxacts = (TransactionId *) &(xlrec->xnodes[xlrec->nrels]);
+	inval_msgs = (SharedInvalidationMessage *) &(subxacts[xlrec->nsubxacts]);
+
+	return (char *) &inval_msgs[xlrec->nmsgs];
+}
+
 /*
  * Utility function to call xact_redo_commit_internal after breaking down xlrec
  */
@@ -6127,8 +6179,16 @@ xact_redo(XLogRecPtr beginLoc __attribute__((unused)), XLogRecPtr lsn __attribut
 	else if (info == XLOG_XACT_COMMIT)
 	{
 		xl_xact_commit *xlrec = (xl_xact_commit *) XLogRecGetData(record);
+		xl_xact_one_phase_distrib distrib;
 
-		xact_redo_commit(xlrec, record->xl_xid, lsn, 0, 0);
+		if (XactCompletionOnePhaseDistributed(xlrec->xinfo))
+		{
+			memcpy(&distrib, xact_commit_trailer(xlrec), sizeof(distrib));
+			xact_redo_commit(xlrec, record->xl_xid, lsn,
+							 distrib.distribXid, distrib.distribTimeStamp);
+		}
+		else
+			xact_redo_commit(xlrec, record->xl_xid, lsn, 0, 0);
 	}
 	else if (info == XLOG_XACT_ABORT)
 	{
@@ -6236,6 +6296,15 @@ xact_desc_commit(StringInfo buf, xl_xact_commit *xlrec)
 		}
 	}
 
+	if (XactCompletionOnePhaseDistributed(xlrec->xinfo))
+	{
+		xl_xact_one_phase_distrib distrib;
+
+		memcpy(&distrib, &msgs[xlrec->nmsgs], sizeof(distrib));
+		appendStringInfo(buf, "; one-phase distributed xid %u (timestamp %u)",
+						 distrib.distribXid, distrib.distribTimeStamp);
+	}
+
 	/*
 -	 * MPP: Return end of regular commit information.
 	 */
@@ -2241,9 +2241,22 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
  */
 void
 XLogFlush(XLogRecPtr record)
+{
+	(void) XLogFlushTracked(record);
+}
+
+/*
+ * Like XLogFlush, but tell whether we did the flush.
+ *
+ * Returns true if we did the flush, false if it was done already, or someone
+ * else did it for us.
+ */
+bool
+XLogFlushTracked(XLogRecPtr record)
 {
 	XLogRecPtr	WriteRqstPtr;
 	XLogwrtRqst WriteRqst;
+	bool		flushed = false;
 
 	/*
 	 * During REDO, we are reading not writing WAL.  Therefore, instead of
@@ -2255,12 +2268,12 @@ XLogFlush(XLogRecPtr record)
 	if (!XLogInsertAllowed())
 	{
 		UpdateMinRecoveryPoint(record, false);
-		return;
+		return false;
 	}
 
 	/* Quick exit if already known flushed */
 	if (XLByteLE(record, LogwrtResult.Flush))
-		return;
+		return false;
 
 #ifdef WAL_DEBUG
 	if (XLOG_DEBUG)
@@ -2346,6 +2359,7 @@ XLogFlush(XLogRecPtr record)
 				WriteRqst.Flush = record;
 			}
 			XLogWrite(WriteRqst, false, false);
+			flushed = true;
 		}
 		LWLockRelease(WALWriteLock);
 		/* done */
@@ -2380,6 +2394,8 @@ XLogFlush(XLogRecPtr record)
 		"xlog flush request %X/%X is not satisfied --- flushed only to %X/%X",
 			 record.xlogid, record.xrecoff,
 			 LogwrtResult.Flush.xlogid, LogwrtResult.Flush.xrecoff);
+
+	return flushed;
 }
 
 /*
@@ -8718,6 +8734,9 @@ LogCheckpointEnd(bool restartpoint)
 			 CheckpointStats.ckpt_sync_rels,
 			 longest_secs, longest_usecs / 1000,
 			 average_secs, average_usecs / 1000);
+
+	if (!restartpoint)
+		logDistributedCommitFlushStats();
 }
 
 /*
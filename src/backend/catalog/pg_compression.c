@@ -220,6 +220,52 @@ callCompressionValidator(PGFunction func, char *comptype, int32 complevel,
 	(void)DirectFunctionCall1(func, PointerGetDatum(&sa));
 }
 
+/*
+ * zlib's compress2() and uncompress() only use malloc() internally, so they
+ * can safely be called from a helper thread. See CompressionState.
+ */
+static bool
+zlib_threadsafe_compress(CompressionState *cs, const void *src, int32 src_sz,
+						 void *dst, int32 dst_sz, int32 *dst_used)
+{
+	zlib_state	   *state = (zlib_state *) cs->opaque;
+	unsigned long	amount_available_used = dst_sz;
+
+	switch (state->compress_fn(dst, &amount_available_used,
+							   src, src_sz, state->level))
+	{
+		case Z_OK:
+			*dst_used = amount_available_used;
+			return true;
+
+		case Z_BUF_ERROR:
+			/* couldn't compress to less than the input, see zlib_compress */
+			*dst_used = src_sz;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+static bool
+zlib_threadsafe_decompress(CompressionState *cs, const void *src, int32 src_sz,
+						   void *dst, int32 dst_sz, int32 *dst_used)
+{
+	zlib_state	   *state = (zlib_state *) cs->opaque;
+	unsigned long	amount_available_used = dst_sz;
+
+	if (src_sz <= 0 || dst_sz <= 0)
+		return false;
+
+	if (state->decompress_fn(dst, &amount_available_used,
+							 (const Bytef *) src, src_sz) != Z_OK)
+		return false;
+
+	*dst_used = amount_available_used;
+	return true;
+}
+
 Datum
 zlib_constructor(PG_FUNCTION_ARGS)
 {
@@ -245,6 +291,11 @@ zlib_constructor(PG_FUNCTION_ARGS)
 	state->compress_fn = compress2;
 	state->decompress_fn = uncompress;
 
+	if (compress)
+		cs->threadsafe_compress = zlib_threadsafe_compress;
+	else
+		cs->threadsafe_decompress = zlib_threadsafe_decompress;
+
 	PG_RETURN_POINTER(cs);
 
 }
@@ -467,7 +518,7 @@ compresstype_is_valid(char *comptype)
 	 * must change!
 	 */
 	static const char *const valid_comptypes[] =
-			{"quicklz", "zlib", "rle_type", "none", "zstd"};
+			{"quicklz", "zlib", "rle_type", "none", "zstd", "lz4"};
 	for (i = 0; !found && i < ARRAY_SIZE(valid_comptypes); ++i)
 	{
 		if (pg_strcasecmp(valid_comptypes[i], comptype) == 0)
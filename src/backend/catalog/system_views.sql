@@ -652,6 +652,15 @@ CREATE VIEW gp_stat_replication AS
          ON G.gp_segment_id = R.gp_segment_id
     );
 
+CREATE VIEW gp_fts_probe_stats AS
+    SELECT * FROM pg_catalog.gp_get_fts_probe_stats();
+
+CREATE VIEW gp_session_gang_stats AS
+    SELECT * FROM pg_catalog.gp_get_session_gang_stats();
+
+CREATE VIEW gp_dtx_group_commit_stats AS
+    SELECT * FROM pg_catalog.gp_get_dtx_group_commit_stats();
+
 CREATE VIEW pg_stat_database AS
     SELECT
             D.oid AS datid,
@@ -29,6 +29,48 @@ typedef struct zstd_state
 	ZSTD_DCtx  *zstd_decompress_context;	/* ZSTD decompression context */
 } zstd_state;
 
+/*
+ * Compress and decompress using the state's contexts, without touching any
+ * backend facilities. See CompressionState.
+ */
+static bool
+zstd_threadsafe_compress(CompressionState *cs, const void *src, int32 src_sz,
+						 void *dst, int32 dst_sz, int32 *dst_used)
+{
+	zstd_state *state = (zstd_state *) cs->opaque;
+	size_t		dst_length_used;
+
+	dst_length_used = ZSTD_compressCCtx(state->zstd_compress_context,
+										dst, dst_sz,
+										src, src_sz,
+										state->level);
+	if (ZSTD_isError(dst_length_used))
+		return false;
+
+	*dst_used = (int32) dst_length_used;
+	return true;
+}
+
+static bool
+zstd_threadsafe_decompress(CompressionState *cs, const void *src, int32 src_sz,
+						   void *dst, int32 dst_sz, int32 *dst_used)
+{
+	zstd_state *state = (zstd_state *) cs->opaque;
+	size_t		dst_length_used;
+
+	if (src_sz <= 0 || dst_sz <= 0)
+		return false;
+
+	dst_length_used = ZSTD_decompressDCtx(state->zstd_decompress_context,
+										  dst, dst_sz,
+										  src, src_sz);
+	if (ZSTD_isError(dst_length_used))
+		return false;
+
+	*dst_used = (int32) dst_length_used;
+	return true;
+}
+
 Datum
 zstd_constructor(PG_FUNCTION_ARGS)
 {
@@ -53,6 +95,11 @@ zstd_constructor(PG_FUNCTION_ARGS)
 	state->zstd_compress_context = ZSTD_createCCtx();
 	state->zstd_decompress_context = ZSTD_createDCtx();
 
+	if (compress)
+		cs->threadsafe_compress = zstd_threadsafe_compress;
+	else
+		cs->threadsafe_decompress = zstd_threadsafe_decompress;
+
 	PG_RETURN_POINTER(cs);
 }
 
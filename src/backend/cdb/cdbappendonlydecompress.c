@@ -0,0 +1,247 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbappendonlydecompress.c
+ *	  Compression and decompression of append-only storage blocks on helper
+ *	  threads.
+ *
+ * A scan of a column-oriented table decompresses one block per projected
+ * column every time the columns run out of rows, and a bulk insert fills
+ * the blocks of many columns in one go; the blocks of different columns are
+ * independent of each other. This module lets the scan or insert hand a
+ * batch of blocks to a small pool of helper threads and (de)compress them in
+ * parallel.
+ *
+ * The helper threads run nothing but the CompressionState's
+ * threadsafe_compress and threadsafe_decompress callbacks on buffers that
+ * the backend prepared: they never allocate backend memory, elog, or look at
+ * catalogs. Any failure is only recorded in the task, and the backend redoes
+ * the work through the regular path to report the error with the usual
+ * context.
+ *
+ * The pool is created lazily by the first scan that asks for helpers, and
+ * lives until the backend exits. Threads are only added, never removed, so
+ * there is nothing to clean up on transaction abort; idle threads sleep on a
+ * condition variable. The backend always takes part in decompressing the
+ * batch itself, and does not return until every task in it is done, so no
+ * helper touches a task after AppendOnlyDecompress_Run returns.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbappendonlydecompress.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <pthread.h>
+
+#include "cdb/cdbappendonlydecompress.h"
+#include "cdb/cdbgang.h"
+#include "miscadmin.h"
+#include "utils/guc.h"
+#include "utils/resgroup.h"
+#include "utils/resource_manager.h"
+
+/*
+ * State shared with the helper threads, protected by pool_mutex.
+ *
+ * Every call to AppendOnlyDecompress_Run publishes a new batch by bumping
+ * batch_generation. Helpers claim tasks by advancing batch_next_task, and at most
+ * batch_max_helpers of them join a batch.
+ */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work_cv = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done_cv = PTHREAD_COND_INITIALIZER;
+
+/* Only touched by the backend */
+static pthread_t pool_threads[MAX_AOCS_DECOMPRESS_THREADS];
+static int	pool_num_threads = 0;
+
+static AppendOnlyDecompressTask *batch_tasks = NULL;
+static int	batch_num_tasks = 0;
+static int	batch_next_task = 0;
+static int	batch_tasks_done = 0;
+static int	batch_max_helpers = 0;
+static int	batch_active_helpers = 0;
+static uint64 batch_generation = 0;
+
+static void
+run_task(AppendOnlyDecompressTask *task)
+{
+	CompressionState *cs = task->compressionState;
+
+	task->resultLen = 0;
+	if (task->compress)
+	{
+		task->succeeded = cs->threadsafe_compress(cs,
+												  task->uncompressed,
+												  task->uncompressedLen,
+												  task->compressed,
+												  task->compressedLen,
+												  &task->resultLen);
+	}
+	else
+	{
+		task->succeeded = cs->threadsafe_decompress(cs,
+													task->compressed,
+													task->compressedLen,
+													task->uncompressed,
+													task->uncompressedLen,
+													&task->resultLen);
+		if (task->resultLen != task->uncompressedLen)
+			task->succeeded = false;
+	}
+}
+
+/*
+ * Claim and run tasks of the current batch until there are none left.
+ *
+ * Called with pool_mutex held, returns with it held.
+ */
+static void
+work_on_batch(void)
+{
+	while (batch_next_task < batch_num_tasks)
+	{
+		AppendOnlyDecompressTask *task = &batch_tasks[batch_next_task++];
+
+		pthread_mutex_unlock(&pool_mutex);
+		run_task(task);
+		pthread_mutex_lock(&pool_mutex);
+
+		if (++batch_tasks_done == batch_num_tasks)
+			pthread_cond_signal(&pool_done_cv);
+	}
+}
+
+static void *
+decompress_thread_main(void *arg)
+{
+	uint64		seen_generation;
+
+	gp_set_thread_sigmasks();
+
+	pthread_mutex_lock(&pool_mutex);
+	seen_generation = batch_generation;
+	for (;;)
+	{
+		while (seen_generation == batch_generation)
+			pthread_cond_wait(&pool_work_cv, &pool_mutex);
+		seen_generation = batch_generation;
+
+		if (batch_active_helpers >= batch_max_helpers)
+			continue;
+
+		batch_active_helpers++;
+		work_on_batch();
+		batch_active_helpers--;
+	}
+
+	/* not reached */
+	pthread_mutex_unlock(&pool_mutex);
+	return NULL;
+}
+
+/*
+ * Make sure the pool has at least numThreads threads. Returns the number of
+ * threads actually available, which is less if thread creation fails.
+ */
+static int
+grow_pool(int numThreads)
+{
+	numThreads = Min(numThreads, MAX_AOCS_DECOMPRESS_THREADS);
+
+	while (pool_num_threads < numThreads)
+	{
+		int			pthread_err;
+
+		pthread_err = gp_pthread_create(&pool_threads[pool_num_threads],
+										decompress_thread_main, NULL,
+										"grow_pool");
+		if (pthread_err != 0)
+		{
+			elog(LOG, "could not create AOCS compression thread: error code %d",
+				 pthread_err);
+			break;
+		}
+
+		pool_num_threads++;
+	}
+
+	return Min(pool_num_threads, numThreads);
+}
+
+/*
+ * Number of helper threads a scan or insert over numColumns compressed
+ * columns should use, given the GUC limit maxThreads, or 0 to do all the
+ * work serially.
+ *
+ * The backend handles one of the blocks itself, so there's no point in more
+ * than numColumns - 1 helpers. When the query runs in a resource group, the
+ * helpers plus the backend are kept within the group's CPU cores.
+ */
+int
+AppendOnlyDecompress_NumThreads(int maxThreads, int numColumns)
+{
+	int			numThreads = maxThreads;
+
+	if (numThreads <= 0 || numColumns < 2)
+		return 0;
+
+	numThreads = Min(numThreads, numColumns - 1);
+
+	if (IsResGroupActivated() && ResGroupIsAssigned())
+		numThreads = Min(numThreads, ResGroupGetCpuCoreLimit() - 1);
+
+	return Max(numThreads, 0);
+}
+
+/*
+ * Run all the given tasks, using up to numThreads helper threads in
+ * addition to the calling backend. Returns once all tasks are done; check
+ * each task's 'succeeded' flag for the outcome.
+ */
+void
+AppendOnlyDecompress_Run(AppendOnlyDecompressTask *tasks, int numTasks,
+						 int numThreads)
+{
+	int			i;
+
+	if (numTasks <= 0)
+		return;
+
+	if (numThreads > 0 && numTasks > 1)
+		numThreads = grow_pool(Min(numThreads, numTasks - 1));
+	else
+		numThreads = 0;
+
+	if (numThreads == 0)
+	{
+		for (i = 0; i < numTasks; i++)
+			run_task(&tasks[i]);
+		return;
+	}
+
+	pthread_mutex_lock(&pool_mutex);
+
+	batch_tasks = tasks;
+	batch_num_tasks = numTasks;
+	batch_next_task = 0;
+	batch_tasks_done = 0;
+	batch_max_helpers = numThreads;
+	batch_generation++;
+	pthread_cond_broadcast(&pool_work_cv);
+
+	work_on_batch();
+
+	while (batch_tasks_done < batch_num_tasks)
+		pthread_cond_wait(&pool_done_cv, &pool_mutex);
+
+	batch_tasks = NULL;
+	batch_num_tasks = 0;
+	batch_next_task = 0;
+
+	pthread_mutex_unlock(&pool_mutex);
+}
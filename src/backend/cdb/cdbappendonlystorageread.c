@@ -1441,6 +1441,139 @@ AppendOnlyStorageRead_Content(AppendOnlyStorageRead *storageRead,
 	}
 }
 
+/*
+ * Set up a task to decompress the *small* compressed content of the current
+ * block outside of the backend, see cdbappendonlydecompress.c.
+ *
+ * Returns false, without doing anything, if the current block can't be
+ * handled that way: large or non-compressed content, or a compression type
+ * without a thread-safe decompressor. The caller should then use ~_Content
+ * as usual.
+ *
+ * Otherwise, the block is verified and pinned in the read buffer, and the
+ * task must be run and passed to ~_FinishDecompress before anything else is
+ * done with this storageRead.
+ *
+ * contentOut	- memory to receive the contiguous content.
+ * contentOutLen - byte length of the contentOut buffer.
+ */
+bool
+AppendOnlyStorageRead_PrepareDecompress(AppendOnlyStorageRead *storageRead,
+										uint8 *contentOut,
+										int32 contentOutLen,
+										AppendOnlyDecompressTask *task)
+{
+	uint8	   *header;
+	uint8	   *content;
+
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+	Assert(contentOutLen == storageRead->current.uncompressedLen);
+
+	if (storageRead->current.isLarge ||
+		!storageRead->current.isCompressed ||
+		storageRead->compressionState == NULL ||
+		storageRead->compressionState->threadsafe_decompress == NULL)
+		return false;
+
+	AppendOnlyStorageRead_InternalGetBuffer(storageRead,
+											&header,
+											&content);
+
+	task->compress = false;
+	task->compressed = content;
+	task->compressedLen = storageRead->current.compressedLen;
+	task->uncompressed = contentOut;
+	task->uncompressedLen = contentOutLen;
+	task->compressionState = storageRead->compressionState;
+	task->resultLen = 0;
+	task->succeeded = false;
+
+	return true;
+}
+
+/*
+ * Finish a block set up with ~_PrepareDecompress, after the task has run.
+ *
+ * The helper threads can't report errors, so if decompression failed, do it
+ * again the regular way, which raises the appropriate error.
+ */
+void
+AppendOnlyStorageRead_FinishDecompress(AppendOnlyStorageRead *storageRead,
+									   AppendOnlyDecompressTask *task)
+{
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+
+	if (!task->succeeded)
+	{
+		PGFunction *cfns = storageRead->compression_functions;
+
+		if (cfns == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("decompression information missing")));
+
+		gp_decompress(task->compressed,
+					  task->compressedLen,
+					  task->uncompressed,
+					  task->uncompressedLen,
+					  cfns[COMPRESSION_DECOMPRESS],
+					  storageRead->compressionState,
+					  storageRead->bufferCount);
+	}
+
+	if (Debug_appendonly_print_scan)
+		elog(LOG,
+			 "Append-only Storage Read decompressed block for table '%s' "
+			 "(compressed length %d, uncompressed length = %d, segment file '%s', "
+			 "header offset in file = " INT64_FORMAT ", block count " INT64_FORMAT ", "
+			 "%s)",
+			 storageRead->relationName,
+			 task->compressedLen,
+			 task->uncompressedLen,
+			 storageRead->segmentFileName,
+			 storageRead->current.headerOffsetInFile,
+			 storageRead->bufferCount,
+			 task->succeeded ? "in helper thread" : "retried in backend");
+}
+
+/*
+ * Get a pointer to the *small* content of the current block as it is
+ * stored, without decompressing it, so that the block can be copied to
+ * another segment file with AppendOnlyStorageWrite_StoredContent.
+ *
+ * Returns the header kind of the block in *headerKind, and the length of
+ * the compressed content in *compressedLen, or 0 if the content is stored
+ * non-compressed (then it is as long as the contentLen from ~_GetBlockInfo).
+ *
+ * Like ~_GetBuffer, this consumes the current block.
+ */
+uint8 *
+AppendOnlyStorageRead_GetStoredContent(AppendOnlyStorageRead *storageRead,
+									   int *headerKind,
+									   int32 *compressedLen)
+{
+	uint8	   *header;
+	uint8	   *content;
+
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+	Assert(!storageRead->current.isLarge);
+
+	AppendOnlyStorageRead_InternalGetBuffer(storageRead,
+											&header,
+											&content);
+
+	*headerKind = storageRead->current.headerKind;
+	if (storageRead->current.isCompressed)
+		*compressedLen = storageRead->current.compressedLen;
+	else
+		*compressedLen = 0;
+
+	return content;
+}
+
 /*
  * Skip the current block found with ~_GetBlockInfo.
  *
@@ -1141,6 +1141,7 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 									  int32 sourceLen,
 									  int executorBlockKind,
 									  int itemCount,
+									  AppendOnlyDecompressTask *task,
 									  int32 *compressedLen,
 									  int32 *bufferLen)
 {
@@ -1176,14 +1177,24 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 	/*
 	 * Compress into the BufferedAppend buffer after the large header (and
 	 * optional checksum, etc.
+	 *
+	 * If a helper thread already did that (see ~_PrepareCompress), use its
+	 * result, unless it failed: then compress again here to get the error
+	 * reported.
 	 */
-	gp_trycompress(sourceData,
-					sourceLen,
-					dataBuffer,
-					dataBufferWithOverrrunLen,
-					compressedLen,
-					compressor,
-					storageWrite->compressionState);
+	if (task != NULL && task->succeeded)
+	{
+		Assert(task->compressed == dataBuffer);
+		*compressedLen = task->resultLen;
+	}
+	else
+		gp_trycompress(sourceData,
+					   sourceLen,
+					   dataBuffer,
+					   dataBufferWithOverrrunLen,
+					   compressedLen,
+					   compressor,
+					   storageWrite->compressionState);
 
 #ifdef FAULT_INJECTOR
 	/* Simulate that compression is not possible if the fault is set. */
@@ -1287,34 +1298,12 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 }
 
 /*
- * Mark the current buffer "small" buffer as finished.
- *
- * If compression is configured, we will try to compress the contents in
- * the temporary uncompressed buffer into the write buffer.
- *
- * The buffer can be scheduled for writing and reused.
- *
- * contentLen		- byte length of the content generated directly into the
- *					  buffer returned by AppendOnlyStorageWrite_GetBuffer.
- * executorBlockKind - A value defined externally by the executor that
- *					   describes in content stored in the Append-Only Storage
- *					   Block.
- * rowCount			-  number of rows stored in the content.
+ * Error out if the content doesn't fit in the current buffer.
  */
-void
-AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
-									int32 contentLen,
-									int executorBlockKind,
-									int rowCount)
+static void
+AppendOnlyStorageWrite_CheckContentLen(AppendOnlyStorageWrite *storageWrite,
+									   int32 contentLen)
 {
-	int64		headerOffsetInFile;
-	int32		bufferLen;
-
-	Assert(storageWrite != NULL);
-	Assert(storageWrite->isActive);
-
-	Assert(storageWrite->currentCompleteHeaderLen > 0);
-
 	if (contentLen >
 		storageWrite->maxBufferLen - storageWrite->currentCompleteHeaderLen)
 		elog(ERROR,
@@ -1325,6 +1314,24 @@ AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
 			 storageWrite->maxBufferLen,
 			 storageWrite->currentCompleteHeaderLen,
 			 (storageWrite->isFirstRowNumSet ? "true" : "false"));
+}
+
+static void
+AppendOnlyStorageWrite_DoFinishBuffer(AppendOnlyStorageWrite *storageWrite,
+									  int32 contentLen,
+									  int executorBlockKind,
+									  int rowCount,
+									  AppendOnlyDecompressTask *task)
+{
+	int64		headerOffsetInFile;
+	int32		bufferLen;
+
+	Assert(storageWrite != NULL);
+	Assert(storageWrite->isActive);
+
+	Assert(storageWrite->currentCompleteHeaderLen > 0);
+
+	AppendOnlyStorageWrite_CheckContentLen(storageWrite, contentLen);
 
 
 	headerOffsetInFile = BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend);
@@ -1439,6 +1446,7 @@ AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
 											  contentLen,
 											  executorBlockKind,
 											  rowCount,
+											  task,
 											  &compressedLen,
 											  &bufferLen);
 
@@ -1472,6 +1480,243 @@ AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
 	storageWrite->isFirstRowNumSet = false;
 }
 
+/*
+ * Mark the current buffer "small" buffer as finished.
+ *
+ * If compression is configured, we will try to compress the contents in
+ * the temporary uncompressed buffer into the write buffer.
+ *
+ * The buffer can be scheduled for writing and reused.
+ *
+ * contentLen		- byte length of the content generated directly into the
+ *					  buffer returned by AppendOnlyStorageWrite_GetBuffer.
+ * executorBlockKind - A value defined externally by the executor that
+ *					   describes in content stored in the Append-Only Storage
+ *					   Block.
+ * rowCount			-  number of rows stored in the content.
+ */
+void
+AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
+									int32 contentLen,
+									int executorBlockKind,
+									int rowCount)
+{
+	AppendOnlyStorageWrite_DoFinishBuffer(storageWrite,
+										  contentLen,
+										  executorBlockKind,
+										  rowCount,
+										  NULL);
+}
+
+/*
+ * Set up a task to compress the current "small" buffer outside of the
+ * backend, see cdbappendonlydecompress.c.
+ *
+ * Returns false, without doing anything, if the storage isn't compressed or
+ * its compression type has no thread-safe compressor; the caller should then
+ * use ~_FinishBuffer as usual.
+ *
+ * Otherwise, the task must be run and passed to ~_FinishCompressedBuffer,
+ * with the same arguments, before anything else is done with this
+ * storageWrite.
+ */
+bool
+AppendOnlyStorageWrite_PrepareCompress(AppendOnlyStorageWrite *storageWrite,
+									   int32 contentLen,
+									   AppendOnlyDecompressTask *task)
+{
+	uint8	   *header;
+
+	Assert(storageWrite != NULL);
+	Assert(storageWrite->isActive);
+
+	Assert(storageWrite->currentCompleteHeaderLen > 0);
+
+	if (!storageWrite->storageAttributes.compress ||
+		storageWrite->compression_functions == NULL ||
+		storageWrite->compressionState == NULL ||
+		storageWrite->compressionState->threadsafe_compress == NULL)
+		return false;
+
+	AppendOnlyStorageWrite_CheckContentLen(storageWrite, contentLen);
+
+	/* Same output buffer as ~_CompressAppend will use */
+	storageWrite->currentCompleteHeaderLen =
+		AppendOnlyStorageWrite_CompleteHeaderLen(
+			storageWrite,
+			storageWrite->getBufferAoHeaderKind);
+
+	header = BufferedAppendGetMaxBuffer(&storageWrite->bufferedAppend);
+	if (header == NULL)
+		return false;
+
+	task->compress = true;
+	task->uncompressed = storageWrite->uncompressedBuffer;
+	task->uncompressedLen = contentLen;
+	task->compressed = &header[storageWrite->currentCompleteHeaderLen];
+	task->compressedLen = storageWrite->maxBufferWithCompressionOverrrunLen -
+		storageWrite->currentCompleteHeaderLen;
+	task->compressionState = storageWrite->compressionState;
+	task->resultLen = 0;
+	task->succeeded = false;
+
+	return true;
+}
+
+/*
+ * Like ~_FinishBuffer, for a buffer whose compression was set up with
+ * ~_PrepareCompress and has been run.
+ */
+void
+AppendOnlyStorageWrite_FinishCompressedBuffer(AppendOnlyStorageWrite *storageWrite,
+											  int32 contentLen,
+											  int executorBlockKind,
+											  int rowCount,
+											  AppendOnlyDecompressTask *task)
+{
+	Assert(task != NULL && task->compress);
+
+	AppendOnlyStorageWrite_DoFinishBuffer(storageWrite,
+										  contentLen,
+										  executorBlockKind,
+										  rowCount,
+										  task);
+}
+
+/*
+ * Write a "small" block whose content is already in its stored form, as
+ * returned by AppendOnlyStorageRead_GetStoredContent from a segment file
+ * with the same storage attributes. The content is copied as is; only the
+ * header is made anew, with the first row number set by ~_SetFirstRowNum.
+ *
+ * storedContent	- compressedLen bytes of compressed content, or contentLen
+ *					  bytes if compressedLen is 0.
+ * contentLen		- byte length of the non-compressed content.
+ *
+ * There must be no buffer in progress, see ~_GetBuffer.
+ */
+void
+AppendOnlyStorageWrite_StoredContent(AppendOnlyStorageWrite *storageWrite,
+									 int aoHeaderKind,
+									 uint8 *storedContent,
+									 int32 contentLen,
+									 int32 compressedLen,
+									 int executorBlockKind,
+									 int rowCount)
+{
+	uint8	   *header;
+	uint8	   *dataBuffer;
+	int32		storedLen;
+	int32		dataRoundedUpLen;
+	int32		bufferLen;
+
+	Assert(storageWrite != NULL);
+	Assert(storageWrite->isActive);
+	Assert(storageWrite->currentCompleteHeaderLen == 0);
+	Assert(compressedLen == 0 || storageWrite->storageAttributes.compress);
+
+	storageWrite->getBufferAoHeaderKind = aoHeaderKind;
+	storageWrite->currentCompleteHeaderLen =
+		AppendOnlyStorageWrite_CompleteHeaderLen(storageWrite, aoHeaderKind);
+
+	AppendOnlyStorageWrite_CheckContentLen(storageWrite, contentLen);
+
+	header = BufferedAppendGetMaxBuffer(&storageWrite->bufferedAppend);
+	if (header == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("We do not expect files to be have a maximum length"),
+				 errcontext_appendonly_write_storage_block(storageWrite)));
+
+	storedLen = (compressedLen > 0 ? compressedLen : contentLen);
+	dataRoundedUpLen = AOStorage_RoundUp(storedLen, storageWrite->formatVersion);
+
+	dataBuffer = &header[storageWrite->currentCompleteHeaderLen];
+	memcpy(dataBuffer, storedContent, storedLen);
+	AOStorage_ZeroPad(dataBuffer, storedLen, dataRoundedUpLen);
+
+	switch (aoHeaderKind)
+	{
+		case AoHeaderKind_SmallContent:
+			AppendOnlyStorageFormat_MakeSmallContentHeader
+				(header,
+				 storageWrite->storageAttributes.checksum,
+				 storageWrite->isFirstRowNumSet,
+				 storageWrite->formatVersion,
+				 storageWrite->firstRowNum,
+				 executorBlockKind,
+				 rowCount,
+				 contentLen,
+				 compressedLen);
+			break;
+
+		case AoHeaderKind_NonBulkDenseContent:
+			Assert(compressedLen == 0);
+			AppendOnlyStorageFormat_MakeNonBulkDenseContentHeader
+				(header,
+				 storageWrite->storageAttributes.checksum,
+				 storageWrite->isFirstRowNumSet,
+				 storageWrite->formatVersion,
+				 storageWrite->firstRowNum,
+				 executorBlockKind,
+				 rowCount,
+				 contentLen);
+			break;
+
+		case AoHeaderKind_BulkDenseContent:
+			AppendOnlyStorageFormat_MakeBulkDenseContentHeader
+				(header,
+				 storageWrite->storageAttributes.checksum,
+				 storageWrite->isFirstRowNumSet,
+				 storageWrite->formatVersion,
+				 storageWrite->firstRowNum,
+				 executorBlockKind,
+				 rowCount,
+				 contentLen,
+				 compressedLen);
+			break;
+
+		default:
+			elog(ERROR, "unexpected Append-Only header kind %d",
+				 aoHeaderKind);
+			break;
+	}
+
+	if (Debug_appendonly_print_storage_headers)
+	{
+		AppendOnlyStorageWrite_LogBlockHeader(
+			storageWrite,
+			BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend),
+			header);
+	}
+
+	elogif(Debug_appendonly_print_insert, LOG,
+		   "Append-only insert copied %s block for table '%s' "
+		   "(segment file '%s', header offset in file " INT64_FORMAT ", "
+		   "length = %d, stored length %d, item count %d, block count "
+		   INT64_FORMAT ")",
+		   (compressedLen > 0) ? "compressed" : "uncompressed",
+		   storageWrite->relationName,
+		   storageWrite->segmentFileName,
+		   BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend),
+		   contentLen,
+		   storedLen,
+		   rowCount,
+		   storageWrite->bufferCount);
+
+	bufferLen = storageWrite->currentCompleteHeaderLen + dataRoundedUpLen;
+
+	BufferedAppendFinishBuffer(&storageWrite->bufferedAppend,
+							   bufferLen,
+							   storageWrite->currentCompleteHeaderLen +
+							   AOStorage_RoundUp(contentLen, storageWrite->formatVersion) /* non-compressed size */ );
+
+	/* Declare it finished. */
+	storageWrite->currentCompleteHeaderLen = 0;
+	storageWrite->currentBuffer = NULL;
+	storageWrite->isFirstRowNumSet = false;
+}
+
 /*
  * Cancel the last ~GetBuffer call.
  *
@@ -1585,6 +1830,7 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 												  contentLen,
 												  executorBlockKind,
 												  rowCount,
+												  NULL,
 												  &compressedLen,
 												  &bufferLen);
 
@@ -1705,6 +1951,7 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 													  smallContentLen,
 													  executorBlockKind,
 													   /* rowCount */ 0,
+													  NULL,
 													  &compressedLen,
 													  &bufferLen);
 
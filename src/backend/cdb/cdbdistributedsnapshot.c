@@ -38,7 +38,7 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 												  bool isVacuumCheck)
 {
 	DistributedSnapshot *ds = &dslm->ds;
-	uint32		i;
+	int32		i;
 	DistributedTransactionId distribXid = InvalidDistributedTransactionId;
 
 	Assert(!IS_QUERY_DISPATCHER());
@@ -187,46 +187,38 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
-	for (i = 0; i < ds->count; i++)
+	if (DistributedSnapshot_IsInProgress(ds, distribXid))
 	{
-		if (distribXid == ds->inProgressXidArray[i])
+		/*
+		 * Save the relationship to the local xid so we may avoid checking the
+		 * distributed committed log in a subsequent check. We can only record
+		 * local xids till cache size permits.
+		 */
+		if (dslm->currentLocalXidsCount < dslm->maxLocalXidsCount)
 		{
-			/*
-			 * Save the relationship to the local xid so we may avoid checking
-			 * the distributed committed log in a subsequent check. We can
-			 * only record local xids till cache size permits.
-			 */
-			if (dslm->currentLocalXidsCount < dslm->maxLocalXidsCount)
-			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
+			Assert(dslm->inProgressMappedLocalXids != NULL);
+			Assert(dslm->inProgressMappedDistribXids != NULL);
 
-				dslm->inProgressMappedLocalXids[dslm->currentLocalXidsCount++] =
-					localXid;
+			dslm->inProgressMappedLocalXids[dslm->currentLocalXidsCount] =
+				localXid;
+			dslm->inProgressMappedDistribXids[dslm->currentLocalXidsCount] =
+				distribXid;
+			dslm->currentLocalXidsCount++;
 
-				if (!TransactionIdIsValid(dslm->minCachedLocalXid) ||
-					TransactionIdPrecedes(localXid, dslm->minCachedLocalXid))
-				{
-					dslm->minCachedLocalXid = localXid;
-				}
-
-				if (!TransactionIdIsValid(dslm->maxCachedLocalXid) ||
-					TransactionIdFollows(localXid, dslm->maxCachedLocalXid))
-				{
-					dslm->maxCachedLocalXid = localXid;
-				}
+			if (!TransactionIdIsValid(dslm->minCachedLocalXid) ||
+				TransactionIdPrecedes(localXid, dslm->minCachedLocalXid))
+			{
+				dslm->minCachedLocalXid = localXid;
 			}
 
-			return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
+			if (!TransactionIdIsValid(dslm->maxCachedLocalXid) ||
+				TransactionIdFollows(localXid, dslm->maxCachedLocalXid))
+			{
+				dslm->maxCachedLocalXid = localXid;
+			}
 		}
 
-		/*
-		 * Leverage the fact that ds->inProgressXidArray is sorted in
-		 * ascending order based on distribXid while creating the snapshot in
-		 * CreateDistributedSnapshot(). So, can fail fast once known are
-		 * lower than rest of them.
-		 */
-		if (distribXid < ds->inProgressXidArray[i])
-			break;
+		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
 	/*
@@ -235,6 +227,112 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 	return DISTRIBUTEDSNAPSHOT_COMMITTED_VISIBLE;
 }
 
+/*
+ * DistributedSnapshot_IsInProgress
+ *		Is the given distributed xid in the in-progress array of the
+ *		snapshot?
+ *
+ * Leverages the fact that ds->inProgressXidArray is sorted in ascending order
+ * while creating the snapshot in CreateDistributedSnapshot(), so a binary
+ * search will do.  With thousands of concurrent distributed transactions, a
+ * scan of the array for every tuple checked adds up.
+ */
+bool
+DistributedSnapshot_IsInProgress(DistributedSnapshot *ds,
+								 DistributedTransactionId distribXid)
+{
+	int32		low = 0;
+	int32		high = ds->count - 1;
+
+	if (ds->count == 0 ||
+		distribXid < ds->inProgressXidArray[0] ||
+		distribXid > ds->inProgressXidArray[high])
+		return false;
+
+	while (low <= high)
+	{
+		int32		mid = low + (high - low) / 2;
+		DistributedTransactionId midXid = ds->inProgressXidArray[mid];
+
+		if (distribXid == midXid)
+			return true;
+		if (distribXid < midXid)
+			high = mid - 1;
+		else
+			low = mid + 1;
+	}
+
+	return false;
+}
+
+/*
+ * DistributedSnapshotWithLocalMapping_Install
+ *		Copy a distributed snapshot received from the QD into the snapshot
+ *		of this backend, keeping what can be kept of the local xid cache.
+ *
+ * The mapping from a committed local xid to its distributed xid doesn't
+ * change, so a local xid cached as in progress under the previous distributed
+ * snapshot is still in progress under the new one if its distributed xid is
+ * in the new in-progress array.  Carrying those entries over spares the
+ * statements of a transaction from looking up the distributed log again for
+ * the same tuples; the entries whose distributed transaction has committed
+ * since are dropped.
+ */
+void
+DistributedSnapshotWithLocalMapping_Install(DistributedSnapshotWithLocalMapping *dslm,
+											DistributedSnapshot *source)
+{
+	int32		i;
+	int32		kept = 0;
+
+	if (dslm->currentLocalXidsCount > 0 &&
+		dslm->ds.distribTransactionTimeStamp == source->distribTransactionTimeStamp &&
+		dslm->ds.distribSnapshotId == source->distribSnapshotId)
+	{
+		/* Same snapshot again, e.g. in another slice; nothing to prune. */
+		DistributedSnapshot_Copy(&dslm->ds, source);
+		return;
+	}
+
+	if (dslm->ds.distribTransactionTimeStamp == source->distribTransactionTimeStamp)
+	{
+		dslm->minCachedLocalXid = InvalidTransactionId;
+		dslm->maxCachedLocalXid = InvalidTransactionId;
+
+		for (i = 0; i < dslm->currentLocalXidsCount; i++)
+		{
+			TransactionId localXid = dslm->inProgressMappedLocalXids[i];
+			DistributedTransactionId distribXid = dslm->inProgressMappedDistribXids[i];
+
+			if (!DistributedSnapshot_IsInProgress(source, distribXid))
+				continue;
+
+			dslm->inProgressMappedLocalXids[kept] = localXid;
+			dslm->inProgressMappedDistribXids[kept] = distribXid;
+			kept++;
+
+			if (!TransactionIdIsValid(dslm->minCachedLocalXid) ||
+				TransactionIdPrecedes(localXid, dslm->minCachedLocalXid))
+				dslm->minCachedLocalXid = localXid;
+			if (!TransactionIdIsValid(dslm->maxCachedLocalXid) ||
+				TransactionIdFollows(localXid, dslm->maxCachedLocalXid))
+				dslm->maxCachedLocalXid = localXid;
+		}
+
+		elog((Debug_print_full_dtm ? LOG : DEBUG5),
+			 "DistributedSnapshotWithLocalMapping_Install kept %d of %d cached local xids",
+			 kept, dslm->currentLocalXidsCount);
+	}
+	else
+	{
+		dslm->minCachedLocalXid = InvalidTransactionId;
+		dslm->maxCachedLocalXid = InvalidTransactionId;
+	}
+	dslm->currentLocalXidsCount = kept;
+
+	DistributedSnapshot_Copy(&dslm->ds, source);
+}
+
 /*
  * Reset all fields except maxCount and the malloc'd pointer for
  * inProgressXidArray.
@@ -321,17 +419,100 @@ DistributedSnapshot_Copy(DistributedSnapshot *target,
 		   source->count * sizeof(DistributedTransactionId));
 }
 
+/*
+ * The in-progress array is the bulk of a serialized distributed snapshot, and
+ * it's dispatched with every query.  It's sorted, and all of its xids are in
+ * [xmin, xmax], so it's sent in whichever of these forms is the smallest:
+ *
+ * DS_XIDS_ARRAY	the xids as they are, 4 bytes each.
+ * DS_XIDS_DELTA	the difference of each xid to the previous one (to xmin for
+ *					the first), as a varint: 7 bits per byte, the high bit
+ *					set on all but the last byte.  Usually 1 or 2 bytes each.
+ * DS_XIDS_BITMAP	one bit per xid in [xmin, xmax], for when most of the
+ *					transactions in that range are still running.
+ *
+ * The form is given by a byte following the count, if the count isn't zero.
+ */
+#define DS_XIDS_ARRAY	0
+#define DS_XIDS_DELTA	1
+#define DS_XIDS_BITMAP	2
+
+static int
+varint_size(uint32 value)
+{
+	int			size = 1;
+
+	while (value >= 0x80)
+	{
+		value >>= 7;
+		size++;
+	}
+	return size;
+}
+
+/*
+ * Pick the form in which to send the in-progress array, and return the size
+ * of the array in that form.
+ */
+static int
+DistributedSnapshot_ChooseXidsForm(DistributedSnapshot *ds, uint8 *form)
+{
+	int			arraySize = ds->count * sizeof(DistributedTransactionId);
+	int			deltaSize = 0;
+	int			bitmapSize;
+	DistributedTransactionId prev = ds->xmin;
+	int32		i;
+
+	Assert(ds->count > 0);
+
+	for (i = 0; i < ds->count; i++)
+	{
+		DistributedTransactionId xid = ds->inProgressXidArray[i];
+
+		/* Only a sorted array within [xmin, xmax] can be encoded. */
+		if (xid < prev || xid > ds->xmax)
+		{
+			*form = DS_XIDS_ARRAY;
+			return arraySize;
+		}
+		deltaSize += varint_size(xid - prev);
+		prev = xid;
+	}
+
+	bitmapSize = (ds->xmax - ds->xmin) / 8 + 1;
+
+	if (bitmapSize < deltaSize && bitmapSize < arraySize)
+	{
+		*form = DS_XIDS_BITMAP;
+		return bitmapSize;
+	}
+	if (deltaSize < arraySize)
+	{
+		*form = DS_XIDS_DELTA;
+		return deltaSize;
+	}
+	*form = DS_XIDS_ARRAY;
+	return arraySize;
+}
+
 int
 DistributedSnapshot_SerializeSize(DistributedSnapshot *ds)
 {
-	return sizeof(DistributedTransactionTimeStamp) +
+	int			size;
+	uint8		form;
+
+	size = sizeof(DistributedTransactionTimeStamp) +
 		sizeof(DistributedSnapshotId) +
 	/* xminAllDistributedSnapshots, xmin, xmax */
 		3 * sizeof(DistributedTransactionId) +
 	/* count */
-		sizeof(int32) +
-	/* Size of inProgressXidArray */
-		sizeof(DistributedTransactionId) * ds->count;
+		sizeof(int32);
+
+	/* form and inProgressXidArray */
+	if (ds->count > 0)
+		size += sizeof(uint8) + DistributedSnapshot_ChooseXidsForm(ds, &form);
+
+	return size;
 }
 
 int
@@ -352,8 +533,51 @@ DistributedSnapshot_Serialize(DistributedSnapshot *ds, char *buf)
 	memcpy(p, &ds->count, sizeof(int32));
 	p += sizeof(int32);
 
-	memcpy(p, ds->inProgressXidArray, sizeof(DistributedTransactionId) * ds->count);
-	p += sizeof(DistributedTransactionId) * ds->count;
+	if (ds->count > 0)
+	{
+		uint8		form;
+		int			size;
+		DistributedTransactionId prev;
+		int32		i;
+
+		size = DistributedSnapshot_ChooseXidsForm(ds, &form);
+		*p++ = (char) form;
+
+		switch (form)
+		{
+			case DS_XIDS_ARRAY:
+				memcpy(p, ds->inProgressXidArray, size);
+				p += size;
+				break;
+
+			case DS_XIDS_DELTA:
+				prev = ds->xmin;
+				for (i = 0; i < ds->count; i++)
+				{
+					uint32		delta = ds->inProgressXidArray[i] - prev;
+
+					while (delta >= 0x80)
+					{
+						*p++ = (char) ((delta & 0x7F) | 0x80);
+						delta >>= 7;
+					}
+					*p++ = (char) delta;
+					prev = ds->inProgressXidArray[i];
+				}
+				break;
+
+			case DS_XIDS_BITMAP:
+				memset(p, 0, size);
+				for (i = 0; i < ds->count; i++)
+				{
+					uint32		bit = ds->inProgressXidArray[i] - ds->xmin;
+
+					p[bit / 8] |= (char) (1 << (bit % 8));
+				}
+				p += size;
+				break;
+		}
+	}
 
 	Assert((p - buf) == DistributedSnapshot_SerializeSize(ds));
 
@@ -412,13 +636,65 @@ DistributedSnapshot_Deserialize(const char *buf, DistributedSnapshot *ds)
 
 	if (count > 0)
 	{
-		int			xipsize;
+		uint8		form = (uint8) *p++;
+		DistributedTransactionId prev;
+		int32		i;
 
 		Assert(ds->inProgressXidArray != NULL);
 
-		xipsize = sizeof(DistributedTransactionId) * count;
-		memcpy(ds->inProgressXidArray, p, xipsize);
-		p += xipsize;
+		switch (form)
+		{
+			case DS_XIDS_ARRAY:
+				memcpy(ds->inProgressXidArray, p,
+					   sizeof(DistributedTransactionId) * count);
+				p += sizeof(DistributedTransactionId) * count;
+				break;
+
+			case DS_XIDS_DELTA:
+				prev = ds->xmin;
+				for (i = 0; i < count; i++)
+				{
+					uint32		delta = 0;
+					int			shift = 0;
+					uint8		b;
+
+					do
+					{
+						b = (uint8) *p++;
+						delta |= (uint32) (b & 0x7F) << shift;
+						shift += 7;
+					} while (b & 0x80);
+
+					prev += delta;
+					ds->inProgressXidArray[i] = prev;
+				}
+				break;
+
+			case DS_XIDS_BITMAP:
+				{
+					uint32		nbits = ds->xmax - ds->xmin + 1;
+					uint32		bit;
+
+					i = 0;
+					for (bit = 0; bit < nbits; bit++)
+					{
+						if ((p[bit / 8] & (1 << (bit % 8))) == 0)
+							continue;
+						if (i >= count)
+							break;
+						ds->inProgressXidArray[i++] = ds->xmin + bit;
+					}
+					if (i != count)
+						elog(ERROR, "distributed snapshot bitmap has %d in-progress xids, expected %d",
+							 i, count);
+					p += (ds->xmax - ds->xmin) / 8 + 1;
+				}
+				break;
+
+			default:
+				elog(ERROR, "unrecognized distributed snapshot in-progress array form %d",
+					 (int) form);
+		}
 	}
 	ds->count = count;
 
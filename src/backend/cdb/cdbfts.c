@@ -43,6 +43,8 @@
 #define MASTER_SEGMENT_ID -1
 
 volatile FtsProbeInfo *ftsProbeInfo = NULL;	/* Probe process updates this structure */
+volatile FtsProbeStats *ftsProbeStats = NULL;	/* and this one */
+int			ftsNumProbeStats = 0;	/* entries in ftsProbeStats */
 static LWLockId ftsControlLock;
 
 /*
@@ -57,7 +59,8 @@ FtsShmemSize(void)
 	if ((Gp_role != GP_ROLE_DISPATCH) && (Gp_role != GP_ROLE_UTILITY))
 		return 0;
 
-	return MAXALIGN(sizeof(FtsControlBlock));
+	return MAXALIGN(offsetof(FtsControlBlock, fts_probe_stats) +
+					Max(GpIdentity.numsegments, 1) * sizeof(FtsProbeStats));
 }
 
 void
@@ -73,6 +76,7 @@ FtsShmemInit(void)
 	/* Initialize locks and shared memory area */
 	ftsControlLock = shared->ControlLock;
 	ftsProbeInfo = &shared->fts_probe_info;
+	ftsProbeStats = shared->fts_probe_stats;
 
 	if (!IsUnderPostmaster)
 	{
@@ -80,7 +84,11 @@ FtsShmemInit(void)
 		ftsControlLock = shared->ControlLock;
 
 		shared->fts_probe_info.fts_statusVersion = 0;
+		shared->num_probe_stats = Max(GpIdentity.numsegments, 1);
+		MemSet(shared->fts_probe_stats, 0,
+			   shared->num_probe_stats * sizeof(FtsProbeStats));
 	}
+	ftsNumProbeStats = shared->num_probe_stats;
 }
 
 void
@@ -16,12 +16,76 @@
 #include "postgres.h"
 
 #include <math.h>
+#ifdef HAVE_LIBLZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 
 #include "cdb/cdbsrlz.h"
+#include "cdb/cdbvars.h"
 #include "nodes/nodes.h"
+#include "nodes/plannodes.h"
 #include "utils/memaccounting.h"
 #include "utils/zlib_wrapper.h"
 
+/*
+ * A serialized node is sent as the uncompressed length, followed by a byte
+ * saying how the rest is compressed, followed by the compressed (or not)
+ * node string.  The codec byte is a DispatchCompressAlgorithm.
+ */
+#define SERIALIZED_HEADER_SIZE	(sizeof(int) + 1)
+
+/*
+ * A compression codec for serialized nodes.  compress returns the size of
+ * the compressed data, or -1 if it doesn't fit in dst; decompress returns
+ * false on corrupt input.
+ */
+typedef struct SerializeCodec
+{
+	const char *name;
+	int			(*bound) (int len);
+	int			(*compress) (const char *src, int len, char *dst, int dstlen);
+	bool		(*decompress) (const char *src, int len, char *dst, int dstlen);
+} SerializeCodec;
+
+static int	zlib_bound(int len);
+static int	zlib_compress(const char *src, int len, char *dst, int dstlen);
+static bool zlib_decompress(const char *src, int len, char *dst, int dstlen);
+#ifdef HAVE_LIBLZ4
+static int	lz4_bound(int len);
+static int	lz4_compress(const char *src, int len, char *dst, int dstlen);
+static bool lz4_decompress(const char *src, int len, char *dst, int dstlen);
+#endif
+#ifdef HAVE_LIBZSTD
+static int	zstd_bound(int len);
+static int	zstd_compress(const char *src, int len, char *dst, int dstlen);
+static bool zstd_decompress(const char *src, int len, char *dst, int dstlen);
+#endif
+
+/* Indexed by DispatchCompressAlgorithm; NULL functions if not built in */
+static const SerializeCodec codecs[] = {
+	{"none", NULL, NULL, NULL},
+	{"zlib", zlib_bound, zlib_compress, zlib_decompress},
+#ifdef HAVE_LIBLZ4
+	{"lz4", lz4_bound, lz4_compress, lz4_decompress},
+#else
+	{"lz4", NULL, NULL, NULL},
+#endif
+#ifdef HAVE_LIBZSTD
+	{"zstd", zstd_bound, zstd_compress, zstd_decompress},
+#else
+	{"zstd", NULL, NULL, NULL},
+#endif
+};
+
+/* Time spent flattening and compressing nodes in this backend */
+instr_time	serializeNodeTime;
+instr_time	compressNodeTime;
+
+static char *flatten_node(Node *node, bool forSlice,
+			 Bitmapset *motions, Bitmapset *subplans, int *size);
 static char *compress_string(const char *src, int uncompressed_size, int *size);
 static char *uncompress_string(const char *src, int size, int *uncompressed_len);
 
@@ -39,15 +103,16 @@ serializeNode(Node *node, int *size, int *uncompressed_size_out)
 
 	Assert(node != NULL);
 	Assert(size != NULL);
-	START_MEMORY_ACCOUNT(MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Serializer));
+
+	pszNode = serializeNodeUncompressed(node, &uncompressed_size);
+
+	if (NULL != uncompressed_size_out)
 	{
-		pszNode = nodeToBinaryStringFast(node, &uncompressed_size);
-		Assert(pszNode != NULL);
+		*uncompressed_size_out = uncompressed_size;
+	}
 
-		if (NULL != uncompressed_size_out)
-		{
-			*uncompressed_size_out = uncompressed_size;
-		}
+	START_MEMORY_ACCOUNT(MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Serializer));
+	{
 		sNode = compress_string(pszNode, uncompressed_size, size);
 		pfree(pszNode);
 	}
@@ -56,6 +121,69 @@ serializeNode(Node *node, int *size, int *uncompressed_size_out)
 	return sNode;
 }
 
+/*
+ * Flatten a node with nodeToBinaryStringFast, to be compressed later with
+ * compressSerializedNode.
+ * The returned string is palloc'ed in the current memory context.
+ */
+char *
+serializeNodeUncompressed(Node *node, int *size)
+{
+	Assert(node != NULL);
+
+	return flatten_node(node, false, NULL, NULL, size);
+}
+
+/*
+ * Like serializeNodeUncompressed, for a plan to be dispatched to the QEs of
+ * a single slice.  See nodeToBinaryStringFastForSlice.
+ */
+char *
+serializePlanForSliceUncompressed(PlannedStmt *stmt,
+								  Bitmapset *motions, Bitmapset *subplans,
+								  int *size)
+{
+	Assert(stmt != NULL);
+
+	return flatten_node((Node *) stmt, true, motions, subplans, size);
+}
+
+static char *
+flatten_node(Node *node, bool forSlice,
+			 Bitmapset *motions, Bitmapset *subplans, int *size)
+{
+	char	   *pszNode;
+	instr_time	start;
+	instr_time	end;
+
+	INSTR_TIME_SET_CURRENT(start);
+	START_MEMORY_ACCOUNT(MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Serializer));
+	{
+		if (forSlice)
+			pszNode = nodeToBinaryStringFastForSlice((PlannedStmt *) node, size,
+													 motions, subplans);
+		else
+			pszNode = nodeToBinaryStringFast(node, size);
+		Assert(pszNode != NULL);
+	}
+	END_MEMORY_ACCOUNT();
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_ACCUM_DIFF(serializeNodeTime, end, start);
+
+	return pszNode;
+}
+
+/*
+ * Compress a node already flattened with nodeToBinaryStringFast into the
+ * form deserializeNode expects.  The result is palloc'ed in the current
+ * memory context.
+ */
+char *
+compressSerializedNode(const char *pszNode, int uncompressed_size, int *size)
+{
+	return compress_string(pszNode, uncompressed_size, size);
+}
+
 /*
  * This is used on the qExecs to deserialize serialized Plan and Query Trees
  * received from the dispatcher.
@@ -86,18 +214,20 @@ deserializeNode(const char *strNode, int size)
 }
 
 /*
- * Compress a (binary) string using zlib.
+ * Compress a (binary) string with the codec of gp_dispatch_compress_algorithm,
+ * unless it's smaller than gp_dispatch_compress_threshold.
  *
  * returns the compressed data and the size of the compressed data.
  */
 static char *
 compress_string(const char *src, int uncompressed_size, int *size)
 {
-	int			level = 3;
-	unsigned long compressed_size;
-	int			status;
-
-	Bytef	   *result;
+	DispatchCompressAlgorithm algorithm = gp_dispatch_compress_algorithm;
+	const SerializeCodec *codec;
+	instr_time	start;
+	instr_time	end;
+	char	   *result;
+	int			compressed_size = -1;
 
 	Assert(size != NULL);
 
@@ -107,20 +237,46 @@ compress_string(const char *src, int uncompressed_size, int *size)
 		return NULL;
 	}
 
-	compressed_size = gp_compressBound(uncompressed_size);	/* worst case */
+	if ((int64) uncompressed_size < (int64) gp_dispatch_compress_threshold * 1024)
+		algorithm = DISPATCH_COMPRESS_NONE;
 
-	result = palloc(compressed_size + sizeof(int));
-	memcpy(result, &uncompressed_size, sizeof(int));	/* save the original
-														 * length */
+	codec = &codecs[algorithm];
+	if (codec->compress == NULL)
+	{
+		algorithm = DISPATCH_COMPRESS_NONE;
+		codec = &codecs[algorithm];
+	}
 
-	status = gp_compress2(result + sizeof(int), &compressed_size, (Bytef *) src, uncompressed_size, level);
-	if (status != Z_OK)
-		elog(ERROR, "Compression failed: %s (errno=%d) uncompressed len %d, compressed %d",
-			 zError(status), status, uncompressed_size, (int) compressed_size);
+	INSTR_TIME_SET_CURRENT(start);
+
+	if (codec->compress != NULL)
+	{
+		int			bound = codec->bound(uncompressed_size);
+
+		result = palloc(SERIALIZED_HEADER_SIZE + bound);
+		compressed_size = codec->compress(src, uncompressed_size,
+										  result + SERIALIZED_HEADER_SIZE, bound);
+		if (compressed_size < 0)
+			elog(ERROR, "%s compression failed: uncompressed len %d",
+				 codec->name, uncompressed_size);
+	}
+	else
+	{
+		result = palloc(SERIALIZED_HEADER_SIZE + uncompressed_size);
+		memcpy(result + SERIALIZED_HEADER_SIZE, src, uncompressed_size);
+		compressed_size = uncompressed_size;
+	}
 
-	*size = compressed_size + sizeof(int);
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_ACCUM_DIFF(compressNodeTime, end, start);
 
-	return (char *) result;
+	/* save the original length, and how the rest is compressed */
+	memcpy(result, &uncompressed_size, sizeof(int));
+	result[sizeof(int)] = (char) algorithm;
+
+	*size = SERIALIZED_HEADER_SIZE + compressed_size;
+
+	return result;
 }
 
 /*
@@ -129,26 +285,124 @@ compress_string(const char *src, int uncompressed_size, int *size)
 static char *
 uncompress_string(const char *src, int size, int *uncompressed_len)
 {
-	Bytef	   *result;
-	unsigned long resultlen;
-	int			status;
+	const SerializeCodec *codec;
+	char	   *result;
+	int			algorithm;
 
 	*uncompressed_len = 0;
 
 	if (src == NULL)
 		return NULL;
 
-	Assert(size >= sizeof(int));
+	Assert(size >= SERIALIZED_HEADER_SIZE);
 
 	memcpy(uncompressed_len, src, sizeof(int));
+	algorithm = (unsigned char) src[sizeof(int)];
+	src += SERIALIZED_HEADER_SIZE;
+	size -= SERIALIZED_HEADER_SIZE;
+
+	if (algorithm >= lengthof(codecs))
+		elog(ERROR, "unrecognized compression algorithm %d for serialized node",
+			 algorithm);
+	codec = &codecs[algorithm];
+
+	result = palloc(*uncompressed_len);
+
+	if (algorithm == DISPATCH_COMPRESS_NONE)
+	{
+		if (size != *uncompressed_len)
+			elog(ERROR, "serialized node has length %d, expected %d",
+				 size, *uncompressed_len);
+		memcpy(result, src, size);
+	}
+	else if (codec->decompress == NULL)
+		elog(ERROR, "serialized node is compressed with %s, which this build doesn't support",
+			 codec->name);
+	else if (!codec->decompress(src, size, result, *uncompressed_len))
+		elog(ERROR, "%s uncompress failed (compressed len %d, uncompressed %d)",
+			 codec->name, size, *uncompressed_len);
+
+	return result;
+}
 
-	resultlen = *uncompressed_len;
-	result = palloc(resultlen);
+static int
+zlib_bound(int len)
+{
+	return gp_compressBound(len);
+}
 
-	status = gp_uncompress(result, &resultlen, (Bytef *) (src + sizeof(int)), size - sizeof(int));
+static int
+zlib_compress(const char *src, int len, char *dst, int dstlen)
+{
+	int			level = 3;
+	unsigned long compressed_size = dstlen;
+	int			status;
+
+	status = gp_compress2((Bytef *) dst, &compressed_size, (Bytef *) src, len, level);
+	if (status != Z_OK)
+		elog(ERROR, "Compression failed: %s (errno=%d) uncompressed len %d, compressed %d",
+			 zError(status), status, len, (int) compressed_size);
+
+	return (int) compressed_size;
+}
+
+static bool
+zlib_decompress(const char *src, int len, char *dst, int dstlen)
+{
+	unsigned long resultlen = dstlen;
+	int			status;
+
+	status = gp_uncompress((Bytef *) dst, &resultlen, (Bytef *) src, len);
 	if (status != Z_OK)
 		elog(ERROR, "Uncompress failed: %s (errno=%d compressed len %d, uncompressed %d)",
-			 zError(status), status, size, *uncompressed_len);
+			 zError(status), status, len, dstlen);
+
+	return resultlen == dstlen;
+}
+
+#ifdef HAVE_LIBLZ4
+static int
+lz4_bound(int len)
+{
+	return LZ4_compressBound(len);
+}
+
+static int
+lz4_compress(const char *src, int len, char *dst, int dstlen)
+{
+	int			compressed_size = LZ4_compress_default(src, dst, len, dstlen);
+
+	return compressed_size > 0 ? compressed_size : -1;
+}
+
+static bool
+lz4_decompress(const char *src, int len, char *dst, int dstlen)
+{
+	return LZ4_decompress_safe(src, dst, len, dstlen) == dstlen;
+}
+#endif							/* HAVE_LIBLZ4 */
+
+#ifdef HAVE_LIBZSTD
+static int
+zstd_bound(int len)
+{
+	return ZSTD_compressBound(len);
+}
+
+static int
+zstd_compress(const char *src, int len, char *dst, int dstlen)
+{
+	/* level 1: dispatch latency matters more than the last few bytes */
+	size_t		compressed_size = ZSTD_compress(dst, dstlen, src, len, 1);
+
+	return ZSTD_isError(compressed_size) ? -1 : (int) compressed_size;
+}
+
+static bool
+zstd_decompress(const char *src, int len, char *dst, int dstlen)
+{
+	size_t		resultlen = ZSTD_decompress(dst, dstlen, src, len);
 
-	return (char *) result;
+	return !ZSTD_isError(resultlen) && resultlen == (size_t) dstlen;
 }
+#endif							/* HAVE_LIBZSTD */
@@ -21,6 +21,7 @@
 
 #include "catalog/pg_authid.h"
 #include "cdb/cdbtm.h"
+#include "funcapi.h"
 #include "libpq/libpq-be.h"
 #include "miscadmin.h"
 #include "storage/shmem.h"
@@ -45,12 +46,15 @@
 
 #include "cdb/cdbllize.h"
 #include "utils/faultinjector.h"
+#include "utils/builtins.h"
 #include "utils/guc.h"
 #include "utils/fmgroids.h"
 #include "utils/sharedsnapshot.h"
 #include "utils/snapmgr.h"
 
 extern bool Test_print_direct_dispatch_info;
+extern int	CommitDelay;
+extern int	CommitSiblings;
 
 #define DTM_DEBUG3 (Debug_print_full_dtm ? LOG : DEBUG3)
 #define DTM_DEBUG5 (Debug_print_full_dtm ? LOG : DEBUG5)
@@ -77,12 +81,23 @@ uint32 *shmNextSnapshotId;
 /* transactions need recover */
 TMGXACT_LOG *shmCommittedGxactArray;
 volatile int *shmNumCommittedGxacts;
+static volatile uint64 *shmCommitRecordsFlushed;
+static volatile uint64 *shmCommitFlushes;
 
 /**
  * This pointer into shared memory is on the QD, and represents the current open transaction.
  */
 static TMGXACT *currentGxact;
 
+/*
+ * On a QE: set while committing a distributed transaction in one phase, and
+ * while prepared after a prepare that found nothing written here.
+ */
+static bool qeOnePhaseCommit = false;
+static DistributedTransactionTimeStamp qeOnePhaseDistribTimeStamp;
+static DistributedTransactionId qeOnePhaseDistribXid;
+static bool qePreparedReadOnly = false;
+
 static int	max_tm_gxacts = 100;
 
 static int	redoFileFD = -1;
@@ -134,6 +149,8 @@ static bool doDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 							 bool *badGangs, bool raiseError, CdbDispatchDirectDesc *direct,
 							 char *serializedDtxContextInfo, int serializedDtxContextInfoLen);
 static void doPrepareTransaction(void);
+static void doOnePhaseCommitTransaction(void);
+static bool retryOnePhaseCommit(CdbDispatchDirectDesc *direct);
 static void doInsertForgetCommitted(void);
 static void clearTransactionState(void);
 static void doNotifyingCommitPrepared(void);
@@ -147,6 +164,8 @@ static bool isDtxQueryDispatcher(void);
 static void UtilityModeSaveRedo(bool committed, TMGXACT_LOG *gxact_log);
 static void ReplayRedoFromUtilityMode(void);
 static void RemoveRedoUtilityModeFile(void);
+static void performDtxProtocolCommitOnePhase(const char *gid);
+static void performDtxProtocolRetryCommitOnePhase(const char *gid);
 static void performDtxProtocolCommitPrepared(const char *gid, bool raiseErrorIfNotFound);
 static void performDtxProtocolAbortPrepared(const char *gid, bool raiseErrorIfNotFound);
 
@@ -318,6 +337,23 @@ isPreparedDtxTransaction(void)
 	return (currentGxact->state == DTX_STATE_PREPARED);
 }
 
+/*
+ * Is this QE committing a distributed transaction without having prepared
+ * it?  RecordTransactionCommit must then mark the DistributedLog itself,
+ * with the distributed transaction returned here.
+ */
+bool
+getOnePhaseDtxCommitInfo(DistributedTransactionTimeStamp *distribTimeStamp,
+						 DistributedTransactionId *distribXid)
+{
+	if (!qeOnePhaseCommit)
+		return false;
+
+	*distribTimeStamp = qeOnePhaseDistribTimeStamp;
+	*distribXid = qeOnePhaseDistribXid;
+	return true;
+}
+
 void
 getDtxLogInfo(TMGXACT_LOG *gxact_log)
 {
@@ -371,6 +407,14 @@ notifyCommittedDtxTransaction(void)
 
 	Assert(currentGxact != NULL);
 
+	if (currentGxact->state == DTX_STATE_ONE_PHASE_COMMIT)
+	{
+		/* The segment has committed already; there is no second phase. */
+		clearTransactionState();
+		resetCurrentGxact();
+		return;
+	}
+
 	doNotifyingCommitPrepared();
 }
 
@@ -707,6 +751,148 @@ doPrepareTransaction(void)
 	elog(DTM_DEBUG5, "doPrepareTransaction leaving in state = %s", DtxStateToString(currentGxact->state));
 }
 
+/*
+ * Commit a transaction that only one segment took part in on that segment,
+ * without a prepare, and without a distributed commit record on the QD.
+ *
+ * Should the connection to the segment be lost while it commits, the
+ * transaction is in doubt, as a prepared one would be after a failed COMMIT
+ * PREPARED.  We then reconnect and ask the segment whether it committed.
+ */
+static void
+doOnePhaseCommitTransaction(void)
+{
+	bool		succeeded;
+	bool		badGangs = false;
+	volatile int savedInterruptHoldoffCount;
+
+	CdbDispatchDirectDesc direct = default_dispatch_direct_desc;
+
+	CHECK_FOR_INTERRUPTS();
+
+	elog(DTM_DEBUG5, "doOnePhaseCommitTransaction entering in state = %s",
+		 DtxStateToString(currentGxact->state));
+
+	HOLD_INTERRUPTS();
+
+	copyDirectDispatchFromTransaction(&direct);
+	Assert(direct.directed_dispatch);
+
+	Assert(currentGxact->state == DTX_STATE_ACTIVE_DISTRIBUTED);
+	setCurrentGxactState(DTX_STATE_ONE_PHASE_COMMIT);
+
+	SIMPLE_FAULT_INJECTOR(DtmBroadcastCommitOnePhase);
+	savedInterruptHoldoffCount = InterruptHoldoffCount;
+
+	PG_TRY();
+	{
+		succeeded = doDispatchDtxProtocolCommand(DTX_PROTOCOL_COMMAND_COMMIT_ONEPHASE, /* flags */ 0,
+												 currentGxact->gid, currentGxact->gxid,
+												 &badGangs, /* raiseError */ true, &direct, NULL, 0);
+	}
+	PG_CATCH();
+	{
+		/*
+		 * restore the previous value, which is reset to 0 in errfinish.
+		 */
+		InterruptHoldoffCount = savedInterruptHoldoffCount;
+
+		/* An error the segment reported itself means it did not commit. */
+		if (!badGangs)
+			PG_RE_THROW();
+
+		succeeded = false;
+		FlushErrorState();
+	}
+	PG_END_TRY();
+
+	if (!succeeded && badGangs)
+		succeeded = retryOnePhaseCommit(&direct);
+
+	RESUME_INTERRUPTS();
+
+	if (!succeeded)
+		elog(ERROR, "The distributed transaction 'Commit (One-Phase)' failed on segment %d for gid = %s.",
+			 currentGxact->directTransactionContentId, currentGxact->gid);
+
+	elog(DTM_DEBUG5, "The distributed transaction 'Commit (One-Phase)' succeeded on segment %d for gid = %s.",
+		 currentGxact->directTransactionContentId, currentGxact->gid);
+}
+
+/*
+ * Find out whether the segment committed a one-phase commit we lost the
+ * connection for, retrying like a failed COMMIT PREPARED broadcast.
+ *
+ * Returns whether the segment committed the transaction.  If we can't get an
+ * answer from it, we PANIC, as for a COMMIT PREPARED that can't be delivered.
+ */
+static bool
+retryOnePhaseCommit(CdbDispatchDirectDesc *direct)
+{
+	int			retry = 0;
+	bool		badGangs;
+	volatile bool committed = false;
+	volatile bool resolved = false;
+	volatile int savedInterruptHoldoffCount;
+	MemoryContext oldcontext = CurrentMemoryContext;
+
+	while (!resolved && dtx_phase2_retry_count > retry++)
+	{
+		elog(WARNING, "the distributed transaction 'Commit (One-Phase)' lost "
+			 "the connection to segment %d for gid = %s, so it may or may not "
+			 "have committed.  Checking ... try %d",
+			 currentGxact->directTransactionContentId, currentGxact->gid, retry);
+
+		DisconnectAndDestroyAllGangs(true);
+
+		/*
+		 * This call will at a minimum change the session id so we will not
+		 * have SharedSnapshotAdd colissions.
+		 */
+		CheckForResetSession();
+		savedInterruptHoldoffCount = InterruptHoldoffCount;
+
+		PG_TRY();
+		{
+			resolved = committed = doDispatchDtxProtocolCommand(
+											DTX_PROTOCOL_COMMAND_RETRY_COMMIT_ONEPHASE, /* flags */ 0,
+											currentGxact->gid, currentGxact->gxid,
+											&badGangs, /* raiseError */ true,
+											direct, NULL, 0);
+		}
+		PG_CATCH();
+		{
+			ErrorData  *edata;
+
+			/*
+			 * restore the previous value, which is reset to 0 in errfinish.
+			 */
+			InterruptHoldoffCount = savedInterruptHoldoffCount;
+
+			MemoryContextSwitchTo(oldcontext);
+			edata = CopyErrorData();
+			FlushErrorState();
+
+			/* The segment has no trace of a commit, and nothing is left to do it. */
+			if (edata->sqlerrcode == ERRCODE_UNDEFINED_OBJECT)
+				resolved = true;
+			FreeErrorData(edata);
+		}
+		PG_END_TRY();
+	}
+
+	if (!resolved)
+		elog(PANIC, "unable to complete 'Commit (One-Phase)' for gid = %s",
+			 currentGxact->gid);
+
+	elog(LOG, "the distributed transaction 'Commit (One-Phase)' for gid = %s "
+		 "was found %s on segment %d",
+		 currentGxact->gid, committed ? "committed" : "aborted",
+		 currentGxact->directTransactionContentId);
+
+	return committed;
+}
+
 /*
  * Insert FORGET COMMITTED into the xlog.
  */
@@ -1135,6 +1321,18 @@ prepareDtxTransaction(void)
 
 	Assert(currentGxact->state == DTX_STATE_ACTIVE_DISTRIBUTED);
 
+	/*
+	 * If only one segment took part, and nothing was written here, that
+	 * segment's commit decides the outcome alone: skip the two-phase commit.
+	 */
+	if (gp_enable_one_phase_commit &&
+		currentGxact->directTransaction &&
+		!TransactionIdIsValid(GetTopTransactionIdIfAny()))
+	{
+		doOnePhaseCommitTransaction();
+		return;
+	}
+
 	/*
 	 * Broadcast PREPARE TRANSACTION to segments.
 	 */
@@ -1177,6 +1375,15 @@ rollbackDtxTransaction(void)
 			setCurrentGxactState(DTX_STATE_NOTIFYING_ABORT_NO_PREPARED);
 			break;
 
+		case DTX_STATE_ONE_PHASE_COMMIT:
+
+			/*
+			 * The segment either failed to commit and aborted, or committed
+			 * before we failed; nothing was prepared either way.
+			 */
+			setCurrentGxactState(DTX_STATE_NOTIFYING_ABORT_NO_PREPARED);
+			break;
+
 		case DTX_STATE_PREPARING:
 			if (currentGxact->badPrepareGangs)
 			{
@@ -1591,6 +1798,8 @@ tmShmemInit(void)
 	shmNextSnapshotId = &shared->NextSnapshotId;
 	shmNumCommittedGxacts = &shared->num_committed_xacts;
 	shmCommittedGxactArray = &shared->committed_gxact_array[0];
+	shmCommitRecordsFlushed = &shared->commitRecordsFlushed;
+	shmCommitFlushes = &shared->commitFlushes;
 
 	if (!IsUnderPostmaster)
 		/* Initialize locks and shared memory area */
@@ -1603,6 +1812,8 @@ tmShmemInit(void)
 		*shmDtmStarted = false;
 		*shmTmRecoverred = false;
 		*shmNumCommittedGxacts = 0;
+		*shmCommitRecordsFlushed = 0;
+		*shmCommitFlushes = 0;
 	}
 }
 
@@ -2259,6 +2470,104 @@ insertedDistributedCommitted(void)
 	setCurrentGxactState(DTX_STATE_INSERTED_COMMITTED);
 }
 
+/*
+ * Flush the distributed commit record we just inserted.
+ *
+ * With gp_dtx_group_commit_delay, and at least commit_siblings other
+ * distributed transactions on their way to commit, we wait that long before
+ * the flush, so that the others insert their commit records meanwhile and
+ * whoever flushes first takes them all with the same fsync.  As with
+ * commit_delay, the wait is taken before asking for WALWriteLock, so that
+ * nobody waits on the lock while we sleep.  The forget records need no flush
+ * of their own; they go out with the next one.
+ */
+void
+flushDistributedCommitted(XLogRecPtr recptr)
+{
+	bool		flushed;
+
+	if (gp_dtx_group_commit_delay > 0 && enableFsync &&
+		MinimumActiveDistributedTransactions(CommitSiblings))
+		pg_usleep(gp_dtx_group_commit_delay);
+	else if (CommitDelay > 0 && enableFsync &&
+			 MinimumActiveBackends(CommitSiblings))
+		pg_usleep(CommitDelay);
+
+	flushed = XLogFlushTracked(recptr);
+
+	/*
+	 * The counters only matter when grouping; don't put another spinlock
+	 * on every commit otherwise.
+	 */
+	if (gp_dtx_group_commit_delay > 0)
+	{
+		SpinLockAcquire(shmControlSeqnoLock);
+		(*shmCommitRecordsFlushed)++;
+		if (flushed)
+			(*shmCommitFlushes)++;
+		SpinLockRelease(shmControlSeqnoLock);
+	}
+}
+
+/*
+ * Log how many distributed commit records each WAL flush carried since the
+ * last call.  Called at the end of each checkpoint, with log_checkpoints, by
+ * the checkpointer only.  The counts are only kept while
+ * gp_dtx_group_commit_delay is set.
+ */
+void
+logDistributedCommitFlushStats(void)
+{
+	static uint64 lastRecords = 0;
+	static uint64 lastFlushes = 0;
+	uint64		records;
+	uint64		flushes;
+
+	if (shmCommitRecordsFlushed == NULL)
+		return;
+
+	SpinLockAcquire(shmControlSeqnoLock);
+	records = *shmCommitRecordsFlushed - lastRecords;
+	flushes = *shmCommitFlushes - lastFlushes;
+	lastRecords += records;
+	lastFlushes += flushes;
+	SpinLockRelease(shmControlSeqnoLock);
+
+	if (records == 0)
+		return;
+
+	elog(LOG, "distributed commits: " UINT64_FORMAT " records in " UINT64_FORMAT
+		 " flushes, %.2f records per flush",
+		 records, flushes, flushes > 0 ? (double) records / flushes : (double) records);
+}
+
+/*
+ * Return how many distributed commit records were flushed, and in how many
+ * WAL flushes, since the server started.  These are only counted while
+ * gp_dtx_group_commit_delay is set.
+ */
+Datum
+gp_get_dtx_group_commit_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[2];
+	bool		nulls[2];
+	HeapTuple	tuple;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	MemSet(nulls, false, sizeof(nulls));
+	SpinLockAcquire(shmControlSeqnoLock);
+	values[0] = Int64GetDatum((int64) *shmCommitRecordsFlushed);
+	values[1] = Int64GetDatum((int64) *shmCommitFlushes);
+	SpinLockRelease(shmControlSeqnoLock);
+
+	tuple = heap_form_tuple(tupdesc, values, nulls);
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
 /* generate global transaction id */
 static DistributedTransactionId
 generateGID(void)
@@ -3098,8 +3407,31 @@ sendDtxExplicitBegin(void)
 static void
 performDtxProtocolPrepare(const char *gid)
 {
+	qePreparedReadOnly = false;
+
 	StartTransactionCommand();
 
+	/*
+	 * A QE that wrote nothing has nothing to prepare: commit right away,
+	 * which needs no fsync, and ignore the second phase when it comes.
+	 */
+	if (gp_enable_one_phase_commit &&
+		!TransactionIdIsValid(GetTopTransactionIdIfAny()))
+	{
+		elog(DTM_DEBUG5, "performDtxProtocolCommand going to commit read-only distributed transaction (id = '%s')", gid);
+		if (!EndTransactionBlock())
+		{
+			elog(ERROR, "Prepare of distributed transaction %s failed", gid);
+			return;
+		}
+
+		CommitTransactionCommand();
+
+		qePreparedReadOnly = true;
+		setDistributedTransactionContext(DTX_CONTEXT_QE_PREPARED);
+		return;
+	}
+
 	elog(DTM_DEBUG5, "performDtxProtocolCommand going to call PrepareTransactionBlock for distributed transaction (id = '%s')", gid);
 	if (!PrepareTransactionBlock((char *) gid))
 	{
@@ -3118,12 +3450,100 @@ performDtxProtocolPrepare(const char *gid)
 	setDistributedTransactionContext(DTX_CONTEXT_QE_PREPARED);
 }
 
+/**
+ * On the QE, commit the distributed transaction without preparing it.
+ */
+static void
+performDtxProtocolCommitOnePhase(const char *gid)
+{
+	StartTransactionCommand();
+
+	elog(DTM_DEBUG5, "performDtxProtocolCommand going to call EndTransactionBlock for distributed transaction (id = '%s')", gid);
+	if (!EndTransactionBlock())
+	{
+		elog(ERROR, "One-phase commit of distributed transaction %s failed", gid);
+		return;
+	}
+
+	dtxCrackOpenGid(gid, &qeOnePhaseDistribTimeStamp, &qeOnePhaseDistribXid);
+
+	qeOnePhaseCommit = true;
+	PG_TRY();
+	{
+		CommitTransactionCommand();
+	}
+	PG_CATCH();
+	{
+		qeOnePhaseCommit = false;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	qeOnePhaseCommit = false;
+
+	elog(DTM_DEBUG5, "One-phase commit of distributed transaction succeeded (id = '%s')", gid);
+}
+
+/**
+ * On the QE, tell whether a one-phase commit the QD lost track of committed
+ * here.  Returns if it did, and fails with ERRCODE_UNDEFINED_OBJECT if it
+ * did not and no longer can.
+ */
+static void
+performDtxProtocolRetryCommitOnePhase(const char *gid)
+{
+	DistributedTransactionTimeStamp distribTimeStamp;
+	DistributedTransactionId distribXid;
+	DistributedTransactionTimeStamp foundTimeStamp;
+	DistributedTransactionId foundXid;
+	TransactionId indexXid;
+
+	dtxCrackOpenGid(gid, &distribTimeStamp, &distribXid);
+
+	/*
+	 * The backend that was committing it may not have noticed the lost
+	 * connection yet.  Check this first: once it is done, its commit, if
+	 * any, is in the DistributedLog.
+	 */
+	if (DistributedTransactionIsActive(distribTimeStamp, distribXid))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_IN_USE),
+				 errmsg("distributed transaction %s is still in progress", gid)));
+
+	/*
+	 * The QD keeps the transaction in the oldest distributed xmin until it
+	 * knows the outcome, so its entry can't have been truncated away.  A
+	 * transaction that wrote nothing here leaves no entry either, but then
+	 * reporting it as not committed loses nothing.
+	 */
+	indexXid = ReadNewTransactionId();
+	while (DistributedLog_ScanForPrevCommitted(&indexXid, &foundTimeStamp, &foundXid))
+	{
+		if (foundTimeStamp == distribTimeStamp && foundXid == distribXid)
+		{
+			elog(DTM_DEBUG5, "Found one-phase commit of distributed transaction %s as local xid %u",
+				 gid, indexXid);
+			return;
+		}
+	}
+
+	ereport(ERROR,
+			(errcode(ERRCODE_UNDEFINED_OBJECT),
+			 errmsg("distributed transaction %s did not commit", gid)));
+}
+
 /**
  * On the QD, run the Commit Prepared operation.
  */
 static void
 performDtxProtocolCommitPrepared(const char *gid, bool raiseErrorIfNotFound)
 {
+	if (qePreparedReadOnly)
+	{
+		qePreparedReadOnly = false;
+		finishDistributedTransactionContext("performDtxProtocolCommitPrepared -- Read-Only", false);
+		return;
+	}
+
 	elog(DTM_DEBUG5,
 		 "performDtxProtocolCommitPrepared going to call FinishPreparedTransaction for distributed transaction %s", gid);
 
@@ -3158,6 +3578,13 @@ performDtxProtocolCommitPrepared(const char *gid, bool raiseErrorIfNotFound)
 static void
 performDtxProtocolAbortPrepared(const char *gid, bool raiseErrorIfNotFound)
 {
+	if (qePreparedReadOnly)
+	{
+		qePreparedReadOnly = false;
+		finishDistributedTransactionContext("performDtxProtocolAbortPrepared -- Read-Only", true);
+		return;
+	}
+
 	elog(DTM_DEBUG5, "performDtxProtocolAbortPrepared going to call FinishPreparedTransaction for distributed transaction %s", gid);
 
 	StartTransactionCommand();
@@ -3270,6 +3697,39 @@ performDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 			}
 			break;
 
+		case DTX_PROTOCOL_COMMAND_COMMIT_ONEPHASE:
+			switch (DistributedTransactionContext)
+			{
+				case DTX_CONTEXT_LOCAL_ONLY:
+					elog(ERROR, "Distributed transaction %s not found", gid);
+					break;
+
+				case DTX_CONTEXT_QE_TWO_PHASE_EXPLICIT_WRITER:
+				case DTX_CONTEXT_QE_TWO_PHASE_IMPLICIT_WRITER:
+					performDtxProtocolCommitOnePhase(gid);
+					break;
+
+				case DTX_CONTEXT_QD_DISTRIBUTED_CAPABLE:
+				case DTX_CONTEXT_QD_RETRY_PHASE_2:
+				case DTX_CONTEXT_QE_PREPARED:
+				case DTX_CONTEXT_QE_FINISH_PREPARED:
+				case DTX_CONTEXT_QE_ENTRY_DB_SINGLETON:
+				case DTX_CONTEXT_QE_READER:
+					elog(FATAL, "Unexpected segment distribute transaction context: '%s'",
+						 DtxContextToString(DistributedTransactionContext));
+
+				default:
+					elog(PANIC, "Unexpected segment distribute transaction context value: %d",
+						 (int) DistributedTransactionContext);
+					break;
+			}
+			break;
+
+		case DTX_PROTOCOL_COMMAND_RETRY_COMMIT_ONEPHASE:
+			requireDistributedTransactionContext(DTX_CONTEXT_LOCAL_ONLY);
+			performDtxProtocolRetryCommitOnePhase(gid);
+			break;
+
 		case DTX_PROTOCOL_COMMAND_ABORT_SOME_PREPARED:
 			switch (DistributedTransactionContext)
 			{
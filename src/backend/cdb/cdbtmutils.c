@@ -50,6 +50,8 @@ DtxStateToString(DtxState state)
 			return "Active Not Distributed";
 		case DTX_STATE_ACTIVE_DISTRIBUTED:
 			return "Active Distributed";
+		case DTX_STATE_ONE_PHASE_COMMIT:
+			return "One-Phase Commit";
 		case DTX_STATE_PREPARING:
 			return "Preparing";
 		case DTX_STATE_PREPARED:
@@ -114,6 +116,10 @@ DtxProtocolCommandToString(DtxProtocolCommand command)
 			return "Release Current Subtransaction";
 		case DTX_PROTOCOL_COMMAND_SUBTRANSACTION_ROLLBACK_INTERNAL:
 			return "Rollback Current Subtransaction";
+		case DTX_PROTOCOL_COMMAND_COMMIT_ONEPHASE:
+			return "Distributed Commit (One-Phase)";
+		case DTX_PROTOCOL_COMMAND_RETRY_COMMIT_ONEPHASE:
+			return "Retry Distributed Commit (One-Phase)";
 	}
 
 	return "Unknown";
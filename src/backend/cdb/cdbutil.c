@@ -588,6 +588,7 @@ void
 				 ((double) cdb_total_slices / (double) cdb_total_plans),
 				 cdb_max_slices);
 		}
+		logGangStats();
 	}
 
 	if (Gp_role != GP_ROLE_UTILITY)
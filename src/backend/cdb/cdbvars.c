@@ -128,6 +128,18 @@ int			gp_fts_probe_timeout = 20;
  */
 int			gp_fts_probe_interval = 60;
 
+/*
+ * Maximum number of segments the fts prober has probes in flight with, 0 for
+ * no limit.
+ */
+int			gp_fts_probe_max_concurrency = 0;
+
+/*
+ * Probe each segment on its own schedule, spread over the probe interval,
+ * rather than all of them every interval.
+ */
+bool		gp_fts_probe_spread = false;
+
 /*
  * If mirror disconnects and re-connects between this period, or just takes
  * this much time during initial connection of cluster start, it will not get
@@ -263,6 +275,19 @@ int			gp_segworker_relative_priority = PRIO_MAX;
 /* Max size of dispatched plans; 0 if no limit */
 int			gp_max_plan_size = 0;
 
+/* Number of dispatched plans to cache per session; 0 to disable */
+int			gp_dispatch_plan_cache_size = 0;
+
+/* Compression of dispatched plans, and the size in kB below which it's skipped */
+int			gp_dispatch_compress_algorithm = DISPATCH_COMPRESS_ZLIB;
+int			gp_dispatch_compress_threshold = 0;
+
+/* Send each gang only the part of the plan its slice executes */
+bool		gp_dispatch_slice_plans = false;
+
+/* Overlap the sending of the plan with the master's interconnect setup */
+bool		gp_dispatch_pipelined = false;
+
 /* Disable setting of tuple hints while reading */
 bool		gp_disable_tuple_hints = false;
 
@@ -284,6 +309,18 @@ int			gp_workfile_bytes_to_checksum = 16;
 /* The type of work files that HashJoin should use */
 int			gp_workfile_type_hashjoin = 0;
 
+/* Reuse the spilled output of identical subplans across queries */
+bool		gp_workfile_reuse = false;
+
+/* Maximum disk space to keep for reusable workfiles on a segment, in kilobytes */
+int			gp_workfile_reuse_limit = 10485760;
+
+/* Do workfile I/O on a helper thread */
+bool		gp_workfile_async_io = false;
+
+/* Let operators borrow memory that other operators of the query gave back */
+bool		gp_enable_memory_broker = false;
+
 /* Gpmon */
 bool		gp_enable_gpperfmon = false;
 int			gp_gpperfmon_send_interval = 1;
@@ -295,6 +332,12 @@ bool		gp_enable_fast_sri = true;
 /* Enable single-mirror pair dispatch. */
 bool		gp_enable_direct_dispatch = true;
 
+/* Commit single-segment distributed transactions without preparing. */
+bool		gp_enable_one_phase_commit = false;
+
+/* Microseconds to hold a WAL flush for other distributed commit records. */
+int			gp_dtx_group_commit_delay = 0;
+
 /* Force core dump on memory context error */
 bool		coredump_on_memerror = false;
 
@@ -114,6 +114,7 @@ cdbdisp_dispatchToGang(struct CdbDispatcherState *ds,
 void
 cdbdisp_waitDispatchFinish(struct CdbDispatcherState *ds)
 {
+	ds->dispatchPending = false;
 	if (pDispatchFuncs->waitDispatchFinish != NULL)
 		(pDispatchFuncs->waitDispatchFinish) (ds);
 }
@@ -130,6 +131,14 @@ void
 cdbdisp_checkDispatchResult(struct CdbDispatcherState *ds,
 					   DispatchWaitMode waitMode)
 {
+	/*
+	 * The QEs can't complete a command they haven't fully received.  When
+	 * canceling, the dispatcher gives up on the QEs that haven't got all of
+	 * it instead.
+	 */
+	if (ds->dispatchPending && waitMode != DISPATCH_WAIT_CANCEL)
+		cdbdisp_waitDispatchFinish(ds);
+
 	(pDispatchFuncs->checkResults) (ds, waitMode);
 
 	if (log_dispatch_stats)
@@ -321,6 +330,14 @@ cdbdisp_makeDispatchParams(CdbDispatcherState *ds,
 	MemoryContextSwitchTo(oldContext);
 }
 
+void
+cdbdisp_setDispatchQueryText(CdbDispatcherState *ds, char *queryText, int queryTextLen)
+{
+	Assert(ds->dispatchParams);
+
+	(pDispatchFuncs->setQueryText) (ds, queryText, queryTextLen);
+}
+
 /*
  * Free memory in CdbDispatcherState
  *
@@ -337,6 +354,16 @@ cdbdisp_destroyDispatcherState(CdbDispatcherState *ds)
 	CdbDispatchResults *results = ds->primaryResults;
 	dispatcher_handle_t *h = find_dispatcher_handle(ds);
 
+	/*
+	 * If the command never got to all QEs, some of them are still waiting
+	 * for the rest of it, and their gangs can't be cleaned up for reuse.
+	 */
+	if (ds->dispatchPending)
+	{
+		ds->dispatchPending = false;
+		ds->recycleGang = false;
+	}
+
 	if (results != NULL && results->resultArray != NULL)
 	{
 		int			i;
@@ -83,6 +83,7 @@ typedef struct CdbDispatchCmdAsync
 } CdbDispatchCmdAsync;
 
 static void *cdbdisp_makeDispatchParams_async(int maxSlices, char *queryText, int len);
+static void cdbdisp_setQueryText_async(struct CdbDispatcherState *ds, char *queryText, int len);
 
 static void cdbdisp_checkDispatchResult_async(struct CdbDispatcherState *ds,
 								  DispatchWaitMode waitMode);
@@ -104,7 +105,8 @@ DispatcherInternalFuncs DispatcherAsyncFuncs =
 	cdbdisp_makeDispatchParams_async,
 	cdbdisp_checkDispatchResult_async,
 	cdbdisp_dispatchToGang_async,
-	cdbdisp_waitDispatchFinish_async
+	cdbdisp_waitDispatchFinish_async,
+	cdbdisp_setQueryText_async
 };
 
 
@@ -117,6 +119,8 @@ static void checkDispatchResult(CdbDispatcherState *ds,
 
 static bool processResults(CdbDispatchResult *dispatchResult);
 
+static void abandonPendingDispatch(CdbDispatcherState *ds);
+
 static void
 			signalQEs(CdbDispatchCmdAsync *pParms);
 
@@ -334,6 +338,17 @@ cdbdisp_checkDispatchResult_async(struct CdbDispatcherState *ds,
 	if (pParms == NULL)
 		return;
 
+	/*
+	 * The command may still be on its way to some QEs, with
+	 * gp_dispatch_pipelined.  cdbdisp_checkDispatchResult finishes sending it
+	 * unless we are canceling.
+	 */
+	if (ds->dispatchPending)
+	{
+		Assert(waitMode == DISPATCH_WAIT_CANCEL);
+		abandonPendingDispatch(ds);
+	}
+
 	/*
 	 * Don't overwrite DISPATCH_WAIT_CANCEL or DISPATCH_WAIT_FINISH with
 	 * DISPATCH_WAIT_NONE
@@ -353,6 +368,54 @@ cdbdisp_checkDispatchResult_async(struct CdbDispatcherState *ds,
 		CHECK_FOR_INTERRUPTS();
 }
 
+/*
+ * Give up on a command that gp_dispatch_pipelined left in flight, because
+ * the query is being canceled.
+ *
+ * A QE that has received only part of its command can't be canceled: it is
+ * still waiting for the rest.  Don't send it the rest, nor wait for it to
+ * finish, and have its gang destroyed rather than recycled, since the
+ * connection is out of sync.  The QE exits when it is disconnected.
+ */
+static void
+abandonPendingDispatch(CdbDispatcherState *ds)
+{
+	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync *) ds->dispatchParams;
+	int			i;
+
+	ds->dispatchPending = false;
+
+	for (i = 0; i < pParms->dispatchCount; i++)
+	{
+		CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
+		SegmentDatabaseDescriptor *segdbDesc = dispatchResult->segdbDesc;
+		PGconn	   *conn = segdbDesc->conn;
+		ListCell   *lc;
+
+		if (!dispatchResult->stillRunning || conn->outCount == 0)
+			continue;
+
+		/* Maybe the rest goes out right away */
+		if (pqFlushNonBlocking(conn) == 0)
+			continue;
+
+		elog(LOG, "Abandoning the command partially dispatched to %s",
+			 segdbDesc->whoami);
+
+		conn->outCount = 0;
+		dispatchResult->stillRunning = false;
+
+		foreach(lc, ds->allocatedGangs)
+		{
+			Gang	   *gp = (Gang *) lfirst(lc);
+
+			if (segdbDesc >= gp->db_descriptors &&
+				segdbDesc < gp->db_descriptors + gp->size)
+				gp->noReuse = true;
+		}
+	}
+}
+
 /*
  * Allocates memory for a CdbDispatchCmdAsync structure and do the initialization.
  *
@@ -377,6 +440,19 @@ cdbdisp_makeDispatchParams_async(int maxSlices, char *queryText, int len)
 	return (void *) pParms;
 }
 
+/*
+ * Change the command for the gangs dispatched to from now on.  The previous
+ * text may still be queued in libpq, so it is left alone.
+ */
+static void
+cdbdisp_setQueryText_async(struct CdbDispatcherState *ds, char *queryText, int len)
+{
+	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync *) ds->dispatchParams;
+
+	pParms->query_text = queryText;
+	pParms->query_text_len = len;
+}
+
 /*
  * Receive and process results from all running QEs.
  *
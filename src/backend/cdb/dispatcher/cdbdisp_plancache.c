@@ -0,0 +1,225 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbdisp_plancache.c
+ *	  Per-session cache of dispatched plans, on the QD and on the QEs.
+ *
+ * A statement executed over and over, typically a prepared one, is planned
+ * once but serialized, compressed, shipped and deserialized again on every
+ * execution.  With gp_dispatch_plan_cache_size > 0, the QD keeps the last
+ * few plans it dispatched in a small array of slots, and each QE keeps the
+ * deserialized plan it received in the same slot.
+ *
+ * The QD still flattens the plan on every execution, and compares the
+ * flattened bytes with what it has in its slots.  On a hit, it reuses the
+ * compressed string instead of compressing again, and if every QE the plan
+ * goes to has already received that plan (which the QD tracks in the
+ * SegmentDatabaseDescriptor of each QE), only the slot and the plan id are
+ * sent along with the parameters and the QueryDispatchDesc.  The QE then
+ * executes a copy of the plan it kept, since the executor scribbles on
+ * plan nodes.
+ *
+ * The QD decides what goes in which slot; the QEs just do as they are told.
+ * A QE that reports an error forgets nothing, but the QD forgets what it
+ * thought the QE had (see cdbdisp_seterrcode), so the next dispatch ships
+ * the full plan again.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/dispatcher/cdbdisp_plancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "cdb/cdbdisp_plancache.h"
+#include "cdb/cdbsrlz.h"
+#include "cdb/cdbvars.h"
+#include "utils/memaccounting.h"
+#include "utils/memutils.h"
+
+/* A plan the QD dispatched, kept in its flattened and compressed forms */
+typedef struct DispatchedPlan
+{
+	uint32		planId;			/* 0 if the slot is empty */
+	uint32		hash;			/* of the flattened plan */
+	char	   *flat;
+	int			flat_len;
+	char	   *compressed;
+	int			compressed_len;
+	uint64		lastUsed;
+} DispatchedPlan;
+
+/* A plan a QE received, deserialized and kept in its own context */
+typedef struct ReceivedPlan
+{
+	uint32		planId;			/* 0 if the slot is empty */
+	MemoryContext context;
+	PlannedStmt *stmt;
+} ReceivedPlan;
+
+static DispatchedPlan dispatchedPlans[MAX_GP_DISPATCH_PLAN_CACHE_SIZE];
+static ReceivedPlan receivedPlans[MAX_GP_DISPATCH_PLAN_CACHE_SIZE];
+
+static MemoryContext DispatchPlanCacheContext = NULL;
+static uint32 nextPlanId = 1;
+static uint64 planCacheClock = 0;
+
+static MemoryContext
+getPlanCacheContext(void)
+{
+	if (DispatchPlanCacheContext == NULL)
+		DispatchPlanCacheContext = AllocSetContextCreate(TopMemoryContext,
+														 "DispatchPlanCache",
+														 ALLOCSET_DEFAULT_MINSIZE,
+														 ALLOCSET_DEFAULT_INITSIZE,
+														 ALLOCSET_DEFAULT_MAXSIZE);
+	return DispatchPlanCacheContext;
+}
+
+/*
+ * Compress a plan flattened for dispatch, going through the cache if it's
+ * enabled.  Takes ownership of 'flat'.
+ *
+ * On return, *slot and *planId identify the plan in the cache, or *slot is
+ * -1 if the plan isn't cached.  The returned string must not be freed by the
+ * caller; it may belong to the cache.
+ */
+char *
+cdbdisp_compressPlan(char *flat, int flat_len, int *size,
+					 int *slot, uint32 *planId)
+{
+	DispatchedPlan *entry;
+	DispatchedPlan *victim = NULL;
+	MemoryContext oldcxt;
+	char	   *result;
+	uint32		hash;
+	int			i;
+
+	*slot = -1;
+	*planId = 0;
+
+	if (gp_dispatch_plan_cache_size <= 0)
+	{
+		START_MEMORY_ACCOUNT(MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Serializer));
+		{
+			result = compressSerializedNode(flat, flat_len, size);
+		}
+		END_MEMORY_ACCOUNT();
+		pfree(flat);
+		return result;
+	}
+
+	hash = DatumGetUInt32(hash_any((const unsigned char *) flat, flat_len));
+
+	for (i = 0; i < gp_dispatch_plan_cache_size; i++)
+	{
+		entry = &dispatchedPlans[i];
+
+		if (entry->planId != 0 &&
+			entry->hash == hash &&
+			entry->flat_len == flat_len &&
+			memcmp(entry->flat, flat, flat_len) == 0)
+		{
+			pfree(flat);
+			entry->lastUsed = ++planCacheClock;
+			*slot = i;
+			*planId = entry->planId;
+			*size = entry->compressed_len;
+			return entry->compressed;
+		}
+
+		if (victim == NULL || entry->planId == 0 ||
+			(victim->planId != 0 && entry->lastUsed < victim->lastUsed))
+			victim = entry;
+	}
+
+	/* Not seen before: compress it, and keep it in place of the oldest */
+	Assert(victim != NULL);
+	if (victim->planId != 0)
+	{
+		pfree(victim->flat);
+		pfree(victim->compressed);
+	}
+
+	oldcxt = MemoryContextSwitchTo(getPlanCacheContext());
+	START_MEMORY_ACCOUNT(MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Serializer));
+	{
+		victim->compressed = compressSerializedNode(flat, flat_len, &victim->compressed_len);
+	}
+	END_MEMORY_ACCOUNT();
+	victim->flat = palloc(flat_len);
+	MemoryContextSwitchTo(oldcxt);
+
+	memcpy(victim->flat, flat, flat_len);
+	pfree(flat);
+
+	victim->flat_len = flat_len;
+	victim->hash = hash;
+	victim->lastUsed = ++planCacheClock;
+	victim->planId = nextPlanId++;
+	if (nextPlanId == 0)
+		nextPlanId = 1;
+
+	*slot = victim - dispatchedPlans;
+	*planId = victim->planId;
+	*size = victim->compressed_len;
+	return victim->compressed;
+}
+
+/*
+ * Keep a plan received from the QD in the given slot.  The plan is copied,
+ * so the caller may go ahead and execute it.
+ */
+void
+cdbdisp_cacheReceivedPlan(int slot, uint32 planId, PlannedStmt *stmt)
+{
+	ReceivedPlan *entry;
+	MemoryContext oldcxt;
+
+	if (slot < 0 || slot >= MAX_GP_DISPATCH_PLAN_CACHE_SIZE || planId == 0)
+		elog(ERROR, "invalid dispatched plan cache slot %d for plan %u",
+			 slot, planId);
+
+	entry = &receivedPlans[slot];
+	if (entry->context != NULL)
+		MemoryContextDelete(entry->context);
+	entry->context = NULL;
+	entry->planId = 0;
+	entry->stmt = NULL;
+
+	entry->context = AllocSetContextCreate(getPlanCacheContext(),
+										   "DispatchedPlan",
+										   ALLOCSET_SMALL_MINSIZE,
+										   ALLOCSET_SMALL_INITSIZE,
+										   ALLOCSET_DEFAULT_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(entry->context);
+	entry->stmt = (PlannedStmt *) copyObject(stmt);
+	MemoryContextSwitchTo(oldcxt);
+
+	entry->planId = planId;
+}
+
+/*
+ * Return a copy, in the current memory context, of a plan kept by
+ * cdbdisp_cacheReceivedPlan.
+ */
+PlannedStmt *
+cdbdisp_getCachedPlan(int slot, uint32 planId)
+{
+	ReceivedPlan *entry;
+
+	if (slot < 0 || slot >= MAX_GP_DISPATCH_PLAN_CACHE_SIZE ||
+		receivedPlans[slot].planId != planId || planId == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("dispatched plan %u not found in plan cache slot %d",
+						planId, slot)));
+
+	entry = &receivedPlans[slot];
+
+	return (PlannedStmt *) copyObject(entry->stmt);
+}
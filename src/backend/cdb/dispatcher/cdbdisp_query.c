@@ -27,6 +27,7 @@
 #include "cdb/cdbsrlz.h"
 #include "cdb/tupleremap.h"
 #include "nodes/execnodes.h"
+#include "optimizer/walkers.h"
 #include "tcop/tcopprot.h"
 #include "utils/datum.h"
 #include "utils/guc.h"
@@ -41,6 +42,8 @@
 
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbdisp_query.h"
+#include "cdb/cdbdisp_plancache.h"
+#include "cdb/cdbexplain.h"
 #include "cdb/cdbdisp_thread.h" /* for CdbDispatchCmdThreads and
 								 * DispatchCommandParms */
 #include "cdb/cdbdisp_dtx.h"	/* for qdSerializeDtxContextInfo() */
@@ -75,6 +78,13 @@ typedef struct DispatchCommandQueryParms
 	int			serializedQuerytreelen;
 	char	   *serializedPlantree;
 	int			serializedPlantreelen;
+
+	/*
+	 * Where the plan is in the dispatched plan cache, -1 if it's not.  If
+	 * serializedPlantree is NULL, the QEs already have it.
+	 */
+	int			planCacheSlot;
+	uint32		planId;
 	char	   *serializedQueryDispatchDesc;
 	int			serializedQueryDispatchDesclen;
 	char	   *serializedParams;
@@ -108,6 +118,8 @@ static char *buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 				   int *finalLen);
 
 static DispatchCommandQueryParms *cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc, bool planRequiresTxn);
+static void cdbdisp_setQueryParmsPlan(DispatchCommandQueryParms *pQueryParms,
+						  PlannedStmt *stmt, SliceTable *sliceTbl, Slice *slice);
 static DispatchCommandQueryParms *cdbdisp_buildUtilityQueryParms(struct Node *stmt, int flags, List *oid_assignments);
 static DispatchCommandQueryParms *cdbdisp_buildCommandQueryParms(const char *strCommand, int flags);
 
@@ -436,6 +448,7 @@ cdbdisp_buildCommandQueryParms(const char *strCommand, int flags)
 	pQueryParms->serializedQuerytreelen = 0;
 	pQueryParms->serializedQueryDispatchDesc = NULL;
 	pQueryParms->serializedQueryDispatchDesclen = 0;
+	pQueryParms->planCacheSlot = -1;
 
 	/*
 	 * Serialize a version of our DTX Context Info
@@ -507,6 +520,7 @@ cdbdisp_buildUtilityQueryParms(struct Node *stmt,
 	pQueryParms->serializedQuerytreelen = serializedQuerytree_len;
 	pQueryParms->serializedQueryDispatchDesc = serializedQueryDispatchDesc;
 	pQueryParms->serializedQueryDispatchDesclen = serializedQueryDispatchDesc_len;
+	pQueryParms->planCacheSlot = -1;
 
 	/*
 	 * Serialize a version of our DTX Context Info
@@ -524,13 +538,10 @@ static DispatchCommandQueryParms *
 cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 							bool planRequiresTxn)
 {
-	char	   *splan,
-			   *sddesc,
+	char	   *sddesc,
 			   *sparams;
 
-	int			splan_len,
-				splan_len_uncompressed,
-				sddesc_len,
+	int			sddesc_len,
 				sparams_len,
 				rootIdx;
 
@@ -547,28 +558,10 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	DispatchCommandQueryParms *pQueryParms = (DispatchCommandQueryParms *) palloc0(sizeof(*pQueryParms));
 
 	/*
-	 * serialized plan tree. Note that we're called for a single slice tree
-	 * (corresponding to an initPlan or the main plan), so the parameters are
-	 * fixed and we can include them in the prefix.
+	 * The plan tree itself is filled in by cdbdisp_setQueryParmsPlan, as
+	 * each gang may get a plan of its own.
 	 */
-	splan = serializeNode((Node *) queryDesc->plannedstmt, &splan_len, &splan_len_uncompressed);
-
-	uint64		plan_size_in_kb = ((uint64) splan_len_uncompressed) / (uint64) 1024;
-
-	elog(((gp_log_gang >= GPVARS_VERBOSITY_TERSE) ? LOG : DEBUG1),
-		 "Query plan size to dispatch: " UINT64_FORMAT "KB", plan_size_in_kb);
-
-	if (0 < gp_max_plan_size && plan_size_in_kb > gp_max_plan_size)
-	{
-		ereport(ERROR,
-				(errcode(ERRCODE_STATEMENT_TOO_COMPLEX),
-				 (errmsg("Query plan size limit exceeded, current size: "
-						 UINT64_FORMAT "KB, max allowed size: %dKB",
-						 plan_size_in_kb, gp_max_plan_size),
-				  errhint("Size controlled by gp_max_plan_size"))));
-	}
-
-	Assert(splan != NULL && splan_len > 0 && splan_len_uncompressed > 0);
+	pQueryParms->planCacheSlot = -1;
 
 	if (queryDesc->params != NULL && queryDesc->params->numParams > 0)
 	{
@@ -585,8 +578,6 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	pQueryParms->strCommand = queryDesc->sourceText;
 	pQueryParms->serializedQuerytree = NULL;
 	pQueryParms->serializedQuerytreelen = 0;
-	pQueryParms->serializedPlantree = splan;
-	pQueryParms->serializedPlantreelen = splan_len;
 	pQueryParms->serializedParams = sparams;
 	pQueryParms->serializedParamslen = sparams_len;
 	pQueryParms->serializedQueryDispatchDesc = sddesc;
@@ -609,6 +600,103 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	return pQueryParms;
 }
 
+typedef struct SlicePlanContext
+{
+	plan_tree_base_prefix base; /* Required prefix for plan_tree_walker */
+	Bitmapset  *motions;		/* Motions whose subtrees are kept */
+	Bitmapset  *subplans;		/* subplans (plan_id - 1) reachable from them */
+} SlicePlanContext;
+
+static bool
+SlicePlanSubplanWalker(Node *node, void *context)
+{
+	SlicePlanContext *ctx = (SlicePlanContext *) context;
+
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Motion) &&
+		!bms_is_member(((Motion *) node)->motionID, ctx->motions))
+		return false;			/* don't visit subtree */
+
+	if (IsA(node, SubPlan))
+	{
+		int			i = ((SubPlan *) node)->plan_id - 1;
+
+		if (bms_is_member(i, ctx->subplans))
+			return false;
+		ctx->subplans = bms_add_member(ctx->subplans, i);
+	}
+
+	return plan_tree_walker(node, SlicePlanSubplanWalker, ctx);
+}
+
+/*
+ * Fill in the plan tree to dispatch in pQueryParms.  With 'slice', that's
+ * the plan for the gang of that slice only: the subtrees of the Motions that
+ * send to other slices are left out, and so are the subplans that only they
+ * use.  What a QE of the slice executes, the Motion its slice sends from,
+ * is kept along with the path from the root to it, so that the QE can find
+ * it (see findSenderMotion) and the init plans above it.
+ */
+static void
+cdbdisp_setQueryParmsPlan(DispatchCommandQueryParms *pQueryParms,
+						  PlannedStmt *stmt, SliceTable *sliceTbl, Slice *slice)
+{
+	char	   *flat;
+	int			flat_len;
+
+	if (slice == NULL)
+		flat = serializeNodeUncompressed((Node *) stmt, &flat_len);
+	else
+	{
+		SlicePlanContext ctx;
+		Slice	   *s = slice;
+
+		ctx.base.node = (Node *) stmt;
+		ctx.motions = NULL;
+		ctx.subplans = NULL;
+
+		/* The Motion of a slice has the slice's index as its motionID */
+		for (;;)
+		{
+			ctx.motions = bms_add_member(ctx.motions, s->sliceIndex);
+			if (s->parentIndex < 0)
+				break;
+			s = (Slice *) list_nth(sliceTbl->slices, s->parentIndex);
+		}
+		SlicePlanSubplanWalker((Node *) stmt->planTree, &ctx);
+
+		flat = serializePlanForSliceUncompressed(stmt, ctx.motions, ctx.subplans,
+												 &flat_len);
+		bms_free(ctx.motions);
+		bms_free(ctx.subplans);
+	}
+
+	uint64		plan_size_in_kb = ((uint64) flat_len) / (uint64) 1024;
+
+	elog(((gp_log_gang >= GPVARS_VERBOSITY_TERSE) ? LOG : DEBUG1),
+		 "Query plan size to dispatch: " UINT64_FORMAT "KB", plan_size_in_kb);
+
+	if (0 < gp_max_plan_size && plan_size_in_kb > gp_max_plan_size)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_STATEMENT_TOO_COMPLEX),
+				 (errmsg("Query plan size limit exceeded, current size: "
+						 UINT64_FORMAT "KB, max allowed size: %dKB",
+						 plan_size_in_kb, gp_max_plan_size),
+				  errhint("Size controlled by gp_max_plan_size"))));
+	}
+
+	pQueryParms->serializedPlantree =
+		cdbdisp_compressPlan(flat, flat_len,
+							 &pQueryParms->serializedPlantreelen,
+							 &pQueryParms->planCacheSlot, &pQueryParms->planId);
+
+	Assert(pQueryParms->serializedPlantree != NULL &&
+		   pQueryParms->serializedPlantreelen > 0);
+}
+
 /*
  * Three Helper functions for cdbdisp_dispatchX:
  *
@@ -799,6 +887,8 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	const char *dtxContextInfo = pQueryParms->serializedDtxContextInfo;
 	int			dtxContextInfo_len = pQueryParms->serializedDtxContextInfolen;
 	int			flags = 0;		/* unused flags */
+	int			planCacheSlot = pQueryParms->planCacheSlot;
+	uint32		planId = pQueryParms->planId;
 	int			rootIdx = pQueryParms->rootIdx;
 	int			numSlices = pQueryParms->numSlices;
 	int		   *sliceIndexGangIdMap = pQueryParms->sliceIndexGangIdMap;
@@ -837,6 +927,8 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 		sizeof(dtxContextInfo_len) +
 		dtxContextInfo_len +
 		sizeof(flags) +
+		sizeof(planCacheSlot) +
+		sizeof(planId) +
 		command_len +
 		querytree_len +
 		plantree_len +
@@ -931,6 +1023,14 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	memcpy(pos, &tmp, sizeof(tmp));
 	pos += sizeof(tmp);
 
+	tmp = htonl(planCacheSlot);
+	memcpy(pos, &tmp, sizeof(tmp));
+	pos += sizeof(tmp);
+
+	n32 = htonl(planId);
+	memcpy(pos, &n32, sizeof(n32));
+	pos += sizeof(n32);
+
 	memcpy(pos, command, command_len);
 	pos += command_len;
 
@@ -1000,6 +1100,58 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	return shared_query;
 }
 
+/*
+ * Does every QE the slices are dispatched to hold the given plan in its
+ * dispatched plan cache?
+ */
+static bool
+planCachedOnQEs(SliceVec *sliceVector, int nSlices, int slot, uint32 planId)
+{
+	int			iSlice;
+	int			i;
+
+	for (iSlice = 0; iSlice < nSlices; iSlice++)
+	{
+		Slice	   *slice = sliceVector[iSlice].slice;
+		Gang	   *gang = slice->primaryGang;
+		bool		direct = slice->directDispatch.isDirectDispatch;
+
+		if (slice->gangType == GANGTYPE_UNALLOCATED)
+			continue;
+
+		for (i = 0; i < gang->size; i++)
+		{
+			SegmentDatabaseDescriptor *segdbDesc = &gang->db_descriptors[i];
+
+			if (direct &&
+				segdbDesc->segindex != linitial_int(slice->directDispatch.contentIds))
+				continue;
+			if (segdbDesc->cachedPlanIds[slot] != planId)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Remember that the QEs of a gang we just dispatched to now hold the plan.
+ */
+static void
+markPlanCached(Gang *gang, CdbDispatchDirectDesc *direct, int slot, uint32 planId)
+{
+	int			i;
+
+	for (i = 0; i < gang->size; i++)
+	{
+		SegmentDatabaseDescriptor *segdbDesc = &gang->db_descriptors[i];
+
+		if (direct->directed_dispatch && segdbDesc->segindex != direct->content[0])
+			continue;
+		segdbDesc->cachedPlanIds[slot] = planId;
+	}
+}
+
 /*
  * This function is used for dispatching sliced plans
  */
@@ -1021,6 +1173,12 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	CdbDispatcherState *ds;
 	ErrorData *qeError = NULL;
 	DispatchCommandQueryParms *pQueryParms;
+	instr_time	gangTime;
+	instr_time	serializeTime;
+	instr_time	compressTime;
+	instr_time	sendTime;
+	bool		slicePlans;
+	bool		pipelined;
 
 	if (log_dispatch_stats)
 		ResetUsage();
@@ -1049,7 +1207,16 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	 * 
 	 * Notice: This must be done before cdbdisp_buildPlanQueryParms
 	 */
+	INSTR_TIME_SET_CURRENT(gangTime);
 	AssignGangs(ds, queryDesc);
+	if (queryDesc->showstatctx)
+	{
+		instr_time	now;
+
+		INSTR_TIME_SET_CURRENT(now);
+		INSTR_TIME_SUBTRACT(now, gangTime);
+		gangTime = now;
+	}
 
 	/*
 	 * Traverse the slice tree in sliceTbl rooted at rootIdx and build a
@@ -1059,10 +1226,55 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	sliceVector = palloc0(nTotalSlices * sizeof(SliceVec));
 	nSlices = fillSliceVector(sliceTbl, rootIdx, sliceVector, nTotalSlices);
 
+	/*
+	 * Send each gang a plan of its own, trimmed to its slice?  The QEs only
+	 * ignore the other slices' subtrees if they eliminate alien nodes.  Only
+	 * done for the main plan: the slices of an init plan hang off a SubPlan
+	 * that may itself be in another slice's subtree.
+	 */
+	slicePlans = gp_dispatch_slice_plans && execute_pruned_plan &&
+		queryDesc->plannedstmt->nMotionNodes > 0 && rootIdx == 0;
+
+	/*
+	 * Let ExecutorStart set up our end of the interconnect before we wait for
+	 * the plan to reach every QE?  The slices are dispatched bottom-up, so
+	 * the QEs that get their plan first run the leaf slices, and can send to
+	 * us as soon as we are set up.  Only the UDP interconnect keeps packets
+	 * that arrive before their receiver is set up, and only the main plan's
+	 * root slice runs here.
+	 */
+	pipelined = gp_dispatch_pipelined &&
+		Gp_interconnect_type == INTERCONNECT_TYPE_UDPIFC &&
+		queryDesc->plannedstmt->nMotionNodes > 0 && rootIdx == 0 &&
+		((Slice *) list_nth(sliceTbl->slices, rootIdx))->gangType == GANGTYPE_UNALLOCATED;
+
+	/* For EXPLAIN ANALYZE, see how long the serializing takes */
+	serializeTime = serializeNodeTime;
+	compressTime = compressNodeTime;
+	INSTR_TIME_SET_CURRENT(sendTime);
+
 	pQueryParms = cdbdisp_buildPlanQueryParms(queryDesc, planRequiresTxn);
 	pQueryParms->numSlices = nTotalSlices;
 	pQueryParms->sliceIndexGangIdMap = buildSliceIndexGangIdMap(sliceVector, nSlices, nTotalSlices);
-	queryText = buildGpQueryString(pQueryParms, &queryTextLength);
+
+	if (!slicePlans)
+	{
+		cdbdisp_setQueryParmsPlan(pQueryParms, queryDesc->plannedstmt, sliceTbl, NULL);
+
+		/*
+		 * If every QE we're about to dispatch to has kept this plan from an
+		 * earlier dispatch, send it by reference.
+		 */
+		if (pQueryParms->planCacheSlot >= 0 &&
+			planCachedOnQEs(sliceVector, nSlices,
+							pQueryParms->planCacheSlot, pQueryParms->planId))
+		{
+			pQueryParms->serializedPlantree = NULL;
+			pQueryParms->serializedPlantreelen = 0;
+		}
+
+		queryText = buildGpQueryString(pQueryParms, &queryTextLength);
+	}
 
 	/*
 	 * Allocate result array with enough slots for QEs of primary gangs.
@@ -1159,14 +1371,60 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 				break;
 		}
 
+		if (slicePlans)
+		{
+			cdbdisp_setQueryParmsPlan(pQueryParms, queryDesc->plannedstmt,
+									  sliceTbl, slice);
+			if (pQueryParms->planCacheSlot >= 0 &&
+				planCachedOnQEs(&sliceVector[iSlice], 1,
+								pQueryParms->planCacheSlot, pQueryParms->planId))
+			{
+				pQueryParms->serializedPlantree = NULL;
+				pQueryParms->serializedPlantreelen = 0;
+			}
+
+			queryText = buildGpQueryString(pQueryParms, &queryTextLength);
+			cdbdisp_setDispatchQueryText(ds, queryText, queryTextLength);
+		}
+
 		cdbdisp_dispatchToGang(ds, primaryGang, si, &direct);
 
+		if (pQueryParms->planCacheSlot >= 0)
+			markPlanCached(primaryGang, &direct,
+						   pQueryParms->planCacheSlot, pQueryParms->planId);
+
 		SIMPLE_FAULT_INJECTOR(AfterOneSliceDispatched);
 	}
 
 	pfree(sliceVector);
 
-	cdbdisp_waitDispatchFinish(ds);
+	if (pipelined && iSlice == nSlices)
+		ds->dispatchPending = true;
+	else
+		cdbdisp_waitDispatchFinish(ds);
+
+	if (queryDesc->showstatctx)
+	{
+		instr_time	now;
+
+		now = serializeNodeTime;
+		INSTR_TIME_SUBTRACT(now, serializeTime);
+		serializeTime = now;
+
+		now = compressNodeTime;
+		INSTR_TIME_SUBTRACT(now, compressTime);
+		compressTime = now;
+
+		/* The rest of the time is spent building and sending the commands */
+		INSTR_TIME_SET_CURRENT(now);
+		INSTR_TIME_SUBTRACT(now, sendTime);
+		INSTR_TIME_SUBTRACT(now, serializeTime);
+		INSTR_TIME_SUBTRACT(now, compressTime);
+		sendTime = now;
+
+		cdbexplain_addDispatchTime(queryDesc->showstatctx, gangTime,
+								   serializeTime, compressTime, sendTime);
+	}
 
 	/*
 	 * If bailed before completely dispatched, stop QEs and throw error.
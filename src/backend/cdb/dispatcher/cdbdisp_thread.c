@@ -148,6 +148,7 @@ static bool
 			cdbdisp_shouldCancel(struct CdbDispatcherState *ds);
 
 static void *cdbdisp_makeDispatchThreads(int maxSlices, char *queryText, int queryTextLen);
+static void cdbdisp_setQueryText_threads(struct CdbDispatcherState *ds, char *queryText, int queryTextLen);
 
 static void CdbCheckDispatchResult_internal(struct CdbDispatcherState *ds,
 								DispatchWaitMode waitMode);
@@ -165,7 +166,8 @@ DispatcherInternalFuncs DispatcherSyncFuncs =
 	cdbdisp_makeDispatchThreads,
 	CdbCheckDispatchResult_internal,
 	cdbdisp_dispatchToGang_internal,
-	NULL
+	NULL,
+	cdbdisp_setQueryText_threads
 };
 
 /*
@@ -473,6 +475,24 @@ cdbdisp_makeDispatchThreads(int maxSlices, char *queryText, int queryTextLen)
 	return (void *) dThreads;
 }
 
+/*
+ * Change the command for the threads not started yet.
+ */
+static void
+cdbdisp_setQueryText_threads(struct CdbDispatcherState *ds, char *queryText, int queryTextLen)
+{
+	CdbDispatchCmdThreads *dThreads = (CdbDispatchCmdThreads *) ds->dispatchParams;
+	int			i;
+
+	for (i = dThreads->threadCount; i < dThreads->dispatchCommandParmsArSize; i++)
+	{
+		DispatchCommandParms *pParms = &dThreads->dispatchCommandParmsAr[i];
+
+		pParms->query_text = queryText;
+		pParms->query_text_len = queryTextLen;
+	}
+}
+
 /*
  * Dispatch the command to all segment DBs.
  */
@@ -238,6 +238,14 @@ cdbdisp_seterrcode(int errcode, /* ERRCODE_xxx or 0 */
 			dispatchResult->errindex = resultIndex;
 	}
 
+	/*
+	 * The QE may have failed before it got to keep the plan we sent it, so
+	 * don't count on it having any dispatched plan cached.
+	 */
+	if (dispatchResult->segdbDesc)
+		MemSet(dispatchResult->segdbDesc->cachedPlanIds, 0,
+			   sizeof(dispatchResult->segdbDesc->cachedPlanIds));
+
 	if (!meleeResults)
 		return;
 
@@ -20,6 +20,7 @@
 
 #include "libpq-fe.h"
 #include "miscadmin.h"			/* MyDatabaseId */
+#include "portability/instr_time.h"
 #include "storage/proc.h"		/* MyProc */
 #include "storage/ipc.h"
 #include "utils/memutils.h"
@@ -27,9 +28,11 @@
 #include "access/xact.h"
 #include "catalog/namespace.h"
 #include "commands/variable.h"
+#include "funcapi.h"
 #include "nodes/execnodes.h"	/* CdbProcess, Slice, SliceTable */
 #include "postmaster/postmaster.h"
 #include "tcop/tcopprot.h"
+#include "utils/builtins.h"
 #include "utils/int8.h"
 #include "utils/portal.h"
 #include "utils/sharedsnapshot.h"
@@ -70,6 +73,7 @@ MemoryContext GangContext = NULL;
 Gang	   *CurrentGangCreating = NULL;
 
 CreateGangFunc pCreateGangFunc = NULL;
+static CreateReaderGangsFunc pCreateReaderGangsFunc = NULL;
 
 /*
  * Points to the result of getCdbComponentDatabases()
@@ -93,6 +97,15 @@ static int numAllocatedReaderGangs = 0;
 #define PRIMARY_WRITER_GANG_ID 1
 static int	gang_id_counter = 2;
 
+/*
+ * How often this session found a gang ready when it needed one, and how long
+ * it spent creating gangs.  See logGangStats and gp_get_session_gang_stats.
+ */
+static int	numGangsReused = 0;
+static int	numGangsCreatedOnDemand = 0;
+static int	numGangsCreated = 0;
+static instr_time gangCreateTime;
+
 
 static Gang *createGang(GangType type, int gang_id, int size, int content);
 static void disconnectAndDestroyAllReaderGangs(bool destroyAllocated);
@@ -104,6 +117,7 @@ static CdbComponentDatabaseInfo *copyCdbComponentDatabaseInfo(
 static CdbComponentDatabaseInfo *findDatabaseInfoBySegIndex(
 						   CdbComponentDatabases *cdbs, int segIndex);
 static Gang *getAvailableGang(GangType type, int size, int content);
+static void countGangsCreated(int ngangs, instr_time start);
 
 /*
  * Create a reader gang.
@@ -173,7 +187,10 @@ AllocateReaderGang(CdbDispatcherState *ds, GangType type, char *portal_name)
 
 		gp = createGang(type, gang_id_counter++, size, content);
 		gp->allocated = true;
+		numGangsCreatedOnDemand++;
 	}
+	else
+		numGangsReused++;
 
 	/*
 	 * make sure no memory is still allocated for previous portal name that
@@ -250,6 +267,7 @@ AllocateWriterGang(CdbDispatcherState *ds)
 			ELOG_DISPATCHER_DEBUG("Reusing an existing primary writer gang");
 			writerGang = availablePrimaryWriterGang;
 			availablePrimaryWriterGang = NULL;
+			numGangsReused++;
 		}
 	}
 
@@ -265,6 +283,7 @@ AllocateWriterGang(CdbDispatcherState *ds)
 		writerGang = createGang(GANGTYPE_PRIMARY_WRITER,
 								PRIMARY_WRITER_GANG_ID, nsegdb, -1);
 		writerGang->allocated = true;
+		numGangsCreatedOnDemand++;
 
 		/*
 		 * set "whoami" for utility statement. non-utility statement will
@@ -295,7 +314,136 @@ AllocateWriterGang(CdbDispatcherState *ds)
 static Gang *
 createGang(GangType type, int gang_id, int size, int content)
 {
-	return pCreateGangFunc(type, gang_id, size, content);
+	Gang	   *gp;
+	instr_time	start;
+
+	INSTR_TIME_SET_CURRENT(start);
+	gp = pCreateGangFunc(type, gang_id, size, content);
+	countGangsCreated(1, start);
+
+	return gp;
+}
+
+/*
+ * Make sure there are enough idle N-reader gangs for the next 'numNeeded'
+ * AllocateReaderGang(GANGTYPE_PRIMARY_READER) calls, so that a query doesn't
+ * create its reader gangs one after another.
+ *
+ * Only done with the asynchronous gang creation, where all the missing gangs
+ * are created at once, with their connections started together.  Must be
+ * called after the writer gang is allocated, as that is created before the
+ * readers.
+ */
+void
+CreateMissingReaderGangs(int numNeeded)
+{
+	MemoryContext oldContext;
+	Gang	  **gangs;
+	instr_time	start;
+	int			numCreate;
+	int			size;
+	int			i;
+
+	if (Gp_role != GP_ROLE_DISPATCH)
+		return;
+
+	/* Nothing to gain when they would be created one by one anyway */
+	if (pCreateReaderGangsFunc == NULL)
+		return;
+
+	numCreate = numNeeded - list_length(availableReaderGangsN);
+	if (numCreate <= 1)
+		return;
+
+	ELOG_DISPATCHER_DEBUG("CreateMissingReaderGangs: %d needed, creating %d reader N-gangs",
+						  numNeeded, numCreate);
+
+	if (GangContext == NULL)
+	{
+		GangContext = AllocSetContextCreate(TopMemoryContext, "Gang Context",
+											ALLOCSET_DEFAULT_MINSIZE,
+											ALLOCSET_DEFAULT_INITSIZE,
+											ALLOCSET_DEFAULT_MAXSIZE);
+	}
+
+	oldContext = MemoryContextSwitchTo(GangContext);
+
+	size = getgpsegmentCount();
+	gangs = palloc(numCreate * sizeof(Gang *));
+
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < numCreate; i++)
+		gangs[i] = buildGangDefinition(GANGTYPE_PRIMARY_READER,
+									   gang_id_counter++, size, 0);
+	pCreateReaderGangsFunc(gangs, numCreate);
+	countGangsCreated(numCreate, start);
+
+	for (i = 0; i < numCreate; i++)
+		availableReaderGangsN = lappend(availableReaderGangsN, gangs[i]);
+	pfree(gangs);
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+static void
+countGangsCreated(int ngangs, instr_time start)
+{
+	instr_time	end;
+
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_SUBTRACT(end, start);
+	INSTR_TIME_ADD(gangCreateTime, end);
+	numGangsCreated += ngangs;
+
+	ELOG_DISPATCHER_DEBUG("created %d gang(s) in %.3f ms",
+						  ngangs, INSTR_TIME_GET_MILLISEC(end));
+}
+
+/*
+ * Report how this session's gangs were obtained, when the session ends.
+ */
+void
+logGangStats(void)
+{
+	int			numAllocated = numGangsReused + numGangsCreatedOnDemand;
+
+	if (numAllocated == 0)
+		return;
+
+	elog(((gp_log_gang >= GPVARS_VERBOSITY_TERSE) ? LOG : DEBUG1),
+		 "session allocated %d gangs, %d (%.1f%%) already created; "
+		 "created %d gangs in %.3f ms (%.3f ms per gang)",
+		 numAllocated, numGangsReused,
+		 100.0 * numGangsReused / numAllocated,
+		 numGangsCreated, INSTR_TIME_GET_MILLISEC(gangCreateTime),
+		 numGangsCreated > 0 ?
+		 INSTR_TIME_GET_MILLISEC(gangCreateTime) / numGangsCreated : 0.0);
+}
+
+/*
+ * Return the same statistics as logGangStats, so far, for the current
+ * session.  They are kept by the QD, so this only runs there.
+ */
+Datum
+gp_get_session_gang_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[4];
+	bool		nulls[4];
+	HeapTuple	tuple;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	MemSet(nulls, false, sizeof(nulls));
+	values[0] = Int32GetDatum(numGangsReused + numGangsCreatedOnDemand);
+	values[1] = Int32GetDatum(numGangsReused);
+	values[2] = Int32GetDatum(numGangsCreated);
+	values[3] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(gangCreateTime));
+
+	tuple = heap_form_tuple(tupdesc, values, nulls);
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
 }
 
 /*
@@ -1641,9 +1789,15 @@ void
 cdbgang_setAsync(bool async)
 {
 	if (async)
+	{
 		pCreateGangFunc = pCreateGangFuncAsync;
+		pCreateReaderGangsFunc = pCreateReaderGangsFuncAsync;
+	}
 	else
+	{
 		pCreateGangFunc = pCreateGangFuncThreaded;
+		pCreateReaderGangsFunc = NULL;
+	}
 }
 
 void
@@ -35,9 +35,12 @@
 #include "utils/resowner.h"
 
 static int	getPollTimeout(const struct timeval *startTS);
+static int	connectGangs(Gang **gangs, int ngangs, int *in_recovery_mode_count);
 static Gang *createGang_async(GangType type, int gang_id, int size, int content);
+static void createReaderGangs_async(Gang **gangs, int ngangs);
 
 CreateGangFunc pCreateGangFuncAsync = createGang_async;
+CreateReaderGangsFunc pCreateReaderGangsFuncAsync = createReaderGangs_async;
 
 /*
  * Creates a new gang by logging on a session to each segDB involved.
@@ -49,21 +52,10 @@ static Gang *
 createGang_async(GangType type, int gang_id, int size, int content)
 {
 	Gang	   *newGangDefinition;
-	SegmentDatabaseDescriptor *segdbDesc = NULL;
-	int			i = 0;
 	int			create_gang_retry_counter = 0;
 	int			in_recovery_mode_count = 0;
 	int			successful_connections = 0;
 	bool		retry = false;
-	int			poll_timeout = 0;
-	struct timeval startTS;
-	PostgresPollingStatusType *pollingStatus = NULL;
-
-	/*
-	 * true means connection status is confirmed, either established or in
-	 * recovery mode
-	 */
-	bool	   *connStatusDone = NULL;
 
 	ELOG_DISPATCHER_DEBUG("createGang type = %d, gang_id = %d, size = %d, content = %d",
 						  type, gang_id, size, content);
@@ -94,18 +86,211 @@ create_gang_retry:
 	Assert(newGangDefinition->perGangContext != NULL);
 	MemoryContextSwitchTo(newGangDefinition->perGangContext);
 
+	PG_TRY();
+	{
+		successful_connections = connectGangs(&newGangDefinition, 1,
+											  &in_recovery_mode_count);
+
+		ELOG_DISPATCHER_DEBUG("createGang: %d processes requested; %d successful connections %d in recovery",
+							  size, successful_connections, in_recovery_mode_count);
+
+		MemoryContextSwitchTo(GangContext);
+
+		/* some segments are in recovery mode */
+		if (successful_connections != size)
+		{
+			Assert(successful_connections + in_recovery_mode_count == size);
+
+			if (gp_gang_creation_retry_count <= 0 ||
+				create_gang_retry_counter++ >= gp_gang_creation_retry_count ||
+				type != GANGTYPE_PRIMARY_WRITER)
+				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+								errmsg("failed to acquire resources on one or more segments"),
+								errdetail("Segments are in recovery mode.")));
+
+			ELOG_DISPATCHER_DEBUG("createGang: gang creation failed, but retryable.");
+
+			DisconnectAndDestroyGang(newGangDefinition);
+			newGangDefinition = NULL;
+			CurrentGangCreating = NULL;
+			retry = true;
+		}
+	}
+	PG_CATCH();
+	{
+		MemoryContextSwitchTo(GangContext);
+
+		FtsNotifyProber();
+		/* FTS shows some segment DBs are down */
+		if (FtsTestSegmentDBIsDown(newGangDefinition->db_descriptors, size))
+		{
+
+			DisconnectAndDestroyGang(newGangDefinition);
+			newGangDefinition = NULL;
+			CurrentGangCreating = NULL;
+			DisconnectAndDestroyAllGangs(true);
+			CheckForResetSession();
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("failed to acquire resources on one or more segments"),
+							errdetail("FTS detected one or more segments are down")));
+
+		}
+
+		DisconnectAndDestroyGang(newGangDefinition);
+		newGangDefinition = NULL;
+		CurrentGangCreating = NULL;
+
+		if (type == GANGTYPE_PRIMARY_WRITER)
+		{
+			DisconnectAndDestroyAllGangs(true);
+			CheckForResetSession();
+		}
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	SIMPLE_FAULT_INJECTOR(GangCreated);
+
+	if (retry)
+	{
+		CHECK_FOR_INTERRUPTS();
+		pg_usleep(gp_gang_creation_retry_timer * 1000);
+		CHECK_FOR_INTERRUPTS();
+
+		goto create_gang_retry;
+	}
+
+	setLargestGangsize(size);
+
+	CurrentGangCreating = NULL;
+
+	return newGangDefinition;
+}
+
+/*
+ * Log on the QEs of several reader gangs at once, so that creating them
+ * costs about as much as creating one.  The gangs come from
+ * buildGangDefinition.
+ *
+ * call this function in GangContext memory context.
+ * elog ERROR, after destroying all the gangs, if any QE can't be connected.
+ * There's no retry for readers: see createGang_async.
+ */
+static void
+createReaderGangs_async(Gang **gangs, int ngangs)
+{
+	int			in_recovery_mode_count = 0;
+	int			successful_connections = 0;
+	int			size = 0;
+	int			i;
+
+	Assert(CurrentResourceOwner != NULL);
+	Assert(CurrentMemoryContext == GangContext);
+	Assert(CurrentGangCreating == NULL);
+
+	for (i = 0; i < ngangs; i++)
+	{
+		Assert(gangs[i]->type != GANGTYPE_PRIMARY_WRITER);
+		size += gangs[i]->size;
+	}
+
+	ELOG_DISPATCHER_DEBUG("createReaderGangs: %d gangs, %d processes", ngangs, size);
+
+	PG_TRY();
+	{
+		successful_connections = connectGangs(gangs, ngangs, &in_recovery_mode_count);
+
+		ELOG_DISPATCHER_DEBUG("createReaderGangs: %d processes requested; %d successful connections %d in recovery",
+							  size, successful_connections, in_recovery_mode_count);
+
+		if (successful_connections != size)
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("failed to acquire resources on one or more segments"),
+							errdetail("Segments are in recovery mode.")));
+	}
+	PG_CATCH();
+	{
+		bool		segmentDown = false;
+
+		MemoryContextSwitchTo(GangContext);
+
+		FtsNotifyProber();
+		for (i = 0; i < ngangs; i++)
+		{
+			if (!segmentDown &&
+				FtsTestSegmentDBIsDown(gangs[i]->db_descriptors, gangs[i]->size))
+				segmentDown = true;
+			DisconnectAndDestroyGang(gangs[i]);
+			gangs[i] = NULL;
+		}
+
+		/* FTS shows some segment DBs are down */
+		if (segmentDown)
+		{
+			DisconnectAndDestroyAllGangs(true);
+			CheckForResetSession();
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("failed to acquire resources on one or more segments"),
+							errdetail("FTS detected one or more segments are down")));
+		}
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	SIMPLE_FAULT_INJECTOR(GangCreated);
+
+	for (i = 0; i < ngangs; i++)
+		setLargestGangsize(gangs[i]->size);
+}
+
+/*
+ * Start connections to all the QEs of the given gangs, and poll them until
+ * each one is either established or found in recovery mode.
+ *
+ * Returns the number of established connections; *in_recovery_mode_count
+ * is set to the number of the others.  elog ERROR on any other failure.
+ */
+static int
+connectGangs(Gang **gangs, int ngangs, int *in_recovery_mode_count)
+{
+	SegmentDatabaseDescriptor **segdbDescs;
+	SegmentDatabaseDescriptor *segdbDesc = NULL;
+	PostgresPollingStatusType *pollingStatus = NULL;
+	struct pollfd *fds;
+	int			successful_connections = 0;
+	int			poll_timeout = 0;
+	int			size = 0;
+	int			g;
+	int			i;
+	struct timeval startTS;
+
+	/*
+	 * true means connection status is confirmed, either established or in
+	 * recovery mode
+	 */
+	bool	   *connStatusDone = NULL;
+
+	*in_recovery_mode_count = 0;
+
+	for (g = 0; g < ngangs; g++)
+		size += gangs[g]->size;
+
 	/*
-	 * allocate memory within perGangContext and will be freed automatically
-	 * when gang is destroyed
+	 * allocate memory within the current context, perGangContext when
+	 * creating a single gang, so it's freed when the gang is destroyed
 	 */
+	segdbDescs = palloc(sizeof(SegmentDatabaseDescriptor *) * size);
 	pollingStatus = palloc(sizeof(PostgresPollingStatusType) * size);
 	connStatusDone = palloc(sizeof(bool) * size);
 
-	struct pollfd *fds;
-
-	PG_TRY();
+	size = 0;
+	for (g = 0; g < ngangs; g++)
 	{
-		for (i = 0; i < size; i++)
+		Gang	   *gang = gangs[g];
+
+		for (i = 0; i < gang->size; i++)
 		{
 			bool		ret;
 			char		gpqeid[100];
@@ -116,7 +301,8 @@ create_gang_retry:
 			 * valid segdb we error out.  Also, if this segdb is invalid, we
 			 * must fail the connection.
 			 */
-			segdbDesc = &newGangDefinition->db_descriptors[i];
+			segdbDesc = &gang->db_descriptors[i];
+			segdbDescs[size] = segdbDesc;
 
 			/*
 			 * Build the connection string.  Writer-ness needs to be processed
@@ -124,8 +310,8 @@ create_gang_retry:
 			 * options are recognized.
 			 */
 			ret = build_gpqeid_param(gpqeid, sizeof(gpqeid),
-									 type == GANGTYPE_PRIMARY_WRITER,
-									 gang_id,
+									 gang->type == GANGTYPE_PRIMARY_WRITER,
+									 gang->gang_id,
 									 segdbDesc->segment_database_info->hostSegs);
 
 			if (!ret)
@@ -143,213 +329,144 @@ create_gang_retry:
 								errmsg("failed to acquire resources on one or more segments"),
 								errdetail("%s (%s)", PQerrorMessage(segdbDesc->conn), segdbDesc->whoami)));
 
-			connStatusDone[i] = false;
+			connStatusDone[size] = false;
 
 			/*
 			 * If connection status is not CONNECTION_BAD after
 			 * PQconnectStart(), we must act as if the PQconnectPoll() had
 			 * returned PGRES_POLLING_WRITING
 			 */
-			pollingStatus[i] = PGRES_POLLING_WRITING;
+			pollingStatus[size] = PGRES_POLLING_WRITING;
+			size++;
 		}
+	}
 
-		/*
-		 * Ok, we've now launched all the connection attempts. Start the
-		 * timeout clock (= get the start timestamp), and poll until they're
-		 * all completed or we reach timeout.
-		 */
-		gettimeofday(&startTS, NULL);
-		fds = (struct pollfd *) palloc0(sizeof(struct pollfd) * size);
+	/*
+	 * Ok, we've now launched all the connection attempts. Start the timeout
+	 * clock (= get the start timestamp), and poll until they're all completed
+	 * or we reach timeout.
+	 */
+	gettimeofday(&startTS, NULL);
+	fds = (struct pollfd *) palloc0(sizeof(struct pollfd) * size);
 
-		for (;;)
+	for (;;)
+	{
+		int			nready;
+		int			nfds = 0;
+
+		poll_timeout = getPollTimeout(&startTS);
+
+		for (i = 0; i < size; i++)
 		{
-			int			nready;
-			int			nfds = 0;
+			segdbDesc = segdbDescs[i];
 
-			poll_timeout = getPollTimeout(&startTS);
+			/*
+			 * Skip established connections and in-recovery-mode connections
+			 */
+			if (connStatusDone[i])
+				continue;
 
-			for (i = 0; i < size; i++)
+			switch (pollingStatus[i])
 			{
-				segdbDesc = &newGangDefinition->db_descriptors[i];
-
-				/*
-				 * Skip established connections and in-recovery-mode
-				 * connections
-				 */
-				if (connStatusDone[i])
+				case PGRES_POLLING_OK:
+					cdbconn_doConnectComplete(segdbDesc);
+					if (segdbDesc->motionListener == 0)
+						ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+										errmsg("failed to acquire resources on one or more segments"),
+										errdetail("Internal error: No motion listener port (%s)", segdbDesc->whoami)));
+					successful_connections++;
+					connStatusDone[i] = true;
 					continue;
 
-				switch (pollingStatus[i])
-				{
-					case PGRES_POLLING_OK:
-						cdbconn_doConnectComplete(segdbDesc);
-						if (segdbDesc->motionListener == 0)
-							ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-											errmsg("failed to acquire resources on one or more segments"),
-											errdetail("Internal error: No motion listener port (%s)", segdbDesc->whoami)));
-						successful_connections++;
+				case PGRES_POLLING_READING:
+					fds[nfds].fd = PQsocket(segdbDesc->conn);
+					fds[nfds].events = POLLIN;
+					nfds++;
+					break;
+
+				case PGRES_POLLING_WRITING:
+					fds[nfds].fd = PQsocket(segdbDesc->conn);
+					fds[nfds].events = POLLOUT;
+					nfds++;
+					break;
+
+				case PGRES_POLLING_FAILED:
+					if (segment_failure_due_to_recovery(PQerrorMessage(segdbDesc->conn)))
+					{
+						(*in_recovery_mode_count)++;
 						connStatusDone[i] = true;
-						continue;
-
-					case PGRES_POLLING_READING:
-						fds[nfds].fd = PQsocket(segdbDesc->conn);
-						fds[nfds].events = POLLIN;
-						nfds++;
-						break;
-
-					case PGRES_POLLING_WRITING:
-						fds[nfds].fd = PQsocket(segdbDesc->conn);
-						fds[nfds].events = POLLOUT;
-						nfds++;
-						break;
-
-					case PGRES_POLLING_FAILED:
-						if (segment_failure_due_to_recovery(PQerrorMessage(segdbDesc->conn)))
-						{
-							in_recovery_mode_count++;
-							connStatusDone[i] = true;
-							elog(LOG, "segment is in recovery mode (%s)", segdbDesc->whoami);
-						}
-						else
-						{
-							ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-											errmsg("failed to acquire resources on one or more segments"),
-											errdetail("%s (%s)", PQerrorMessage(segdbDesc->conn), segdbDesc->whoami)));
-						}
-						break;
-
-					default:
+						elog(LOG, "segment is in recovery mode (%s)", segdbDesc->whoami);
+					}
+					else
+					{
 						ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 										errmsg("failed to acquire resources on one or more segments"),
-										errdetail("unknow pollstatus (%s)", segdbDesc->whoami)));
-						break;
-				}
+										errdetail("%s (%s)", PQerrorMessage(segdbDesc->conn), segdbDesc->whoami)));
+					}
+					break;
 
-				if (poll_timeout == 0)
+				default:
 					ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 									errmsg("failed to acquire resources on one or more segments"),
-									errdetail("timeout expired\n (%s)", segdbDesc->whoami)));
+									errdetail("unknow pollstatus (%s)", segdbDesc->whoami)));
+					break;
 			}
 
-			if (nfds == 0)
-				break;
-
-			SIMPLE_FAULT_INJECTOR(CreateGangInProgress);
-
-			CHECK_FOR_INTERRUPTS();
-
-			/* Wait until something happens */
-			nready = poll(fds, nfds, poll_timeout);
-
-			if (nready < 0)
-			{
-				int			sock_errno = SOCK_ERRNO;
-
-				if (sock_errno == EINTR)
-					continue;
-
+			if (poll_timeout == 0)
 				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 								errmsg("failed to acquire resources on one or more segments"),
-								errdetail("poll() failed: errno = %d", sock_errno)));
-			}
-			else if (nready > 0)
-			{
-				int			currentFdNumber = 0;
-
-				for (i = 0; i < size; i++)
-				{
-					segdbDesc = &newGangDefinition->db_descriptors[i];
-					if (connStatusDone[i])
-						continue;
-
-					Assert(PQsocket(segdbDesc->conn) > 0);
-					Assert(PQsocket(segdbDesc->conn) == fds[currentFdNumber].fd);
-
-					if (fds[currentFdNumber].revents & fds[currentFdNumber].events ||
-						fds[currentFdNumber].revents & (POLLERR | POLLHUP | POLLNVAL))
-						pollingStatus[i] = PQconnectPoll(segdbDesc->conn);
-
-					currentFdNumber++;
-
-				}
-			}
+								errdetail("timeout expired\n (%s)", segdbDesc->whoami)));
 		}
 
-		ELOG_DISPATCHER_DEBUG("createGang: %d processes requested; %d successful connections %d in recovery",
-							  size, successful_connections, in_recovery_mode_count);
+		if (nfds == 0)
+			break;
 
-		MemoryContextSwitchTo(GangContext);
+		SIMPLE_FAULT_INJECTOR(CreateGangInProgress);
 
-		/* some segments are in recovery mode */
-		if (successful_connections != size)
-		{
-			Assert(successful_connections + in_recovery_mode_count == size);
-
-			if (gp_gang_creation_retry_count <= 0 ||
-				create_gang_retry_counter++ >= gp_gang_creation_retry_count ||
-				type != GANGTYPE_PRIMARY_WRITER)
-				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-								errmsg("failed to acquire resources on one or more segments"),
-								errdetail("Segments are in recovery mode.")));
+		CHECK_FOR_INTERRUPTS();
 
-			ELOG_DISPATCHER_DEBUG("createGang: gang creation failed, but retryable.");
+		/* Wait until something happens */
+		nready = poll(fds, nfds, poll_timeout);
 
-			DisconnectAndDestroyGang(newGangDefinition);
-			newGangDefinition = NULL;
-			CurrentGangCreating = NULL;
-			retry = true;
-		}
-	}
-	PG_CATCH();
-	{
-		MemoryContextSwitchTo(GangContext);
-
-		FtsNotifyProber();
-		/* FTS shows some segment DBs are down */
-		if (FtsTestSegmentDBIsDown(newGangDefinition->db_descriptors, size))
+		if (nready < 0)
 		{
+			int			sock_errno = SOCK_ERRNO;
+
+			if (sock_errno == EINTR)
+				continue;
 
-			DisconnectAndDestroyGang(newGangDefinition);
-			newGangDefinition = NULL;
-			CurrentGangCreating = NULL;
-			DisconnectAndDestroyAllGangs(true);
-			CheckForResetSession();
 			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 							errmsg("failed to acquire resources on one or more segments"),
-							errdetail("FTS detected one or more segments are down")));
-
+							errdetail("poll() failed: errno = %d", sock_errno)));
 		}
-
-		DisconnectAndDestroyGang(newGangDefinition);
-		newGangDefinition = NULL;
-		CurrentGangCreating = NULL;
-
-		if (type == GANGTYPE_PRIMARY_WRITER)
+		else if (nready > 0)
 		{
-			DisconnectAndDestroyAllGangs(true);
-			CheckForResetSession();
-		}
+			int			currentFdNumber = 0;
 
-		PG_RE_THROW();
-	}
-	PG_END_TRY();
+			for (i = 0; i < size; i++)
+			{
+				segdbDesc = segdbDescs[i];
+				if (connStatusDone[i])
+					continue;
 
-	SIMPLE_FAULT_INJECTOR(GangCreated);
+				Assert(PQsocket(segdbDesc->conn) > 0);
+				Assert(PQsocket(segdbDesc->conn) == fds[currentFdNumber].fd);
 
-	if (retry)
-	{
-		CHECK_FOR_INTERRUPTS();
-		pg_usleep(gp_gang_creation_retry_timer * 1000);
-		CHECK_FOR_INTERRUPTS();
+				if (fds[currentFdNumber].revents & fds[currentFdNumber].events ||
+					fds[currentFdNumber].revents & (POLLERR | POLLHUP | POLLNVAL))
+					pollingStatus[i] = PQconnectPoll(segdbDesc->conn);
 
-		goto create_gang_retry;
+				currentFdNumber++;
+			}
+		}
 	}
 
-	setLargestGangsize(size);
-
-	CurrentGangCreating = NULL;
+	pfree(segdbDescs);
+	pfree(pollingStatus);
+	pfree(connStatusDone);
+	pfree(fds);
 
-	return newGangDefinition;
+	return successful_connections;
 }
 
 static int
@@ -108,18 +108,16 @@ validateCdbInfo(CdbComponentDatabaseInfo *cdbinfo, int segindex)
 	assert_int_equal(cdbinfo->preferred_role, 'p');
 }
 
+/*
+ * Mock what is asked of a connection once it's established.
+ */
 void
-mockLibpq(PGconn *pgConn, uint32 motionListener, int qePid)
+mockLibpqConnected(PGconn *pgConn, uint32 motionListener, int qePid)
 {
 	static char motionListener_str[11];
 
 	snprintf(motionListener_str, sizeof(motionListener_str), "%u", motionListener);
 
-	expect_any_count(PQconnectdbParams, keywords, -1);
-	expect_any_count(PQconnectdbParams, values, -1);
-	expect_any_count(PQconnectdbParams, expand_dbname, -1);
-	will_return_count(PQconnectdbParams, pgConn, TOTOAL_SEGMENTS);
-
 	expect_value_count(PQstatus, conn, pgConn, -1);
 	will_return_count(PQstatus, CONNECTION_OK, -1);
 
@@ -136,6 +134,17 @@ mockLibpq(PGconn *pgConn, uint32 motionListener, int qePid)
 	will_return_count(PQbackendPID, qePid, -1);
 }
 
+void
+mockLibpq(PGconn *pgConn, uint32 motionListener, int qePid)
+{
+	expect_any_count(PQconnectdbParams, keywords, -1);
+	expect_any_count(PQconnectdbParams, values, -1);
+	expect_any_count(PQconnectdbParams, expand_dbname, -1);
+	will_return_count(PQconnectdbParams, pgConn, TOTOAL_SEGMENTS);
+
+	mockLibpqConnected(pgConn, motionListener, qePid);
+}
+
 static void
 test__createWriterGang(void **state)
 {
@@ -241,6 +250,81 @@ test__createReaderGang(void **state)
 	}
 }
 
+/*
+ * With the asynchronous gang creation, the missing reader gangs are created
+ * together: the connections to all their QEs are started, and then polled in
+ * one loop.
+ */
+static void
+test__createMissingReaderGangs(void **state)
+{
+	int			segmentCount = TOTOAL_SEGMENTS;
+	uint8		ftsVersion = 1;
+	PGconn	   *conn = &pgconn;
+	uint32		motionListener = 10000;
+	int			qePid = 2000;
+	int			numIdle = list_length(availableReaderGangsN);
+	int			numCreated = numGangsCreated;
+	int			sock[2];
+	int			g;
+	int			i;
+
+	/* poll() finds the write end of a pipe ready right away */
+	assert_int_equal(pipe(sock), 0);
+
+	will_return_count(getgpsegmentCount, segmentCount, -1);
+	will_return_count(getFtsVersion, ftsVersion, 2);
+
+	/* CreateGangInProgress, before the one poll(), and GangCreated */
+	expect_any_count(FaultInjector_InjectFaultIfSet, identifier, 2);
+	expect_any_count(FaultInjector_InjectFaultIfSet, ddlStatement, 2);
+	expect_any_count(FaultInjector_InjectFaultIfSet, databaseName, 2);
+	expect_any_count(FaultInjector_InjectFaultIfSet, tableName, 2);
+	will_return_count(FaultInjector_InjectFaultIfSet, false, 2);
+
+	expect_any_count(PQconnectStartParams, keywords, TOTOAL_SEGMENTS * 2);
+	expect_any_count(PQconnectStartParams, values, TOTOAL_SEGMENTS * 2);
+	expect_any_count(PQconnectStartParams, expand_dbname, TOTOAL_SEGMENTS * 2);
+	will_return_count(PQconnectStartParams, conn, TOTOAL_SEGMENTS * 2);
+
+	expect_value_count(PQsocket, conn, conn, -1);
+	will_return_count(PQsocket, sock[1], -1);
+
+	expect_value_count(PQconnectPoll, conn, conn, TOTOAL_SEGMENTS * 2);
+	will_return_count(PQconnectPoll, PGRES_POLLING_OK, TOTOAL_SEGMENTS * 2);
+
+	mockLibpqConnected(conn, motionListener, qePid);
+
+	cdbgang_setAsync(true);
+
+	CreateMissingReaderGangs(numIdle + 2);
+	assert_int_equal(list_length(availableReaderGangsN), numIdle + 2);
+	assert_int_equal(numGangsCreated, numCreated + 2);
+
+	for (g = numIdle; g < numIdle + 2; g++)
+	{
+		Gang	   *gang = (Gang *) list_nth(availableReaderGangsN, g);
+
+		assert_int_equal(gang->type, GANGTYPE_PRIMARY_READER);
+		assert_int_equal(gang->size, TOTOAL_SEGMENTS);
+		assert_int_equal(gang->allocated, false);
+
+		for (i = 0; i < gang->size; i++)
+		{
+			SegmentDatabaseDescriptor *segdb = &gang->db_descriptors[i];
+
+			assert_int_equal(segdb->conn, conn);
+			assert_int_equal(segdb->backendPid, qePid);
+			assert_int_equal(segdb->motionListener, motionListener);
+			assert_int_equal(segdb->segindex, i);
+		}
+	}
+
+	cdbgang_setAsync(false);
+	close(sock[0]);
+	close(sock[1]);
+}
+
 /*
  * Make sure resetSessionForPrimaryGangLoss doesn't access catalog.
  */
@@ -271,7 +355,8 @@ main(int argc, char *argv[])
 	{
 		unit_test(test__resetSessionForPrimaryGangLoss),
 		unit_test(test__createWriterGang),
-	unit_test(test__createReaderGang),};
+		unit_test(test__createReaderGang),
+		unit_test(test__createMissingReaderGangs),};
 
 	MemoryContextInit();
 	DispatcherContext = AllocSetContextCreate(TopMemoryContext,
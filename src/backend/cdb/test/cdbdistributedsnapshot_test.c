@@ -26,6 +26,8 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 
 		dslm.inProgressMappedLocalXids =
 			(TransactionId*)malloc(5 * sizeof(TransactionId));
+		dslm.inProgressMappedDistribXids =
+			(DistributedTransactionId*)malloc(5 * sizeof(DistributedTransactionId));
 		dslm.maxLocalXidsCount = 5;
 
 		ds->inProgressXidArray =
@@ -162,8 +164,116 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
 	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
 
+	/*
+	 * A new distributed snapshot in which the distributed transaction of
+	 * local xid 20 has committed: the other cached local xids are carried
+	 * over, and are still found in progress without asking the distributed
+	 * log again.
+	 */
+	{
+		DistributedSnapshot next;
+		DistributedTransactionId nextInProgress[2] = {50, 100};
+
+		next = *ds;
+		next.distribSnapshotId = 12346;
+		next.count = 2;
+		next.maxCount = 2;
+		next.inProgressXidArray = nextInProgress;
+
+		DistributedSnapshotWithLocalMapping_Install(&dslm, &next);
+		assert_true(ds->distribSnapshotId == 12346);
+		assert_true(ds->count == 2);
+		assert_true(dslm.currentLocalXidsCount == 2);
+		assert_true(dslm.minCachedLocalXid == 5);
+		assert_true(dslm.maxCachedLocalXid == 10);
+		assert_true(dslm.inProgressMappedLocalXids[0] == 10);
+		assert_true(dslm.inProgressMappedLocalXids[1] == 5);
+		assert_true(dslm.inProgressMappedDistribXids[0] == 100);
+		assert_true(dslm.inProgressMappedDistribXids[1] == 50);
+
+		retval = DistributedSnapshotWithLocalMapping_CommittedTest(&dslm, 10, false);
+		assert_true(retval == DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS);
+
+		/* A restarted DTM starts from an empty cache */
+		next.distribTransactionTimeStamp = timeStamp + 1;
+		DistributedSnapshotWithLocalMapping_Install(&dslm, &next);
+		assert_true(dslm.currentLocalXidsCount == 0);
+		assert_true(dslm.minCachedLocalXid == InvalidTransactionId);
+		assert_true(dslm.maxCachedLocalXid == InvalidTransactionId);
+	}
+
 	free(ds->inProgressXidArray);
 	free(dslm.inProgressMappedLocalXids);
+	free(dslm.inProgressMappedDistribXids);
+}
+
+static void
+check_serialize_roundtrip(DistributedSnapshot *ds, int expectedXidsSize)
+{
+	DistributedSnapshot result = DistributedSnapshot_StaticInit;
+	int			size = DistributedSnapshot_SerializeSize(ds);
+	char	   *buf = malloc(size);
+	int			i;
+
+	/* timestamp, snapshot id, 3 xids, count, form */
+	assert_int_equal(size, sizeof(DistributedTransactionTimeStamp) +
+					 sizeof(DistributedSnapshotId) +
+					 3 * sizeof(DistributedTransactionId) +
+					 sizeof(int32) + 1 + expectedXidsSize);
+
+	assert_int_equal(DistributedSnapshot_Serialize(ds, buf), size);
+	assert_int_equal(DistributedSnapshot_Deserialize(buf, &result), size);
+
+	assert_true(result.distribTransactionTimeStamp == ds->distribTransactionTimeStamp);
+	assert_true(result.xminAllDistributedSnapshots == ds->xminAllDistributedSnapshots);
+	assert_true(result.distribSnapshotId == ds->distribSnapshotId);
+	assert_true(result.xmin == ds->xmin);
+	assert_true(result.xmax == ds->xmax);
+	assert_int_equal(result.count, ds->count);
+	for (i = 0; i < ds->count; i++)
+		assert_true(result.inProgressXidArray[i] == ds->inProgressXidArray[i]);
+
+	free(result.inProgressXidArray);
+	free(buf);
+}
+
+void
+test__DistributedSnapshot_Serialize(void **state)
+{
+	DistributedSnapshot ds;
+	DistributedTransactionId xids[1000];
+	int			i;
+
+	ds.distribTransactionTimeStamp = time(NULL);
+	ds.xminAllDistributedSnapshots = 1000;
+	ds.distribSnapshotId = 42;
+	ds.inProgressXidArray = xids;
+	ds.maxCount = 1000;
+
+	/* Sparse: deltas of 300, two bytes each */
+	ds.xmin = 1000;
+	ds.count = 1000;
+	for (i = 0; i < ds.count; i++)
+		xids[i] = ds.xmin + 300 * i;
+	ds.xmax = xids[ds.count - 1] + 5;
+	check_serialize_roundtrip(&ds, 2 * ds.count - 1);
+
+	/* Dense: all but every tenth xid of the range still running */
+	ds.count = 0;
+	for (i = 0; i < 1000; i++)
+	{
+		if (i % 10 != 0)
+			xids[ds.count++] = ds.xmin + i;
+	}
+	ds.xmax = ds.xmin + 999;
+	check_serialize_roundtrip(&ds, 999 / 8 + 1);
+
+	/* Out of order, as a hand-made snapshot could be: sent as it is */
+	ds.count = 3;
+	xids[0] = 1200;
+	xids[1] = 1100;
+	xids[2] = 1300;
+	check_serialize_roundtrip(&ds, 3 * sizeof(DistributedTransactionId));
 }
 
 int
@@ -173,7 +283,8 @@ main(int argc, char* argv[])
 
 	const UnitTest tests[] =
 	{
-		unit_test(test__DistributedSnapshotWithLocalMapping_CommittedTest)
+		unit_test(test__DistributedSnapshotWithLocalMapping_CommittedTest),
+		unit_test(test__DistributedSnapshot_Serialize)
 	};
 
 	MemoryContextInit();
@@ -69,6 +69,7 @@
 #include "postmaster/autostats.h"
 #include "utils/metrics_utils.h"
 #include "utils/resscheduler.h"
+#include "utils/workfile_mgr.h"
 
 
 #define ISOCTAL(c) (((c) >= '0') && ((c) <= '7'))
@@ -164,6 +165,8 @@ static uint64 CopyToDispatch(CopyState cstate);
 static uint64 CopyTo(CopyState cstate);
 static uint64 CopyFrom(CopyState cstate);
 static uint64 CopyDispatchOnSegment(CopyState cstate, const CopyStmt *stmt);
+static void CopyFromInsertBatchAOCS(ResultRelInfo *resultRelInfo,
+						int nBufferedTuples, HeapTuple *bufferedTuples);
 static void CopyFromInsertBatch(CopyState cstate, EState *estate,
 					CommandId mycid, int hi_options,
 					ResultRelInfo *resultRelInfo, TupleTableSlot *myslot,
@@ -3284,6 +3287,7 @@ CopyFrom(CopyState cstate)
 	resultRelInfo = makeNode(ResultRelInfo);
 	resultRelInfo->ri_RangeTableIndex = 1;		/* dummy */
 	resultRelInfo->ri_RelationDesc = cstate->rel;
+	workfile_reuse_note_writer(RelationGetRelid(cstate->rel));
 	resultRelInfo->ri_TrigDesc = CopyTriggerDesc(cstate->rel->trigdesc);
 	if (resultRelInfo->ri_TrigDesc)
 	{
@@ -3321,15 +3325,19 @@ CopyFrom(CopyState cstate)
 	 * BEFORE/INSTEAD OF triggers, or we need to evaluate volatile default
 	 * expressions. Such triggers or expressions might query the table we're
 	 * inserting to, and act differently if the tuples that have already been
-	 * processed and prepared for insertion are not there.
+	 * processed and prepared for insertion are not there. The batched path
+	 * also doesn't set the OIDs loaded from the file.
 	 */
 	if ((resultRelInfo->ri_TrigDesc != NULL &&
 		 (resultRelInfo->ri_TrigDesc->trig_insert_before_row ||
 		  resultRelInfo->ri_TrigDesc->trig_insert_instead_row)) ||
-		cstate->volatile_defexprs)
+		cstate->volatile_defexprs ||
+		cstate->file_has_oids)
 	{
 		useHeapMultiInsert = false;
 	}
+	else
+		useHeapMultiInsert = true;
 
 	/* Prepare to catch AFTER triggers. */
 	AfterTriggerBeginQuery();
@@ -3744,19 +3752,15 @@ CopyFrom(CopyState cstate)
 			if (resultRelInfo->ri_RelationDesc->rd_att->constr)
 				ExecConstraints(resultRelInfo, slot, estate);
 
-			if (useHeapMultiInsert)
+			/*
+			 * Heap and column-oriented tables are loaded in batches. The
+			 * decision is made per row, since the partitions of a
+			 * partitioned table can have different storage.
+			 */
+			if (useHeapMultiInsert &&
+				relstorage != RELSTORAGE_AOROWS &&
+				relstorage != RELSTORAGE_EXTERNAL)
 			{
-				char relstorage = RelinfoGetStorage(resultRelInfo);
-				if (relstorage != RELSTORAGE_AOROWS &&
-					relstorage != RELSTORAGE_AOCOLS &&
-					relstorage != RELSTORAGE_EXTERNAL)
-					useHeapMultiInsert = true;
-				else
-					useHeapMultiInsert = false;
-			}
-
-			/* OK, store the tuple and create index entries for it */
-			if (useHeapMultiInsert) {
 				HeapTuple	tuple;
 				tuple = ExecFetchSlotHeapTuple(slot);
 
@@ -3879,7 +3883,7 @@ CopyFrom(CopyState cstate)
 	}
 	elog(DEBUG1, "Segment %u, Copied %lu rows.", GpIdentity.segindex, processed);
 	/* Flush any remaining buffered tuples */
-	if (useHeapMultiInsert)
+	if (nTotalBufferedTuples > 0)
 		cdbFlushInsertBatches(resultRelInfoList, cstate, estate, mycid, hi_options, baseSlot);
 
 	/* Done, clean up */
@@ -4025,10 +4029,42 @@ CopyFrom(CopyState cstate)
 	return processed;
 }
 
+/*
+ * Insert a batch of buffered tuples into a column-oriented table, and set
+ * their t_self to the AO TIDs they got.
+ */
+static void
+CopyFromInsertBatchAOCS(ResultRelInfo *resultRelInfo,
+						int nBufferedTuples, HeapTuple *bufferedTuples)
+{
+	TupleDesc	tupDesc = RelationGetDescr(resultRelInfo->ri_RelationDesc);
+	Datum	  **values;
+	bool	  **nulls;
+	AOTupleId  *aoTupleIds;
+	int			i;
+
+	values = palloc(nBufferedTuples * sizeof(Datum *));
+	nulls = palloc(nBufferedTuples * sizeof(bool *));
+	aoTupleIds = palloc(nBufferedTuples * sizeof(AOTupleId));
+
+	for (i = 0; i < nBufferedTuples; i++)
+	{
+		values[i] = palloc(tupDesc->natts * sizeof(Datum));
+		nulls[i] = palloc(tupDesc->natts * sizeof(bool));
+		heap_deform_tuple(bufferedTuples[i], tupDesc, values[i], nulls[i]);
+	}
+
+	aocs_insert_values_multi(resultRelInfo->ri_aocsInsertDesc,
+							 values, nulls, nBufferedTuples, aoTupleIds);
+
+	for (i = 0; i < nBufferedTuples; i++)
+		bufferedTuples[i]->t_self = *(ItemPointer) &aoTupleIds[i];
+}
+
 /*
  * A subroutine of CopyFrom, to write the current batch of buffered heap
- * tuples to the heap. Also updates indexes and runs AFTER ROW INSERT
- * triggers.
+ * tuples to the heap, or to a column-oriented table. Also updates indexes
+ * and runs AFTER ROW INSERT triggers.
  */
 static void
 CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
@@ -4044,13 +4080,17 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 	 * before calling it.
 	 */
 	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	heap_multi_insert(resultRelInfo->ri_RelationDesc,
-					  bufferedTuples,
-					  nBufferedTuples,
-					  mycid,
-					  hi_options,
-					  bistate,
-					  GetCurrentTransactionId());
+	if (RelinfoGetStorage(resultRelInfo) == RELSTORAGE_AOCOLS)
+		CopyFromInsertBatchAOCS(resultRelInfo, nBufferedTuples,
+								bufferedTuples);
+	else
+		heap_multi_insert(resultRelInfo->ri_RelationDesc,
+						  bufferedTuples,
+						  nBufferedTuples,
+						  mycid,
+						  hi_options,
+						  bistate,
+						  GetCurrentTransactionId());
 	MemoryContextSwitchTo(oldcontext);
 
 	/*
@@ -106,6 +106,8 @@ typedef struct CdbExplain_StatInst
 	double		execmemused;	/* executor memory used (bytes) */
 	double		workmemused;	/* work_mem actually used (bytes) */
 	double		workmemwanted;	/* work_mem to avoid workfile i/o (bytes) */
+	double		workmemgranted;	/* memory borrowed from the broker (bytes) */
+	double		workmemreleased;	/* memory given back to the broker (bytes) */
 	bool		workfileCreated;	/* workfile created in this node */
 	instr_time	firststart;		/* Start time of first iteration of node */
 	double		peakMemBalance; /* Max mem account balance */
@@ -176,6 +178,8 @@ typedef struct CdbExplain_NodeSummary
 	CdbExplain_Agg execmemused;
 	CdbExplain_Agg workmemused;
 	CdbExplain_Agg workmemwanted;
+	CdbExplain_Agg workmemgranted;
+	CdbExplain_Agg workmemreleased;
 	CdbExplain_Agg totalWorkfileCreated;
 	CdbExplain_Agg peakMemBalance;
 	/* Used for DynamicTableScan, DynamicIndexScan and DynamicBitmapTableScan */
@@ -240,6 +244,14 @@ typedef struct CdbExplain_ShowStatCtx
 	double		workmemused_max;
 	double		workmemwanted_max;
 
+	/* Time spent dispatching the plan, over all its dispatches */
+	int			ndispatch;
+	instr_time	dispatch_gangs;
+	instr_time	dispatch_serialize;
+	instr_time	dispatch_compress;
+	instr_time	dispatch_send;
+	instr_time	dispatch_interconnect;
+
 	/* Per-slice statistics are deposited in this SliceSummary array */
 	int			nslice;			/* num of slots in slices array */
 	CdbExplain_SliceSummary *slices;	/* -> array[0..nslice-1] of
@@ -420,6 +432,41 @@ String2ExplainSortSpaceType(const char *sortSpaceType, ExplainSortMethod sortMet
 	}
 }
 
+/*
+ * cdbexplain_addDispatchTime
+ *	  Called by qDisp after dispatching a plan, to add the time spent
+ *	  allocating gangs for it, and flattening, compressing and sending it
+ *	  to the statement statistics.
+ */
+void
+cdbexplain_addDispatchTime(struct CdbExplain_ShowStatCtx *showstatctx,
+						   instr_time gangs,
+						   instr_time serialize,
+						   instr_time compress,
+						   instr_time send)
+{
+	showstatctx->ndispatch++;
+	INSTR_TIME_ADD(showstatctx->dispatch_gangs, gangs);
+	INSTR_TIME_ADD(showstatctx->dispatch_serialize, serialize);
+	INSTR_TIME_ADD(showstatctx->dispatch_compress, compress);
+	INSTR_TIME_ADD(showstatctx->dispatch_send, send);
+}								/* cdbexplain_addDispatchTime */
+
+/*
+ * cdbexplain_addInterconnectSetupTime
+ *	  Called by qDisp after setting up its end of the interconnect, to add
+ *	  the time it took, and the time then spent finishing sending a pipelined
+ *	  dispatch, to the statement statistics.
+ */
+void
+cdbexplain_addInterconnectSetupTime(struct CdbExplain_ShowStatCtx *showstatctx,
+									instr_time setup,
+									instr_time send)
+{
+	INSTR_TIME_ADD(showstatctx->dispatch_interconnect, setup);
+	INSTR_TIME_ADD(showstatctx->dispatch_send, send);
+}								/* cdbexplain_addInterconnectSetupTime */
+
 /*
  * cdbexplain_localExecStats
  *	  Called by qDisp to build NodeSummary and SliceSummary blocks
@@ -980,6 +1027,8 @@ cdbexplain_collectStatsFromNode(PlanState *planstate, CdbExplain_SendStatCtx *ct
 	si->execmemused = instr->execmemused;
 	si->workmemused = instr->workmemused;
 	si->workmemwanted = instr->workmemwanted;
+	si->workmemgranted = instr->workmemgranted;
+	si->workmemreleased = instr->workmemreleased;
 	si->workfileCreated = instr->workfileCreated;
 	si->peakMemBalance = MemoryAccounting_GetAccountPeakBalance(planstate->plan->memoryAccountId);
 	si->firststart = instr->firststart;
@@ -1107,6 +1156,8 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 	CdbExplain_DepStatAcc execmemused;
 	CdbExplain_DepStatAcc workmemused;
 	CdbExplain_DepStatAcc workmemwanted;
+	CdbExplain_DepStatAcc workmemgranted;
+	CdbExplain_DepStatAcc workmemreleased;
 	CdbExplain_DepStatAcc totalWorkfileCreated;
 	CdbExplain_DepStatAcc peakmemused;
 	CdbExplain_DepStatAcc vmem_reserved;
@@ -1135,6 +1186,8 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 	cdbexplain_depStatAcc_init0(&execmemused);
 	cdbexplain_depStatAcc_init0(&workmemused);
 	cdbexplain_depStatAcc_init0(&workmemwanted);
+	cdbexplain_depStatAcc_init0(&workmemgranted);
+	cdbexplain_depStatAcc_init0(&workmemreleased);
 	cdbexplain_depStatAcc_init0(&totalWorkfileCreated);
 	cdbexplain_depStatAcc_init0(&peakMemBalance);
 	cdbexplain_depStatAcc_init0(&totalPartTableScanned);
@@ -1186,6 +1239,8 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 		cdbexplain_depStatAcc_upd(&execmemused, rsi->execmemused, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&workmemused, rsi->workmemused, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&workmemwanted, rsi->workmemwanted, rsh, rsi, nsi);
+		cdbexplain_depStatAcc_upd(&workmemgranted, rsi->workmemgranted, rsh, rsi, nsi);
+		cdbexplain_depStatAcc_upd(&workmemreleased, rsi->workmemreleased, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&totalWorkfileCreated, (rsi->workfileCreated ? 1 : 0), rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&peakMemBalance, rsi->peakMemBalance, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&totalPartTableScanned, rsi->numPartScanned, rsh, rsi, nsi);
@@ -1206,6 +1261,8 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 	ns->execmemused = execmemused.agg;
 	ns->workmemused = workmemused.agg;
 	ns->workmemwanted = workmemwanted.agg;
+	ns->workmemgranted = workmemgranted.agg;
+	ns->workmemreleased = workmemreleased.agg;
 	ns->totalWorkfileCreated = totalWorkfileCreated.agg;
 	ns->peakMemBalance = peakMemBalance.agg;
 	ns->totalPartTableScanned = totalPartTableScanned.agg;
@@ -1635,6 +1692,30 @@ cdbexplain_showExecStats(struct PlanState *planstate, ExplainState *es)
 		}
 	}
 
+	/*
+	 * Memory borrowed from, and given back to, the memory broker.
+	 */
+	if (es->analyze && es->verbose &&
+		(ns->workmemgranted.vcnt > 0 || ns->workmemreleased.vcnt > 0))
+	{
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str, "Memory broker: granted %ldkB  Segments: %d  released %ldkB  Segments: %d\n",
+							 (long) kb(ns->workmemgranted.vsum),
+							 ns->workmemgranted.vcnt,
+							 (long) kb(ns->workmemreleased.vsum),
+							 ns->workmemreleased.vcnt);
+		}
+		else
+		{
+			ExplainPropertyLong("Memory Broker Granted", (long) kb(ns->workmemgranted.vsum), es);
+			ExplainPropertyInteger("Memory Broker Granted Segments", ns->workmemgranted.vcnt, es);
+			ExplainPropertyLong("Memory Broker Released", (long) kb(ns->workmemreleased.vsum), es);
+			ExplainPropertyInteger("Memory Broker Released Segments", ns->workmemreleased.vcnt, es);
+		}
+	}
+
 	if (es->verbose && EXPLAIN_MEMORY_VERBOSITY_SUPPRESS < explain_memory_verbosity)
 	{
 		/*
@@ -1894,6 +1975,31 @@ cdbexplain_showExecStatsEnd(struct PlannedStmt *stmt,
 {
     gpexplain_formatSlicesOutput(showstatctx, estate, es);
 
+	/* Dispatch timings are only shown with VERBOSE */
+	if (showstatctx->ndispatch > 0 && es->verbose)
+	{
+		double		gangs = INSTR_TIME_GET_MILLISEC(showstatctx->dispatch_gangs);
+		double		serialize = INSTR_TIME_GET_MILLISEC(showstatctx->dispatch_serialize);
+		double		compress = INSTR_TIME_GET_MILLISEC(showstatctx->dispatch_compress);
+		double		send = INSTR_TIME_GET_MILLISEC(showstatctx->dispatch_send);
+		double		interconnect = INSTR_TIME_GET_MILLISEC(showstatctx->dispatch_interconnect);
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+			appendStringInfo(es->str,
+							 "Dispatch: gangs %.3f ms, serialize %.3f ms, compress %.3f ms, send %.3f ms, interconnect setup %.3f ms\n",
+							 gangs, serialize, compress, send, interconnect);
+		else
+		{
+			ExplainOpenGroup("Dispatch", "Dispatch", true, es);
+			ExplainPropertyFloat("Gang Allocation Time", gangs, 3, es);
+			ExplainPropertyFloat("Serialize Time", serialize, 3, es);
+			ExplainPropertyFloat("Compress Time", compress, 3, es);
+			ExplainPropertyFloat("Send Time", send, 3, es);
+			ExplainPropertyFloat("Interconnect Setup Time", interconnect, 3, es);
+			ExplainCloseGroup("Dispatch", "Dispatch", true, es);
+		}
+	}
+
 	if (!IsResManagerMemoryPolicyNone())
 	{
 		ExplainOpenGroup("Statement statistics", "Statement statistics", true, es);
@@ -76,7 +76,7 @@ typedef enum InputRecordType
 #define SANITY_CHECK_METADATA_SIZE(hashtable) \
 	do { \
 		Assert((hashtable)->mem_for_metadata > 0); \
-		Assert((hashtable)->mem_for_metadata > (hashtable)->nbuckets * OVERHEAD_PER_BUCKET); \
+		Assert((hashtable)->mem_for_metadata > (hashtable)->nbuckets * BUCKET_OVERHEAD(hashtable)); \
 		if ((hashtable)->mem_for_metadata >= (hashtable)->max_mem) \
 			ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR), \
 				errmsg(ERRMSG_GP_INSUFFICIENT_STATEMENT_MEMORY)));\
@@ -94,6 +94,30 @@ typedef enum InputRecordType
 /* Actual memory needed per bucket = entry pointer + bloom value */
 #define OVERHEAD_PER_BUCKET (sizeof(HashAggBucket) + sizeof(uint64))
 
+/* Actual memory needed per slot of the open-addressing layout */
+#define OVERHEAD_PER_SLOT (sizeof(HashAggSlot))
+
+#define BUCKET_OVERHEAD(hashtable) \
+		((hashtable)->open_addressing ? OVERHEAD_PER_SLOT : OVERHEAD_PER_BUCKET)
+
+/*
+ * Maximum fill factor of the open-addressing layout, in percent. A table
+ * that would get fuller is expanded, or if it can't be, reported full.
+ */
+#define MAX_SLOT_FILL_PERCENT 75
+
+#define SLOTS_FULL(hashtable, nentries) \
+		((uint64) (nentries) * 100 > (uint64) (hashtable)->nbuckets * MAX_SLOT_FILL_PERCENT)
+
+/* How many slots ahead to prefetch when walking over the slots */
+#define SLOT_PREFETCH_DISTANCE 8
+
+#if defined(__GNUC__)
+#define hha_prefetch(addr) __builtin_prefetch(addr)
+#else
+#define hha_prefetch(addr) ((void) 0)
+#endif
+
 #define BLOOMVAL(hashkey) ((uint64)1) << (((hashkey) >> 23) & 0x3f);
 
 #define BUCKET_IDX(hashtable, hashkey) \
@@ -117,11 +141,17 @@ static void *readHashEntry(AggState *aggstate,
 /* Methods for hash table */
 static uint32 calc_hash_value(AggState* aggstate, TupleTableSlot *inputslot);
 static void spill_hash_table(AggState *aggstate);
+static bool grow_hash_table_mem(AggState *aggstate);
 static void expand_hash_table(AggState *aggstate);
+static void expand_hash_slots(AggState *aggstate);
+static void spill_hash_slots(AggState *aggstate, SpillSet *spill_set);
 static void init_agg_hash_iter(HashAggTable* ht);
 static HashAggEntry *lookup_agg_hash_entry(AggState *aggstate, void *input_record,
 										   InputRecordType input_type, int32 input_size,
 										   uint32 hashkey, bool *p_isnew);
+static HashAggEntry *lookup_agg_hash_slot(AggState *aggstate, void *input_record,
+										  InputRecordType input_type, int32 input_size,
+										  uint32 hashkey, bool *p_isnew);
 static void agg_hash_table_stat_upd(HashAggTable *ht);
 static void reset_agg_hash_table(AggState *aggstate, int64 nentries);
 static bool agg_hash_reload(AggState *aggstate);
@@ -367,6 +397,211 @@ setGroupAggs(HashAggTable *hashtable, HashAggEntry *entry)
 	}
 }
 
+/*
+ * Function: get_input_key
+ *
+ * Returns grouping column 'att' of the given input record.
+ */
+static inline Datum
+get_input_key(AggState *aggstate, void *input_record,
+			  InputRecordType input_type, AttrNumber att, bool *isnull)
+{
+	switch(input_type)
+	{
+		case INPUT_RECORD_TUPLE:
+			return slot_getattr((TupleTableSlot *)input_record, att, isnull);
+		case INPUT_RECORD_GROUP_AND_AGGS:
+			return memtuple_getattr((MemTuple)input_record,
+									aggstate->hashslot->tts_mt_bind, att, isnull);
+		default:
+			insist_log(false, "invalid record type %d", input_type);
+	}
+	return 0;
+}
+
+/*
+ * Function: match_group_keys
+ *
+ * Returns true if the grouping keys of the input record equal the ones
+ * stored in the given entry tuple.
+ */
+static bool
+match_group_keys(AggState *aggstate, void *input_record,
+				 InputRecordType input_type, MemTuple mtup)
+{
+	Agg *agg = (Agg*)aggstate->ss.ps.plan;
+	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
+	int i;
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		AttrNumber	att = agg->grpColIdx[i];
+		Datum input_datum;
+		Datum entry_datum;
+		bool input_isNull = false;
+		bool entry_isNull = false;
+
+		input_datum = get_input_key(aggstate, input_record, input_type, att, &input_isNull);
+		entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
+
+		if ( !input_isNull && !entry_isNull &&
+			 (DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
+										 input_datum,
+										 entry_datum)) ) )
+			continue; /* Both non-NULL and equal. */
+		if (!(input_isNull && entry_isNull)) /* NULLs match in group keys. */
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Function: match_inline_keys
+ *
+ * Like match_group_keys, but compares with the grouping key stored in a slot
+ * of the open-addressing layout.
+ */
+static bool
+match_inline_keys(AggState *aggstate, void *input_record,
+				  InputRecordType input_type, HashAggSlot *slot)
+{
+	Agg *agg = (Agg*)aggstate->ss.ps.plan;
+	int i;
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		bool input_isNull = false;
+		bool slot_isNull = (slot->keynulls & (1 << i)) != 0;
+		Datum input_datum = get_input_key(aggstate, input_record, input_type,
+										  agg->grpColIdx[i], &input_isNull);
+
+		if (input_isNull || slot_isNull)
+		{
+			if (input_isNull != slot_isNull)
+				return false;
+			continue; /* NULLs match in group keys. */
+		}
+		if (!DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
+										input_datum,
+										slot->keys[i])))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Function: store_inline_keys
+ *
+ * Store the grouping key of the input record in a slot of the
+ * open-addressing layout. All grouping columns are passed by value.
+ */
+static void
+store_inline_keys(AggState *aggstate, void *input_record,
+				  InputRecordType input_type, HashAggSlot *slot)
+{
+	Agg *agg = (Agg*)aggstate->ss.ps.plan;
+	int i;
+
+	Assert(agg->numCols <= HHA_INLINE_KEYS);
+
+	slot->keynulls = 0;
+	for (i = 0; i < agg->numCols; i++)
+	{
+		bool isnull = false;
+
+		slot->keys[i] = get_input_key(aggstate, input_record, input_type,
+									  agg->grpColIdx[i], &isnull);
+		if (isnull)
+		{
+			slot->keys[i] = 0;
+			slot->keynulls |= (1 << i);
+		}
+	}
+}
+
+/*
+ * Function: can_inline_keys
+ *
+ * Can the grouping keys of input tuples of the given descriptor be stored in
+ * the slots of the open-addressing layout?
+ */
+static bool
+can_inline_keys(Agg *agg, TupleDesc tupdesc)
+{
+	int i;
+
+	if (agg->numCols > HHA_INLINE_KEYS)
+		return false;
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		if (!tupdesc->attrs[agg->grpColIdx[i] - 1]->attbyval)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Function: find_free_slot
+ *
+ * Returns the free slot where an entry with the given hash value goes.
+ */
+static inline HashAggSlot *
+find_free_slot(HashAggTable *hashtable, uint32 hashkey)
+{
+	unsigned mask = hashtable->nbuckets - 1;
+	unsigned idx = BUCKET_IDX(hashtable, hashkey);
+
+	while (hashtable->slots[idx].entry != NULL)
+		idx = (idx + 1) & mask;
+
+	return &hashtable->slots[idx];
+}
+
+/*
+ * Function: prefetch_slot_entries
+ *
+ * Prefetch the entries of the slots ahead of 'idx', when walking over all
+ * slots. The entry of a slot is fetched first, and then, closer to 'idx',
+ * the grouping keys and aggregate values it points to.
+ */
+static inline void
+prefetch_slot_entries(HashAggTable *hashtable, unsigned idx)
+{
+	HashAggSlot *slots = hashtable->slots;
+
+	if (idx + 2 * SLOT_PREFETCH_DISTANCE < hashtable->nbuckets &&
+		slots[idx + 2 * SLOT_PREFETCH_DISTANCE].entry != NULL)
+		hha_prefetch(slots[idx + 2 * SLOT_PREFETCH_DISTANCE].entry);
+
+	if (idx + SLOT_PREFETCH_DISTANCE < hashtable->nbuckets &&
+		slots[idx + SLOT_PREFETCH_DISTANCE].entry != NULL)
+		hha_prefetch(slots[idx + SLOT_PREFETCH_DISTANCE].entry->tuple_and_aggs);
+}
+
+/*
+ * Function: calc_num_slots
+ *
+ * Calculate the number of slots of the open-addressing layout for the
+ * given number of entries: a power of two big enough to keep the fill under
+ * MAX_SLOT_FILL_PERCENT, but using at most a quarter of the memory.
+ */
+static unsigned
+calc_num_slots(double nentries, double max_mem)
+{
+	double nslots = 64;
+
+	while (nslots * MAX_SLOT_FILL_PERCENT < nentries * 100 &&
+		   2 * nslots * OVERHEAD_PER_SLOT <= max_mem / 4 &&
+		   2 * nslots * OVERHEAD_PER_SLOT <= MaxAllocSize)
+		nslots *= 2;
+
+	return (unsigned) nslots;
+}
+
 /*
  * Function: lookup_agg_hash_entry
  *
@@ -392,20 +627,26 @@ lookup_agg_hash_entry(AggState *aggstate,
 {
 	HashAggEntry *entry;
 	HashAggTable *hashtable = aggstate->hhashtable;
-	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
 	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
-	Agg *agg = (Agg*)aggstate->ss.ps.plan;
 	MemoryContext oldcxt;
 	unsigned int bucket_idx;
 	uint64 bloomval;			/* bloom filter value */
    
-	Assert(mt_bind != NULL);
+	Assert(aggstate->hashslot->tts_mt_bind != NULL);
 
 	if (p_isnew != NULL)
 		*p_isnew = false;
 
 	oldcxt = MemoryContextSwitchTo(tmpcontext->ecxt_per_tuple_memory);
 
+	if (hashtable->open_addressing)
+	{
+		entry = lookup_agg_hash_slot(aggstate, input_record, input_type,
+									 input_size, hashkey, p_isnew);
+		(void) MemoryContextSwitchTo(oldcxt);
+		return entry;
+	}
+
 	bucket_idx = BUCKET_IDX(hashtable, hashkey);
 	bloomval = BLOOMVAL(hashkey);
 	entry = (0 == (hashtable->bloom[bucket_idx] & bloomval) ? NULL :
@@ -419,48 +660,10 @@ lookup_agg_hash_entry(AggState *aggstate,
 	 */
 	while (entry != NULL)
 	{
-		MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
-		int i;
-		bool match = true;
-
-		if (hashkey != entry->hashvalue)
-		{
-			entry = entry->next;
-			continue;
-		}
-		
-		for (i = 0; match && i < agg->numCols; i++)
-		{
-			AttrNumber	att = agg->grpColIdx[i];
-			Datum input_datum = 0;
-			Datum entry_datum = 0;
-			bool input_isNull = false;
-			bool entry_isNull = false;
-				
-			switch(input_type)
-			{
-				case INPUT_RECORD_TUPLE:
-					input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
-					break;
-				case INPUT_RECORD_GROUP_AND_AGGS:
-					input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
-					break;
-				default:
-					insist_log(false, "invalid record type %d", input_type);
-			}
-
-			entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
-
-			if ( !input_isNull && !entry_isNull &&
-				 (DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
-											 input_datum,
-											 entry_datum)) ) )
-				continue; /* Both non-NULL and equal. */
-			match = (input_isNull && entry_isNull);/* NULLs match in group keys. */
-		}
-		
 		/* Break if found an existing matching entry. */
-		if (match)
+		if (hashkey == entry->hashvalue &&
+			match_group_keys(aggstate, input_record, input_type,
+							 (MemTuple) entry->tuple_and_aggs))
 			break;
 
 		entry = entry->next;
@@ -511,6 +714,89 @@ lookup_agg_hash_entry(AggState *aggstate,
 	return entry;
 }
 
+/*
+ * Function: lookup_agg_hash_slot
+ *
+ * lookup_agg_hash_entry for the open-addressing layout.
+ *
+ * Slots are probed linearly from the one the hash value maps to, until
+ * the matching entry or a free slot is found. The key of an entry is only
+ * compared if the hash value stored in its slot matches, and with inline
+ * keys, the entry isn't touched at all for the comparison.
+ *
+ * If a new entry would make the table fuller than MAX_SLOT_FILL_PERCENT, the
+ * table is expanded. If that's not possible, NULL is returned, just as when
+ * no memory is left for the entry, so the caller spills.
+ */
+static HashAggEntry *
+lookup_agg_hash_slot(AggState *aggstate, void *input_record,
+					 InputRecordType input_type, int32 input_size,
+					 uint32 hashkey, bool *p_isnew)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	unsigned mask = hashtable->nbuckets - 1;
+	unsigned idx = BUCKET_IDX(hashtable, hashkey);
+	HashAggSlot *slot;
+	HashAggEntry *entry = NULL;
+
+	for (;;)
+	{
+		slot = &hashtable->slots[idx];
+
+		if (slot->entry == NULL)
+			break;
+
+		if (slot->hashvalue == hashkey &&
+			(hashtable->inline_keys ?
+			 match_inline_keys(aggstate, input_record, input_type, slot) :
+			 match_group_keys(aggstate, input_record, input_type,
+							  (MemTuple) slot->entry->tuple_and_aggs)))
+			return slot->entry;
+
+		idx = (idx + 1) & mask;
+	}
+
+	/* Entry not found! Make sure there is a slot for a new one. */
+	if (SLOTS_FULL(hashtable, hashtable->num_entries + 1))
+	{
+		if (hashtable->expandable)
+			expand_hash_slots(aggstate);
+
+		if (SLOTS_FULL(hashtable, hashtable->num_entries + 1))
+			return NULL;
+
+		slot = find_free_slot(hashtable, hashkey);
+	}
+
+	switch(input_type)
+	{
+		case INPUT_RECORD_TUPLE:
+			entry = makeHashAggEntryForInput(aggstate, (TupleTableSlot *)input_record, hashkey);
+			break;
+		case INPUT_RECORD_GROUP_AND_AGGS:
+			entry = makeHashAggEntryForGroup(aggstate, input_record, input_size, hashkey);
+			break;
+		default:
+			insist_log(false, "invalid record type %d", input_type);
+	}
+
+	/* No room to create one. */
+	if (entry == NULL)
+		return NULL;
+
+	slot->entry = entry;
+	slot->hashvalue = hashkey;
+	if (hashtable->inline_keys)
+		store_inline_keys(aggstate, input_record, input_type, slot);
+
+	++hashtable->num_ht_groups;
+	++hashtable->num_entries;
+
+	*p_isnew = true; /* created a new entry */
+
+	return entry;
+}
+
 /*
  * Compute HHashTable entry size
  *
@@ -767,10 +1053,20 @@ create_agg_hash_table(AggState *aggstate)
 		elog(ERROR, ERRMSG_GP_INSUFFICIENT_STATEMENT_MEMORY);
 	}
 
-	/* Initialize the hash buckets */
-	hashtable->nbuckets = hashtable->hats.nbuckets;
-	hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-	hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+	/* Initialize the hash buckets, or slots */
+	hashtable->open_addressing = gp_hashagg_open_addressing;
+	if (hashtable->open_addressing)
+	{
+		hashtable->nbuckets = calc_num_slots(hashtable->hats.nentries,
+											 1024.0 * (double) operatorMemKB);
+		hashtable->slots = (HashAggSlot *) palloc0(hashtable->nbuckets * sizeof(HashAggSlot));
+	}
+	else
+	{
+		hashtable->nbuckets = hashtable->hats.nbuckets;
+		hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
+		hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+	}
 
 	hashtable->pshift = 0;
 	hashtable->expandable = true;
@@ -792,7 +1088,7 @@ create_agg_hash_table(AggState *aggstate)
 
 	hashtable->max_mem = 1024.0 * operatorMemKB;
 	hashtable->mem_for_metadata = sizeof(HashAggTable) +
-			hashtable->nbuckets * OVERHEAD_PER_BUCKET +
+			hashtable->nbuckets * BUCKET_OVERHEAD(hashtable) +
 			sizeof(GroupKeysAndAggs);
 	hashtable->mem_wanted = hashtable->mem_for_metadata;
 	hashtable->mem_used = hashtable->mem_for_metadata;
@@ -830,6 +1126,7 @@ agg_hash_initial_pass(AggState *aggstate)
 	TupleTableSlot *outerslot = NULL;
 	bool streaming = ((Agg *) aggstate->ss.ps.plan)->streaming;
 	bool tuple_remaining = true;
+	uint64 fill_start_tuples = hashtable->num_tuples;
 
 	Assert(hashtable);
 	AssertImply(!streaming, aggstate->hashaggstatus == HASHAGG_BEFORE_FIRST_PASS);
@@ -880,6 +1177,10 @@ agg_hash_initial_pass(AggState *aggstate)
 			
 			hashtable->hashkey_buf = (HashKey *)palloc0(size);
 			hashtable->mem_for_metadata += size;
+
+			if (hashtable->open_addressing)
+				hashtable->inline_keys = can_inline_keys((Agg *) aggstate->ss.ps.plan,
+														 outerslot->tts_tupleDescriptor);
 		}
 
 		/* set up for advance_aggregates call */
@@ -890,6 +1191,15 @@ agg_hash_initial_pass(AggState *aggstate)
 		hashkey = calc_hash_value(aggstate, outerslot);
 		entry = lookup_agg_hash_entry(aggstate, (void *)outerslot,
 									  INPUT_RECORD_TUPLE, 0, hashkey, &isNew);
+
+		/*
+		 * Before the first spill, see if the memory broker can let us have
+		 * more memory.  A streaming hash table streams its groups instead.
+		 */
+		if (entry == NULL && !streaming && !hashtable->is_spilling &&
+			grow_hash_table_mem(aggstate))
+			entry = lookup_agg_hash_entry(aggstate, (void *)outerslot,
+										  INPUT_RECORD_TUPLE, 0, hashkey, &isNew);
 		
 		if (entry == NULL)
 		{
@@ -988,8 +1298,32 @@ agg_hash_initial_pass(AggState *aggstate)
 
 	AssertImply(tuple_remaining, streaming);
 	if(tuple_remaining) 
+	{
+		uint64 fill_tuples = hashtable->num_tuples - fill_start_tuples;
+
 		elog(HHA_MSG_LVL, "HashAgg: streaming out the intermediate results.");
 
+		/*
+		 * The table filled up.  If it barely reduced its input, the groups
+		 * are close to unique in this segment's input, and hashing the rest
+		 * of it only costs time: the upper stage will combine the rows
+		 * anyway.  Stop aggregating once the current groups are streamed.
+		 */
+		if (gp_hashagg_bypass_min_reduction > 0 &&
+			!((Agg *) aggstate->ss.ps.plan)->inputHasGrouping &&
+			(double) hashtable->num_ht_groups >
+			(1.0 - gp_hashagg_bypass_min_reduction) * (double) fill_tuples)
+		{
+			hashtable->bypass = true;
+			hashtable->bypass_fill_tuples = fill_tuples;
+			hashtable->bypass_fill_groups = hashtable->num_ht_groups;
+
+			elog(HHA_MSG_LVL, "HashAgg: " INT64_FORMAT " input tuples formed "
+				 INT64_FORMAT " groups, bypassing aggregation.",
+				 fill_tuples, hashtable->num_ht_groups);
+		}
+	}
+
 	return tuple_remaining;
 }
 
@@ -1246,6 +1580,21 @@ obtain_spill_set(HashAggTable *hashtable)
 	return *p_spill_set;
 }
 
+/* Ask the memory broker for as much memory again as the hash table may use,
+ * and raise max_mem by whatever is granted.  Returns true if anything was.
+ */
+static bool
+grow_hash_table_mem(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	uint64		granted;
+
+	granted = ExecRequestOperatorMem(&aggstate->ss.ps, (uint64) hashtable->max_mem);
+	hashtable->max_mem += granted;
+
+	return granted > 0;
+}
+
 /* Spill all entries from the hash table to file in order to make room
  * for new hash entries.
  *
@@ -1281,7 +1630,8 @@ spill_hash_table(AggState *aggstate)
 	/* Book keeping. */
 	hashtable->is_spilling = true;
 
-	Assert(hashtable->nbuckets > spill_set->num_spill_files);
+	AssertImply(!hashtable->open_addressing,
+				hashtable->nbuckets > spill_set->num_spill_files);
 
 	/*
 	 * Write each spill file. Write the last spill file first, since it will
@@ -1314,6 +1664,10 @@ spill_hash_table(AggState *aggstate)
 			CheckSendPlanStateGpmonPkt(&aggstate->ss.ps);
 		}
 
+		/* The slots are written in one pass below, once all files exist */
+		if (hashtable->open_addressing)
+			continue;
+
 		for (bucket_no = file_no; bucket_no < hashtable->nbuckets;
 			 bucket_no += spill_set->num_spill_files)
 		{
@@ -1345,6 +1699,9 @@ spill_hash_table(AggState *aggstate)
 		}
 	}
 
+	if (hashtable->open_addressing)
+		spill_hash_slots(aggstate, spill_set);
+
 	/* Reset the buffer */
 	mpool_reset(hashtable->group_buf);
 
@@ -1357,6 +1714,45 @@ spill_hash_table(AggState *aggstate)
 	MemoryContextSwitchTo(oldcxt);
 }
 
+/*
+ * spill_hash_slots -- spill_hash_table for the open-addressing layout.
+ *
+ * The slots are walked once, and each entry is written to the spill file
+ * its hash value maps to, the same file that the chained layout would
+ * write it to, so the reload of a batch file doesn't need to know which
+ * layout it was written by.
+ */
+static void
+spill_hash_slots(AggState *aggstate, SpillSet *spill_set)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	unsigned idx;
+
+	for (idx = 0; idx < hashtable->nbuckets; idx++)
+	{
+		HashAggSlot *slot = &hashtable->slots[idx];
+		SpillFile *spill_file;
+		int32 written_bytes;
+
+		prefetch_slot_entries(hashtable, idx);
+
+		if (slot->entry == NULL)
+			continue;
+
+		spill_file = &spill_set->spill_files[(slot->hashvalue >> hashtable->pshift) &
+											 (spill_set->num_spill_files - 1)];
+		Assert(spill_file->file_info != NULL);
+
+		written_bytes = writeHashEntry(aggstate, spill_file->file_info, slot->entry);
+		spill_file->file_info->ntuples++;
+		spill_file->file_info->total_bytes += written_bytes;
+
+		hashtable->num_spill_groups++;
+	}
+
+	MemSet(hashtable->slots, 0, hashtable->nbuckets * sizeof(HashAggSlot));
+}
+
 static void
 expand_hash_table(AggState *aggstate)
 {
@@ -1438,6 +1834,78 @@ expand_hash_table(AggState *aggstate)
 	Assert(nentries == hashtable->num_entries);
 }
 
+/*
+ * expand_hash_slots -- expand_hash_table for the open-addressing layout.
+ *
+ * Doubles the number of slots, and moves the entries to their slots in the
+ * new array. Only the hash values stored in the slots are needed for that.
+ */
+static void
+expand_hash_slots(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	HashAggSlot *old_slots = hashtable->slots;
+	HashAggSlot *new_slots;
+	unsigned old_nslots = hashtable->nbuckets;
+	unsigned mask;
+	double mem_needed;
+	unsigned idx;
+
+	Assert(hashtable->open_addressing);
+
+	/* Make sure there is memory available for additional slots */
+	mem_needed = (double) old_nslots * OVERHEAD_PER_SLOT;
+	if (mem_needed > AVAIL_MEM(hashtable) ||
+		old_nslots > (UINT_MAX / 2) ||
+		2 * mem_needed > MaxAllocSize)
+	{
+		elog(HHA_MSG_LVL, "HashAgg: cannot grow the number of slots!");
+		elog(HHA_MSG_LVL, "HashAgg: mem needed = %.0f available = %.0f; nslots = %d",
+			 mem_needed, AVAIL_MEM(hashtable), old_nslots);
+		hashtable->expandable = false;
+		return;
+	}
+	elog(HHA_MSG_LVL, "Growing the hash table to %d slots with " INT64_FORMAT " entries",
+		 old_nslots * 2, hashtable->num_entries);
+
+	new_slots = (HashAggSlot *) MemoryContextAllocZero(aggstate->aggcontext,
+										2 * (Size) old_nslots * sizeof(HashAggSlot));
+
+	hashtable->slots = new_slots;
+	hashtable->nbuckets = old_nslots * 2;
+	hashtable->mem_for_metadata += mem_needed;
+	hashtable->mem_wanted = Max(hashtable->mem_wanted, hashtable->mem_for_metadata);
+	mask = hashtable->nbuckets - 1;
+
+	Assert(GET_TOTAL_USED_SIZE(hashtable) < hashtable->max_mem);
+
+	for (idx = 0; idx < old_nslots; idx++)
+	{
+		HashAggSlot *slot = &old_slots[idx];
+		unsigned new_idx;
+
+		/* The writes to the new array are random, fetch them ahead */
+		if (idx + SLOT_PREFETCH_DISTANCE < old_nslots &&
+			old_slots[idx + SLOT_PREFETCH_DISTANCE].entry != NULL)
+			hha_prefetch(&new_slots[BUCKET_IDX(hashtable,
+											   old_slots[idx + SLOT_PREFETCH_DISTANCE].hashvalue)]);
+
+		if (slot->entry == NULL)
+			continue;
+
+		new_idx = BUCKET_IDX(hashtable, slot->hashvalue);
+		while (new_slots[new_idx].entry != NULL)
+			new_idx = (new_idx + 1) & mask;
+
+		new_slots[new_idx] = *slot;
+	}
+
+	pfree(old_slots);
+
+	hashtable->num_expansions++;
+	Assert(hashtable->mem_for_metadata > 0);
+}
+
 /*
  * writeHashEntry -- write an hash entry to a batch file.
  *
@@ -1526,6 +1994,25 @@ agg_hash_table_stat_upd(HashAggTable *hashtable)
 {
 	unsigned int	i;
 
+	if (hashtable->open_addressing)
+	{
+		unsigned int	mask = hashtable->nbuckets - 1;
+
+		/* Record the probe length of each entry instead of chain lengths */
+		for (i = 0; i < hashtable->nbuckets; i++)
+		{
+			HashAggSlot    *slot = &hashtable->slots[i];
+
+			if (slot->entry != NULL)
+				cdbexplain_agg_upd(&hashtable->chainlength,
+								   ((i - BUCKET_IDX(hashtable, slot->hashvalue)) & mask) + 1,
+								   i);
+		}
+
+		hashtable->total_buckets += hashtable->nbuckets;
+		return;
+	}
+
 	for (i = 0; i < hashtable->nbuckets; i++)
 	{
 		HashAggEntry   *entry = hashtable->buckets[i];
@@ -1550,7 +2037,9 @@ agg_hash_table_stat_upd(HashAggTable *hashtable)
  * Initialize the HashAggTable's (one and only) entry iterator. */
 void init_agg_hash_iter(HashAggTable* hashtable)
 {
-	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
+	Assert( hashtable != NULL &&
+			(hashtable->buckets != NULL || hashtable->slots != NULL) &&
+			hashtable->nbuckets > 0 );
 	
 	hashtable->curr_bucket_idx = -1;
 	hashtable->next_entry = NULL;
@@ -1573,14 +2062,29 @@ agg_hash_iter(AggState *aggstate)
 	SpillSet *spill_set = hashtable->spill_set;
 	MemoryContext oldcxt;
 
-	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
+	Assert( hashtable != NULL &&
+			(hashtable->buckets != NULL || hashtable->slots != NULL) &&
+			hashtable->nbuckets > 0 );
 
 	if (hashtable->curr_spill_file != NULL)
 		spill_set = hashtable->curr_spill_file->spill_set;
 	
 	oldcxt = MemoryContextSwitchTo(hashtable->entry_cxt);
 
-	while (entry == NULL &&
+	while (hashtable->open_addressing &&
+		   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
+	{
+		prefetch_slot_entries(hashtable, hashtable->curr_bucket_idx);
+
+		entry = hashtable->slots[hashtable->curr_bucket_idx].entry;
+		if (entry != NULL)
+		{
+			Assert(entry->is_primodial);
+			break;
+		}
+	}
+
+	while (!hashtable->open_addressing && entry == NULL &&
 		   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
 	{
 		entry = hashtable->buckets[hashtable->curr_bucket_idx];
@@ -1675,6 +2179,80 @@ agg_hash_stream(AggState *aggstate)
 	return agg_hash_initial_pass(aggstate);
 }
 
+/* Function: agg_hash_start_bypass
+ *
+ * Switch a streaming hash table, whose groups have all been streamed, to
+ * bypass mode: from now on agg_hash_bypass_next returns every remaining
+ * input tuple as a group of its own, without hashing it.
+ */
+void
+agg_hash_start_bypass(AggState *aggstate)
+{
+	Assert(((Agg *) aggstate->ss.ps.plan)->streaming);
+	Assert(aggstate->hhashtable->bypass);
+
+	elog(HHA_MSG_LVL,
+		"HashAgg: passing the remaining input tuples through");
+
+	reset_agg_hash_table(aggstate, 0 /* don't reallocate buckets */);
+}
+
+/* Function: agg_hash_bypass_next
+ *
+ * Read the next input tuple in bypass mode, and run it through the
+ * transition functions of a fresh set of aggregate states.
+ *
+ * Returns the aggregate states, with the input tuple in *outerslot, or
+ * NULL at the end of the input.  The states stay valid until the next
+ * call.
+ */
+AggStatePerGroup
+agg_hash_bypass_next(AggState *aggstate, TupleTableSlot **outerslot)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	TupleTableSlot *slot;
+	AggStatePerGroup pergroup;
+
+	Assert(hashtable->bypass);
+
+	/*
+	 * The caller is done with the previous tuple's aggregate states, so
+	 * their memory can be recycled once it adds up to the operator's
+	 * quota.
+	 */
+	ResetExprContext(tmpcontext);
+	if (!HAVE_FREESPACE(hashtable))
+		mpool_reset(hashtable->group_buf);
+
+	if (hashtable->prev_slot != NULL)
+	{
+		slot = hashtable->prev_slot;
+		hashtable->prev_slot = NULL;
+	}
+	else
+		slot = ExecProcNode(outerPlanState(aggstate));
+
+	if (TupIsNull(slot))
+		return NULL;
+
+	pergroup = (AggStatePerGroup)
+		mpool_alloc(hashtable->group_buf,
+					Max(aggstate->numaggs, 1) * sizeof(AggStatePerGroupData));
+	MemSet(pergroup, 0, aggstate->numaggs * sizeof(AggStatePerGroupData));
+
+	tmpcontext->ecxt_outertuple = slot;
+	initialize_aggregates(aggstate, aggstate->peragg, pergroup,
+						  &(aggstate->mem_manager));
+	advance_aggregates(aggstate, pergroup, &(aggstate->mem_manager));
+
+	hashtable->num_tuples++;
+	hashtable->num_bypass_tuples++;
+
+	*outerslot = slot;
+	return pergroup;
+}
+
 /*
  * Function: agg_hash_load
  *
@@ -2092,8 +2670,39 @@ agg_hash_explain(AggState *aggstate)
 		appendStringInfo(hbuf, ".\n");
 	}
 
+	if (hashtable->bypass)
+	{
+		appendStringInfo(hbuf,
+				"Aggregation bypassed after " INT64_FORMAT " rows formed "
+				INT64_FORMAT " groups; " INT64_FORMAT " rows passed through.\n",
+				hashtable->bypass_fill_tuples,
+				hashtable->bypass_fill_groups,
+				hashtable->num_bypass_tuples);
+	}
+
+	/* Time spent waiting for the workfile helper thread, if any */
+	if (hashtable->work_set != NULL &&
+		!INSTR_TIME_IS_ZERO(hashtable->work_set->io_wait_time))
+	{
+		appendStringInfo(hbuf,
+				"Waited %.3f ms for workfile I/O.\n",
+				INSTR_TIME_GET_MILLISEC(hashtable->work_set->io_wait_time));
+	}
+
 	/* Hash chain statistics */
-	if (hashtable->chainlength.vcnt > 0)
+	if (hashtable->chainlength.vcnt > 0 && hashtable->open_addressing)
+	{
+		appendStringInfo(hbuf,
+				"Hash probe length %.1f avg, %.0f max,"
+				" using %d of " INT64_FORMAT " slots"
+				"; total %d expansions.\n",
+				cdbexplain_agg_avg(&hashtable->chainlength),
+				hashtable->chainlength.vmax,
+				hashtable->chainlength.vcnt,
+				hashtable->total_buckets,
+				hashtable->num_expansions);
+	}
+	else if (hashtable->chainlength.vcnt > 0)
 	{
 		appendStringInfo(hbuf,
 				"Hash chain length %.1f avg, %.0f max,"
@@ -2114,6 +2723,53 @@ Gpmon_ResetAggHashTable(AggState* aggstate)
 	CheckSendPlanStateGpmonPkt(&aggstate->ss.ps);
 }
 
+/* Function: reset_agg_hash_slots
+ *
+ * reset_agg_hash_table for the open-addressing layout.
+ */
+static void
+reset_agg_hash_slots(AggState *aggstate, int64 nentries)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	unsigned nslots;
+
+	Assert(hashtable->slots);
+
+	nslots = (nentries > 0 ?
+			  calc_num_slots(nentries, hashtable->max_mem) : hashtable->nbuckets);
+
+	if (nslots != hashtable->nbuckets)
+	{
+		hashtable->mem_for_metadata +=
+			((double) nslots - hashtable->nbuckets) * OVERHEAD_PER_SLOT;
+		hashtable->nbuckets = nslots;
+
+		pfree(hashtable->slots);
+		hashtable->slots = (HashAggSlot *)
+			MemoryContextAllocZero(aggstate->aggcontext, nslots * sizeof(HashAggSlot));
+
+		elog(HHA_MSG_LVL, "Resetting with %d slots for " INT64_FORMAT " entries",
+			 nslots, nentries);
+	}
+	else
+		MemSet(hashtable->slots, 0, hashtable->nbuckets * sizeof(HashAggSlot));
+
+	hashtable->expandable = true;
+
+	Assert(hashtable->mem_for_metadata > 0);
+
+	hashtable->num_ht_groups = 0;
+	hashtable->num_entries = 0;
+
+	hashtable->pshift = 0;
+
+	mpool_reset(hashtable->group_buf);
+
+	init_agg_hash_iter(hashtable);
+
+	Gpmon_ResetAggHashTable(aggstate);
+}
+
 /* Function: reset_agg_hash_table
  *
  * Clear the hash table content anchored by the bucket array.
@@ -2130,6 +2786,12 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		"HashAgg: resetting " INT64_FORMAT "-entry hash table",
 		hashtable->num_ht_groups);
 
+	if (hashtable->open_addressing)
+	{
+		reset_agg_hash_slots(aggstate, nentries);
+		return;
+	}
+
 	Assert(hashtable->buckets && hashtable->bloom);
 
 	/*
@@ -2216,8 +2878,12 @@ void destroy_agg_hash_table(AggState *aggstate)
 		Gpmon_ResetAggHashTable(aggstate);
 
 		/* destroy_batches(aggstate->hhashtable); */
-		pfree(aggstate->hhashtable->buckets);
-		pfree(aggstate->hhashtable->bloom);
+		if (aggstate->hhashtable->buckets)
+			pfree(aggstate->hhashtable->buckets);
+		if (aggstate->hhashtable->bloom)
+			pfree(aggstate->hhashtable->bloom);
+		if (aggstate->hhashtable->slots)
+			pfree(aggstate->hhashtable->slots);
 		if (aggstate->hhashtable->hashkey_buf)
 			pfree(aggstate->hhashtable->hashkey_buf);
 
@@ -741,10 +741,36 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 			if (queryDesc->planstate != NULL &&
 				queryDesc->planstate->plan->nMotionNodes > 0 && !estate->es_interconnect_is_setup)
 			{
+				instr_time	startTime;
+				instr_time	setupTime;
+				instr_time	sendTime;
+
+				INSTR_TIME_SET_CURRENT(startTime);
+
 				Assert(!estate->interconnect_context);
 				SetupInterconnect(estate);
 				Assert(estate->interconnect_context);
 				UpdateMotionExpectedReceivers(estate->motionlayer_context, estate->es_sliceTable);
+
+				INSTR_TIME_SET_CURRENT(setupTime);
+
+				/*
+				 * With gp_dispatch_pipelined, the plan may still be on its
+				 * way to some QEs.  Now that we can receive from the others,
+				 * finish sending it.
+				 */
+				if (estate->dispatcherState &&
+					estate->dispatcherState->dispatchPending)
+					cdbdisp_waitDispatchFinish(estate->dispatcherState);
+
+				if (queryDesc->showstatctx)
+				{
+					INSTR_TIME_SET_CURRENT(sendTime);
+					INSTR_TIME_SUBTRACT(sendTime, setupTime);
+					INSTR_TIME_SUBTRACT(setupTime, startTime);
+					cdbexplain_addInterconnectSetupTime(queryDesc->showstatctx,
+														setupTime, sendTime);
+				}
 			}
 
 			if (estate->es_interconnect_is_setup)
@@ -759,6 +785,11 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 			Assert(!"unsupported parallel execution strategy");
 		}
 
+		/* The QEs must have all of the plan before we start executing */
+		if (estate->dispatcherState &&
+			estate->dispatcherState->dispatchPending)
+			cdbdisp_waitDispatchFinish(estate->dispatcherState);
+
 		if(estate->es_interconnect_is_setup)
 			Assert(estate->interconnect_context != NULL);
 
@@ -2290,6 +2321,9 @@ InitResultRelInfo(ResultRelInfo *resultRelInfo,
 	resultRelInfo->nBufferedTuples = 0;
 	resultRelInfo->bufferedTuples = NULL;
 	resultRelInfo->biState = GetBulkInsertState();
+
+	/* Cached outputs of subplans reading the relation are about to go stale */
+	workfile_reuse_note_writer(RelationGetRelid(resultRelationDesc));
 }
 
 
@@ -0,0 +1,933 @@
+/*-------------------------------------------------------------------------
+ *
+ * execSteps.c
+ *	  Flattened, step-based evaluation of expression state trees.
+ *
+ * ExecInitExpr builds a tree of ExprStates, evaluated by recursing through
+ * their evalfunc pointers.  For the common shapes of quals and projections,
+ * ExecCompileExprSteps additionally flattens the tree under a top-level
+ * ExprState into an array of steps, which ExecEvalExprSteps runs in a single
+ * loop: each step stores its result where the step that consumes it expects
+ * its argument, and AND/OR short-circuit by jumping ahead.
+ *
+ * The Vars of each input slot are fetched by deforming the slot once, up to
+ * the last attribute any of them needs, at the start of the program.
+ * Comparisons of int2, int4, int8, float4, float8 and date have steps of
+ * their own that don't go through the function manager.  Subtrees of node
+ * types that aren't flattened are evaluated the ordinary way, by a step
+ * that calls ExecEvalExpr on them.
+ *
+ * With gcc, the steps are direct threaded: each one holds the address of
+ * its code, and jumps straight to that of the next.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/executor/execSteps.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "executor/execSteps.h"
+#include "executor/executor.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "pgstat.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+
+#if defined(__GNUC__)
+#define STEPS_USE_COMPUTED_GOTO
+#endif
+
+/* Slots Vars can come from, in the order of the STEP_DEFORM_* and *_VAR steps */
+#define STEPS_INNER		0
+#define STEPS_OUTER		1
+#define STEPS_SCAN		2
+#define STEPS_NSLOTS	3
+
+typedef struct StepsBuilder
+{
+	ExprStep   *steps;
+	int			nsteps;
+	int			maxsteps;
+
+	/* Vars of each slot */
+	List	   *attnums[STEPS_NSLOTS];
+	List	   *vartypes[STEPS_NSLOTS];
+	int			last_attnum[STEPS_NSLOTS];
+} StepsBuilder;
+
+/* The comparisons that have steps of their own */
+static const struct
+{
+	Oid			foid;
+	ExprStepOp	op;
+}			steps_cmp_funcs[] =
+{
+	{F_INT2EQ, STEP_INT2_EQ}, {F_INT2NE, STEP_INT2_NE},
+	{F_INT2LT, STEP_INT2_LT}, {F_INT2LE, STEP_INT2_LE},
+	{F_INT2GT, STEP_INT2_GT}, {F_INT2GE, STEP_INT2_GE},
+	{F_INT4EQ, STEP_INT4_EQ}, {F_INT4NE, STEP_INT4_NE},
+	{F_INT4LT, STEP_INT4_LT}, {F_INT4LE, STEP_INT4_LE},
+	{F_INT4GT, STEP_INT4_GT}, {F_INT4GE, STEP_INT4_GE},
+	{F_INT8EQ, STEP_INT8_EQ}, {F_INT8NE, STEP_INT8_NE},
+	{F_INT8LT, STEP_INT8_LT}, {F_INT8LE, STEP_INT8_LE},
+	{F_INT8GT, STEP_INT8_GT}, {F_INT8GE, STEP_INT8_GE},
+	{F_FLOAT4EQ, STEP_FLOAT4_EQ}, {F_FLOAT4NE, STEP_FLOAT4_NE},
+	{F_FLOAT4LT, STEP_FLOAT4_LT}, {F_FLOAT4LE, STEP_FLOAT4_LE},
+	{F_FLOAT4GT, STEP_FLOAT4_GT}, {F_FLOAT4GE, STEP_FLOAT4_GE},
+	{F_FLOAT8EQ, STEP_FLOAT8_EQ}, {F_FLOAT8NE, STEP_FLOAT8_NE},
+	{F_FLOAT8LT, STEP_FLOAT8_LT}, {F_FLOAT8LE, STEP_FLOAT8_LE},
+	{F_FLOAT8GT, STEP_FLOAT8_GT}, {F_FLOAT8GE, STEP_FLOAT8_GE},
+	/* date is an int4 */
+	{F_DATE_EQ, STEP_INT4_EQ}, {F_DATE_NE, STEP_INT4_NE},
+	{F_DATE_LT, STEP_INT4_LT}, {F_DATE_LE, STEP_INT4_LE},
+	{F_DATE_GT, STEP_INT4_GT}, {F_DATE_GE, STEP_INT4_GE},
+};
+
+static void compile_expr(StepsBuilder *b, ExprState *state,
+			 Datum *resvalue, bool *resnull);
+
+
+static int
+steps_push(StepsBuilder *b, ExprStep *step)
+{
+	if (b->nsteps == b->maxsteps)
+	{
+		b->maxsteps *= 2;
+		b->steps = repalloc(b->steps, b->maxsteps * sizeof(ExprStep));
+	}
+	b->steps[b->nsteps] = *step;
+	return b->nsteps++;
+}
+
+static void
+compile_var(StepsBuilder *b, Var *var, ExprStep *step)
+{
+	int			slot;
+
+	switch (var->varno)
+	{
+		case INNER_VAR:
+			slot = STEPS_INNER;
+			break;
+		case OUTER_VAR:
+			slot = STEPS_OUTER;
+			break;
+		default:
+			slot = STEPS_SCAN;
+			break;
+	}
+
+	step->opcode = STEP_INNER_VAR + slot;
+	step->d.var.attnum = var->varattno;
+	steps_push(b, step);
+
+	b->attnums[slot] = lappend_int(b->attnums[slot], var->varattno);
+	b->vartypes[slot] = lappend_oid(b->vartypes[slot], var->vartype);
+	b->last_attnum[slot] = Max(b->last_attnum[slot], var->varattno);
+}
+
+static void
+compile_func(StepsBuilder *b, FuncExprState *fstate, Oid foid, Oid inputcollid,
+			 ExprStep *step)
+{
+	FunctionCallInfo fcinfo;
+	ListCell   *lc;
+	int			i = 0;
+
+	fcinfo = palloc0(sizeof(FunctionCallInfoData));
+	foreach(lc, fstate->args)
+	{
+		compile_expr(b, (ExprState *) lfirst(lc),
+					 &fcinfo->arg[i], &fcinfo->argnull[i]);
+		i++;
+	}
+
+	step->opcode = STEP_FUNC_INIT;
+	step->d.func.foid = foid;
+	step->d.func.inputcollid = inputcollid;
+	step->d.func.expr = fstate->xprstate.expr;
+	step->d.func.nargs = i;
+	step->d.func.finfo = palloc0(sizeof(FmgrInfo));
+	step->d.func.fcinfo = fcinfo;
+	steps_push(b, step);
+}
+
+static void
+compile_bool(StepsBuilder *b, BoolExprState *bstate, ExprStep *step)
+{
+	BoolExpr   *boolexpr = (BoolExpr *) bstate->xprstate.expr;
+	ExprStepOp	firstop;
+	List	   *jumps = NIL;
+	bool	   *anynull;
+	ListCell   *lc;
+	int			nargs = list_length(bstate->args);
+	int			i = 0;
+
+	if (boolexpr->boolop == NOT_EXPR)
+	{
+		compile_expr(b, (ExprState *) linitial(bstate->args),
+					 step->resvalue, step->resnull);
+		step->opcode = STEP_BOOL_NOT;
+		steps_push(b, step);
+		return;
+	}
+
+	/* Each argument stores its result in ours, and is checked in turn */
+	firstop = (boolexpr->boolop == AND_EXPR ? STEP_BOOL_AND_FIRST : STEP_BOOL_OR_FIRST);
+	anynull = palloc(sizeof(bool));
+	foreach(lc, bstate->args)
+	{
+		compile_expr(b, (ExprState *) lfirst(lc), step->resvalue, step->resnull);
+
+		if (i == 0)
+			step->opcode = firstop;
+		else if (i == nargs - 1)
+			step->opcode = firstop + 2;
+		else
+			step->opcode = firstop + 1;
+		step->d.boolexpr.anynull = anynull;
+		jumps = lappend_int(jumps, steps_push(b, step));
+		i++;
+	}
+
+	foreach(lc, jumps)
+		b->steps[lfirst_int(lc)].d.boolexpr.jumpdone = b->nsteps;
+	list_free(jumps);
+}
+
+/*
+ * Appends the steps that evaluate state into *resvalue and *resnull.
+ */
+static void
+compile_expr(StepsBuilder *b, ExprState *state, Datum *resvalue, bool *resnull)
+{
+	Expr	   *node = state->expr;
+	ExprStep	step;
+
+	check_stack_depth();
+
+	MemSet(&step, 0, sizeof(step));
+	step.resvalue = resvalue;
+	step.resnull = resnull;
+
+	switch (nodeTag(node))
+	{
+		case T_Var:
+			if (((Var *) node)->varattno > 0)
+			{
+				compile_var(b, (Var *) node, &step);
+				return;
+			}
+			break;
+
+		case T_Const:
+			step.opcode = STEP_CONST;
+			step.d.constval.value = ((Const *) node)->constvalue;
+			step.d.constval.isnull = ((Const *) node)->constisnull;
+			steps_push(b, &step);
+			return;
+
+		case T_FuncExpr:
+			if (!((FuncExpr *) node)->funcretset &&
+				list_length(((FuncExprState *) state)->args) <= FUNC_MAX_ARGS)
+			{
+				FuncExpr   *func = (FuncExpr *) node;
+
+				compile_func(b, (FuncExprState *) state, func->funcid,
+							 func->inputcollid, &step);
+				return;
+			}
+			break;
+
+		case T_OpExpr:
+			if (!((OpExpr *) node)->opretset)
+			{
+				OpExpr	   *op = (OpExpr *) node;
+
+				compile_func(b, (FuncExprState *) state, op->opfuncid,
+							 op->inputcollid, &step);
+				return;
+			}
+			break;
+
+		case T_BoolExpr:
+			if (((BoolExpr *) node)->boolop == NOT_EXPR ||
+				list_length(((BoolExprState *) state)->args) >= 2)
+			{
+				compile_bool(b, (BoolExprState *) state, &step);
+				return;
+			}
+			break;
+
+		case T_NullTest:
+			if (!((NullTest *) node)->argisrow)
+			{
+				compile_expr(b, ((NullTestState *) state)->arg, resvalue, resnull);
+				step.opcode = (((NullTest *) node)->nulltesttype == IS_NULL ?
+							   STEP_NULLTEST_ISNULL : STEP_NULLTEST_ISNOTNULL);
+				steps_push(b, &step);
+				return;
+			}
+			break;
+
+		case T_RelabelType:
+			compile_expr(b, ((GenericExprState *) state)->arg, resvalue, resnull);
+			return;
+
+		default:
+			break;
+	}
+
+	step.opcode = STEP_EVAL_EXPRSTATE;
+	step.d.eval.state = state;
+	steps_push(b, &step);
+}
+
+/*
+ * Is flattening the tree under state worth it?  Bare Vars and Consts are as
+ * fast as they get already.
+ */
+static bool
+steps_worthwhile(ExprState *state)
+{
+	switch (nodeTag(state->expr))
+	{
+		case T_FuncExpr:
+		case T_OpExpr:
+		case T_BoolExpr:
+		case T_NullTest:
+			break;
+		default:
+			return false;
+	}
+
+	/* Sets need the ordinary machinery */
+	return !expression_returns_set((Node *) state->expr);
+}
+
+/*
+ * ExecCompileExprSteps
+ *
+ * Flattens the tree under an ExprState fresh out of ExecInitExpr, if it is
+ * worth it, and switches it over to ExecEvalExprSteps.  Lists and target
+ * entries have each of their expressions flattened.
+ */
+void
+ExecCompileExprSteps(ExprState *state)
+{
+	StepsBuilder b;
+	ExprSteps  *prog;
+	ExprStep	step;
+	int			ndeform = 0;
+	int			slot;
+	int			i;
+
+	if (state == NULL)
+		return;
+
+	if (IsA(state, List))
+	{
+		ListCell   *lc;
+
+		foreach(lc, (List *) state)
+			ExecCompileExprSteps((ExprState *) lfirst(lc));
+		return;
+	}
+
+	if (IsA(state, GenericExprState) && IsA(state->expr, TargetEntry))
+	{
+		ExecCompileExprSteps(((GenericExprState *) state)->arg);
+		return;
+	}
+
+	if (!steps_worthwhile(state))
+		return;
+
+	prog = palloc0(sizeof(ExprSteps));
+
+	MemSet(&b, 0, sizeof(b));
+	b.maxsteps = 16;
+	b.steps = palloc(b.maxsteps * sizeof(ExprStep));
+
+	compile_expr(&b, state, &prog->resvalue, &prog->resnull);
+
+	/* The slots get deformed first, so make room for that */
+	for (slot = 0; slot < STEPS_NSLOTS; slot++)
+	{
+		if (b.last_attnum[slot] > 0)
+			ndeform++;
+	}
+
+	prog->nsteps = ndeform + b.nsteps + 1;
+	prog->steps = palloc0(prog->nsteps * sizeof(ExprStep));
+
+	i = 0;
+	for (slot = 0; slot < STEPS_NSLOTS; slot++)
+	{
+		ExprStep   *deform = &prog->steps[i];
+		ListCell   *lc1;
+		ListCell   *lc2;
+		int			n = 0;
+
+		if (b.last_attnum[slot] == 0)
+			continue;
+
+		deform->opcode = STEP_DEFORM_INNER + slot;
+		deform->d.deform.last_attnum = b.last_attnum[slot];
+		deform->d.deform.checked = false;
+		deform->d.deform.nvars = list_length(b.attnums[slot]);
+		deform->d.deform.attnums = palloc(deform->d.deform.nvars * sizeof(AttrNumber));
+		deform->d.deform.vartypes = palloc(deform->d.deform.nvars * sizeof(Oid));
+		forboth(lc1, b.attnums[slot], lc2, b.vartypes[slot])
+		{
+			deform->d.deform.attnums[n] = (AttrNumber) lfirst_int(lc1);
+			deform->d.deform.vartypes[n] = lfirst_oid(lc2);
+			n++;
+		}
+		list_free(b.attnums[slot]);
+		list_free(b.vartypes[slot]);
+		i++;
+	}
+
+	memcpy(prog->steps + ndeform, b.steps, b.nsteps * sizeof(ExprStep));
+	pfree(b.steps);
+
+	MemSet(&step, 0, sizeof(step));
+	step.opcode = STEP_DONE;
+	prog->steps[prog->nsteps - 1] = step;
+
+	for (i = ndeform; i < prog->nsteps; i++)
+	{
+		ExprStep   *op = &prog->steps[i];
+
+		switch ((ExprStepOp) op->opcode)
+		{
+			case STEP_BOOL_AND_FIRST:
+			case STEP_BOOL_AND:
+			case STEP_BOOL_AND_LAST:
+			case STEP_BOOL_OR_FIRST:
+			case STEP_BOOL_OR:
+			case STEP_BOOL_OR_LAST:
+				op->d.boolexpr.jumpdone += ndeform;
+				break;
+			default:
+				break;
+		}
+	}
+
+#ifdef STEPS_USE_COMPUTED_GOTO
+	{
+		const void *const *dispatch_table;
+
+		dispatch_table = (const void *const *)
+			DatumGetPointer(ExecEvalExprSteps(NULL, NULL, NULL, NULL));
+		for (i = 0; i < prog->nsteps; i++)
+			prog->steps[i].opcode = (intptr_t) dispatch_table[prog->steps[i].opcode];
+	}
+#endif
+
+	state->steps = prog;
+	state->evalfunc = ExecEvalExprSteps;
+}
+
+/*
+ * Checks the types of the Vars against the slot, once, like
+ * ExecEvalScalarVar does.
+ */
+static void
+steps_check_vars(ExprStep *op, TupleTableSlot *slot)
+{
+	TupleDesc	tupdesc = slot->tts_tupleDescriptor;
+	int			i;
+
+	for (i = 0; i < op->d.deform.nvars; i++)
+	{
+		AttrNumber	attnum = op->d.deform.attnums[i];
+		Form_pg_attribute attr;
+
+		if (attnum > tupdesc->natts)	/* should never happen */
+			elog(ERROR, "attribute number %d exceeds number of columns %d",
+				 attnum, tupdesc->natts);
+
+		attr = tupdesc->attrs[attnum - 1];
+
+		/* can't check type if dropped, since atttypid is probably 0 */
+		if (!attr->attisdropped && op->d.deform.vartypes[i] != attr->atttypid)
+			ereport(ERROR,
+					(errmsg("attribute %d has wrong type", attnum),
+					 errdetail("Table has type %s, but query expects %s.",
+							   format_type_be(attr->atttypid),
+							   format_type_be(op->d.deform.vartypes[i]))));
+	}
+
+	op->d.deform.checked = true;
+}
+
+static void
+steps_deform(ExprStep *op, TupleTableSlot *slot)
+{
+	/* The slot may well be empty if the Vars are never reached */
+	if (TupIsNull(slot))
+		return;
+
+	if (!op->d.deform.checked)
+		steps_check_vars(op, slot);
+
+	slot_getsomeattrs(slot, op->d.deform.last_attnum);
+}
+
+/*
+ * Looks up the function of a STEP_FUNC_INIT step, like init_fcache, and
+ * returns the step it turns into.
+ */
+static ExprStepOp
+steps_init_func(ExprStep *op, ExprContext *econtext)
+{
+	FmgrInfo   *finfo = op->d.func.finfo;
+	AclResult	aclresult;
+	int			i;
+
+	/* Check permission to call function */
+	aclresult = pg_proc_aclcheck(op->d.func.foid, GetUserId(), ACL_EXECUTE);
+	if (aclresult != ACLCHECK_OK)
+		aclcheck_error(aclresult, ACL_KIND_PROC, get_func_name(op->d.func.foid));
+
+	fmgr_info_cxt(op->d.func.foid, finfo, econtext->ecxt_per_query_memory);
+	fmgr_info_set_expr((Node *) op->d.func.expr, finfo);
+
+	/* Leaves the arguments alone, the steps before us store them there */
+	InitFunctionCallInfoData(*op->d.func.fcinfo, finfo, op->d.func.nargs,
+							 op->d.func.inputcollid, NULL, NULL);
+
+	if (finfo->fn_retset)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (pgstat_track_functions > finfo->fn_stats)
+		return STEP_FUNC_FUSAGE;
+
+	if (!finfo->fn_strict)
+		return STEP_FUNC;
+
+	if (op->d.func.nargs == 2)
+	{
+		for (i = 0; i < lengthof(steps_cmp_funcs); i++)
+		{
+			if (steps_cmp_funcs[i].foid == op->d.func.foid)
+				return steps_cmp_funcs[i].op;
+		}
+	}
+
+	return STEP_FUNC_STRICT;
+}
+
+/* Like float4_cmp_internal and float8_cmp_internal: NaN sorts above all */
+static inline int
+steps_float_cmp(double a, double b)
+{
+	if (isnan(a))
+		return isnan(b) ? 0 : 1;
+	if (isnan(b))
+		return -1;
+	return (a > b) ? 1 : ((a < b) ? -1 : 0);
+}
+
+#ifdef STEPS_USE_COMPUTED_GOTO
+#define STEP_SWITCH()
+#define STEP_CASE(name)		CASE_##name:
+#define STEP_DISPATCH()		goto *((void *) op->opcode)
+#define STEP_OPCODE(o)		((intptr_t) dispatch_table[o])
+#else
+#define STEP_SWITCH()		starteval: switch ((ExprStepOp) op->opcode)
+#define STEP_CASE(name)		case name:
+#define STEP_DISPATCH()		goto starteval
+#define STEP_OPCODE(o)		((intptr_t) (o))
+#endif
+
+#define STEP_NEXT() \
+	do { \
+		op++; \
+		STEP_DISPATCH(); \
+	} while (0)
+
+#define STEP_JUMP(stepno) \
+	do { \
+		op = &prog->steps[stepno]; \
+		STEP_DISPATCH(); \
+	} while (0)
+
+/* A strict comparison of the two arguments, which must not be NULL */
+#define STEP_CMP(name, getter, oper) \
+	STEP_CASE(name) \
+	{ \
+		FunctionCallInfo fcinfo = op->d.func.fcinfo; \
+		\
+		if (fcinfo->argnull[0] || fcinfo->argnull[1]) \
+		{ \
+			*op->resvalue = (Datum) 0; \
+			*op->resnull = true; \
+		} \
+		else \
+		{ \
+			*op->resvalue = BoolGetDatum(getter(fcinfo->arg[0]) oper getter(fcinfo->arg[1])); \
+			*op->resnull = false; \
+		} \
+		STEP_NEXT(); \
+	}
+
+#define STEP_CMP_FLOAT(name, getter, oper) \
+	STEP_CASE(name) \
+	{ \
+		FunctionCallInfo fcinfo = op->d.func.fcinfo; \
+		\
+		if (fcinfo->argnull[0] || fcinfo->argnull[1]) \
+		{ \
+			*op->resvalue = (Datum) 0; \
+			*op->resnull = true; \
+		} \
+		else \
+		{ \
+			*op->resvalue = BoolGetDatum(steps_float_cmp(getter(fcinfo->arg[0]), \
+														 getter(fcinfo->arg[1])) oper 0); \
+			*op->resnull = false; \
+		} \
+		STEP_NEXT(); \
+	}
+
+/*
+ * ExecEvalExprSteps
+ *
+ * Evaluates an ExprState flattened by ExecCompileExprSteps.  Called with a
+ * NULL state, returns the dispatch table of the steps instead.
+ */
+Datum
+ExecEvalExprSteps(ExprState *state, ExprContext *econtext,
+				  bool *isNull, ExprDoneCond *isDone)
+{
+	ExprSteps  *prog;
+	ExprStep   *op;
+
+#ifdef STEPS_USE_COMPUTED_GOTO
+	static const void *const dispatch_table[] = {
+		&&CASE_STEP_DONE,
+		&&CASE_STEP_DEFORM_INNER,
+		&&CASE_STEP_DEFORM_OUTER,
+		&&CASE_STEP_DEFORM_SCAN,
+		&&CASE_STEP_INNER_VAR,
+		&&CASE_STEP_OUTER_VAR,
+		&&CASE_STEP_SCAN_VAR,
+		&&CASE_STEP_CONST,
+		&&CASE_STEP_FUNC_INIT,
+		&&CASE_STEP_FUNC,
+		&&CASE_STEP_FUNC_STRICT,
+		&&CASE_STEP_FUNC_FUSAGE,
+		&&CASE_STEP_BOOL_AND_FIRST,
+		&&CASE_STEP_BOOL_AND,
+		&&CASE_STEP_BOOL_AND_LAST,
+		&&CASE_STEP_BOOL_OR_FIRST,
+		&&CASE_STEP_BOOL_OR,
+		&&CASE_STEP_BOOL_OR_LAST,
+		&&CASE_STEP_BOOL_NOT,
+		&&CASE_STEP_NULLTEST_ISNULL,
+		&&CASE_STEP_NULLTEST_ISNOTNULL,
+		&&CASE_STEP_EVAL_EXPRSTATE,
+		&&CASE_STEP_INT2_EQ, &&CASE_STEP_INT2_NE, &&CASE_STEP_INT2_LT,
+		&&CASE_STEP_INT2_LE, &&CASE_STEP_INT2_GT, &&CASE_STEP_INT2_GE,
+		&&CASE_STEP_INT4_EQ, &&CASE_STEP_INT4_NE, &&CASE_STEP_INT4_LT,
+		&&CASE_STEP_INT4_LE, &&CASE_STEP_INT4_GT, &&CASE_STEP_INT4_GE,
+		&&CASE_STEP_INT8_EQ, &&CASE_STEP_INT8_NE, &&CASE_STEP_INT8_LT,
+		&&CASE_STEP_INT8_LE, &&CASE_STEP_INT8_GT, &&CASE_STEP_INT8_GE,
+		&&CASE_STEP_FLOAT4_EQ, &&CASE_STEP_FLOAT4_NE, &&CASE_STEP_FLOAT4_LT,
+		&&CASE_STEP_FLOAT4_LE, &&CASE_STEP_FLOAT4_GT, &&CASE_STEP_FLOAT4_GE,
+		&&CASE_STEP_FLOAT8_EQ, &&CASE_STEP_FLOAT8_NE, &&CASE_STEP_FLOAT8_LT,
+		&&CASE_STEP_FLOAT8_LE, &&CASE_STEP_FLOAT8_GT, &&CASE_STEP_FLOAT8_GE,
+	};
+
+	if (state == NULL)
+	{
+		Assert(lengthof(dispatch_table) == STEP_LAST);
+		return PointerGetDatum(dispatch_table);
+	}
+#endif
+
+	if (isDone)
+		*isDone = ExprSingleResult;
+
+	prog = state->steps;
+	op = prog->steps;
+
+	STEP_DISPATCH();
+
+	STEP_SWITCH()
+	{
+		STEP_CASE(STEP_DONE)
+		{
+			goto out;
+		}
+
+		STEP_CASE(STEP_DEFORM_INNER)
+		{
+			steps_deform(op, econtext->ecxt_innertuple);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_DEFORM_OUTER)
+		{
+			steps_deform(op, econtext->ecxt_outertuple);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_DEFORM_SCAN)
+		{
+			steps_deform(op, econtext->ecxt_scantuple);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_INNER_VAR)
+		{
+			*op->resvalue = slot_getattr(econtext->ecxt_innertuple,
+										 op->d.var.attnum, op->resnull);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_OUTER_VAR)
+		{
+			*op->resvalue = slot_getattr(econtext->ecxt_outertuple,
+										 op->d.var.attnum, op->resnull);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_SCAN_VAR)
+		{
+			*op->resvalue = slot_getattr(econtext->ecxt_scantuple,
+										 op->d.var.attnum, op->resnull);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_CONST)
+		{
+			*op->resvalue = op->d.constval.value;
+			*op->resnull = op->d.constval.isnull;
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_FUNC_INIT)
+		{
+			op->opcode = STEP_OPCODE(steps_init_func(op, econtext));
+			STEP_DISPATCH();
+		}
+
+		STEP_CASE(STEP_FUNC)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo;
+
+			fcinfo->isnull = false;
+			*op->resvalue = FunctionCallInvoke(fcinfo);
+			*op->resnull = fcinfo->isnull;
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_FUNC_STRICT)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo;
+			int			i;
+
+			for (i = 0; i < op->d.func.nargs; i++)
+			{
+				if (fcinfo->argnull[i])
+				{
+					*op->resvalue = (Datum) 0;
+					*op->resnull = true;
+					STEP_NEXT();
+				}
+			}
+			fcinfo->isnull = false;
+			*op->resvalue = FunctionCallInvoke(fcinfo);
+			*op->resnull = fcinfo->isnull;
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_FUNC_FUSAGE)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo;
+			PgStat_FunctionCallUsage fcusage;
+			int			i;
+
+			if (op->d.func.finfo->fn_strict)
+			{
+				for (i = 0; i < op->d.func.nargs; i++)
+				{
+					if (fcinfo->argnull[i])
+					{
+						*op->resvalue = (Datum) 0;
+						*op->resnull = true;
+						STEP_NEXT();
+					}
+				}
+			}
+
+			pgstat_init_function_usage(fcinfo, &fcusage);
+
+			fcinfo->isnull = false;
+			*op->resvalue = FunctionCallInvoke(fcinfo);
+			*op->resnull = fcinfo->isnull;
+
+			pgstat_end_function_usage(&fcusage, true);
+			STEP_NEXT();
+		}
+
+		/*
+		 * AND: stop at the first FALSE argument.  Otherwise the result is
+		 * NULL if any argument was NULL, else TRUE.  OR likewise.
+		 */
+		STEP_CASE(STEP_BOOL_AND_FIRST)
+		{
+			*op->d.boolexpr.anynull = false;
+			if (*op->resnull)
+				*op->d.boolexpr.anynull = true;
+			else if (!DatumGetBool(*op->resvalue))
+				STEP_JUMP(op->d.boolexpr.jumpdone);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_BOOL_AND)
+		{
+			if (*op->resnull)
+				*op->d.boolexpr.anynull = true;
+			else if (!DatumGetBool(*op->resvalue))
+				STEP_JUMP(op->d.boolexpr.jumpdone);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_BOOL_AND_LAST)
+		{
+			if (*op->resnull)
+				;
+			else if (!DatumGetBool(*op->resvalue))
+				;
+			else if (*op->d.boolexpr.anynull)
+			{
+				*op->resvalue = (Datum) 0;
+				*op->resnull = true;
+			}
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_BOOL_OR_FIRST)
+		{
+			*op->d.boolexpr.anynull = false;
+			if (*op->resnull)
+				*op->d.boolexpr.anynull = true;
+			else if (DatumGetBool(*op->resvalue))
+				STEP_JUMP(op->d.boolexpr.jumpdone);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_BOOL_OR)
+		{
+			if (*op->resnull)
+				*op->d.boolexpr.anynull = true;
+			else if (DatumGetBool(*op->resvalue))
+				STEP_JUMP(op->d.boolexpr.jumpdone);
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_BOOL_OR_LAST)
+		{
+			if (*op->resnull)
+				;
+			else if (DatumGetBool(*op->resvalue))
+				;
+			else if (*op->d.boolexpr.anynull)
+			{
+				*op->resvalue = (Datum) 0;
+				*op->resnull = true;
+			}
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_BOOL_NOT)
+		{
+			/* NOT NULL is NULL, the value doesn't matter then */
+			*op->resvalue = BoolGetDatum(!DatumGetBool(*op->resvalue));
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_NULLTEST_ISNULL)
+		{
+			*op->resvalue = BoolGetDatum(*op->resnull);
+			*op->resnull = false;
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_NULLTEST_ISNOTNULL)
+		{
+			*op->resvalue = BoolGetDatum(!*op->resnull);
+			*op->resnull = false;
+			STEP_NEXT();
+		}
+
+		STEP_CASE(STEP_EVAL_EXPRSTATE)
+		{
+			*op->resvalue = ExecEvalExpr(op->d.eval.state, econtext,
+										 op->resnull, NULL);
+			STEP_NEXT();
+		}
+
+		STEP_CMP(STEP_INT2_EQ, DatumGetInt16, ==)
+		STEP_CMP(STEP_INT2_NE, DatumGetInt16, !=)
+		STEP_CMP(STEP_INT2_LT, DatumGetInt16, <)
+		STEP_CMP(STEP_INT2_LE, DatumGetInt16, <=)
+		STEP_CMP(STEP_INT2_GT, DatumGetInt16, >)
+		STEP_CMP(STEP_INT2_GE, DatumGetInt16, >=)
+
+		STEP_CMP(STEP_INT4_EQ, DatumGetInt32, ==)
+		STEP_CMP(STEP_INT4_NE, DatumGetInt32, !=)
+		STEP_CMP(STEP_INT4_LT, DatumGetInt32, <)
+		STEP_CMP(STEP_INT4_LE, DatumGetInt32, <=)
+		STEP_CMP(STEP_INT4_GT, DatumGetInt32, >)
+		STEP_CMP(STEP_INT4_GE, DatumGetInt32, >=)
+
+		STEP_CMP(STEP_INT8_EQ, DatumGetInt64, ==)
+		STEP_CMP(STEP_INT8_NE, DatumGetInt64, !=)
+		STEP_CMP(STEP_INT8_LT, DatumGetInt64, <)
+		STEP_CMP(STEP_INT8_LE, DatumGetInt64, <=)
+		STEP_CMP(STEP_INT8_GT, DatumGetInt64, >)
+		STEP_CMP(STEP_INT8_GE, DatumGetInt64, >=)
+
+		STEP_CMP_FLOAT(STEP_FLOAT4_EQ, DatumGetFloat4, ==)
+		STEP_CMP_FLOAT(STEP_FLOAT4_NE, DatumGetFloat4, !=)
+		STEP_CMP_FLOAT(STEP_FLOAT4_LT, DatumGetFloat4, <)
+		STEP_CMP_FLOAT(STEP_FLOAT4_LE, DatumGetFloat4, <=)
+		STEP_CMP_FLOAT(STEP_FLOAT4_GT, DatumGetFloat4, >)
+		STEP_CMP_FLOAT(STEP_FLOAT4_GE, DatumGetFloat4, >=)
+
+		STEP_CMP_FLOAT(STEP_FLOAT8_EQ, DatumGetFloat8, ==)
+		STEP_CMP_FLOAT(STEP_FLOAT8_NE, DatumGetFloat8, !=)
+		STEP_CMP_FLOAT(STEP_FLOAT8_LT, DatumGetFloat8, <)
+		STEP_CMP_FLOAT(STEP_FLOAT8_LE, DatumGetFloat8, <=)
+		STEP_CMP_FLOAT(STEP_FLOAT8_GT, DatumGetFloat8, >)
+		STEP_CMP_FLOAT(STEP_FLOAT8_GE, DatumGetFloat8, >=)
+
+#ifndef STEPS_USE_COMPUTED_GOTO
+		case STEP_LAST:
+			break;
+#endif
+	}
+
+	elog(ERROR, "unrecognized expression step");
+
+out:
+	*isNull = prog->resnull;
+	return prog->resvalue;
+}
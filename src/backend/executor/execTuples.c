@@ -139,6 +139,12 @@ static void cleanup_slot(TupleTableSlot *slot)
 		slot->tts_mt_bind = NULL;
 	}
 
+	if (slot->tts_heap_deform)
+	{
+		destroy_heaptuple_deform(slot->tts_heap_deform);
+		slot->tts_heap_deform = NULL;
+	}
+
 	if (slot->tts_tupleDescriptor)
 		ReleaseTupleDesc(slot->tts_tupleDescriptor);
 
@@ -303,6 +309,7 @@ ExecSetSlotDescriptor(TupleTableSlot *slot,		/* slot to change */
 		MemoryContext oldcontext = MemoryContextSwitchTo(slot->tts_mcxt);
 
 		slot->tts_mt_bind = create_memtuple_binding(tupdesc);
+		slot->tts_heap_deform = create_heaptuple_deform(tupdesc);
 		slot->PRIVATE_tts_values = (Datum *) palloc(tupdesc->natts * sizeof(Datum));
 		slot->PRIVATE_tts_isnull = (bool *) palloc(tupdesc->natts * sizeof(bool));
 
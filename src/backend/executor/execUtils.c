@@ -64,6 +64,7 @@
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
 #include "cdb/cdbdisp_query.h"
+#include "cdb/cdbgang.h"
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/ml_ipc.h"
 #include "cdb/cdbmotion.h"
@@ -1898,18 +1899,19 @@ AssignGangs(CdbDispatcherState *ds, QueryDesc *queryDesc)
 	if (inv.numNgangs > 0)
 	{
 		inv.vecNgangs = (Gang **) palloc(sizeof(Gang *) * inv.numNgangs);
-		for (i = 0; i < inv.numNgangs; i++)
+		i = 0;
+		if (!queryDesc->extended_query)
 		{
-			if (i == 0 && !queryDesc->extended_query)
-			{
-				inv.vecNgangs[i] = AllocateWriterGang(ds);
-				Assert(inv.vecNgangs[i] != NULL);
-			}
-			else
-			{
-				inv.vecNgangs[i] = AllocateReaderGang(ds, GANGTYPE_PRIMARY_READER, queryDesc->portal_name);
-			}
+			inv.vecNgangs[i] = AllocateWriterGang(ds);
+			Assert(inv.vecNgangs[i] != NULL);
+			i++;
 		}
+
+		/* Create the reader gangs we don't have yet all at once */
+		CreateMissingReaderGangs(inv.numNgangs - i);
+
+		for (; i < inv.numNgangs; i++)
+			inv.vecNgangs[i] = AllocateReaderGang(ds, GANGTYPE_PRIMARY_READER, queryDesc->portal_name);
 	}
 	if (inv.num1gangs_primary_reader > 0)
 	{
@@ -2457,17 +2459,107 @@ uint64 PlanStateOperatorMemKB(const PlanState *ps)
 	}
 	else
 	{
-		if (IsA(ps, AggState))
+		if (IsA(ps, AggState) && !gp_enable_memory_broker)
 		{
 			result = ps->plan->operatorMemKB + MemoryAccounting_RequestQuotaIncrease();
 		}
 		else
 			result = ps->plan->operatorMemKB;
+
+		/*
+		 * Don't count on memory still lent to other operators, down to the
+		 * minimum work_mem.
+		 */
+		if (ps->operatorMemLent > 0)
+			result = Max(result - Min(result, ps->operatorMemLent / 1024), 64);
 	}
 	
 	return result;
 }
 
+/*
+ * ExecRequestOperatorMem
+ *
+ * The memory broker. Hash, HashAgg, Sort and Material ask for more memory
+ * here before they spill, and get up to 'wanted' bytes out of what other
+ * operators of the query have given back with ExecReleaseOperatorMem (or
+ * MemoryAccounting_DeclareDone). The caller adds whatever it gets to its own
+ * limit. Returns 0 unless gp_enable_memory_broker is set.
+ */
+uint64
+ExecRequestOperatorMem(PlanState *ps, uint64 wanted)
+{
+	uint64		granted = 0;
+
+	Assert(ps);
+	Assert(ps->plan);
+
+	if (!gp_enable_memory_broker || ps->plan->operatorMemKB == 0 || wanted == 0)
+		return 0;
+
+	START_MEMORY_ACCOUNT(ps->plan->memoryAccountId);
+	{
+		granted = MemoryAccounting_RequestQuota(wanted);
+	}
+	END_MEMORY_ACCOUNT();
+
+	if (granted > 0 && ps->instrument)
+		ps->instrument->workmemgranted += granted;
+
+	return granted;
+}
+
+/*
+ * ExecReleaseOperatorMem
+ *
+ * Called when an operator is done with a phase of its work, e.g. the build
+ * side of a hash join has been loaded, or a sort has returned its last row.
+ * Gives the part of its quota that it isn't holding on to back to the
+ * memory broker, for operators that run later. An operator that may be
+ * rescanned must take the memory back with ExecReclaimOperatorMem first.
+ */
+void
+ExecReleaseOperatorMem(PlanState *ps)
+{
+	uint64		released = 0;
+
+	Assert(ps);
+	Assert(ps->plan);
+
+	START_MEMORY_ACCOUNT(ps->plan->memoryAccountId);
+	{
+		released = MemoryAccounting_DeclareDone();
+	}
+	END_MEMORY_ACCOUNT();
+
+	if (released > 0 && ps->instrument)
+		ps->instrument->workmemreleased += released;
+}
+
+/*
+ * ExecReclaimOperatorMem
+ *
+ * Called when an operator that gave memory back to the broker is rescanned.
+ * Takes back what is still in the pool. Whatever other operators have
+ * borrowed meanwhile is taken off the operator's own memory for this scan,
+ * so that the query doesn't use more than it was given.
+ */
+void
+ExecReclaimOperatorMem(PlanState *ps)
+{
+	Assert(ps);
+	Assert(ps->plan);
+
+	if (!gp_enable_memory_broker || ps->plan->operatorMemKB == 0)
+		return;
+
+	START_MEMORY_ACCOUNT(ps->plan->memoryAccountId);
+	{
+		ps->operatorMemLent = MemoryAccounting_ReclaimQuota();
+	}
+	END_MEMORY_ACCOUNT();
+}
+
 /**
  * Methods to find motionstate object within a planstate tree given a motion id (which is the same as slice index)
  */
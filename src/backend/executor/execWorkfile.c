@@ -452,6 +452,9 @@ ExecWorkFile_Close(ExecWorkFile *workfile)
 				ExecWorkFile_AdjustBFZSize(workfile, file_size);
 			}
 
+			if (workfile->work_set != NULL)
+				INSTR_TIME_ADD(workfile->work_set->io_wait_time, bfz_file->io_wait);
+
 			bfz_close(bfz_file);
 			break;
 		default:
@@ -140,6 +140,7 @@
 #include "utils/memutils.h"
 #include "utils/syscache.h"
 #include "utils/tuplesort.h"
+#include "utils/workfile_mgr.h"
 #include "utils/datum.h"
 
 #include "cdb/cdbexplain.h"
@@ -190,6 +191,7 @@ static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void clear_agg_object(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_bypass(AggState *aggstate);
 static void ExecAggExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 
 
@@ -1116,6 +1118,16 @@ ExecAgg(AggState *node)
 	if (node->agg_done)
 		return NULL;
 
+	/* Read the output of an earlier query, if we have it */
+	if (node->workfile_reuse && workfile_reuse_start(node->workfile_reuse))
+	{
+		TupleTableSlot *slot = workfile_reuse_next(node->workfile_reuse);
+
+		if (slot == NULL)
+			node->agg_done = true;
+		return slot;
+	}
+
 	/* Dispatch based on strategy */
 	if (((Agg *) node->ss.ps.plan)->aggstrategy == AGG_HASHED)
 	{
@@ -1157,13 +1169,17 @@ ExecAgg(AggState *node)
 		 */
 		for (;;)
 		{
-			if (!node->hhashtable->is_spilling)
+			if (!node->hhashtable->is_spilling &&
+				node->hashaggstatus != HASHAGG_BYPASS)
 			{
 				tuple = agg_retrieve_hash_table(node);
 				node->agg_done = false; /* Not done 'til batches used up. */
 
 				if (tuple != NULL)
+				{
+					workfile_reuse_put(node->workfile_reuse, tuple);
 					return tuple;
+				}
 			}
 
 			switch (node->hashaggstatus)
@@ -1183,20 +1199,43 @@ ExecAgg(AggState *node)
 
 				case HASHAGG_END_OF_PASSES:
 					node->agg_done = true;
+					workfile_reuse_finish(node->workfile_reuse,
+										  node->hhashtable->num_overflows > 0);
 					/* Append stats before destroying the htable for EXPLAIN ANALYZE */
 					if (node->ss.ps.instrument && (node->ss.ps.instrument)->need_cdb)
 					{
 						agg_hash_explain(node);
 					}
 					ExecEagerFreeAgg(node);
+
+					/* Let operators that run after us have the memory. */
+					if (gp_enable_memory_broker)
+						ExecReleaseOperatorMem(&node->ss.ps);
 					return NULL;
 
 				case HASHAGG_STREAMING:
 					Assert(streaming);
+					if (node->hhashtable->bypass)
+					{
+						agg_hash_start_bypass(node);
+						node->hashaggstatus = HASHAGG_BYPASS;
+						continue;
+					}
 					if (!agg_hash_stream(node))
 						node->hashaggstatus = HASHAGG_END_OF_PASSES;
 					continue;
 
+				case HASHAGG_BYPASS:
+					Assert(streaming);
+					tuple = agg_retrieve_bypass(node);
+					if (tuple != NULL)
+					{
+						workfile_reuse_put(node->workfile_reuse, tuple);
+						return tuple;
+					}
+					node->hashaggstatus = HASHAGG_END_OF_PASSES;
+					continue;
+
 				case HASHAGG_BEFORE_FIRST_PASS:
 				default:
 					elog(ERROR, "hybrid hash aggregation sequencing error");
@@ -1807,6 +1846,51 @@ agg_retrieve_hash_table(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * ExecAgg for a hashed streaming agg that stopped aggregating: every
+ * remaining input tuple makes a group of its own.
+ */
+static TupleTableSlot *
+agg_retrieve_bypass(AggState *aggstate)
+{
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	Datum	   *aggvalues = econtext->ecxt_aggvalues;
+	bool	   *aggnulls = econtext->ecxt_aggnulls;
+	AggStatePerAgg peragg = aggstate->peragg;
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+
+	Assert(!node->inputHasGrouping);
+
+	for (;;)
+	{
+		TupleTableSlot *outerslot;
+		AggStatePerGroup pergroup;
+		int			aggno;
+
+		pergroup = agg_hash_bypass_next(aggstate, &outerslot);
+		if (pergroup == NULL)
+			return NULL;
+
+		ResetExprContext(econtext);
+
+		for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+		{
+			Assert(peragg[aggno].numSortCols == 0);
+			finalize_aggregate(aggstate, &peragg[aggno], &pergroup[aggno],
+							   &aggvalues[aggno], &aggnulls[aggno]);
+		}
+
+		econtext->ecxt_outertuple = outerslot;
+		econtext->group_id = node->rollupGSTimes;
+		econtext->grouping = node->grouping;
+
+		if (ExecQual(aggstate->ss.ps.qual, econtext, false))
+			return ExecProject(aggstate->ss.ps.ps_ProjInfo, NULL);
+		else
+			InstrCountFiltered1(aggstate, 1);
+	}
+}
+
 /* -----------------
  * ExecInitAgg
  *
@@ -1976,6 +2060,10 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	if (node->aggstrategy == AGG_HASHED)
 	{
 		aggstate->hash_needed = find_hash_columns(aggstate);
+
+		/* The hash table's output may be kept for later queries */
+		if ((eflags & EXEC_FLAG_EXPLAIN_ONLY) == 0)
+			aggstate->workfile_reuse = workfile_reuse_create(&aggstate->ss.ps);
 	}
 	else
 	{
@@ -2493,6 +2581,9 @@ ExecEndAgg(AggState *node)
 
 	MemoryContextDelete(node->aggcontext);
 
+	workfile_reuse_end(node->workfile_reuse);
+	node->workfile_reuse = NULL;
+
 	outerPlan = outerPlanState(node);
 	ExecEndNode(outerPlan);
 
@@ -2506,6 +2597,11 @@ ExecReScanAgg(AggState *node)
 
 	ExecEagerFreeAgg(node);
 
+	/* Take back the memory we gave to the broker, if we can */
+	ExecReclaimOperatorMem(&node->ss.ps);
+
+	workfile_reuse_rescan(node->workfile_reuse);
+
 	/*
 	 * Release all temp storage. Note that with AGG_HASHED, the hash table is
 	 * allocated in a sub-context of the aggcontext. We're going to rebuild
@@ -44,6 +44,7 @@
 #include "cdb/cdbvars.h"
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
+static bool ExecHashGrowSpaceAllowed(HashState *hashState, HashJoinTable hashtable);
 static void ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node,
 					  int mcvsToUse);
 static void ExecHashSkewTableInsert(HashState *hashState, HashJoinTable hashtable,
@@ -155,7 +156,11 @@ MultiExecHash(HashState *node)
 			}
 		}
 	}
-	MemoryAccounting_DeclareDone();
+	/* The build phase is over; give unused memory back to the broker. */
+	if (gp_enable_memory_broker)
+		ExecReleaseOperatorMem(&node->ps);
+	else
+		MemoryAccounting_DeclareDone();
 
 	/* Now we have set up all the initial batches & primary overflow batches. */
 	hashtable->nbatch_outstart = hashtable->nbatch;
@@ -674,6 +679,9 @@ ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable)
 
 	if (hashtable->work_set != NULL)
 	{
+		if (hashtable->stats)
+			INSTR_TIME_ADD(hashtable->stats->spill_io_wait,
+						   hashtable->work_set->io_wait_time);
 		workfile_mgr_close_set(hashtable->work_set);
 		hashtable->work_set = NULL;
 	}
@@ -684,6 +692,23 @@ ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable)
 	END_MEMORY_ACCOUNT();
 }
 
+/*
+ * ExecHashGrowSpaceAllowed
+ *		ask the memory broker for more memory when the current batch doesn't
+ *		fit, and return true if it fits now.  Doubling spaceAllowed keeps the
+ *		number of requests down, but anything granted helps.
+ */
+static bool
+ExecHashGrowSpaceAllowed(HashState *hashState, HashJoinTable hashtable)
+{
+	uint64		granted;
+
+	granted = ExecRequestOperatorMem(&hashState->ps, hashtable->spaceAllowed);
+	hashtable->spaceAllowed += granted;
+
+	return hashtable->spaceUsed <= hashtable->spaceAllowed;
+}
+
 /*
  * ExecHashIncreaseNumBatches
  *		increase the original number of batches in order to reduce
@@ -919,7 +944,8 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 		hashtable->spaceUsed += hashTupleSize;
 		if (hashtable->spaceUsed > hashtable->spacePeak)
 			hashtable->spacePeak = hashtable->spaceUsed;
-		if (hashtable->spaceUsed > hashtable->spaceAllowed)
+		if (hashtable->spaceUsed > hashtable->spaceAllowed &&
+			!ExecHashGrowSpaceAllowed(hashState, hashtable))
 		{
 			ExecHashIncreaseNumBatches(hashtable);
 
@@ -1384,6 +1410,7 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
     HashJoinTable       hashtable = hjstate->hj_HashTable;
     HashJoinTableStats *stats;
     Instrumentation    *jinstrument = hjstate->js.ps.instrument;
+    instr_time          spill_io_wait;
     int                 total_buckets;
     int                 i;
 
@@ -1474,6 +1501,15 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
 				"Secondary Overflow");
     }
 
+	/* Time spent waiting for the workfile helper thread, if any. */
+	spill_io_wait = stats->spill_io_wait;
+	if (hashtable->work_set != NULL)
+		INSTR_TIME_ADD(spill_io_wait, hashtable->work_set->io_wait_time);
+	if (!INSTR_TIME_IS_ZERO(spill_io_wait))
+		appendStringInfo(buf,
+						 "Waited %.3f ms for workfile I/O.\n",
+						 INSTR_TIME_GET_MILLISEC(spill_io_wait));
+
     /* Report hash chain statistics. */
     total_buckets = stats->nonemptybatches * hashtable->nbuckets;
     if (total_buckets > 0)
@@ -1954,7 +1990,8 @@ ExecHashSkewTableInsert(HashState *hashState,
 		ExecHashRemoveNextSkewBucket(hashState, hashtable);
 
 	/* Check we are not over the total spaceAllowed, either */
-	if (hashtable->spaceUsed > hashtable->spaceAllowed)
+	if (hashtable->spaceUsed > hashtable->spaceAllowed &&
+		!ExecHashGrowSpaceAllowed(hashState, hashtable))
 		ExecHashIncreaseNumBatches(hashtable);
 }
 
@@ -52,6 +52,7 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 						  uint32 *hashvalue,
 						  TupleTableSlot *tupleSlot);
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
+static void ExecHashJoinRewindOuterBatch(HashJoinTable hashtable, int curbatch);
 static bool isNotDistinctJoin(List *qualList);
 
 static void ReleaseHashTable(HashJoinState *node);
@@ -1036,15 +1037,35 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	if (curbatch >= nbatch)
 		return false;			/* no more batches */
 
+	/*
+	 * Rewind outer batch file (if present), so that we can start reading it.
+	 * With gp_workfile_async_io, this is done before reloading the inner
+	 * batch, so that the first outer block is read ahead while the hash
+	 * table is being built.  Reloading only ever moves inner tuples to later
+	 * batches, so the outer file of this batch isn't touched.
+	 */
+	if (gp_workfile_async_io)
+		ExecHashJoinRewindOuterBatch(hashtable, curbatch);
+
 	if (!ExecHashJoinReloadHashTable(hjstate))
 	{
 		/* We no longer continue as we couldn't load the batch */
 		return false;
 	}
 
-	/*
-	 * Rewind outer batch file (if present), so that we can start reading it.
-	 */
+	if (!gp_workfile_async_io)
+		ExecHashJoinRewindOuterBatch(hashtable, curbatch);
+
+	return true;
+}
+
+/*
+ * ExecHashJoinRewindOuterBatch
+ *		rewind the outer batch file of a batch, if it has one.
+ */
+static void
+ExecHashJoinRewindOuterBatch(HashJoinTable hashtable, int curbatch)
+{
 	if (hashtable->outerBatchFile[curbatch] != NULL)
 	{
 		if (!ExecWorkFile_Rewind(hashtable->outerBatchFile[curbatch]))
@@ -1052,8 +1073,6 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 					(errcode_for_file_access(),
 					 errmsg("could not access temporary file")));
 	}
-
-	return true;
 }
 
 /*
@@ -1237,6 +1256,9 @@ ExecReScanHashJoin(HashJoinState *node)
 			node->hj_HashTable = NULL;
 			node->hj_JoinState = HJ_BUILD_HASHTABLE;
 
+			/* Take back the memory the build gave to the broker, if we can */
+			ExecReclaimOperatorMem(innerPlanState(node));
+
 			/*
 			 * if chgParam of subnode is not null then plan will be re-scanned
 			 * by first ExecProcNode.
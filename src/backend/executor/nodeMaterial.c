@@ -27,6 +27,7 @@
 #include "executor/nodeMaterial.h"
 #include "executor/instrument.h"        /* Instrumentation */
 #include "utils/tuplestorenew.h"
+#include "utils/workfile_mgr.h"
 
 #include "miscadmin.h"
 
@@ -35,6 +36,7 @@
 static void ExecMaterialExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static void ExecChildRescan(MaterialState *node);
 static void DestroyTupleStore(MaterialState *node);
+static TupleTableSlot *ExecMaterialFetchOuter(MaterialState *node);
 
 
 /* ----------------------------------------------------------------
@@ -97,6 +99,13 @@ ExecMaterial(MaterialState *node)
 
 			ts = ntuplestore_create_readerwriter(rwfile_prefix, PlanStateOperatorMemKB((PlanState *)node) * 1024, true);
 			tsa = ntuplestore_create_accessor(ts, true);
+
+			/*
+			 * Stream the tuples to the readers through a shared-memory
+			 * channel if we can get one, rather than have them wait for the
+			 * whole workfile.
+			 */
+			node->share_lk_ctxt = shareinput_writer_openchannel(ma->share_id, ma->nsharer_xslice);
 		}
 		else
 		{
@@ -105,6 +114,9 @@ ExecMaterial(MaterialState *node)
 
 			ts = ntuplestore_create_workset(work_set, PlanStateOperatorMemKB((PlanState *) node) * 1024);
 			tsa = ntuplestore_create_accessor(ts, true /* isWriter */);
+
+			/* Borrow memory from the broker, if we may, before spilling */
+			ntuplestore_setplanstate(ts, &node->ss.ps);
 		}
 
 		Assert(ts && tsa);
@@ -136,7 +148,7 @@ ExecMaterial(MaterialState *node)
 		while (((Material *) node->ss.ps.plan)->cdb_strict
 				|| ma->share_type != SHARE_NOTSHARED)
 		{
-			TupleTableSlot *outerslot = ExecProcNode(outerPlanState(node));
+			TupleTableSlot *outerslot = ExecMaterialFetchOuter(node);
 
 			if (TupIsNull(outerslot))
 			{
@@ -146,7 +158,10 @@ ExecMaterial(MaterialState *node)
 				break;
 			}
 
-			ntuplestore_acc_put_tupleslot(tsa, outerslot);
+			/* Tuples that don't fit in the channel go to the workfile */
+			if (node->share_lk_ctxt == NULL ||
+				!shareinput_writer_puttuple(node->share_lk_ctxt, outerslot))
+				ntuplestore_acc_put_tupleslot(tsa, outerslot);
 		}
 
 		CheckSendPlanStateGpmonPkt(&node->ss.ps);
@@ -170,8 +185,11 @@ ExecMaterial(MaterialState *node)
 				{
 					ntuplestore_flush(ts);
 
-					node->share_lk_ctxt = shareinput_writer_notifyready(ma->share_id, ma->nsharer_xslice,
-							estate->es_plannedstmt->planGen);
+					if (node->share_lk_ctxt)
+						shareinput_writer_closechannel(node->share_lk_ctxt);
+					else
+						node->share_lk_ctxt = shareinput_writer_notifyready(ma->share_id, ma->nsharer_xslice,
+								estate->es_plannedstmt->planGen);
 				}
 			}
 			return NULL;
@@ -208,21 +226,23 @@ ExecMaterial(MaterialState *node)
 	 */
 	if (eof_tuplestore && !node->eof_underlying)
 	{
-		PlanState  *outerNode;
 		TupleTableSlot *outerslot;
 
 		/*
 		 * We can only get here with forward==true, so no need to worry about
 		 * which direction the subplan will go.
 		 */
-		outerNode = outerPlanState(node);
-		outerslot = ExecProcNode(outerNode);
+		outerslot = ExecMaterialFetchOuter(node);
 		if (TupIsNull(outerslot))
 		{
 			node->eof_underlying = true;
 			if (!node->ss.ps.delayEagerFree)
 			{
 				ExecEagerFreeMaterial(node);
+
+				/* Let operators that run after us have the memory. */
+				if (gp_enable_memory_broker)
+					ExecReleaseOperatorMem(&node->ss.ps);
 			}
 
 			return NULL;
@@ -241,6 +261,10 @@ ExecMaterial(MaterialState *node)
 	if (!node->ss.ps.delayEagerFree)
 	{
 		ExecEagerFreeMaterial(node);
+
+		/* Let operators that run after us have the memory. */
+		if (gp_enable_memory_broker)
+			ExecReleaseOperatorMem(&node->ss.ps);
 	}
 
 	/*
@@ -375,10 +399,42 @@ ExecInitMaterial(Material *node, EState *estate, int eflags)
 		snEntry->sharePlan = (Node *) node;
 		snEntry->shareState = (Node *) matstate;
 	}
+	else if ((eflags & EXEC_FLAG_EXPLAIN_ONLY) == 0)
+	{
+		/* The subplan's output may be kept for later queries */
+		matstate->workfile_reuse = workfile_reuse_create(&matstate->ss.ps);
+	}
 
 	return matstate;
 }
 
+/*
+ * ExecMaterialFetchOuter
+ *		Fetch the next tuple of the subplan.
+ *
+ * If an earlier query left the subplan's output behind, it is read from
+ * there instead of running the subplan.  Otherwise what the subplan
+ * returns is recorded, so that a later query can do the same.
+ */
+static TupleTableSlot *
+ExecMaterialFetchOuter(MaterialState *node)
+{
+	WorkfileReuse *wr = node->workfile_reuse;
+	TupleTableSlot *slot;
+
+	if (wr && workfile_reuse_start(wr))
+		return workfile_reuse_next(wr);
+
+	slot = ExecProcNode(outerPlanState(node));
+	if (TupIsNull(slot))
+		workfile_reuse_finish(wr, node->ts_state->matstore != NULL &&
+							  ntuplestore_spilled(node->ts_state->matstore));
+	else
+		workfile_reuse_put(wr, slot);
+
+	return slot;
+}
+
 /*
  * ExecMaterialExplainEnd
  *      Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
@@ -421,6 +477,9 @@ ExecEndMaterial(MaterialState *node)
 		DestroyTupleStore(node);
 	}
 
+	workfile_reuse_end(node->workfile_reuse);
+	node->workfile_reuse = NULL;
+
 	/*
 	 * shut down the subplan
 	 */
@@ -536,6 +595,7 @@ ExecChildRescan(MaterialState *node)
 	if (node->ss.ps.lefttree->chgParam == NULL)
 		ExecReScan(node->ss.ps.lefttree);
 
+	workfile_reuse_rescan(node->workfile_reuse);
 	node->eof_underlying = false;
 }
 
@@ -550,6 +610,9 @@ ExecReScanMaterial(MaterialState *node)
 {
 	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 
+	/* Take back the memory we gave to the broker, if we can */
+	ExecReclaimOperatorMem(&node->ss.ps);
+
 	if (node->eflags != 0)
 	{
 		/*
@@ -585,6 +648,7 @@ ExecReScanMaterial(MaterialState *node)
 			DestroyTupleStore(node);
 			if (node->ss.ps.lefttree->chgParam == NULL)
 				ExecReScan(node->ss.ps.lefttree);
+			workfile_reuse_rescan(node->workfile_reuse);
 		}
 		else
 		{
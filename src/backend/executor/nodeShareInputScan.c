@@ -31,11 +31,60 @@
 #include "executor/executor.h"
 #include "executor/nodeShareInputScan.h"
 #include "miscadmin.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/faultinjector.h"
 #include "utils/gp_alloc.h"
 #include "utils/tuplesort.h"
 #include "utils/tuplestorenew.h"
 
+/*
+ * Shared-memory channel of a cross-slice shared material.
+ *
+ * The writer copies the tuples into the buffer of the channel as it produces
+ * them, and the readers in other slices stream them from there, instead of
+ * waiting for the whole material to be written to the workfile.  Once the
+ * buffer is full, the rest of the tuples go to the workfile, which readers
+ * read after the buffer.  The writer signals its progress through the
+ * readers' latches, and readers signal they are done through the writer's.
+ *
+ * The key and refcount are protected by ShareInputChannelLock, the rest by
+ * the mutex.  Tuples are MemTuples at MAXALIGNed offsets of the buffer.
+ */
+#define SISC_CHANNEL_MAX_READERS	16
+
+/* The writer publishes its progress to readers every this many bytes */
+#define SISC_CHANNEL_PUBLISH_BYTES	BLCKSZ
+
+typedef struct ShareInputChannel
+{
+	int			session_id;		/* 0 if the channel is free */
+	int			command_count;
+	int			share_id;
+	int			refcount;
+
+	slock_t		mutex;
+	PGPROC	   *writer;
+	PGPROC	   *readers[SISC_CHANNEL_MAX_READERS];
+	int			nreaders;
+	int			nreaders_done;
+	Size		published;		/* bytes of the buffer readers may read */
+	bool		done;			/* writer has produced all tuples */
+	bool		spilled;		/* the rest of the tuples are in the workfile */
+	bool		aborted;		/* writer went away before it was done */
+} ShareInputChannel;
+
+typedef struct ShareInputChannelCtl
+{
+	int			nchannels;
+	Size		bufsize;
+	ShareInputChannel channels[1];	/* VARIABLE LENGTH ARRAY */
+} ShareInputChannelCtl;
+
+static ShareInputChannelCtl *shareInputChannels = NULL;
+
 typedef struct ShareInput_Lk_Context
 {
 	int readyfd;
@@ -45,9 +94,44 @@ typedef struct ShareInput_Lk_Context
 	bool del_done;
 	char lkname_ready[MAXPGPATH];
 	char lkname_done[MAXPGPATH];
+
+	/* Channel, if the writer got one */
+	volatile ShareInputChannel *channel;
+	int share_id;
+	bool is_writer;
+	bool counted;		/* a reader the writer waits for */
+	Size pos;			/* bytes of the buffer written or read */
+	Size published;		/* writer's progress, as last published or seen */
+	bool done;
+	bool spilled;
+	bool in_workfile;	/* reader has moved on to the workfile */
 } ShareInput_Lk_Context;
 
 static void writer_wait_for_acks(ShareInput_Lk_Context *pctxt, int share_id, int xslice);
+static void *shareinput_reader_openchannel(int share_id);
+static void channel_reader_attach(ShareInput_Lk_Context *pctxt, bool counted);
+static void channel_release(ShareInput_Lk_Context *pctxt);
+static void writer_open_fifos(ShareInput_Lk_Context *pctxt, int share_id);
+static void writer_wait_for_channel_readers(ShareInput_Lk_Context *pctxt, int xslice);
+static bool shareinput_reader_nexttuple(ShareInput_Lk_Context *pctxt, TupleTableSlot *slot);
+
+
+/*
+ * open_xslice_workfile
+ *    Open the workfile a cross-slice shared material is written to.
+ */
+static void
+open_xslice_workfile(ShareInputScanState *node)
+{
+	ShareInputScan *sisc = (ShareInputScan *)node->ss.ps.plan;
+	char rwfile_prefix[100];
+
+	shareinput_create_bufname_prefix(rwfile_prefix, sizeof(rwfile_prefix), sisc->share_id);
+
+	node->ts_state->matstore = ntuplestore_create_readerwriter(rwfile_prefix, 0, false);
+	node->ts_pos = (void *) ntuplestore_create_accessor(node->ts_state->matstore, false);
+	ntuplestore_acc_seek_bof((NTupleStoreAccessor *)node->ts_pos);
+}
 
 
 /*
@@ -83,14 +167,23 @@ init_tuplestore_state(ShareInputScanState *node)
 
 	if(share_type == SHARE_MATERIAL_XSLICE)
 	{
-		char rwfile_prefix[100];
-		shareinput_create_bufname_prefix(rwfile_prefix, sizeof(rwfile_prefix), sisc->share_id);
-	
+		ShareInput_Lk_Context *lk_ctxt;
+
+		/*
+		 * A reader in the writer's own slice runs after the writer is done,
+		 * but the tuples may still be in the writer's channel.
+		 */
+		if (node->share_lk_ctxt == NULL && snState != NULL)
+			node->share_lk_ctxt = shareinput_reader_openchannel(sisc->share_id);
+		lk_ctxt = (ShareInput_Lk_Context *) node->share_lk_ctxt;
+
 		node->ts_state = palloc0(sizeof(GenericTupStore));
 
-		node->ts_state->matstore = ntuplestore_create_readerwriter(rwfile_prefix, 0, false);
-		node->ts_pos = (void *) ntuplestore_create_accessor(node->ts_state->matstore, false);
-		ntuplestore_acc_seek_bof((NTupleStoreAccessor *)node->ts_pos);
+		/* With a channel, the workfile is opened once the channel runs dry */
+		if (lk_ctxt == NULL || lk_ctxt->channel == NULL)
+			open_xslice_workfile(node);
+		else
+			return;
 	}
 	else if(share_type == SHARE_MATERIAL)
 	{
@@ -154,6 +247,7 @@ ExecShareInputScan(ShareInputScanState *node)
 	ShareInputScan * sisc = (ShareInputScan *) node->ss.ps.plan;
 
 	ShareType share_type = sisc->share_type;
+	ShareInput_Lk_Context *lk_ctxt;
 
 	/* 
 	 * get state info from node
@@ -173,11 +267,28 @@ ExecShareInputScan(ShareInputScanState *node)
 
 	slot = node->ss.ps.ps_ResultTupleSlot;
 
+	lk_ctxt = (ShareInput_Lk_Context *) node->share_lk_ctxt;
+	if (lk_ctxt && lk_ctxt->channel && !forward)
+		elog(ERROR, "backward scan of a shared input channel is not supported");
+
 	while(1)
 	{
 		bool gotOK = false;
 
-		if(share_type == SHARE_MATERIAL || share_type == SHARE_MATERIAL_XSLICE) 
+		if (lk_ctxt && lk_ctxt->channel && !lk_ctxt->in_workfile)
+		{
+			gotOK = shareinput_reader_nexttuple(lk_ctxt, slot);
+
+			if (!gotOK && lk_ctxt->spilled)
+			{
+				/* The rest of the tuples are in the workfile */
+				if (node->ts_state->matstore == NULL)
+					open_xslice_workfile(node);
+				lk_ctxt->in_workfile = true;
+				continue;
+			}
+		}
+		else if(share_type == SHARE_MATERIAL || share_type == SHARE_MATERIAL_XSLICE) 
 		{
 			ntuplestore_acc_advance((NTupleStoreAccessor *) node->ts_pos, forward ? 1 : -1);
 			gotOK = ntuplestore_acc_current_tupleslot((NTupleStoreAccessor *) node->ts_pos, slot);
@@ -338,8 +449,20 @@ ExecReScanShareInputScan(ShareInputScanState *node)
 	}
 
 	ShareInputScan *sisc = (ShareInputScan *) node->ss.ps.plan;
+	ShareInput_Lk_Context *lk_ctxt = (ShareInput_Lk_Context *) node->share_lk_ctxt;
 
 	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+
+	if (lk_ctxt && lk_ctxt->channel)
+	{
+		/* Start over from the beginning of the channel */
+		lk_ctxt->pos = 0;
+		lk_ctxt->in_workfile = false;
+		if (node->ts_state->matstore != NULL)
+			ntuplestore_acc_seek_bof((NTupleStoreAccessor *) node->ts_pos);
+		return;
+	}
+
 	Assert(NULL != node->ts_pos);
 
 	if(sisc->share_type == SHARE_MATERIAL || sisc->share_type == SHARE_MATERIAL_XSLICE)
@@ -421,6 +544,9 @@ static void shareinput_clean_lk_ctxt(ShareInput_Lk_Context *lk_ctxt)
 	if (!lk_ctxt)
 		return;
 
+	if (lk_ctxt->channel)
+		channel_release(lk_ctxt);
+
 	if (lk_ctxt->readyfd >= 0)
 	{
 		if (gp_retry_close(lk_ctxt->readyfd))
@@ -464,6 +590,28 @@ static void XCallBack_ShareInput_FIFO(XactEvent ev, void* vp)
 	shareinput_clean_lk_ctxt(lk_ctxt);
 }
 
+static void
+init_lk_ctxt(ShareInput_Lk_Context *pctxt, int share_id)
+{
+	pctxt->readyfd = -1;
+	pctxt->donefd = -1;
+	pctxt->zcnt = 0;
+	pctxt->del_ready = false;
+	pctxt->del_done = false;
+	pctxt->lkname_ready[0] = '\0';
+	pctxt->lkname_done[0] = '\0';
+
+	pctxt->channel = NULL;
+	pctxt->share_id = share_id;
+	pctxt->is_writer = false;
+	pctxt->counted = false;
+	pctxt->pos = 0;
+	pctxt->published = 0;
+	pctxt->done = false;
+	pctxt->spilled = false;
+	pctxt->in_workfile = false;
+}
+
 static void
 create_tmp_fifo(const char *fifoname)
 {
@@ -564,13 +712,7 @@ shareinput_reader_waitready(int share_id, PlanGenerator planGen)
 		ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
 			errmsg("Share input reader failed: out of memory")));
 
-	pctxt->readyfd = -1;
-	pctxt->donefd = -1;
-	pctxt->zcnt = 0;
-	pctxt->del_ready = false;
-	pctxt->del_done = false;
-	pctxt->lkname_ready[0] = '\0';
-	pctxt->lkname_done[0] = '\0';
+	init_lk_ctxt(pctxt, share_id);
 
 	RegisterXactCallbackOnce(XCallBack_ShareInput_FIFO, pctxt);
 
@@ -604,12 +746,19 @@ shareinput_reader_waitready(int share_id, PlanGenerator planGen)
 			int rwsize =
 #endif
 			retry_read(pctxt->readyfd, &a, 1);
-			Assert(rwsize == 1 && a == 'a');
+			Assert(rwsize == 1 && (a == 'a' || a == 'c'));
 
 			elog(DEBUG1, "SISC READER (shareid=%d, slice=%d): Wait ready got writer's handshake",
 					share_id, currentSliceId);
 
-			if (planGen == PLANGEN_PLANNER)
+			if (a == 'c')
+			{
+				/* The writer streams through a channel and doesn't wait for acks */
+				channel_reader_attach(pctxt, true);
+				if (pctxt->channel == NULL)
+					elog(ERROR, "could not find channel of shared input %d", share_id);
+			}
+			else if (planGen == PLANGEN_PLANNER)
 			{
 				/* For planner-generated plans, we send ack back after receiving the handshake */
 				elog(DEBUG1, "SISC READER (shareid=%d, slice=%d): Wait ready writing ack back to writer",
@@ -639,6 +788,30 @@ shareinput_reader_waitready(int share_id, PlanGenerator planGen)
 	return (void *) pctxt;
 }
 
+/*
+ * writer_open_fifos
+ *
+ *  Create and open both fifos on the writer side.  The writer removes them
+ *  once all readers are done.
+ */
+static void
+writer_open_fifos(ShareInput_Lk_Context *pctxt, int share_id)
+{
+	sisc_lockname(pctxt->lkname_ready, MAXPGPATH, share_id, "ready");
+	create_tmp_fifo(pctxt->lkname_ready);
+	pctxt->del_ready = true;
+	pctxt->readyfd = open(pctxt->lkname_ready, O_RDWR, 0600); 
+	if(pctxt->readyfd < 0)
+		elog(ERROR, "could not open fifo \"%s\": %m", pctxt->lkname_ready);
+
+	sisc_lockname(pctxt->lkname_done, MAXPGPATH, share_id, "done");
+	create_tmp_fifo(pctxt->lkname_done);
+	pctxt->del_done = true;
+	pctxt->donefd = open(pctxt->lkname_done, O_RDWR, 0600);
+	if(pctxt->donefd < 0)
+		elog(ERROR, "could not open fifo \"%s\": %m", pctxt->lkname_done);
+}
+
 /*
  * shareinput_writer_notifyready
  *
@@ -663,29 +836,11 @@ shareinput_writer_notifyready(int share_id, int xslice, PlanGenerator planGen)
 		ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
 			errmsg("Shareinput Writer failed: out of memory")));
 
-	pctxt->readyfd = -1;
-	pctxt->donefd = -1;
-	pctxt->zcnt = 0;
-	pctxt->del_ready = false;
-	pctxt->del_done = false;
-	pctxt->lkname_ready[0] = '\0';
-	pctxt->lkname_done[0] = '\0';
+	init_lk_ctxt(pctxt, share_id);
 
 	RegisterXactCallbackOnce(XCallBack_ShareInput_FIFO, pctxt);
 
-	sisc_lockname(pctxt->lkname_ready, MAXPGPATH, share_id, "ready");
-	create_tmp_fifo(pctxt->lkname_ready);
-	pctxt->del_ready = true;
-	pctxt->readyfd = open(pctxt->lkname_ready, O_RDWR, 0600); 
-	if(pctxt->readyfd < 0)
-		elog(ERROR, "could not open fifo \"%s\": %m", pctxt->lkname_ready);
-
-	sisc_lockname(pctxt->lkname_done, MAXPGPATH, share_id, "done");
-	create_tmp_fifo(pctxt->lkname_done);
-	pctxt->del_done = true;
-	pctxt->donefd = open(pctxt->lkname_done, O_RDWR, 0600);
-	if(pctxt->donefd < 0)
-		elog(ERROR, "could not open fifo \"%s\": %m", pctxt->lkname_done);
+	writer_open_fifos(pctxt, share_id);
 
 	for(n=0; n<xslice; ++n)
 	{
@@ -780,11 +935,16 @@ void
 shareinput_reader_notifydone(void *ctxt, int share_id)
 {
 	ShareInput_Lk_Context *pctxt = (ShareInput_Lk_Context *) ctxt;
+
+	/* A channel reader counts itself done as it lets go of the channel */
+	if (pctxt->channel == NULL)
+	{
 #if USE_ASSERT_CHECKING
-	int rwsize  =
+		int rwsize  =
 #endif
-	retry_write(pctxt->donefd, "z", 1);
-	Assert(rwsize == 1);
+		retry_write(pctxt->donefd, "z", 1);
+		Assert(rwsize == 1);
+	}
 
 	shareinput_clean_lk_ctxt(pctxt);
 	UnregisterXactCallbackOnce(XCallBack_ShareInput_FIFO, (void *) ctxt);
@@ -811,6 +971,12 @@ shareinput_writer_waitdone(void *ctxt, int share_id, int nsharer_xslice)
 	elog(DEBUG1, "SISC WRITER (shareid=%d, slice=%d): waiting for DONE message from %d readers",
 							share_id, currentSliceId, ack_needed);
 
+	if (pctxt->channel != NULL)
+	{
+		writer_wait_for_channel_readers(pctxt, nsharer_xslice);
+		ack_needed = 0;
+	}
+
 	while(ack_needed > 0)
 	{
 		CHECK_FOR_INTERRUPTS();
@@ -920,3 +1086,481 @@ ExecEagerFreeShareInputScan(ShareInputScanState *node)
 	}
 	node->freed = true;
 }
+
+/*************************************************************************
+ * Shared-memory channels.
+ *
+ * A writer that gets a channel writes 'c' instead of 'a' into the ready fifo,
+ * as soon as it starts producing.  That is the only use of the fifos then:
+ * readers attach to the channel of the share, don't ack, and count themselves
+ * done in the channel rather than writing 'z'.  A writer that doesn't get a
+ * channel (none free, too many readers, or gp_shareinput_channels is 0) uses
+ * the fifo protocol above.
+ **************************************************************************/
+
+Size
+ShareInputChannel_ShmemSize(void)
+{
+	Size		size;
+
+	if (gp_shareinput_channels <= 0)
+		return 0;
+
+	size = add_size(offsetof(ShareInputChannelCtl, channels),
+					mul_size(gp_shareinput_channels, sizeof(ShareInputChannel)));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(gp_shareinput_channels,
+								   (Size) gp_shareinput_channel_size * 1024));
+	return size;
+}
+
+void
+ShareInputChannel_ShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	if (gp_shareinput_channels <= 0)
+		return;
+
+	shareInputChannels = (ShareInputChannelCtl *)
+		ShmemInitStruct("ShareInputScan channels",
+						ShareInputChannel_ShmemSize(),
+						&found);
+	if (!found)
+	{
+		shareInputChannels->nchannels = gp_shareinput_channels;
+		shareInputChannels->bufsize = (Size) gp_shareinput_channel_size * 1024;
+		for (i = 0; i < gp_shareinput_channels; i++)
+		{
+			ShareInputChannel *ch = &shareInputChannels->channels[i];
+
+			MemSet(ch, 0, sizeof(ShareInputChannel));
+			SpinLockInit(&ch->mutex);
+		}
+	}
+}
+
+static char *
+channel_buffer(volatile ShareInputChannel *ch)
+{
+	Size		offset;
+	int			i = (ShareInputChannel *) ch - shareInputChannels->channels;
+
+	offset = MAXALIGN(offsetof(ShareInputChannelCtl, channels) +
+					  shareInputChannels->nchannels * sizeof(ShareInputChannel));
+	return (char *) shareInputChannels + offset + i * shareInputChannels->bufsize;
+}
+
+/*
+ * Takes a reference on the channel of share_id in the current command.  With
+ * create, claims a free channel for it instead.  Returns NULL if there is
+ * none.
+ */
+static ShareInputChannel *
+channel_attach(int share_id, bool create)
+{
+	ShareInputChannel *result = NULL;
+	ShareInputChannel *freech = NULL;
+	int			i;
+
+	if (shareInputChannels == NULL)
+		return NULL;
+
+	LWLockAcquire(ShareInputChannelLock, LW_EXCLUSIVE);
+
+	for (i = 0; i < shareInputChannels->nchannels; i++)
+	{
+		ShareInputChannel *ch = &shareInputChannels->channels[i];
+
+		if (ch->session_id == 0)
+		{
+			if (freech == NULL)
+				freech = ch;
+		}
+		else if (ch->session_id == gp_session_id &&
+				 ch->command_count == gp_command_count &&
+				 ch->share_id == share_id)
+		{
+			result = ch;
+			break;
+		}
+	}
+
+	if (result != NULL)
+	{
+		Assert(!create);
+		result->refcount++;
+	}
+	else if (create && freech != NULL)
+	{
+		volatile ShareInputChannel *vch = freech;
+
+		freech->session_id = gp_session_id;
+		freech->command_count = gp_command_count;
+		freech->share_id = share_id;
+		freech->refcount = 1;
+
+		SpinLockAcquire(&vch->mutex);
+		vch->writer = MyProc;
+		vch->nreaders = 0;
+		vch->nreaders_done = 0;
+		vch->published = 0;
+		vch->done = false;
+		vch->spilled = false;
+		vch->aborted = false;
+		SpinLockRelease(&vch->mutex);
+
+		result = freech;
+	}
+
+	LWLockRelease(ShareInputChannelLock);
+
+	return result;
+}
+
+static void
+channel_detach(volatile ShareInputChannel *ch)
+{
+	LWLockAcquire(ShareInputChannelLock, LW_EXCLUSIVE);
+
+	Assert(ch->refcount > 0);
+	if (--ch->refcount == 0)
+		ch->session_id = 0;
+
+	LWLockRelease(ShareInputChannelLock);
+}
+
+/*
+ * Makes the writer's progress visible to the readers, and wakes them up.
+ */
+static void
+channel_publish(ShareInput_Lk_Context *pctxt, bool done)
+{
+	volatile ShareInputChannel *ch = pctxt->channel;
+	PGPROC	   *readers[SISC_CHANNEL_MAX_READERS];
+	int			nreaders;
+	int			i;
+
+	SpinLockAcquire(&ch->mutex);
+	ch->published = pctxt->pos;
+	if (done)
+	{
+		ch->done = true;
+		ch->spilled = pctxt->spilled;
+	}
+	nreaders = ch->nreaders;
+	for (i = 0; i < nreaders; i++)
+		readers[i] = ch->readers[i];
+	SpinLockRelease(&ch->mutex);
+
+	pctxt->published = pctxt->pos;
+	if (done)
+		pctxt->done = true;
+
+	for (i = 0; i < nreaders; i++)
+		SetLatch(&readers[i]->procLatch);
+}
+
+static void
+channel_reader_attach(ShareInput_Lk_Context *pctxt, bool counted)
+{
+	volatile ShareInputChannel *ch = channel_attach(pctxt->share_id, false);
+
+	if (ch == NULL)
+		return;
+
+	pctxt->channel = ch;
+	pctxt->counted = counted;
+
+	SIMPLE_FAULT_INJECTOR(ShareInputChannelAttach);
+
+	/* Only the readers the writer waits for need waking up */
+	if (counted)
+	{
+		SpinLockAcquire(&ch->mutex);
+		if (ch->nreaders < SISC_CHANNEL_MAX_READERS)
+			ch->readers[ch->nreaders++] = MyProc;
+		SpinLockRelease(&ch->mutex);
+	}
+}
+
+/*
+ * Lets go of the channel.  A writer that isn't done marks it aborted, so that
+ * readers don't take what they got for all of it.  A reader the writer waits
+ * for counts itself done.
+ */
+static void
+channel_release(ShareInput_Lk_Context *pctxt)
+{
+	volatile ShareInputChannel *ch = pctxt->channel;
+	PGPROC	   *wakeup[SISC_CHANNEL_MAX_READERS];
+	int			nwakeup = 0;
+	int			i;
+
+	SpinLockAcquire(&ch->mutex);
+	if (pctxt->is_writer)
+	{
+		if (!ch->done)
+		{
+			ch->aborted = true;
+			for (i = 0; i < ch->nreaders; i++)
+				wakeup[nwakeup++] = ch->readers[i];
+		}
+	}
+	else if (pctxt->counted)
+	{
+		ch->nreaders_done++;
+		wakeup[nwakeup++] = ch->writer;
+	}
+	SpinLockRelease(&ch->mutex);
+
+	for (i = 0; i < nwakeup; i++)
+		SetLatch(&wakeup[i]->procLatch);
+
+	channel_detach(ch);
+	pctxt->channel = NULL;
+}
+
+/*
+ * shareinput_writer_openchannel
+ *
+ *  Called by the writer (producer) before it starts producing tuples.  If it
+ *  gets a channel, readers (consumers) are notified right away, and the
+ *  tuples are to be passed to shareinput_writer_puttuple.
+ *
+ *  Returns the context for shareinput_writer_waitdone, or NULL to use
+ *  shareinput_writer_notifyready once all the tuples are in the workfile.
+ */
+void *
+shareinput_writer_openchannel(int share_id, int xslice)
+{
+	ShareInput_Lk_Context *pctxt;
+	ShareInputChannel *ch;
+	int n;
+
+	if (xslice <= 0 || xslice > SISC_CHANNEL_MAX_READERS)
+		return NULL;
+
+#ifdef FAULT_INJECTOR
+	/* Act as if all channels were taken */
+	if (SIMPLE_FAULT_INJECTOR(ShareInputChannelOpen) == FaultInjectorTypeSkip)
+		return NULL;
+#endif
+
+	pctxt = gp_malloc(sizeof(ShareInput_Lk_Context));
+	if(!pctxt)
+		ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
+			errmsg("Shareinput Writer failed: out of memory")));
+
+	init_lk_ctxt(pctxt, share_id);
+
+	ch = channel_attach(share_id, true);
+	if (ch == NULL)
+	{
+		gp_free(pctxt);
+		return NULL;
+	}
+	pctxt->channel = ch;
+	pctxt->is_writer = true;
+
+	RegisterXactCallbackOnce(XCallBack_ShareInput_FIFO, pctxt);
+
+	writer_open_fifos(pctxt, share_id);
+
+	for(n=0; n<xslice; ++n)
+	{
+#if USE_ASSERT_CHECKING
+		int rwsize =
+#endif
+		retry_write(pctxt->readyfd, "c", 1);
+		Assert(rwsize == 1);
+	}
+	elog(DEBUG1, "SISC WRITER (shareid=%d, slice=%d): opened channel for %d xslice readers",
+						share_id, currentSliceId, xslice);
+
+	return (void *) pctxt;
+}
+
+/*
+ * shareinput_writer_puttuple
+ *
+ *  Copies a tuple into the channel.  Returns false if it doesn't fit; the
+ *  caller then writes it and all the following tuples to the workfile.
+ */
+bool
+shareinput_writer_puttuple(void *ctxt, TupleTableSlot *slot)
+{
+	ShareInput_Lk_Context *pctxt = (ShareInput_Lk_Context *) ctxt;
+	uint32		len;
+
+	Assert(pctxt->is_writer && pctxt->channel != NULL);
+
+	if (pctxt->spilled)
+		return false;
+
+	len = (uint32) (shareInputChannels->bufsize - pctxt->pos);
+	if (ExecCopySlotMemTupleTo(slot, NULL, channel_buffer(pctxt->channel) + pctxt->pos, &len) == NULL)
+	{
+		pctxt->spilled = true;
+		SIMPLE_FAULT_INJECTOR(ShareInputChannelSpill);
+		return false;
+	}
+
+	pctxt->pos += MAXALIGN(len);
+	if (pctxt->pos - pctxt->published >= SISC_CHANNEL_PUBLISH_BYTES)
+		channel_publish(pctxt, false);
+
+	return true;
+}
+
+/*
+ * shareinput_writer_closechannel
+ *
+ *  Called by the writer once all tuples are produced, and the ones that
+ *  didn't fit in the channel are flushed to the workfile.
+ */
+void
+shareinput_writer_closechannel(void *ctxt)
+{
+	ShareInput_Lk_Context *pctxt = (ShareInput_Lk_Context *) ctxt;
+
+	Assert(pctxt->is_writer && pctxt->channel != NULL);
+
+	channel_publish(pctxt, true);
+
+	elog(DEBUG1, "SISC WRITER (shareid=%d, slice=%d): wrote " UINT64_FORMAT " bytes to channel%s",
+		 pctxt->share_id, currentSliceId, (uint64) pctxt->pos,
+		 pctxt->spilled ? ", spilled the rest to workfile" : "");
+}
+
+/*
+ * Waits until all readers the writer knows of are done with the channel.
+ */
+static void
+writer_wait_for_channel_readers(ShareInput_Lk_Context *pctxt, int xslice)
+{
+	volatile ShareInputChannel *ch = pctxt->channel;
+
+	Assert(pctxt->is_writer && pctxt->done);
+
+	while (1)
+	{
+		int			ndone;
+		int			rc;
+
+		CHECK_FOR_INTERRUPTS();
+
+		ResetLatch(&MyProc->procLatch);
+
+		SpinLockAcquire(&ch->mutex);
+		ndone = ch->nreaders_done;
+		SpinLockRelease(&ch->mutex);
+
+		if (ndone >= xslice)
+			break;
+
+		rc = WaitLatch(&MyProc->procLatch,
+					   WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   1000L);
+		if (rc & WL_POSTMASTER_DEATH)
+			ereport(FATAL,
+					(errcode(ERRCODE_ADMIN_SHUTDOWN),
+					 errmsg("terminating connection due to unexpected postmaster exit")));
+	}
+}
+
+/*
+ * shareinput_reader_openchannel
+ *
+ *  Called by a reader in the writer's own slice, once the writer is done,
+ *  to read from its channel.  Returns NULL if it has none.
+ */
+static void *
+shareinput_reader_openchannel(int share_id)
+{
+	ShareInput_Lk_Context *pctxt;
+
+	if (shareInputChannels == NULL)
+		return NULL;
+
+	pctxt = gp_malloc(sizeof(ShareInput_Lk_Context));
+	if(!pctxt)
+		ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
+			errmsg("Share input reader failed: out of memory")));
+
+	init_lk_ctxt(pctxt, share_id);
+
+	channel_reader_attach(pctxt, false);
+	if (pctxt->channel == NULL)
+	{
+		gp_free(pctxt);
+		return NULL;
+	}
+
+	RegisterXactCallbackOnce(XCallBack_ShareInput_FIFO, pctxt);
+
+	return (void *) pctxt;
+}
+
+/*
+ * shareinput_reader_nexttuple
+ *
+ *  Stores the next tuple of the channel in slot, waiting for the writer to
+ *  produce it if need be.  Returns false at the end of the channel; if the
+ *  writer spilled, the rest of the tuples are in the workfile then.
+ *
+ *  The tuple is not copied out of the channel.
+ */
+static bool
+shareinput_reader_nexttuple(ShareInput_Lk_Context *pctxt, TupleTableSlot *slot)
+{
+	volatile ShareInputChannel *ch = pctxt->channel;
+
+	while (1)
+	{
+		bool		aborted;
+		int			rc;
+
+		if (pctxt->pos < pctxt->published)
+		{
+			MemTuple	mtup = (MemTuple) (channel_buffer(ch) + pctxt->pos);
+
+			pctxt->pos += MAXALIGN(memtuple_get_size(mtup));
+			ExecStoreMinimalTuple(mtup, slot, false);
+			return true;
+		}
+
+		if (pctxt->done)
+		{
+			ExecClearTuple(slot);
+			return false;
+		}
+
+		CHECK_FOR_INTERRUPTS();
+
+		ResetLatch(&MyProc->procLatch);
+
+		SpinLockAcquire(&ch->mutex);
+		pctxt->published = ch->published;
+		pctxt->done = ch->done;
+		pctxt->spilled = ch->spilled;
+		aborted = ch->aborted;
+		SpinLockRelease(&ch->mutex);
+
+		if (aborted)
+			elog(ERROR, "writer of shared input %d went away before it was done",
+				 pctxt->share_id);
+
+		if (pctxt->pos < pctxt->published || pctxt->done)
+			continue;
+
+		rc = WaitLatch(&MyProc->procLatch,
+					   WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   1000L);
+		if (rc & WL_POSTMASTER_DEATH)
+			ereport(FATAL,
+					(errcode(ERRCODE_ADMIN_SHUTDOWN),
+					 errmsg("terminating connection due to unexpected postmaster exit")));
+	}
+}
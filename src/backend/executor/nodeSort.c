@@ -64,6 +64,11 @@ ExecSort(SortState *node)
 	dir = estate->es_direction;
 	tuplesortstate = node->tuplesortstate->sortstore;
 
+	/* Read the sorted output of an earlier query, if we have it */
+	if (node->workfile_reuse && !node->bounded &&
+		workfile_reuse_start(node->workfile_reuse))
+		return workfile_reuse_next(node->workfile_reuse);
+
 	/*
 	 * In Window node, we might need to call ExecSort again even when
 	 * the last tuple in the Sort has been retrieved. Since we might
@@ -246,9 +251,22 @@ ExecSort(SortState *node)
 								  ScanDirectionIsForward(dir),
 								  slot);
 
+	if (node->workfile_reuse)
+	{
+		if (TupIsNull(slot))
+			workfile_reuse_finish(node->workfile_reuse,
+								  tuplesort_spilled(tuplesortstate));
+		else
+			workfile_reuse_put(node->workfile_reuse, slot);
+	}
+
 	if (TupIsNull(slot) && !node->ss.ps.delayEagerFree)
 	{
 		ExecEagerFreeSort(node);
+
+		/* Let operators that run after us have the memory. */
+		if (gp_enable_memory_broker)
+			ExecReleaseOperatorMem(&node->ss.ps);
 	}
 
 	return slot;
@@ -294,6 +312,15 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 	sortstate->tuplesortstate = palloc0(sizeof(GenericTupStore));
 	sortstate->share_lk_ctxt = NULL;
 
+	/*
+	 * The output can be kept for later queries if it is read once, forward,
+	 * and in full.  A bound set later rules it out too.
+	 */
+	if (node->share_type == SHARE_NOTSHARED &&
+		(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) == 0 &&
+		(eflags & EXEC_FLAG_EXPLAIN_ONLY) == 0)
+		sortstate->workfile_reuse = workfile_reuse_create(&sortstate->ss.ps);
+
 	/* CDB */
 
 	/* BUT:
@@ -406,6 +433,9 @@ ExecEndSort(SortState *node)
 
 	ExecEagerFreeSort(node);
 
+	workfile_reuse_end(node->workfile_reuse);
+	node->workfile_reuse = NULL;
+
 	/*
 	 * shut down the subplan
 	 */
@@ -459,6 +489,11 @@ ExecSortRestrPos(SortState *node)
 void
 ExecReScanSort(SortState *node)
 {
+	/* Take back the memory we gave to the broker, if we can */
+	ExecReclaimOperatorMem(&node->ss.ps);
+
+	workfile_reuse_rescan(node->workfile_reuse);
+
 	/*
 	 * If we haven't sorted yet, just return. If outerplan's chgParam is not
 	 * NULL then it will be re-scanned by ExecProcNode, else no reason to
@@ -22,6 +22,11 @@
  * As required by the SQL spec, the output represents the value of the
  * aggregate function over all rows in the current row's window frame.
  *
+ * An aggregate that cannot remove rows from its transition value, but can
+ * combine two transition values, is evaluated over a sliding ROWS frame
+ * with a segment tree built over the partition, so that each row costs
+ * O(log N) combine calls instead of re-aggregating the whole frame.
+ *
  *
  * Portions Copyright (c) 1996-2012, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -35,6 +40,8 @@
 
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbvars.h"
 #include "executor/executor.h"
 #include "executor/nodeWindowAgg.h"
 #include "miscadmin.h"
@@ -157,6 +164,25 @@ typedef struct WindowStatePerAggData
 
 	/* Data local to eval_windowaggregates() */
 	bool		restart;		/* need to restart this agg in this cycle? */
+
+	/*
+	 * Combine function, used to evaluate the aggregate with a segment tree
+	 * if use_segtree is set.  Only looked up if the aggregate has no inverse
+	 * transition function, and its transition type is not internal.
+	 */
+	Oid			combinefn_oid;	/* may be InvalidOid */
+	FmgrInfo	combinefn;
+	bool		use_segtree;
+
+	/*
+	 * Segment tree over the transition values of the current partition's
+	 * rows, in a context of its own under partcontext.  Node i combines nodes 2i and 2i+1, and the leaf of
+	 * row r is node segtreeNumRows + r.  NULL if the tree wasn't built for the
+	 * current partition.
+	 */
+	Datum	   *segtreeValues;
+	bool	   *segtreeIsNull;
+	int64		segtreeNumRows;
 } WindowStatePerAggData;
 
 static void initialize_windowaggregate(WindowAggState *winstate,
@@ -172,8 +198,18 @@ static void finalize_windowaggregate(WindowAggState *winstate,
 						 WindowStatePerFunc perfuncstate,
 						 WindowStatePerAgg peraggstate,
 						 Datum *result, bool *isnull);
+static Datum combine_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate,
+						Datum value1, bool isnull1,
+						Datum value2, bool isnull2,
+						bool *isnull);
 
 static void eval_windowaggregates(WindowAggState *winstate);
+static void build_windowaggregate_segtrees(WindowAggState *winstate);
+static void drop_windowaggregate_segtrees(WindowAggState *winstate,
+							  MemoryContext segtreecontext);
+static void eval_windowaggregates_segtree(WindowAggState *winstate);
 static void eval_windowfunction(WindowAggState *winstate,
 					WindowStatePerFunc perfuncstate,
 					Datum *result, bool *isnull);
@@ -625,6 +661,65 @@ finalize_windowaggregate(WindowAggState *winstate,
 	MemoryContextSwitchTo(oldContext);
 }
 
+/*
+ * combine_windowaggregate
+ * combine two transition values with the agg's combine function
+ *
+ * The result is allocated in CurrentMemoryContext.  Neither input is
+ * modified, even if the combine function scribbles on its first argument.
+ */
+static Datum
+combine_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate,
+						Datum value1, bool isnull1,
+						Datum value2, bool isnull2,
+						bool *isnull)
+{
+	FunctionCallInfoData fcinfo;
+	Datum		result;
+
+	if (peraggstate->combinefn.fn_strict && (isnull1 || isnull2))
+	{
+		/* A NULL transition value hasn't seen any rows, take the other one */
+		if (isnull1)
+		{
+			value1 = value2;
+			isnull1 = isnull2;
+		}
+		*isnull = isnull1;
+		if (isnull1)
+			return (Datum) 0;
+		return datumCopy(value1,
+						 peraggstate->transtypeByVal,
+						 peraggstate->transtypeLen);
+	}
+
+	InitFunctionCallInfoData(fcinfo, &(peraggstate->combinefn),
+							 2,
+							 perfuncstate->winCollation,
+							 (void *) winstate, NULL);
+	fcinfo.arg[0] = isnull1 ? value1 : datumCopy(value1,
+												 peraggstate->transtypeByVal,
+												 peraggstate->transtypeLen);
+	fcinfo.argnull[0] = isnull1;
+	fcinfo.arg[1] = value2;
+	fcinfo.argnull[1] = isnull2;
+	winstate->curaggcontext = CurrentMemoryContext;
+	result = FunctionCallInvoke(&fcinfo);
+	winstate->curaggcontext = NULL;
+	*isnull = fcinfo.isnull;
+
+	/* The combine function may have returned its second argument */
+	if (!peraggstate->transtypeByVal && !*isnull &&
+		!MemoryContextContains(CurrentMemoryContext,
+							   DatumGetPointer(result)))
+		result = datumCopy(result,
+						   peraggstate->transtypeByVal,
+						   peraggstate->transtypeLen);
+	return result;
+}
+
 /*
  * eval_windowaggregates
  * evaluate plain aggregates being used as window functions
@@ -642,6 +737,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	WindowStatePerAgg peraggstate;
 	int			wfuncno,
 				numaggs,
+				numaggs_plain,
 				numaggs_restart,
 				i;
 	int64		aggregatedupto_nonrestarted;
@@ -663,6 +759,28 @@ eval_windowaggregates(WindowAggState *winstate)
 	agg_row_slot = winstate->agg_row_slot;
 	temp_slot = winstate->temp_slot_1;
 
+	/*
+	 * Aggregates with a segment tree over the partition are evaluated on
+	 * their own, and are skipped by everything below.
+	 */
+	if (winstate->currentpos == 0)
+		build_windowaggregate_segtrees(winstate);
+	if (winstate->numsegtreeaggs > 0)
+	{
+		eval_windowaggregates_segtree(winstate);
+
+		numaggs_plain = numaggs - winstate->numsegtreeaggs;
+		if (numaggs_plain == 0)
+		{
+			/* The trees don't need the rows again */
+			if (agg_winobj->markptr >= 0)
+				WinSetMarkPosition(agg_winobj, winstate->currentpos);
+			return;
+		}
+	}
+	else
+		numaggs_plain = numaggs;
+
 	/*
 	 * Currently, we support only a subset of the SQL-standard window framing
 	 * rules.
@@ -740,6 +858,8 @@ eval_windowaggregates(WindowAggState *winstate)
 		for (i = 0; i < numaggs; i++)
 		{
 			peraggstate = &winstate->peragg[i];
+			if (peraggstate->segtreeValues != NULL)
+				continue;
 			wfuncno = peraggstate->wfuncno;
 			econtext->ecxt_aggvalues[wfuncno] = peraggstate->resultValue;
 			econtext->ecxt_aggnulls[wfuncno] = peraggstate->resultValueIsNull;
@@ -809,7 +929,9 @@ eval_windowaggregates(WindowAggState *winstate)
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
-		if (winstate->currentpos == 0 ||
+		if (peraggstate->segtreeValues != NULL)
+			peraggstate->restart = false;
+		else if (winstate->currentpos == 0 ||
 			(winstate->aggregatedbase != winstate->frameheadpos &&
 			 !OidIsValid(peraggstate->invtransfn_oid)) ||
 			winstate->aggregatedupto <= winstate->frameheadpos ||
@@ -830,7 +952,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * i.e. advance_windowaggregate_base() can return false, in which case
 	 * we'll restart that aggregate below.
 	 */
-	while (numaggs_restart < numaggs &&
+	while (numaggs_restart < numaggs_plain &&
 		   winstate->aggregatedbase < winstate->frameheadpos)
 	{
 		/*
@@ -853,7 +975,7 @@ eval_windowaggregates(WindowAggState *winstate)
 			bool		ok;
 
 			peraggstate = &winstate->peragg[i];
-			if (peraggstate->restart)
+			if (peraggstate->restart || peraggstate->segtreeValues != NULL)
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
@@ -905,6 +1027,8 @@ eval_windowaggregates(WindowAggState *winstate)
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
+		if (peraggstate->segtreeValues != NULL)
+			continue;
 
 		/* Aggregates using the shared ctx must restart if *any* agg does */
 		Assert(peraggstate->aggcontext != winstate->aggcontext ||
@@ -973,6 +1097,8 @@ eval_windowaggregates(WindowAggState *winstate)
 		for (i = 0; i < numaggs; i++)
 		{
 			peraggstate = &winstate->peragg[i];
+			if (peraggstate->segtreeValues != NULL)
+				continue;
 
 			/* Non-restarted aggs skip until aggregatedupto_nonrestarted */
 			if (!peraggstate->restart &&
@@ -1011,6 +1137,8 @@ eval_windowaggregates(WindowAggState *winstate)
 		bool	   *isnull;
 
 		peraggstate = &winstate->peragg[i];
+		if (peraggstate->segtreeValues != NULL)
+			continue;
 		wfuncno = peraggstate->wfuncno;
 		result = &econtext->ecxt_aggvalues[wfuncno];
 		isnull = &econtext->ecxt_aggnulls[wfuncno];
@@ -1043,6 +1171,332 @@ eval_windowaggregates(WindowAggState *winstate)
 	}
 }
 
+/*
+ * build_windowaggregate_segtrees
+ * build the segment trees of the current partition
+ *
+ * Called at the first row of each partition.  The whole partition is spooled,
+ * each row's transition value becomes a leaf, and the inner nodes are
+ * combined bottom up.
+ *
+ * The trees must fit in the operator's memory.  If they don't, or stop
+ * fitting as by-reference transition values are copied in, they are thrown
+ * away and all the aggregates are left to eval_windowaggregates() for this
+ * partition.
+ */
+static void
+build_windowaggregate_segtrees(WindowAggState *winstate)
+{
+	WindowObject agg_winobj = winstate->agg_winobj;
+	TupleTableSlot *slot = winstate->temp_slot_1;
+	MemoryContext tmpmem = winstate->tmpcontext->ecxt_per_tuple_memory;
+	MemoryContext segtreecontext;
+	MemoryContext oldContext;
+	Size		memlimit = (Size) PlanStateOperatorMemKB(&winstate->ss.ps) * 1024L;
+	Size		nodesize = 0;
+	bool		byref = false;
+	int64		nrows;
+	int64		pos;
+	int			numaggs = winstate->numaggs;
+	int			i;
+
+	Assert(winstate->numsegtreeaggs == 0);
+
+	for (i = 0; i < numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+		if (!peraggstate->use_segtree)
+			continue;
+		nodesize += sizeof(Datum) + sizeof(bool);
+		if (!peraggstate->transtypeByVal)
+		{
+			byref = true;
+			if (peraggstate->transtypeLen > 0)
+				nodesize += MAXALIGN(peraggstate->transtypeLen);
+		}
+	}
+	if (nodesize == 0)
+		return;
+
+	spool_tuples(winstate, -1);
+	nrows = winstate->spooled_rows;
+
+	if ((Size) nrows * 2 > MaxAllocSize / sizeof(Datum) ||
+		(Size) nrows * 2 > memlimit / nodesize)
+		return;
+
+	segtreecontext = AllocSetContextCreate(winstate->partcontext,
+										   "WindowAgg_SegmentTrees",
+										   ALLOCSET_DEFAULT_MINSIZE,
+										   ALLOCSET_DEFAULT_INITSIZE,
+										   ALLOCSET_DEFAULT_MAXSIZE);
+
+	for (i = 0; i < numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+		if (!peraggstate->use_segtree)
+			continue;
+
+		peraggstate->segtreeValues = (Datum *)
+			MemoryContextAlloc(segtreecontext, nrows * 2 * sizeof(Datum));
+		peraggstate->segtreeIsNull = (bool *)
+			MemoryContextAlloc(segtreecontext, nrows * 2 * sizeof(bool));
+		peraggstate->segtreeNumRows = nrows;
+		winstate->numsegtreeaggs++;
+	}
+
+	/* The leaves: each row aggregated on its own */
+	for (pos = 0; pos < nrows; pos++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (!window_gettupleslot(agg_winobj, pos, slot))
+			elog(ERROR, "could not fetch row " INT64_FORMAT " of window partition",
+				 pos);
+		winstate->tmpcontext->ecxt_outertuple = slot;
+
+		if (byref && MemoryContextGetCurrentSpace(segtreecontext) > memlimit)
+		{
+			drop_windowaggregate_segtrees(winstate, segtreecontext);
+			return;
+		}
+
+		for (i = 0; i < numaggs; i++)
+		{
+			WindowStatePerAgg peraggstate = &winstate->peragg[i];
+			MemoryContext aggcontext = peraggstate->aggcontext;
+			int64		leaf = nrows + pos;
+
+			if (peraggstate->segtreeValues == NULL)
+				continue;
+
+			/*
+			 * Run the transition function in the per-tuple context, the leaf
+			 * gets a copy.
+			 */
+			oldContext = MemoryContextSwitchTo(tmpmem);
+			peraggstate->transValue = peraggstate->initValueIsNull ?
+				peraggstate->initValue :
+				datumCopy(peraggstate->initValue,
+						  peraggstate->transtypeByVal,
+						  peraggstate->transtypeLen);
+			peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+			peraggstate->transValueCount = 0;
+			MemoryContextSwitchTo(oldContext);
+
+			peraggstate->aggcontext = tmpmem;
+			advance_windowaggregate(winstate,
+									&winstate->perfunc[peraggstate->wfuncno],
+									peraggstate);
+			peraggstate->aggcontext = aggcontext;
+
+			peraggstate->segtreeIsNull[leaf] = peraggstate->transValueIsNull;
+			if (peraggstate->transValueIsNull)
+				peraggstate->segtreeValues[leaf] = (Datum) 0;
+			else
+			{
+				oldContext = MemoryContextSwitchTo(segtreecontext);
+				peraggstate->segtreeValues[leaf] =
+					datumCopy(peraggstate->transValue,
+							  peraggstate->transtypeByVal,
+							  peraggstate->transtypeLen);
+				MemoryContextSwitchTo(oldContext);
+			}
+		}
+
+		ResetExprContext(winstate->tmpcontext);
+		ExecClearTuple(slot);
+	}
+
+	/* The inner nodes */
+	for (i = 0; i < numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+		WindowStatePerFunc perfuncstate;
+		Datum	   *values = peraggstate->segtreeValues;
+		bool	   *isnulls = peraggstate->segtreeIsNull;
+		int64		node;
+
+		if (values == NULL)
+			continue;
+		perfuncstate = &winstate->perfunc[peraggstate->wfuncno];
+
+		for (node = nrows - 1; node > 0; node--)
+		{
+			Datum		value;
+
+			CHECK_FOR_INTERRUPTS();
+
+			if (byref && MemoryContextGetCurrentSpace(segtreecontext) > memlimit)
+			{
+				drop_windowaggregate_segtrees(winstate, segtreecontext);
+				return;
+			}
+
+			oldContext = MemoryContextSwitchTo(tmpmem);
+			value = combine_windowaggregate(winstate, perfuncstate, peraggstate,
+											values[2 * node], isnulls[2 * node],
+											values[2 * node + 1], isnulls[2 * node + 1],
+											&isnulls[node]);
+			MemoryContextSwitchTo(segtreecontext);
+			values[node] = isnulls[node] ? (Datum) 0 :
+				datumCopy(value,
+						  peraggstate->transtypeByVal,
+						  peraggstate->transtypeLen);
+			MemoryContextSwitchTo(oldContext);
+
+			ResetExprContext(winstate->tmpcontext);
+		}
+	}
+}
+
+/*
+ * drop_windowaggregate_segtrees
+ * throw away the segment trees being built, that grew too big
+ */
+static void
+drop_windowaggregate_segtrees(WindowAggState *winstate,
+							  MemoryContext segtreecontext)
+{
+	int			i;
+
+	for (i = 0; i < winstate->numaggs; i++)
+	{
+		winstate->peragg[i].segtreeValues = NULL;
+		winstate->peragg[i].segtreeIsNull = NULL;
+	}
+	winstate->numsegtreeaggs = 0;
+
+	ResetExprContext(winstate->tmpcontext);
+	MemoryContextDelete(segtreecontext);
+}
+
+/*
+ * eval_windowaggregates_segtree
+ * evaluate the aggregates that have a segment tree for the partition
+ *
+ * The frame is covered by O(log N) nodes of the tree.  Going up from the
+ * frame's first and last leaf, the nodes on the left edge are appended to
+ * one transition value and those on the right edge are prepended to
+ * another, so the rows are combined in order; the two are combined last.
+ */
+static void
+eval_windowaggregates_segtree(WindowAggState *winstate)
+{
+	ExprContext *econtext = winstate->ss.ps.ps_ExprContext;
+	MemoryContext tmpmem = winstate->tmpcontext->ecxt_per_tuple_memory;
+	int64		frameheadpos;
+	int64		frametailpos;
+	int			i;
+
+	update_frameheadpos(winstate->agg_winobj, winstate->temp_slot_1);
+	update_frametailpos(winstate->agg_winobj, winstate->temp_slot_1);
+	frameheadpos = winstate->frameheadpos;
+	frametailpos = winstate->frametailpos;
+
+	for (i = 0; i < winstate->numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+		WindowStatePerFunc perfuncstate;
+		Datum	   *values = peraggstate->segtreeValues;
+		bool	   *isnulls = peraggstate->segtreeIsNull;
+		int64		nrows = peraggstate->segtreeNumRows;
+		MemoryContext aggcontext = peraggstate->aggcontext;
+		MemoryContext oldContext;
+		Datum		left = (Datum) 0;
+		Datum		right = (Datum) 0;
+		bool		leftIsNull = true;
+		bool		rightIsNull = true;
+		bool		haveLeft = false;
+		bool		haveRight = false;
+		int64		lo;
+		int64		hi;
+		int			wfuncno;
+
+		if (values == NULL)
+			continue;
+		wfuncno = peraggstate->wfuncno;
+		perfuncstate = &winstate->perfunc[wfuncno];
+
+		oldContext = MemoryContextSwitchTo(tmpmem);
+
+		/* Half-open range [lo, hi) of leaves, walked up level by level */
+		lo = Max(frameheadpos, 0) + nrows;
+		hi = Min(frametailpos, nrows - 1) + 1 + nrows;
+		for (; lo < hi; lo >>= 1, hi >>= 1)
+		{
+			if (lo & 1)
+			{
+				if (haveLeft)
+					left = combine_windowaggregate(winstate, perfuncstate,
+												   peraggstate,
+												   left, leftIsNull,
+												   values[lo], isnulls[lo],
+												   &leftIsNull);
+				else
+				{
+					left = values[lo];
+					leftIsNull = isnulls[lo];
+					haveLeft = true;
+				}
+				lo++;
+			}
+			if (hi & 1)
+			{
+				hi--;
+				if (haveRight)
+					right = combine_windowaggregate(winstate, perfuncstate,
+													peraggstate,
+													values[hi], isnulls[hi],
+													right, rightIsNull,
+													&rightIsNull);
+				else
+				{
+					right = values[hi];
+					rightIsNull = isnulls[hi];
+					haveRight = true;
+				}
+			}
+		}
+
+		if (haveLeft && haveRight)
+			left = combine_windowaggregate(winstate, perfuncstate, peraggstate,
+										   left, leftIsNull,
+										   right, rightIsNull,
+										   &leftIsNull);
+		else if (haveRight)
+		{
+			left = right;
+			leftIsNull = rightIsNull;
+		}
+		else if (!haveLeft)
+		{
+			/* Empty frame */
+			leftIsNull = peraggstate->initValueIsNull;
+			left = leftIsNull ? (Datum) 0 :
+				datumCopy(peraggstate->initValue,
+						  peraggstate->transtypeByVal,
+						  peraggstate->transtypeLen);
+		}
+		MemoryContextSwitchTo(oldContext);
+
+		/* Anything the final function allocates goes away with the row */
+		peraggstate->transValue = left;
+		peraggstate->transValueIsNull = leftIsNull;
+		peraggstate->aggcontext = tmpmem;
+		finalize_windowaggregate(winstate, perfuncstate, peraggstate,
+								 &econtext->ecxt_aggvalues[wfuncno],
+								 &econtext->ecxt_aggnulls[wfuncno]);
+		peraggstate->aggcontext = aggcontext;
+		peraggstate->transValue = (Datum) 0;
+		peraggstate->transValueIsNull = true;
+	}
+
+	ResetExprContext(winstate->tmpcontext);
+}
+
 /*
  * eval_windowfunction
  *
@@ -1310,7 +1764,10 @@ release_partition(WindowAggState *winstate)
 	{
 		if (winstate->peragg[i].aggcontext != winstate->aggcontext)
 			MemoryContextResetAndDeleteChildren(winstate->peragg[i].aggcontext);
+		winstate->peragg[i].segtreeValues = NULL;
+		winstate->peragg[i].segtreeIsNull = NULL;
 	}
+	winstate->numsegtreeaggs = 0;
 
 	if (winstate->buffer)
 		tuplestore_end(winstate->buffer);
@@ -2204,6 +2661,34 @@ ExecInitWindowAgg(WindowAgg *node, EState *estate, int eflags)
 		!contain_var_clause(node->endOffset) &&
 		!contain_volatile_functions(node->endOffset);
 
+	/*
+	 * In a ROWS frame whose head moves, aggregates that have a combine
+	 * function (see initialize_peragg) are evaluated with a segment tree.
+	 * Like moving aggregates, they use their own aggcontext, which holds the
+	 * tree for the partition.
+	 */
+	if (gp_enable_window_segment_tree &&
+		(node->frameOptions & FRAMEOPTION_ROWS) &&
+		!(node->frameOptions & FRAMEOPTION_START_UNBOUNDED_PRECEDING))
+	{
+		for (aggno = 0; aggno < winstate->numaggs; aggno++)
+		{
+			WindowStatePerAgg peraggstate = &winstate->peragg[aggno];
+
+			if (!OidIsValid(peraggstate->combinefn_oid))
+				continue;
+
+			Assert(peraggstate->aggcontext == winstate->aggcontext);
+			peraggstate->use_segtree = true;
+			peraggstate->aggcontext =
+				AllocSetContextCreate(CurrentMemoryContext,
+									  "WindowAgg_AggregateSegmentTree",
+									  ALLOCSET_DEFAULT_MINSIZE,
+									  ALLOCSET_DEFAULT_INITSIZE,
+									  ALLOCSET_DEFAULT_MAXSIZE);
+		}
+	}
+
 	winstate->all_first = true;
 	winstate->partition_spooled = false;
 	winstate->more_partitions = false;
@@ -2490,11 +2975,13 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	AclResult	aclresult;
 	Oid			transfn_oid,
 				invtransfn_oid,
-				finalfn_oid;
+				finalfn_oid,
+				combinefn_oid;
 	bool		finalextra;
 	Expr	   *transfnexpr,
 			   *invtransfnexpr,
-			   *finalfnexpr;
+			   *finalfnexpr,
+			   *combinefnexpr;
 	Datum		textInitVal;
 	int			i;
 	ListCell   *lc;
@@ -2544,6 +3031,20 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		initvalAttNo = Anum_pg_aggregate_agginitval;
 	}
 
+	/*
+	 * Without an inverse transition function, a sliding frame can still be
+	 * evaluated efficiently with a segment tree if the aggregate can combine
+	 * transition values.  As for moving aggregates, volatile arguments rule
+	 * that out, since the tree evaluates them only once per row.  We can't
+	 * copy internal transition values around, so those are out too.
+	 */
+	if (!OidIsValid(invtransfn_oid) &&
+		aggtranstype != INTERNALOID &&
+		!contain_volatile_functions((Node *) wfunc))
+		peraggstate->combinefn_oid = combinefn_oid = aggform->aggcombinefn;
+	else
+		peraggstate->combinefn_oid = combinefn_oid = InvalidOid;
+
 	/*
 	 * ExecInitWindowAgg already checked permission to call aggregate function
 	 * ... but we still need to check the component functions
@@ -2585,6 +3086,15 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 				aclcheck_error(aclresult, ACL_KIND_PROC,
 							   get_func_name(finalfn_oid));
 		}
+
+		if (OidIsValid(combinefn_oid))
+		{
+			aclresult = pg_proc_aclcheck(combinefn_oid, aggOwner,
+										 ACL_EXECUTE);
+			if (aclresult != ACLCHECK_OK)
+				aclcheck_error(aclresult, ACL_KIND_PROC,
+							   get_func_name(combinefn_oid));
+		}
 	}
 
 	/* Detect how many arguments to pass to the finalfn */
@@ -2611,11 +3121,11 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							transfn_oid,
 							invtransfn_oid,
 							finalfn_oid,
-							InvalidOid,             /* prelim */
+							combinefn_oid,
 							&transfnexpr,
 							&invtransfnexpr,
 							&finalfnexpr,
-							NULL);
+							&combinefnexpr);
 
 	/* set up infrastructure for calling the transfn(s) and finalfn */
 	fmgr_info(transfn_oid, &peraggstate->transfn);
@@ -2633,6 +3143,12 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		fmgr_info_set_expr((Node *) finalfnexpr, &peraggstate->finalfn);
 	}
 
+	if (OidIsValid(combinefn_oid))
+	{
+		fmgr_info(combinefn_oid, &peraggstate->combinefn);
+		fmgr_info_set_expr((Node *) combinefnexpr, &peraggstate->combinefn);
+	}
+
 	/* get info about relevant datatypes */
 	get_typlenbyval(wfunc->wintype,
 					&peraggstate->resulttypeLen,
@@ -200,6 +200,84 @@ test__destroy_agg_hash_table__check_for_leaks(void **state)
 	assert_true(aggState.hhashtable == NULL);
 }
 
+/* ==================== expand_hash_slots ==================== */
+/*
+ * Test that expanding the open-addressing layout keeps every entry
+ * reachable by probing from the slot its hash value maps to, and that the
+ * iterator returns every entry once.
+ */
+void
+test__expand_hash_slots__entries_reachable(void **state)
+{
+	AggState aggState;
+	HashAggTable *ht;
+	HashAggEntry *entries;
+	HashAggEntry *entry;
+	int nentries = 40;
+	int nfound = 0;
+	int i;
+
+	MemSet(&aggState, 0, sizeof(aggState));
+	aggState.aggcontext =
+		AllocSetContextCreate(TopMemoryContext,
+							  "AggContext",
+							  ALLOCSET_DEFAULT_MINSIZE,
+							  ALLOCSET_DEFAULT_INITSIZE,
+							  ALLOCSET_DEFAULT_MAXSIZE);
+
+	ht = MemoryContextAllocZero(aggState.aggcontext, sizeof(HashAggTable));
+	aggState.hhashtable = ht;
+	ht->entry_cxt = aggState.aggcontext;
+	ht->group_buf = mpool_create(ht->entry_cxt, "GroupsAndAggs Context");
+	ht->open_addressing = true;
+	ht->expandable = true;
+	ht->nbuckets = 64;
+	ht->slots = MemoryContextAllocZero(aggState.aggcontext,
+									   ht->nbuckets * sizeof(HashAggSlot));
+	ht->max_mem = 1024.0 * 1024.0;
+	ht->mem_for_metadata = ht->nbuckets * OVERHEAD_PER_SLOT + 1;
+
+	/* Every other entry maps to slot 0, so the probe sequences overlap */
+	entries = MemoryContextAllocZero(aggState.aggcontext,
+									 nentries * sizeof(HashAggEntry));
+	for (i = 0; i < nentries; i++)
+	{
+		HashAggSlot *slot;
+
+		entries[i].hashvalue = (i % 2 == 0) ? i * 64 : i;
+		entries[i].is_primodial = true;
+
+		slot = find_free_slot(ht, entries[i].hashvalue);
+		slot->entry = &entries[i];
+		slot->hashvalue = entries[i].hashvalue;
+		ht->num_entries++;
+	}
+
+	expand_hash_slots(&aggState);
+
+	assert_int_equal(ht->nbuckets, 128);
+	assert_int_equal(ht->num_expansions, 1);
+
+	for (i = 0; i < nentries; i++)
+	{
+		unsigned idx = BUCKET_IDX(ht, entries[i].hashvalue);
+
+		while (ht->slots[idx].entry != NULL &&
+			   ht->slots[idx].entry != &entries[i])
+			idx = (idx + 1) & (ht->nbuckets - 1);
+
+		assert_true(ht->slots[idx].entry == &entries[i]);
+		assert_int_equal(ht->slots[idx].hashvalue, entries[i].hashvalue);
+	}
+
+	init_agg_hash_iter(ht);
+	while ((entry = agg_hash_iter(&aggState)) != NULL)
+		nfound++;
+	assert_int_equal(nfound, nentries);
+
+	MemoryContextDelete(aggState.aggcontext);
+}
+
 /* ==================== main ==================== */
 int
 main(int argc, char* argv[])
@@ -209,7 +287,8 @@ main(int argc, char* argv[])
 	const UnitTest tests[] = {
 		unit_test(test__getSpillFile__Initialize_wfile_success),
 		unit_test(test__getSpillFile__Initialize_wfile_exception),
-		unit_test(test__destroy_agg_hash_table__check_for_leaks)
+		unit_test(test__destroy_agg_hash_table__check_for_leaks),
+		unit_test(test__expand_hash_slots__entries_reachable)
 	};
 
 	MemoryContextInit();
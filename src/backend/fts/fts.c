@@ -502,6 +502,9 @@ void FtsLoop()
 	while (!shutdown_requested)
 	{
 		bool		has_mirrors;
+		bool		probe_all;
+		bool		probed = false;
+		int			sleep_secs;
 
 		/* no need to live on if postmaster has died */
 		if (!PostmasterIsAlive())
@@ -532,6 +535,12 @@ void FtsLoop()
 		/* close the transaction we started above */
 		CommitTransactionCommand();
 
+		/*
+		 * With gp_fts_probe_spread, only the segments due for a probe are
+		 * probed, unless a probe was requested.
+		 */
+		probe_all = !gp_fts_probe_spread || probe_requested;
+
 		/* Reset this as we are performing the probe */
 		probe_requested = false;
 		skipFtsProbe = false;
@@ -551,7 +560,7 @@ void FtsLoop()
 		{
 			elogif(gp_log_fts == GPVARS_VERBOSITY_DEBUG, LOG,
 				   "FTS: starting %s scan with %d segments and %d contents",
-				   (probe_requested ? "full " : ""),
+				   (probe_all ? "full " : ""),
 				   cdbs->total_segment_dbs,
 				   cdbs->total_segments);
 			/*
@@ -560,7 +569,8 @@ void FtsLoop()
 			 */
 			oldContext = MemoryContextSwitchTo(probeContext);
 
-			updated_probe_state = FtsWalRepMessageSegments(cdbs);
+			updated_probe_state = FtsWalRepMessageSegments(cdbs, probe_all);
+			probed = true;
 
 			MemoryContextSwitchTo(oldContext);
 
@@ -572,15 +582,30 @@ void FtsLoop()
 			if (updated_probe_state)
 				ftsProbeInfo->fts_statusVersion++;
 		}
-		/* Notify any waiting backends about probe cycle completion. */
-		ftsProbeInfo->probeTick++;
+		/*
+		 * Notify any waiting backends about probe cycle completion.  Only a
+		 * cycle that probed every segment counts: FtsNotifyProber waits for
+		 * the segment it found down to be probed, and a cycle that only
+		 * probed the segments due may have left it out.
+		 */
+		if (probe_all)
+			ftsProbeInfo->probeTick++;
 
-		/* check if we need to sleep before starting next iteration */
+		/*
+		 * Check if we need to sleep before starting next iteration.  Probes
+		 * spread over the interval wake us up when the next segment is due,
+		 * but not more often than every second.
+		 */
 		elapsed = time(NULL) - probe_start_time;
-		if (elapsed < gp_fts_probe_interval && !shutdown_requested)
+		if (gp_fts_probe_spread && probed)
+			sleep_secs = Max(1, Min(FtsWalRepNextProbeTime() - time(NULL),
+									gp_fts_probe_interval));
+		else
+			sleep_secs = gp_fts_probe_interval - elapsed;
+		if (sleep_secs > 0 && !shutdown_requested)
 		{
 			if (!probe_requested)
-				pg_usleep((gp_fts_probe_interval - elapsed) * USECS_PER_SEC);
+				pg_usleep(sleep_secs * USECS_PER_SEC);
 
 			CHECK_FOR_INTERRUPTS();
 		}
@@ -30,10 +30,20 @@
 #include "postmaster/ftsprobe.h"
 #include "postmaster/postmaster.h"
 #include "utils/snapmgr.h"
+#include "utils/timestamp.h"
 
 
 static struct pollfd *PollFds;
 
+/*
+ * Whether the current probe cycle probes every primary-mirror pair, or only
+ * those whose next probe time has come (see gp_fts_probe_spread).
+ */
+static bool ftsProbeAll = true;
+
+/* Earliest next probe time of the pairs seen in the last probe cycle */
+static pg_time_t ftsNextProbeTime = 0;
+
 static CdbComponentDatabaseInfo *
 FtsGetPeerSegment(CdbComponentDatabases *cdbs,
 				  int content, int dbid)
@@ -193,6 +203,8 @@ ftsConnectStart(fts_segment_info *ftsInfo)
 	 * Start the timer.
 	 */
 	ftsInfo->startTime = (pg_time_t) time(NULL);
+	if (ftsInfo->state == FTS_PROBE_SEGMENT && ftsInfo->probeStartTime == 0)
+		ftsInfo->probeStartTime = GetCurrentTimestamp();
 
 	return true;
 }
@@ -272,6 +284,14 @@ static void
 ftsConnect(fts_context *context)
 {
 	int i;
+	int inflight = 0;
+
+	for (i = 0; i < context->num_pairs; i++)
+	{
+		if (context->perSegInfos[i].conn != NULL)
+			inflight++;
+	}
+
 	for (i = 0; i < context->num_pairs; i++)
 	{
 		fts_segment_info *ftsInfo = &context->perSegInfos[i];
@@ -298,8 +318,16 @@ ftsConnect(fts_context *context)
 				{
 					AssertImply(ftsInfo->retry_count > 0,
 								ftsInfo->retry_count <= gp_fts_probe_retries);
+					/*
+					 * Leave the segment waiting until a connection in flight
+					 * is done with, if there are as many as allowed.
+					 */
+					if (gp_fts_probe_max_concurrency > 0 &&
+						inflight >= gp_fts_probe_max_concurrency)
+						break;
 					if (!ftsConnectStart(ftsInfo))
 						ftsInfo->state = nextFailedState(ftsInfo->state);
+					inflight++;
 				}
 				else if (ftsInfo->poll_revents & (POLLOUT | POLLIN))
 				{
@@ -403,6 +431,7 @@ ftsCheckTimeout(fts_segment_info *ftsInfo, pg_time_t now)
 			 ftsInfo->primary_cdbinfo->dbid, ftsInfo->state,
 			 ftsInfo->retry_count);
 		ftsInfo->state = nextFailedState(ftsInfo->state);
+		ftsInfo->timedOut = true;
 	}
 }
 
@@ -943,6 +972,115 @@ updateConfiguration(CdbComponentDatabaseInfo *primary,
 	return UpdateNeeded;
 }
 
+/*
+ * Probe statistics of the pair of the given content, or NULL if FTS keeps
+ * none for it.
+ */
+static volatile FtsProbeStats *
+ftsGetProbeStats(int16 segindex)
+{
+	if (ftsProbeStats == NULL || segindex < 0 ||
+		segindex >= ftsNumProbeStats)
+		return NULL;
+	return &ftsProbeStats[segindex];
+}
+
+static void
+ftsNoteNextProbeTime(pg_time_t nextProbeTime)
+{
+	if (ftsNextProbeTime == 0 || nextProbeTime < ftsNextProbeTime)
+		ftsNextProbeTime = nextProbeTime;
+}
+
+/*
+ * Is the pair whose primary is given to be probed in this probe cycle?  A
+ * pair never probed before, or whose primary changed since it was last
+ * probed, always is.
+ */
+static bool
+ftsProbeIsDue(CdbComponentDatabaseInfo *primary, pg_time_t now)
+{
+	volatile FtsProbeStats *stats = ftsGetProbeStats(primary->segindex);
+
+	if (ftsProbeAll || stats == NULL || stats->dbid != primary->dbid)
+		return true;
+	if (stats->nextProbeTime <= now)
+		return true;
+
+	ftsNoteNextProbeTime(stats->nextProbeTime);
+	return false;
+}
+
+/*
+ * Record the outcome of a probe, and schedule the next probe of the pair.
+ *
+ * A probe that timed out, needed retries or failed halves the probe interval
+ * of the pair, down to a second, so that a segment going bad is acted upon
+ * sooner; each clean probe doubles it back, up to gp_fts_probe_interval.  At
+ * the full interval, a pair is probed at an offset into the interval given by
+ * its content id, so that the probes of a large cluster are spread over the
+ * interval instead of all being sent at once.
+ */
+static void
+ftsRecordProbe(fts_segment_info *ftsInfo)
+{
+	CdbComponentDatabaseInfo *primary = ftsInfo->primary_cdbinfo;
+	volatile FtsProbeStats *stats = ftsGetProbeStats(primary->segindex);
+	pg_time_t	now = (pg_time_t) time(NULL);
+	pg_time_t	next;
+	int			interval;
+
+	if (stats == NULL)
+		return;
+
+	if (stats->dbid != primary->dbid)
+	{
+		stats->dbid = primary->dbid;
+		stats->interval = gp_fts_probe_interval;
+		stats->troubled = 0;
+	}
+
+	interval = Min(stats->interval, gp_fts_probe_interval);
+	if (ftsInfo->timedOut || ftsInfo->retry_count > 0 ||
+		ftsInfo->state == FTS_PROBE_FAILED)
+	{
+		interval = Max(interval / 2, 1);
+		stats->troubled++;
+		stats->troubledProbes++;
+	}
+	else
+	{
+		interval = Min(interval * 2, gp_fts_probe_interval);
+		stats->troubled = 0;
+	}
+
+	if (ftsInfo->probeStartTime != 0)
+	{
+		long		secs;
+		int			usecs;
+
+		TimestampDifference(ftsInfo->probeStartTime, GetCurrentTimestamp(),
+							&secs, &usecs);
+		stats->lastLatency = secs * 1000 + usecs / 1000;
+	}
+
+	next = now + interval;
+	if (interval == gp_fts_probe_interval)
+		next -= (next - primary->segindex) % interval;
+
+	stats->interval = interval;
+	stats->lastProbeTime = now;
+	stats->nextProbeTime = next;
+	stats->probes++;
+
+	ftsNoteNextProbeTime(next);
+
+	elogif(gp_log_fts == GPVARS_VERBOSITY_DEBUG, LOG,
+		   "FTS: probe of (content=%d, dbid=%d) took %d ms, next probe in %d s",
+		   primary->segindex, primary->dbid, stats->lastLatency,
+		   (int) (next - now));
+}
+
 /*
  * Process resonses from primary segments:
  * (a) Transition internal state so that segments can be messaged subsequently
@@ -975,6 +1113,10 @@ processResponse(fts_context *context)
 
 		CdbComponentDatabaseInfo *mirror = ftsInfo->mirror_cdbinfo;
 
+		if (ftsInfo->state == FTS_PROBE_SUCCESS ||
+			ftsInfo->state == FTS_PROBE_FAILED)
+			ftsRecordProbe(ftsInfo);
+
 		bool IsPrimaryAlive = ftsInfo->result.isPrimaryAlive;
 		/* Trust a response from primary only if it's alive. */
 		bool IsMirrorAlive =  IsPrimaryAlive ?
@@ -1163,6 +1305,8 @@ processResponse(fts_context *context)
 		ftsInfo->conn = NULL;
 		ftsInfo->poll_events = ftsInfo->poll_revents = 0;
 		ftsInfo->retry_count = 0;
+		ftsInfo->timedOut = false;
+		ftsInfo->probeStartTime = 0;
 	}
 
 	return is_updated;
@@ -1184,11 +1328,15 @@ FtsIsSegmentAlive(CdbComponentDatabaseInfo *segInfo)
 
 /*
  * Initialize context before a probe cycle based on cluster configuration in
- * cdbs.
+ * cdbs.  Unless every pair is to be probed, pairs whose next probe time has
+ * not come yet are left out.
  */
 static void
 FtsWalRepInitProbeContext(CdbComponentDatabases *cdbs, fts_context *context)
 {
+	pg_time_t now = (pg_time_t) time(NULL);
+
+	ftsNextProbeTime = 0;
 	context->num_pairs = cdbs->total_segments;
 	context->perSegInfos = (fts_segment_info *) palloc0(
 		context->num_pairs * sizeof(fts_segment_info));
@@ -1212,6 +1360,12 @@ FtsWalRepInitProbeContext(CdbComponentDatabases *cdbs, fts_context *context)
 			continue;
 		}
 
+		if (!ftsProbeIsDue(primary, now))
+		{
+			context->num_pairs--;
+			continue;
+		}
+
 		/* primary in catalog will NEVER be marked down. */
 		Assert(FtsIsSegmentAlive(primary));
 
@@ -1248,12 +1402,18 @@ InitPollFds(size_t size)
 	PollFds = (struct pollfd *) palloc0(size * sizeof(struct pollfd));
 }
 
+/*
+ * Run a probe cycle: probe every primary-mirror pair, or only those due for a
+ * probe, and act upon the responses.  Returns true if the configuration was
+ * updated.
+ */
 bool
-FtsWalRepMessageSegments(CdbComponentDatabases *cdbs)
+FtsWalRepMessageSegments(CdbComponentDatabases *cdbs, bool probeAll)
 {
 	bool is_updated = false;
 	fts_context context;
 
+	ftsProbeAll = probeAll;
 	FtsWalRepInitProbeContext(cdbs, &context);
 	InitPollFds(cdbs->total_segments);
 
@@ -1300,4 +1460,14 @@ FtsWalRepMessageSegments(CdbComponentDatabases *cdbs)
 	return is_updated;
 }
 
+/*
+ * Earliest time a pair seen in the last probe cycle is due to be probed
+ * again, or 0 if not known.
+ */
+pg_time_t
+FtsWalRepNextProbeTime(void)
+{
+	return ftsNextProbeTime;
+}
+
 /* EOF */
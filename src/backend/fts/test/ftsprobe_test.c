@@ -283,6 +283,43 @@ test_ftsConnect_one_failure_one_success(void **state)
 	assert_true(failure_resp->state == FTS_PROBE_FAILED);
 }
 
+/*
+ * Two primary segments, with at most one probe in flight.  Only the first one
+ * gets connected to; the other waits for its turn.
+ */
+void
+test_ftsConnect_max_concurrency(void **state)
+{
+	CdbComponentDatabases *cdbs = InitTestCdb(
+		2, true, GP_SEGMENT_CONFIGURATION_MODE_INSYNC);
+	fts_context context;
+	FtsWalRepInitProbeContext(cdbs, &context);
+	char primary_conninfo[1024];
+	fts_segment_info *first = &context.perSegInfos[0];
+	fts_segment_info *second = &context.perSegInfos[1];
+
+	gp_fts_probe_max_concurrency = 1;
+
+	PGconn *pgconn = palloc(sizeof(PGconn));
+	pgconn->status = CONNECTION_STARTED;
+	pgconn->sock = 11;
+	snprintf(primary_conninfo, 1024, "host=%s port=%d gpconntype=%s",
+			 first->primary_cdbinfo->hostip, first->primary_cdbinfo->port,
+			 GPCONN_TYPE_FTS);
+	expect_string(PQconnectStart, conninfo, primary_conninfo);
+	will_return(PQconnectStart, pgconn);
+
+	ftsConnect(&context);
+
+	assert_true(first->conn == pgconn);
+	assert_true(first->poll_events & POLLOUT);
+	assert_true(second->conn == NULL);
+	assert_true(second->state == FTS_PROBE_SEGMENT);
+	assert_true(second->poll_events == 0);
+
+	gp_fts_probe_max_concurrency = 0;
+}
+
 /*
  * Starting with one content (primary-mirrror pair) in FTS_PROBE_SEGMENT, test
  * ftsConnect() followed by ftsPoll().
@@ -1328,6 +1365,61 @@ test_probeTimeout(void **state)
 	assert_true(context.perSegInfos[0].retry_count == 0);
 }
 
+/*
+ * A probe that timed out halves the probe interval of the pair, a clean probe
+ * doubles it back.  A pair whose next probe time has not come is left out of
+ * the probe cycle, unless every pair is to be probed.
+ */
+void
+test_ftsRecordProbe_adaptive_interval(void **state)
+{
+	static FtsProbeStats stats[1];
+	CdbComponentDatabases *cdbs = InitTestCdb(
+		1, true, GP_SEGMENT_CONFIGURATION_MODE_INSYNC);
+	fts_context context;
+	fts_segment_info *ftsInfo;
+	pg_time_t now = (pg_time_t) time(NULL);
+
+	ftsProbeStats = stats;
+	ftsNumProbeStats = 1;
+	FtsWalRepInitProbeContext(cdbs, &context);
+	ftsInfo = &context.perSegInfos[0];
+
+	ftsInfo->state = FTS_PROBE_SUCCESS;
+	ftsInfo->timedOut = true;
+	ftsRecordProbe(ftsInfo);
+
+	assert_int_equal(stats[0].dbid, ftsInfo->primary_cdbinfo->dbid);
+	assert_int_equal(stats[0].interval, gp_fts_probe_interval / 2);
+	assert_int_equal(stats[0].troubled, 1);
+	assert_true(stats[0].nextProbeTime >= now + gp_fts_probe_interval / 2);
+
+	ftsInfo->timedOut = false;
+	ftsRecordProbe(ftsInfo);
+
+	assert_int_equal(stats[0].interval, gp_fts_probe_interval);
+	assert_int_equal(stats[0].troubled, 0);
+	assert_int_equal(stats[0].probes, 2);
+	assert_int_equal(stats[0].troubledProbes, 1);
+	assert_true(stats[0].nextProbeTime > now);
+	assert_true(stats[0].nextProbeTime <= time(NULL) + gp_fts_probe_interval);
+
+	/* Not due yet */
+	ftsProbeAll = false;
+	FtsWalRepInitProbeContext(cdbs, &context);
+	assert_int_equal(context.num_pairs, 0);
+	assert_true(FtsWalRepNextProbeTime() == stats[0].nextProbeTime);
+
+	/* Due */
+	stats[0].nextProbeTime = now;
+	FtsWalRepInitProbeContext(cdbs, &context);
+	assert_int_equal(context.num_pairs, 1);
+
+	ftsProbeAll = true;
+	ftsProbeStats = NULL;
+	ftsNumProbeStats = 0;
+}
+
 void
 test_FtsWalRepInitProbeContext_initial_state(void **state)
 {
@@ -1363,6 +1455,7 @@ main(int argc, char* argv[])
 	const UnitTest tests[] = {
 		unit_test(test_ftsConnect_FTS_PROBE_SEGMENT),
 		unit_test(test_ftsConnect_one_failure_one_success),
+		unit_test(test_ftsConnect_max_concurrency),
 		unit_test(test_ftsConnect_ftsPoll),
 		unit_test(test_ftsSend_success),
 		unit_test(test_ftsReceive_success),
@@ -1390,6 +1483,7 @@ main(int argc, char* argv[])
 		unit_test(test_PrimaryUpMirrorDownNotInSync_to_PrimayUpMirrorDownNotInSync),
 		unit_test(test_PrimaryUpMirrorDownNotInSync_to_PrimaryDown),
 		unit_test(test_probeTimeout),
+		unit_test(test_ftsRecordProbe_adaptive_interval),
 		/*-----------------------------------------------------------------------*/
 		unit_test(test_FtsWalRepInitProbeContext_initial_state)
 	};
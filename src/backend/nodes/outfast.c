@@ -177,6 +177,15 @@
 
 static void _outNode(StringInfo str, void *obj);
 
+/*
+ * When serializing a plan for the QEs of a single slice, the Motions whose
+ * subtrees are written out, and the subplans that are.  Everything else is
+ * written as NULL.  See nodeToBinaryStringFastForSlice.
+ */
+static bool pruneForSlice = false;
+static Bitmapset *keepMotions = NULL;
+static Bitmapset *keepSubplans = NULL;
+
 static void
 _outList(StringInfo str, List *node)
 {
@@ -300,7 +309,11 @@ _outPlanInfo(StringInfo str, const Plan *node)
 
 	WRITE_NODE_FIELD(sliceTable);
 
-    WRITE_NODE_FIELD(lefttree);
+	if (pruneForSlice && IsA(node, Motion) &&
+		!bms_is_member(((Motion *) node)->motionID, keepMotions))
+		_outNode(str, NULL);
+	else
+		WRITE_NODE_FIELD(lefttree);
     WRITE_NODE_FIELD(righttree);
     WRITE_NODE_FIELD(initPlan);
 
@@ -340,7 +353,21 @@ _outPlannedStmt(StringInfo str, PlannedStmt *node)
 	WRITE_NODE_FIELD(rtable);
 	WRITE_NODE_FIELD(resultRelations);
 	WRITE_NODE_FIELD(utilityStmt);
-	WRITE_NODE_FIELD(subplans);
+	if (pruneForSlice && node->subplans != NIL)
+	{
+		int16		tg = T_List;
+		int			length = list_length(node->subplans);
+		ListCell   *lc;
+		int			i = 0;
+
+		/* keep the list as long, so that plan_ids still line up */
+		appendBinaryStringInfo(str, (const char *) &tg, sizeof(int16));
+		appendBinaryStringInfo(str, (const char *) &length, sizeof(int));
+		foreach(lc, node->subplans)
+			_outNode(str, bms_is_member(i++, keepSubplans) ? lfirst(lc) : NULL);
+	}
+	else
+		WRITE_NODE_FIELD(subplans);
 	WRITE_BITMAPSET_FIELD(rewindPlanIDs);
 
 	WRITE_NODE_FIELD(result_partitions);
@@ -2311,3 +2338,36 @@ nodeToBinaryStringFast(void *obj, int *length)
 	*length = str.len;
 	return str.data;
 }
+
+/*
+ * nodeToBinaryStringFastForSlice -
+ *	   like nodeToBinaryStringFast, for a PlannedStmt to be executed by the
+ *	   QEs of one slice.  Only the subtrees of the Motions in 'motions', and
+ *	   the subplans (by plan_id - 1) in 'subplans' are written out; the
+ *	   QEs leave the rest alone anyway, with execute_pruned_plan.
+ */
+char *
+nodeToBinaryStringFastForSlice(PlannedStmt *stmt, int *length,
+							   Bitmapset *motions, Bitmapset *subplans)
+{
+	char	   *result;
+
+	Assert(!pruneForSlice);
+
+	pruneForSlice = true;
+	keepMotions = motions;
+	keepSubplans = subplans;
+	PG_TRY();
+	{
+		result = nodeToBinaryStringFast(stmt, length);
+	}
+	PG_CATCH();
+	{
+		pruneForSlice = false;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	pruneForSlice = false;
+
+	return result;
+}
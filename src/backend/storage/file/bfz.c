@@ -32,6 +32,9 @@ static const struct{
 {
     {{"none", "false", "no", "off", "0", 0}, bfz_nothing_init},
     {{"zlib", 0}, bfz_zlib_init},
+#ifdef HAVE_LIBLZ4
+    {{"lz4", 0}, bfz_lz4_init},
+#endif
     {{0}}
 };
 
@@ -60,14 +63,17 @@ bfz_compression_to_string(int index)
 
 /*
  * Compute a checksum for a given char array.
+ *
+ * Also called by the asynchronous I/O helper thread, so it must not look at
+ * any GUCs itself.
  */
-static BFZ_CHECKSUM_TYPE
-compute_checksum(const char *buffer, uint32 size)
+BFZ_CHECKSUM_TYPE
+bfz_compute_checksum(const char *buffer, uint32 size, int bytes_to_checksum)
 {
 	BFZ_CHECKSUM_TYPE crc = 0;
 	/*
-	 * We only checksum the first gp_workfile_bytes_to_checksum bytes
-	 * in every BFZ_CHECKSUM_SECTOR_SIZE bytes.
+	 * We only checksum the first bytes_to_checksum bytes in every
+	 * BFZ_CHECKSUM_SECTOR_SIZE bytes.
 	 */
 	uint32 currSectorBegin = 0;
 	
@@ -76,8 +82,7 @@ compute_checksum(const char *buffer, uint32 size)
 	while (currSectorBegin < size)
 	{
 		COMP_CRC32C(crc, buffer + currSectorBegin,
-				   Min(size - currSectorBegin,
-					   gp_workfile_bytes_to_checksum));
+				   Min(size - currSectorBegin, bytes_to_checksum));
 		currSectorBegin += BFZ_CHECKSUM_SECTOR_SIZE;
 	}
 
@@ -101,6 +106,11 @@ compute_checksum(const char *buffer, uint32 size)
  * If computing a checksum for the block is requested, this function
  * computes the checksum for the content in the buffer and stores
  * it at the end of the buffer.
+ *
+ * If the file does asynchronous I/O, the buffer is handed to the helper
+ * thread instead, which computes the checksum and compresses and writes the
+ * buffer while we go on filling the next one. If isLast is true, this waits
+ * for all the writes to finish.
  */
 static void
 write_bfz_buffer(bfz_t *bfz, bool isLast)
@@ -114,13 +124,14 @@ write_bfz_buffer(bfz_t *bfz, bool isLast)
 	
 	fs->tot_bytes += fs->buffer_pointer - fs->buffer + BFZ_CHECKSUM_SIZE(bfz->has_checksum);
 
-	if (bfz->has_checksum)
+	if (bfz->has_checksum && bfz->async_file < 0)
 	{
 		BFZ_CHECKSUM_TYPE crc;
 
 		Assert(fs->buffer_pointer - fs->buffer >= 0);
-		crc =
-			compute_checksum(fs->buffer, fs->buffer_pointer - fs->buffer);
+		crc = bfz_compute_checksum(fs->buffer,
+								   fs->buffer_pointer - fs->buffer,
+								   gp_workfile_bytes_to_checksum);
 		
 		memcpy(fs->buffer_pointer, &crc, sizeof(BFZ_CHECKSUM_TYPE));
 		fs->buffer_pointer += sizeof(BFZ_CHECKSUM_TYPE);
@@ -128,7 +139,14 @@ write_bfz_buffer(bfz_t *bfz, bool isLast)
 	
 	PG_TRY();
 	{
-		fs->write_ex(bfz, fs->buffer, fs->buffer_pointer - fs->buffer);
+		if (bfz->async_file >= 0)
+		{
+			bfz_async_write(bfz, fs->buffer, fs->buffer_pointer - fs->buffer);
+			if (isLast)
+				bfz_async_finish_writes(bfz);
+		}
+		else
+			fs->write_ex(bfz, fs->buffer, fs->buffer_pointer - fs->buffer);
 	}
 	PG_CATCH();
 	{
@@ -160,6 +178,22 @@ read_bfz_buffer(bfz_t *bfz, char *buffer)
 	int bytesRead = 0;
 	struct bfz_freeable_stuff *fs = bfz->freeable_stuff;
 	int dataSize = 0;
+
+	/*
+	 * With asynchronous I/O, the helper thread has usually read and checked
+	 * the block already. If anything went wrong, it's read again the
+	 * regular way below, to report the error.
+	 */
+	if (bfz->async_file >= 0)
+	{
+		dataSize = bfz_async_read(bfz, buffer);
+		if (dataSize >= 0)
+		{
+			if (dataSize > 0)
+				bfz->blockNo++;
+			return dataSize;
+		}
+	}
 	
 	bytesRead = fs->read_ex(bfz, buffer, sizeof(fs->buffer));
 	Assert(bytesRead <= sizeof(fs->buffer));
@@ -181,7 +215,8 @@ read_bfz_buffer(bfz_t *bfz, char *buffer)
 		 * Verify the stored checksum for this block with the computed
 		 * value.
 		 */
-		crc = compute_checksum(buffer, dataSize);
+		crc = bfz_compute_checksum(buffer, dataSize,
+								   gp_workfile_bytes_to_checksum);
 		memcpy(&storedCrc, buffer + dataSize, sizeof(BFZ_CHECKSUM_TYPE));
 
 		if (!BFZ_CHECKSUM_EQ(crc,storedCrc))
@@ -245,6 +280,7 @@ bfz_create_internal(const char *fileName, bool open_existing,
 
 	bfz_handle = palloc0(sizeof(bfz_t));
 	bfz_handle->filename = pstrdup(fileName);
+	bfz_handle->async_file = -1;
 
 	bfz_handle->file = OpenNamedTemporaryFile(bfz_handle->filename,
 											  !open_existing,
@@ -302,6 +338,9 @@ bfz_create_internal(const char *fileName, bool open_existing,
 	fs->buffer_pointer = fs->buffer;
 	fs->buffer_end = fs->buffer + sizeof(fs->buffer) - BFZ_CHECKSUM_SIZE(bfz_handle->has_checksum);
 
+	if (!open_existing && gp_workfile_async_io)
+		bfz_async_start(bfz_handle);
+
 	return bfz_handle;
 }
 
@@ -312,6 +351,8 @@ bfz_create_internal(const char *fileName, bool open_existing,
 void
 bfz_close(bfz_t *thiz)
 {
+	if (thiz->async_file >= 0)
+		bfz_async_stop(thiz);
 	if (thiz->freeable_stuff)
 	{
 		thiz->freeable_stuff->close_ex(thiz);
@@ -348,6 +389,8 @@ bfz_append_end(bfz_t * thiz)
 	if (WorkfileDiskspace_IsFull())
 	{
 		elog(gp_workfile_caching_loglevel, "closing workfile while workfile diskspace full, skipping flush");
+		if (thiz->async_file >= 0)
+			bfz_async_stop(thiz);
 	}
 	else
 	{
@@ -404,6 +447,9 @@ bfz_scan_begin(bfz_t * thiz)
 	fs->tot_bytes = 0L;
 
 	MemoryContextSwitchTo(oldcxt);
+
+	if (thiz->async_file >= 0 || gp_workfile_async_io)
+		bfz_async_begin_read(thiz);
 }
 
 void
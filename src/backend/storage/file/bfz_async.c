@@ -0,0 +1,842 @@
+/*-------------------------------------------------------------------------
+ *
+ * bfz_async.c
+ *	  Asynchronous I/O for bfz work files, on a helper thread.
+ *
+ * Without this, a spilling hash join or hash aggregate stops every time a
+ * bfz buffer fills up, to checksum, compress and write it, and every time it
+ * has read a buffer's worth of tuples back, to read, decompress and check
+ * the next one. With gp_workfile_async_io, a helper thread does that work
+ * instead:
+ *
+ * - When a buffer fills up, it is copied to a slot and queued. The helper
+ *   checksums and compresses it and writes it at the end of the file, while
+ *   the operator goes on filling the next buffer. Writes of a file are done
+ *   in the order they were queued, and the offset to write at is kept by the
+ *   helper, so compressed buffers of unknown size can be queued back to back.
+ *   The backend only waits when all slots are busy, and when it is done
+ *   appending to the file.
+ *
+ * - When a file is read, the helper reads, decompresses and checks the next
+ *   buffer into a slot while the operator consumes the current one. The
+ *   first buffer is read ahead as soon as the scan of the file begins, which
+ *   is when a hash join or hash aggregate starts on a new batch.
+ *
+ * The helper never allocates backend memory, elogs or touches the bfz: it
+ * only runs the compression algorithm's threadsafe_encode and
+ * threadsafe_read callbacks on the slot it was handed, on a dup() of the
+ * file's descriptor, because the VFD layer may close the descriptor itself
+ * at any time. Write errors are recorded for the backend to report at the
+ * next write or at the end of the file. A read that fails for any reason is
+ * done again through the regular path, so that the usual error is raised.
+ *
+ * Files only support asynchronous I/O if their compression algorithm
+ * provides the callbacks, which zlib doesn't, as it compresses the file as
+ * one stream.
+ *
+ * The helper is created by the first file that asks for it, and lives until
+ * the backend exits. Slots and per-file state live in TopMemoryContext; bfz
+ * files don't outlive the transaction, so it is all reset at transaction end,
+ * after waiting for the helper to finish what it is doing.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/storage/file/bfz_async.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "access/xact.h"
+#include "cdb/cdbgang.h"
+#include "cdb/cdbvars.h"
+#include "miscadmin.h"
+#include "storage/bfz.h"
+#include "utils/memutils.h"
+
+/* Number of buffers that can be in flight, over all files of the backend */
+#define BFZ_ASYNC_SLOTS			8
+
+/* Number of files that can do asynchronous I/O at the same time */
+#define BFZ_ASYNC_MAX_FILES		1024
+
+/* How long to wait for the helper before checking for interrupts, in ms */
+#define BFZ_ASYNC_WAIT_TIMEOUT	100
+
+typedef enum BfzAsyncSlotState
+{
+	BFZ_SLOT_FREE,
+	BFZ_SLOT_QUEUED,
+	BFZ_SLOT_RUNNING,
+	BFZ_SLOT_DONE				/* a read, waiting for its file to take it */
+} BfzAsyncSlotState;
+
+/*
+ * A file doing asynchronous I/O.
+ */
+typedef struct BfzAsyncFile
+{
+	bool		inuse;
+	uint32		generation;		/* bumped when the entry is released */
+
+	/* Writes; maintained by the helper while nwrites > 0 */
+	off_t		write_offset;
+	int			write_errno;	/* first write error, or 0 */
+	int			nwrites;		/* queued or running */
+
+	/* Reads; only touched by the backend */
+	off_t		read_offset;
+	int			readahead;		/* slot reading the next buffer, or -1 */
+} BfzAsyncFile;
+
+/*
+ * One buffer to write or read. The backend fills in everything the helper
+ * needs before queuing the slot, so that the helper looks at nothing else.
+ */
+typedef struct BfzAsyncSlot
+{
+	BfzAsyncSlotState state;
+	uint64		seq;			/* slots are run in the order queued */
+	bool		write;
+	bool		discard;		/* nobody wants this read anymore */
+	int			file;			/* index into async_files */
+	int			fd;				/* closed by whoever runs the slot */
+	off_t		offset;
+	bool		has_checksum;
+	int			bytes_to_checksum;
+	int			(*encode) (const char *src, int size, char *dst);
+	int			(*read) (int fd, off_t offset, char *dst, char *scratch,
+									 int *stored);
+
+	/*
+	 * Length of the buffer in 'data'. After a read, -1 if it failed; after a
+	 * write, the bytes written to the file are in 'stored', and 'err' has the
+	 * errno if that failed.
+	 */
+	int			len;
+	int			stored;
+	int			err;
+
+	char		data[BFZ_BUFFER_SIZE];
+	char		scratch[BFZ_ENCODED_BUFFER_SIZE];
+} BfzAsyncSlot;
+
+/*
+ * State shared with the helper, protected by async_mutex.
+ */
+static pthread_mutex_t async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_work_cv = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t async_done_cv = PTHREAD_COND_INITIALIZER;
+
+static BfzAsyncSlot *async_slots = NULL;
+static BfzAsyncFile *async_files = NULL;
+static uint64 async_next_seq = 0;
+
+/* Only touched by the backend */
+static pthread_t async_thread;
+static bool async_thread_started = false;
+static bool async_thread_failed = false;
+static int	async_next_file = 0;
+
+static void bfz_async_xact_callback(XactEvent event, void *arg);
+
+/* ----------------------------------------------------------------
+ *		Helper thread
+ * ----------------------------------------------------------------
+ */
+
+static void
+run_write(BfzAsyncSlot *slot)
+{
+	char	   *buf = slot->data;
+	int			len = slot->len;
+	int			done = 0;
+
+	if (slot->has_checksum)
+	{
+		pg_crc32	crc = bfz_compute_checksum(slot->data, len,
+											   slot->bytes_to_checksum);
+
+		memcpy(slot->data + len, &crc, sizeof(crc));
+		len += sizeof(crc);
+	}
+
+	if (slot->encode)
+	{
+		len = slot->encode(slot->data, len, slot->scratch);
+		buf = slot->scratch;
+	}
+
+	slot->err = 0;
+	while (done < len)
+	{
+		ssize_t		n = pwrite(slot->fd, buf + done, len - done,
+							   slot->offset + done);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			slot->err = (n < 0) ? errno : ENOSPC;
+			break;
+		}
+		done += n;
+	}
+	slot->stored = done;
+}
+
+static void
+run_read(BfzAsyncSlot *slot)
+{
+	int			len;
+
+	len = slot->read(slot->fd, slot->offset, slot->data, slot->scratch,
+					 &slot->stored);
+
+	if (len > 0 && slot->has_checksum)
+	{
+		pg_crc32	crc;
+		pg_crc32	storedCrc;
+
+		if (len < sizeof(pg_crc32))
+			len = -1;
+		else
+		{
+			len -= sizeof(pg_crc32);
+			crc = bfz_compute_checksum(slot->data, len,
+									   slot->bytes_to_checksum);
+			memcpy(&storedCrc, slot->data + len, sizeof(pg_crc32));
+			if (!EQ_CRC32C(crc, storedCrc))
+				len = -1;
+		}
+	}
+
+	slot->len = len;
+}
+
+/*
+ * The queued slot that was queued first, or NULL.
+ *
+ * Called with async_mutex held.
+ */
+static BfzAsyncSlot *
+next_queued_slot(void)
+{
+	BfzAsyncSlot *next = NULL;
+	int			i;
+
+	for (i = 0; i < BFZ_ASYNC_SLOTS; i++)
+	{
+		BfzAsyncSlot *slot = &async_slots[i];
+
+		if (slot->state == BFZ_SLOT_QUEUED &&
+			(next == NULL || slot->seq < next->seq))
+			next = slot;
+	}
+
+	return next;
+}
+
+static void *
+bfz_async_thread_main(void *arg)
+{
+	gp_set_thread_sigmasks();
+
+	pthread_mutex_lock(&async_mutex);
+	for (;;)
+	{
+		BfzAsyncSlot *slot = next_queued_slot();
+		BfzAsyncFile *file;
+
+		if (slot == NULL)
+		{
+			pthread_cond_wait(&async_work_cv, &async_mutex);
+			continue;
+		}
+
+		file = &async_files[slot->file];
+		slot->state = BFZ_SLOT_RUNNING;
+
+		if (slot->write)
+		{
+			/* Once a write has failed, don't bother with the rest */
+			if (file->write_errno == 0)
+			{
+				slot->offset = file->write_offset;
+				pthread_mutex_unlock(&async_mutex);
+				run_write(slot);
+				close(slot->fd);
+				pthread_mutex_lock(&async_mutex);
+
+				file->write_offset += slot->stored;
+				if (slot->err != 0 && file->write_errno == 0)
+					file->write_errno = slot->err;
+			}
+			else
+				close(slot->fd);
+
+			file->nwrites--;
+			slot->state = BFZ_SLOT_FREE;
+		}
+		else
+		{
+			pthread_mutex_unlock(&async_mutex);
+			run_read(slot);
+			close(slot->fd);
+			pthread_mutex_lock(&async_mutex);
+
+			slot->state = slot->discard ? BFZ_SLOT_FREE : BFZ_SLOT_DONE;
+		}
+
+		pthread_cond_broadcast(&async_done_cv);
+	}
+
+	/* not reached */
+	pthread_mutex_unlock(&async_mutex);
+	return NULL;
+}
+
+/* ----------------------------------------------------------------
+ *		Backend side
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Start the helper thread, if it isn't running yet. Returns false if it
+ * can't be started.
+ */
+static bool
+start_thread(void)
+{
+	int			pthread_err;
+
+	if (async_thread_started)
+		return true;
+	if (async_thread_failed)
+		return false;
+
+	if (async_slots == NULL)
+	{
+		async_slots = MemoryContextAllocZero(TopMemoryContext,
+											 BFZ_ASYNC_SLOTS * sizeof(BfzAsyncSlot));
+		async_files = MemoryContextAllocZero(TopMemoryContext,
+											 BFZ_ASYNC_MAX_FILES * sizeof(BfzAsyncFile));
+		RegisterXactCallback(bfz_async_xact_callback, NULL);
+	}
+
+	pthread_err = gp_pthread_create(&async_thread, bfz_async_thread_main,
+									NULL, "start_thread");
+	if (pthread_err != 0)
+	{
+		elog(LOG, "could not create workfile I/O thread: error code %d",
+			 pthread_err);
+		async_thread_failed = true;
+		return false;
+	}
+
+	async_thread_started = true;
+	return true;
+}
+
+/*
+ * The file's asynchronous I/O state, or NULL if it was reset at the end of
+ * the transaction.
+ */
+static BfzAsyncFile *
+get_file(bfz_t *thiz)
+{
+	BfzAsyncFile *file;
+
+	Assert(thiz->async_file >= 0 && thiz->async_file < BFZ_ASYNC_MAX_FILES);
+
+	file = &async_files[thiz->async_file];
+	if (!file->inuse || file->generation != thiz->async_generation)
+		return NULL;
+
+	return file;
+}
+
+/*
+ * Wait for the helper to finish a slot, or for a while, counting the time
+ * against the file we're waiting for. Callers check again for what they're
+ * waiting for, in a loop.
+ *
+ * Interrupts are checked for with async_mutex let go of, so that an ERROR
+ * doesn't leave it locked; whatever the helper is still doing is sorted out
+ * at transaction end.
+ *
+ * Called with async_mutex held.
+ */
+static void
+wait_for_thread(bfz_t *thiz)
+{
+	instr_time	start;
+	instr_time	elapsed;
+	struct timeval now;
+	struct timespec abstime;
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	gettimeofday(&now, NULL);
+	abstime.tv_sec = now.tv_sec;
+	abstime.tv_nsec = (now.tv_usec + BFZ_ASYNC_WAIT_TIMEOUT * 1000L) * 1000L;
+	abstime.tv_sec += abstime.tv_nsec / 1000000000L;
+	abstime.tv_nsec %= 1000000000L;
+
+	pthread_cond_timedwait(&async_done_cv, &async_mutex, &abstime);
+
+	pthread_mutex_unlock(&async_mutex);
+	CHECK_FOR_INTERRUPTS();
+	pthread_mutex_lock(&async_mutex);
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start);
+
+	if (thiz)
+		INSTR_TIME_ADD(thiz->io_wait, elapsed);
+}
+
+/*
+ * Find a free slot. If 'wait' is true and there is none, take one that holds
+ * a buffer read ahead for some file, or else wait for the helper to free one.
+ *
+ * Called with async_mutex held.
+ */
+static BfzAsyncSlot *
+get_free_slot(bfz_t *thiz, bool wait)
+{
+	for (;;)
+	{
+		BfzAsyncSlot *oldest_done = NULL;
+		int			i;
+
+		for (i = 0; i < BFZ_ASYNC_SLOTS; i++)
+		{
+			BfzAsyncSlot *slot = &async_slots[i];
+
+			if (slot->state == BFZ_SLOT_FREE)
+				return slot;
+			if (slot->state == BFZ_SLOT_DONE &&
+				(oldest_done == NULL || slot->seq < oldest_done->seq))
+				oldest_done = slot;
+		}
+
+		if (!wait)
+			return NULL;
+
+		/* The file will read the buffer itself when it gets to it */
+		if (oldest_done)
+		{
+			async_files[oldest_done->file].readahead = -1;
+			oldest_done->state = BFZ_SLOT_FREE;
+			return oldest_done;
+		}
+
+		wait_for_thread(thiz);
+	}
+}
+
+/*
+ * Hand a filled in slot to the helper.
+ *
+ * Called with async_mutex held.
+ */
+static void
+queue_slot(BfzAsyncSlot *slot)
+{
+	slot->seq = async_next_seq++;
+	slot->state = BFZ_SLOT_QUEUED;
+	pthread_cond_signal(&async_work_cv);
+}
+
+static int
+dup_file(bfz_t *thiz)
+{
+	int			fd = FileDup(thiz->file);
+
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not duplicate descriptor of temporary file %s: %m",
+						thiz->filename)));
+
+	return fd;
+}
+
+/*
+ * Forget about the buffer read ahead for a file, if any.
+ *
+ * Called with async_mutex held.
+ */
+static void
+cancel_readahead(BfzAsyncFile *file)
+{
+	BfzAsyncSlot *slot;
+
+	if (file->readahead < 0)
+		return;
+
+	slot = &async_slots[file->readahead];
+	file->readahead = -1;
+
+	switch (slot->state)
+	{
+		case BFZ_SLOT_QUEUED:
+			close(slot->fd);
+			slot->state = BFZ_SLOT_FREE;
+			break;
+		case BFZ_SLOT_RUNNING:
+			slot->discard = true;
+			break;
+		case BFZ_SLOT_DONE:
+			slot->state = BFZ_SLOT_FREE;
+			break;
+		case BFZ_SLOT_FREE:
+			Assert(false);
+			break;
+	}
+}
+
+/*
+ * Queue a read of the file's next buffer. Unless 'wait' is true, this does
+ * nothing if all slots are busy.
+ */
+static void
+start_readahead(bfz_t *thiz, BfzAsyncFile *file, bool wait)
+{
+	struct bfz_freeable_stuff *fs = thiz->freeable_stuff;
+	BfzAsyncSlot *slot;
+
+	Assert(file->readahead < 0);
+
+	pthread_mutex_lock(&async_mutex);
+	slot = get_free_slot(thiz, wait);
+	pthread_mutex_unlock(&async_mutex);
+
+	if (slot == NULL)
+		return;
+
+	/* Only the backend hands out free slots, so this one stays ours */
+	slot->write = false;
+	slot->discard = false;
+	slot->file = thiz->async_file;
+	slot->fd = dup_file(thiz);
+	slot->offset = file->read_offset;
+	slot->has_checksum = thiz->has_checksum;
+	slot->bytes_to_checksum = gp_workfile_bytes_to_checksum;
+	slot->encode = NULL;
+	slot->read = fs->threadsafe_read;
+
+	pthread_mutex_lock(&async_mutex);
+	queue_slot(slot);
+	file->readahead = slot - async_slots;
+	pthread_mutex_unlock(&async_mutex);
+}
+
+/*
+ * Make a file do asynchronous I/O from now on, if its compression algorithm
+ * supports it and the helper thread is available.
+ */
+void
+bfz_async_start(bfz_t *thiz)
+{
+	struct bfz_freeable_stuff *fs = thiz->freeable_stuff;
+	int			i;
+
+	Assert(thiz->async_file < 0);
+
+	if (fs == NULL || fs->threadsafe_read == NULL)
+		return;
+
+	if (!start_thread())
+		return;
+
+	for (i = 0; i < BFZ_ASYNC_MAX_FILES; i++)
+	{
+		int			n = (async_next_file + i) % BFZ_ASYNC_MAX_FILES;
+		BfzAsyncFile *file = &async_files[n];
+
+		if (file->inuse)
+			continue;
+
+		pthread_mutex_lock(&async_mutex);
+		file->inuse = true;
+		file->write_offset = 0;
+		file->write_errno = 0;
+		file->nwrites = 0;
+		file->read_offset = 0;
+		file->readahead = -1;
+		pthread_mutex_unlock(&async_mutex);
+
+		thiz->async_file = n;
+		thiz->async_generation = file->generation;
+		async_next_file = (n + 1) % BFZ_ASYNC_MAX_FILES;
+		return;
+	}
+
+	/* Too many files already, this one is read and written synchronously */
+}
+
+/*
+ * Queue a full buffer to be written at the end of the file. The checksum is
+ * left for the helper to append; it must have room for it after 'size'
+ * bytes.
+ *
+ * Errors of earlier writes of the file are reported here.
+ */
+void
+bfz_async_write(bfz_t *thiz, const char *buffer, int size)
+{
+	struct bfz_freeable_stuff *fs = thiz->freeable_stuff;
+	BfzAsyncFile *file = get_file(thiz);
+	BfzAsyncSlot *slot;
+	off_t		written;
+	int			err;
+
+	if (file == NULL)
+		elog(ERROR, "temporary file %s lost its asynchronous I/O state",
+			 thiz->filename);
+
+	Assert(size + (thiz->has_checksum ? sizeof(pg_crc32) : 0) <= BFZ_BUFFER_SIZE);
+
+	pthread_mutex_lock(&async_mutex);
+	err = file->write_errno;
+	written = file->write_offset;
+	slot = (err == 0) ? get_free_slot(thiz, true) : NULL;
+	pthread_mutex_unlock(&async_mutex);
+
+	if (err != 0)
+	{
+		errno = err;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to temporary file: %m")));
+	}
+
+	FileAccountWrite(thiz->file, written);
+
+	slot->write = true;
+	slot->discard = false;
+	slot->file = thiz->async_file;
+	slot->fd = dup_file(thiz);
+	slot->has_checksum = thiz->has_checksum;
+	slot->bytes_to_checksum = gp_workfile_bytes_to_checksum;
+	slot->encode = fs->threadsafe_encode;
+	slot->read = NULL;
+	slot->len = size;
+	memcpy(slot->data, buffer, size);
+
+	pthread_mutex_lock(&async_mutex);
+	file->nwrites++;
+	queue_slot(slot);
+	pthread_mutex_unlock(&async_mutex);
+}
+
+/*
+ * Wait for all queued writes of the file, and report any error.
+ */
+void
+bfz_async_finish_writes(bfz_t *thiz)
+{
+	BfzAsyncFile *file = get_file(thiz);
+	off_t		written;
+	int			err;
+
+	if (file == NULL)
+		return;
+
+	pthread_mutex_lock(&async_mutex);
+	while (file->nwrites > 0)
+		wait_for_thread(thiz);
+	err = file->write_errno;
+	written = file->write_offset;
+	pthread_mutex_unlock(&async_mutex);
+
+	if (err != 0)
+	{
+		errno = err;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to temporary file: %m")));
+	}
+
+	FileAccountWrite(thiz->file, written);
+
+	/* Let whatever comes next find the file where we left it */
+	if (FileSeek(thiz->file, written, SEEK_SET) < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in temporary file: %m")));
+}
+
+/*
+ * Start reading the file from the beginning, and read its first buffer
+ * ahead.
+ */
+void
+bfz_async_begin_read(bfz_t *thiz)
+{
+	BfzAsyncFile *file;
+
+	if (thiz->async_file < 0)
+		bfz_async_start(thiz);
+	if (thiz->async_file < 0)
+		return;
+
+	file = get_file(thiz);
+	if (file == NULL)
+	{
+		thiz->async_file = -1;
+		return;
+	}
+
+	pthread_mutex_lock(&async_mutex);
+	Assert(file->nwrites == 0);
+	cancel_readahead(file);
+	pthread_mutex_unlock(&async_mutex);
+
+	file->read_offset = 0;
+	start_readahead(thiz, file, false);
+}
+
+/*
+ * Read the file's next buffer, without the checksum, into 'buffer' of
+ * BFZ_BUFFER_SIZE bytes, and read the one after it ahead. Returns the
+ * length of the buffer, 0 at the end of the file, or -1 if the buffer must
+ * be read the regular way; then the file does synchronous I/O from now on.
+ */
+int
+bfz_async_read(bfz_t *thiz, char *buffer)
+{
+	BfzAsyncFile *file = get_file(thiz);
+	BfzAsyncSlot *slot;
+	int			len;
+
+	if (file == NULL)
+		elog(ERROR, "temporary file %s lost its asynchronous I/O state",
+			 thiz->filename);
+
+	if (file->readahead < 0)
+		start_readahead(thiz, file, true);
+	slot = &async_slots[file->readahead];
+
+	pthread_mutex_lock(&async_mutex);
+	while (slot->state != BFZ_SLOT_DONE)
+		wait_for_thread(thiz);
+	file->readahead = -1;
+	pthread_mutex_unlock(&async_mutex);
+
+	len = slot->len;
+	if (len > 0)
+		memcpy(buffer, slot->data, len);
+	if (len >= 0)
+		file->read_offset += slot->stored;
+
+	pthread_mutex_lock(&async_mutex);
+	slot->state = BFZ_SLOT_FREE;
+	pthread_mutex_unlock(&async_mutex);
+
+	if (len < 0)
+	{
+		if (FileSeek(thiz->file, file->read_offset, SEEK_SET) < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in temporary file: %m")));
+		bfz_async_stop(thiz);
+		return -1;
+	}
+
+	if (len > 0)
+		start_readahead(thiz, file, false);
+
+	return len;
+}
+
+/*
+ * Stop asynchronous I/O on a file, waiting for its writes.
+ */
+void
+bfz_async_stop(bfz_t *thiz)
+{
+	BfzAsyncFile *file = get_file(thiz);
+
+	if (file != NULL)
+	{
+		pthread_mutex_lock(&async_mutex);
+		cancel_readahead(file);
+		while (file->nwrites > 0)
+			wait_for_thread(thiz);
+		file->inuse = false;
+		file->generation++;
+		pthread_mutex_unlock(&async_mutex);
+	}
+
+	thiz->async_file = -1;
+}
+
+/*
+ * At the end of the transaction, all bfz files are gone. Wait for the helper
+ * to finish what it is doing, and forget about everything else.
+ */
+static void
+bfz_async_xact_callback(XactEvent event, void *arg)
+{
+	bool		running;
+	int			i;
+
+	if (event != XACT_EVENT_COMMIT &&
+		event != XACT_EVENT_ABORT &&
+		event != XACT_EVENT_PREPARE)
+		return;
+
+	if (!async_thread_started)
+		return;
+
+	pthread_mutex_lock(&async_mutex);
+	do
+	{
+		running = false;
+		for (i = 0; i < BFZ_ASYNC_SLOTS; i++)
+		{
+			BfzAsyncSlot *slot = &async_slots[i];
+
+			if (slot->state == BFZ_SLOT_QUEUED)
+			{
+				close(slot->fd);
+				if (slot->write)
+					async_files[slot->file].nwrites--;
+				slot->state = BFZ_SLOT_FREE;
+			}
+			else if (slot->state == BFZ_SLOT_RUNNING)
+			{
+				slot->discard = true;
+				running = true;
+			}
+			else if (slot->state == BFZ_SLOT_DONE)
+				slot->state = BFZ_SLOT_FREE;
+		}
+
+		if (running)
+			wait_for_thread(NULL);
+	} while (running);
+
+	for (i = 0; i < BFZ_ASYNC_MAX_FILES; i++)
+	{
+		BfzAsyncFile *file = &async_files[i];
+
+		if (file->inuse)
+		{
+			Assert(file->nwrites == 0);
+			file->inuse = false;
+			file->generation++;
+		}
+	}
+	pthread_mutex_unlock(&async_mutex);
+}
@@ -0,0 +1,352 @@
+/* compress_lz4.c */
+#include "postgres.h"
+
+#include <unistd.h>
+
+#include "storage/bfz.h"
+#include "utils/memutils.h"
+
+#ifdef HAVE_LIBLZ4
+
+#include <lz4.h>
+
+/*
+ * This file implements bfz compression algorithm "lz4".
+ *
+ * Unlike zlib, LZ4 has no streaming mode that we want to depend on, so every
+ * buffer handed to write_ex is compressed independently and written out as a
+ * frame:
+ *
+ *     int32 rawLen | int32 storedLen | storedLen bytes of data
+ *
+ * If compressing a buffer doesn't save any space, the buffer is stored as is,
+ * and storedLen equals rawLen.  bfz always writes at most BFZ_BUFFER_SIZE
+ * bytes at a time, so a frame never decompresses to more than that.
+ */
+
+typedef struct bfz_lz4_frame_header
+{
+	int32		rawLen;
+	int32		storedLen;
+} bfz_lz4_frame_header;
+
+#define LZ4_FRAME_BOUND	LZ4_COMPRESSBOUND(BFZ_BUFFER_SIZE)
+
+struct bfz_lz4_freeable_stuff
+{
+	struct bfz_freeable_stuff super;
+
+	/* true if compressing, false if decompressing */
+	bool		compressing;
+
+	/* decompressed data of the current frame, not yet returned to caller */
+	char	   *pending;
+	int			pendingLen;
+
+	/* compressed frame data */
+	char		cbuf[LZ4_FRAME_BOUND];
+	/* decompressed frame data */
+	char		rbuf[BFZ_BUFFER_SIZE];
+};
+
+static void
+bfz_lz4_file_write(bfz_t *thiz, const char *buffer, int size)
+{
+	while (size > 0)
+	{
+		int			n = FileWrite(thiz->file, (char *) buffer, size);
+
+		if (n < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file: %m")));
+		buffer += n;
+		size -= n;
+	}
+}
+
+/*
+ * Read exactly size bytes from the underlying file. Returns false on a clean
+ * end-of-file before any byte was read.
+ */
+static bool
+bfz_lz4_file_read(bfz_t *thiz, char *buffer, int size)
+{
+	int			done = 0;
+
+	while (done < size)
+	{
+		int			n = FileRead(thiz->file, buffer + done, size - done);
+
+		if (n < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from temporary file: %m")));
+		if (n == 0)
+		{
+			if (done == 0)
+				return false;
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("unexpected end of temporary file")));
+		}
+		done += n;
+	}
+
+	return true;
+}
+
+/*
+ * bfz_lz4_close_ex
+ *	Free up buffers. Does not close the underlying file!
+ */
+static void
+bfz_lz4_close_ex(bfz_t *thiz)
+{
+	if (thiz->freeable_stuff != NULL)
+	{
+		pfree(thiz->freeable_stuff);
+		thiz->freeable_stuff = NULL;
+	}
+}
+
+/*
+ * bfz_lz4_write_ex
+ *	 Compress a buffer and write it out as one frame.
+ */
+static void
+bfz_lz4_write_ex(bfz_t *thiz, const char *buffer, int size)
+{
+	struct bfz_lz4_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	bfz_lz4_frame_header hdr;
+	int			compressedLen;
+
+	Assert(fs->compressing);
+	Assert(size <= BFZ_BUFFER_SIZE);
+
+	compressedLen = LZ4_compress_default(buffer, fs->cbuf, size,
+										 sizeof(fs->cbuf));
+
+	hdr.rawLen = size;
+	if (compressedLen > 0 && compressedLen < size)
+	{
+		hdr.storedLen = compressedLen;
+		bfz_lz4_file_write(thiz, (char *) &hdr, sizeof(hdr));
+		bfz_lz4_file_write(thiz, fs->cbuf, compressedLen);
+	}
+	else
+	{
+		hdr.storedLen = size;
+		bfz_lz4_file_write(thiz, (char *) &hdr, sizeof(hdr));
+		bfz_lz4_file_write(thiz, buffer, size);
+	}
+}
+
+/*
+ * bfz_lz4_read_next_frame
+ *	Read and decompress the next frame into fs->rbuf.
+ *
+ * Returns false at the end of the file.
+ */
+static bool
+bfz_lz4_read_next_frame(bfz_t *thiz, struct bfz_lz4_freeable_stuff *fs)
+{
+	bfz_lz4_frame_header hdr;
+
+	if (!bfz_lz4_file_read(thiz, (char *) &hdr, sizeof(hdr)))
+		return false;
+
+	if (hdr.rawLen < 0 || hdr.rawLen > BFZ_BUFFER_SIZE ||
+		hdr.storedLen < 0 || hdr.storedLen > hdr.rawLen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("invalid lz4 frame in temporary file"),
+				 errdetail("raw length %d, stored length %d",
+						   hdr.rawLen, hdr.storedLen)));
+
+	if (hdr.storedLen == hdr.rawLen)
+	{
+		bfz_lz4_file_read(thiz, fs->rbuf, hdr.rawLen);
+	}
+	else
+	{
+		int			n;
+
+		bfz_lz4_file_read(thiz, fs->cbuf, hdr.storedLen);
+		n = LZ4_decompress_safe(fs->cbuf, fs->rbuf, hdr.storedLen,
+								sizeof(fs->rbuf));
+		if (n != hdr.rawLen)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("could not uncompress data from temporary file")));
+	}
+
+	fs->pending = fs->rbuf;
+	fs->pendingLen = hdr.rawLen;
+
+	return true;
+}
+
+/*
+ * bfz_lz4_read_ex
+ *	Read data from an already opened compressed file.
+ *
+ * The buffer is filled completely, unless the end of file is reached.
+ */
+static int
+bfz_lz4_read_ex(bfz_t *thiz, char *buffer, int size)
+{
+	struct bfz_lz4_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	int			done = 0;
+
+	Assert(!fs->compressing);
+
+	while (done < size)
+	{
+		int			n;
+
+		if (fs->pendingLen == 0 && !bfz_lz4_read_next_frame(thiz, fs))
+			break;
+
+		n = Min(size - done, fs->pendingLen);
+		memcpy(buffer + done, fs->pending, n);
+		fs->pending += n;
+		fs->pendingLen -= n;
+		done += n;
+	}
+
+	return done;
+}
+
+/*
+ * Read exactly size bytes at offset of a kernel file descriptor, for the
+ * asynchronous I/O helper. Returns the number of bytes read, which is less
+ * only at the end of the file, or -1 on error.
+ */
+static int
+bfz_lz4_pread(int fd, off_t offset, char *buffer, int size)
+{
+	int			done = 0;
+
+	while (done < size)
+	{
+		ssize_t		n = pread(fd, buffer + done, size - done, offset + done);
+
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (n == 0)
+			break;
+		done += n;
+	}
+
+	return done;
+}
+
+/*
+ * Compress a buffer into one frame, for asynchronous I/O; see
+ * threadsafe_encode in bfz.h. The frame is the same bfz_lz4_write_ex writes.
+ */
+static int
+bfz_lz4_threadsafe_encode(const char *src, int size, char *dst)
+{
+	bfz_lz4_frame_header hdr;
+	int			compressedLen;
+
+	/* Only keep the compressed data if it's smaller */
+	compressedLen = 0;
+	if (size > 1)
+		compressedLen = LZ4_compress_default(src, dst + sizeof(hdr), size,
+											 size - 1);
+
+	hdr.rawLen = size;
+	if (compressedLen > 0)
+		hdr.storedLen = compressedLen;
+	else
+	{
+		hdr.storedLen = size;
+		memcpy(dst + sizeof(hdr), src, size);
+	}
+	memcpy(dst, &hdr, sizeof(hdr));
+
+	return sizeof(hdr) + hdr.storedLen;
+}
+
+/*
+ * Read and decompress the frame at offset, for asynchronous I/O; see
+ * threadsafe_read in bfz.h.
+ */
+static int
+bfz_lz4_threadsafe_read(int fd, off_t offset, char *dst, char *scratch,
+						int *stored)
+{
+	bfz_lz4_frame_header hdr;
+	int			n;
+
+	n = bfz_lz4_pread(fd, offset, (char *) &hdr, sizeof(hdr));
+	if (n == 0)
+	{
+		*stored = 0;
+		return 0;
+	}
+	if (n != sizeof(hdr) ||
+		hdr.rawLen < 0 || hdr.rawLen > BFZ_BUFFER_SIZE ||
+		hdr.storedLen < 0 || hdr.storedLen > hdr.rawLen)
+		return -1;
+
+	if (hdr.storedLen == hdr.rawLen)
+	{
+		if (bfz_lz4_pread(fd, offset + sizeof(hdr), dst, hdr.rawLen) != hdr.rawLen)
+			return -1;
+	}
+	else
+	{
+		if (bfz_lz4_pread(fd, offset + sizeof(hdr), scratch, hdr.storedLen) != hdr.storedLen)
+			return -1;
+		if (LZ4_decompress_safe(scratch, dst, hdr.storedLen, BFZ_BUFFER_SIZE) != hdr.rawLen)
+			return -1;
+	}
+
+	*stored = sizeof(hdr) + hdr.storedLen;
+	return hdr.rawLen;
+}
+
+/*
+ * bfz_lz4_init
+ *	Initialize the lz4 subsystem for a file.
+ *
+ *	The underlying file descriptor fd should already be opened
+ *	and valid. Memory is allocated in the current memory context.
+ */
+void
+bfz_lz4_init(bfz_t *thiz)
+{
+	struct bfz_lz4_freeable_stuff *fs = palloc(sizeof *fs);
+
+	fs->compressing = (thiz->mode == BFZ_MODE_APPEND);
+	fs->pending = fs->rbuf;
+	fs->pendingLen = 0;
+
+	thiz->freeable_stuff = &fs->super;
+	fs->super.read_ex = bfz_lz4_read_ex;
+	fs->super.write_ex = bfz_lz4_write_ex;
+	fs->super.close_ex = bfz_lz4_close_ex;
+	fs->super.threadsafe_encode = bfz_lz4_threadsafe_encode;
+	fs->super.threadsafe_read = bfz_lz4_threadsafe_read;
+}
+
+#else							/* HAVE_LIBLZ4 */
+
+void
+bfz_lz4_init(bfz_t *thiz)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("LZ4 library is not supported by this build"),
+			 errhint("Compile with --with-lz4 to use LZ4 compression.")));
+}
+
+#endif							/* HAVE_LIBLZ4 */
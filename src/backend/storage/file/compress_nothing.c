@@ -2,6 +2,8 @@
 
 #include "postgres.h"
 
+#include <unistd.h>
+
 #include <storage/bfz.h>
 #include <storage/fd.h>
 
@@ -58,6 +60,36 @@ bfz_nothing_write_ex(bfz_t * bfz, const char *buffer, int size)
 	}
 }
 
+/*
+ * Read a buffer for asynchronous I/O; see threadsafe_read in bfz.h. Every
+ * buffer but the last one fills BFZ_BUFFER_SIZE bytes of the file.
+ */
+static int
+bfz_nothing_threadsafe_read(int fd, off_t offset, char *dst, char *scratch,
+							int *stored)
+{
+	int			done = 0;
+
+	while (done < BFZ_BUFFER_SIZE)
+	{
+		ssize_t		i = pread(fd, dst + done, BFZ_BUFFER_SIZE - done,
+							  offset + done);
+
+		if (i < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (i == 0)
+			break;
+		done += i;
+	}
+
+	*stored = done;
+	return done;
+}
+
 void
 bfz_nothing_init(bfz_t * thiz)
 {
@@ -68,4 +100,6 @@ bfz_nothing_init(bfz_t * thiz)
 	fs->read_ex = bfz_nothing_read_ex;
 	fs->write_ex = bfz_nothing_write_ex;
 	fs->close_ex = bfz_nothing_close_ex;
+	fs->threadsafe_encode = NULL;
+	fs->threadsafe_read = bfz_nothing_threadsafe_read;
 }
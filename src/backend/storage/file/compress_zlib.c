@@ -291,4 +291,8 @@ bfz_zlib_init(bfz_t *thiz)
 	fs->super.read_ex = bfz_zlib_read_ex;
 	fs->super.write_ex = bfz_zlib_write_ex;
 	fs->super.close_ex = bfz_zlib_close_ex;
+
+	/* zlib streams over the whole file, so it can't do asynchronous I/O */
+	fs->super.threadsafe_encode = NULL;
+	fs->super.threadsafe_read = NULL;
 }
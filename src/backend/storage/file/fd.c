@@ -1388,6 +1388,75 @@ FilePrefetch(File file, off_t offset, int amount)
 #endif
 }
 
+/*
+ * FileDup - return a new kernel file descriptor for a file, which the
+ * caller must close() itself.
+ *
+ * This is for handing a file to code that can't go through the VFD layer,
+ * such as helper threads. The descriptor isn't counted against
+ * max_safe_fds, so don't keep many of them around. Like BasicOpenFile, we
+ * close other files to make room if needed. Returns -1 on failure, with
+ * errno set.
+ */
+int
+FileDup(File file)
+{
+	int			fd;
+
+	Assert(FileIsValid(file));
+
+tryAgain:
+	if (FileAccess(file) < 0)
+		return -1;
+
+	fd = dup(VfdCache[file].fd);
+	if (fd >= 0)
+		return fd;
+
+	/* Don't release our own file, it's the most recently used */
+	if ((errno == EMFILE || errno == ENFILE) && nfile > 1)
+	{
+		int			save_errno = errno;
+
+		ereport(LOG,
+				(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+				 errmsg("out of file descriptors: %m; release and retry")));
+		errno = 0;
+		if (ReleaseLruFile())
+			goto tryAgain;
+		errno = save_errno;
+	}
+
+	return -1;
+}
+
+/*
+ * FileAccountWrite - account for data written to a temporary file through
+ * its kernel file descriptor, rather than FileWrite.
+ *
+ * newSize is the size the file has grown to. Like FileWrite, this throws an
+ * error if that exceeds temp_file_limit.
+ */
+void
+FileAccountWrite(File file, off_t newSize)
+{
+	Assert(FileIsValid(file));
+
+	if (!(VfdCache[file].fdstate & FD_TEMPORARY) ||
+		newSize <= VfdCache[file].fileSize)
+		return;
+
+	temporary_files_size += newSize - VfdCache[file].fileSize;
+	VfdCache[file].fileSize = newSize;
+
+	if (temp_file_limit >= 0 &&
+		temporary_files_size > (uint64) temp_file_limit * (uint64) 1024)
+		ereport(ERROR,
+				(errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
+				 errmsg("temporary file size exceeds temp_file_limit (%dkB)",
+						temp_file_limit)));
+}
+
 int
 FileRead(File file, char *buffer, int amount)
 {
@@ -0,0 +1,208 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../bfz_async.c"
+
+/* A full buffer, that takes BFZ_BUFFER_SIZE bytes in the file with its checksum */
+#define FULL_BUFFER		(BFZ_BUFFER_SIZE - sizeof(pg_crc32))
+
+static char path[MAXPGPATH];
+
+static void
+fill_buffer(char *buffer, int size, int seed)
+{
+	int			i;
+
+	for (i = 0; i < size; i++)
+		buffer[i] = (char) (i * 7 + seed);
+}
+
+/*
+ * Set up an uncompressed, checksummed bfz file, without going through
+ * bfz_create.
+ */
+static void
+setup_bfz(bfz_t *bfz)
+{
+	int			fd;
+
+	MemSet(bfz, 0, sizeof(*bfz));
+
+	snprintf(path, sizeof(path), "/tmp/bfz_async_test.XXXXXX");
+	fd = mkstemp(path);
+	assert_true(fd >= 0);
+	close(fd);
+
+	bfz->file = PathNameOpenFile(path, O_RDWR | PG_BINARY, 0600);
+	assert_true(bfz->file > 0);
+	bfz->filename = path;
+	bfz->mode = BFZ_MODE_APPEND;
+	bfz->has_checksum = true;
+	bfz->async_file = -1;
+	bfz_nothing_init(bfz);
+}
+
+static void
+teardown_bfz(bfz_t *bfz)
+{
+	if (bfz->async_file >= 0)
+		bfz_async_stop(bfz);
+	bfz->freeable_stuff->close_ex(bfz);
+	FileClose(bfz->file);
+	unlink(path);
+}
+
+static void
+assert_all_slots_free(void)
+{
+	int			i;
+
+	pthread_mutex_lock(&async_mutex);
+	for (i = 0; i < BFZ_ASYNC_SLOTS; i++)
+		assert_int_equal(async_slots[i].state, BFZ_SLOT_FREE);
+	pthread_mutex_unlock(&async_mutex);
+}
+
+/*
+ * Write more buffers than there are slots, so that the writer has to wait for
+ * the helper, and read them back.
+ */
+void
+test__bfz_async__write_read(void **state)
+{
+	bfz_t		bfz;
+	char		buffer[BFZ_BUFFER_SIZE];
+	char		expected[BFZ_BUFFER_SIZE];
+	int			nbuffers = BFZ_ASYNC_SLOTS * 3;
+	int			i;
+
+	setup_bfz(&bfz);
+
+	bfz_async_start(&bfz);
+	assert_true(bfz.async_file >= 0);
+
+	/* full buffers, and a short one at the end */
+	for (i = 0; i < nbuffers; i++)
+	{
+		fill_buffer(buffer, i < nbuffers - 1 ? FULL_BUFFER : 100, i);
+		bfz_async_write(&bfz, buffer, i < nbuffers - 1 ? FULL_BUFFER : 100);
+	}
+	bfz_async_finish_writes(&bfz);
+
+	/* Each buffer is followed by its checksum, and the file position is at the end */
+	assert_int_equal(FileSeek(bfz.file, 0, SEEK_CUR),
+					 (nbuffers - 1) * BFZ_BUFFER_SIZE + 100 + sizeof(pg_crc32));
+
+	bfz_async_begin_read(&bfz);
+	for (i = 0; i < nbuffers; i++)
+	{
+		int			size = i < nbuffers - 1 ? FULL_BUFFER : 100;
+
+		fill_buffer(expected, size, i);
+		assert_int_equal(bfz_async_read(&bfz, buffer), size);
+		assert_true(memcmp(buffer, expected, size) == 0);
+	}
+	assert_int_equal(bfz_async_read(&bfz, buffer), 0);
+	assert_true(bfz.async_file >= 0);
+
+	assert_all_slots_free();
+
+	teardown_bfz(&bfz);
+}
+
+/*
+ * A buffer that doesn't match its checksum is left to be read the regular
+ * way, which reports the error, and the file goes back to synchronous I/O.
+ */
+void
+test__bfz_async__checksum_mismatch(void **state)
+{
+	bfz_t		bfz;
+	char		buffer[BFZ_BUFFER_SIZE];
+	char		garbage = 'x';
+	int			fd;
+
+	setup_bfz(&bfz);
+
+	bfz_async_start(&bfz);
+	fill_buffer(buffer, FULL_BUFFER, 0);
+	bfz_async_write(&bfz, buffer, FULL_BUFFER);
+	fill_buffer(buffer, FULL_BUFFER, 1);
+	bfz_async_write(&bfz, buffer, FULL_BUFFER);
+	bfz_async_finish_writes(&bfz);
+
+	/* Overwrite a byte of the second buffer */
+	fd = FileDup(bfz.file);
+	assert_true(fd >= 0);
+	assert_int_equal(pwrite(fd, &garbage, 1, BFZ_BUFFER_SIZE + 10), 1);
+	close(fd);
+
+	bfz_async_begin_read(&bfz);
+	assert_int_equal(bfz_async_read(&bfz, buffer), FULL_BUFFER);
+	assert_int_equal(bfz_async_read(&bfz, buffer), -1);
+
+	/* The regular read picks up at the broken buffer */
+	assert_int_equal(bfz.async_file, -1);
+	assert_int_equal(FileSeek(bfz.file, 0, SEEK_CUR), BFZ_BUFFER_SIZE);
+
+	assert_all_slots_free();
+
+	teardown_bfz(&bfz);
+}
+
+/*
+ * At transaction end, queued work is dropped and the file's asynchronous I/O
+ * state is forgotten.
+ */
+void
+test__bfz_async__xact_end(void **state)
+{
+	bfz_t		bfz;
+	char		buffer[BFZ_BUFFER_SIZE];
+	int			i;
+
+	setup_bfz(&bfz);
+
+	bfz_async_start(&bfz);
+	assert_true(bfz.async_file >= 0);
+
+	for (i = 0; i < BFZ_ASYNC_SLOTS; i++)
+	{
+		fill_buffer(buffer, FULL_BUFFER, i);
+		bfz_async_write(&bfz, buffer, FULL_BUFFER);
+	}
+
+	bfz_async_xact_callback(XACT_EVENT_ABORT, NULL);
+
+	assert_true(get_file(&bfz) == NULL);
+	assert_all_slots_free();
+
+	/* The file can't be used asynchronously anymore */
+	bfz_async_stop(&bfz);
+	assert_int_equal(bfz.async_file, -1);
+
+	teardown_bfz(&bfz);
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__bfz_async__write_read),
+		unit_test(test__bfz_async__checksum_mismatch),
+		unit_test(test__bfz_async__xact_end)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -24,6 +24,7 @@
 #include "access/twophase.h"
 #include "access/distributedlog.h"
 #include "access/appendonlywriter.h"
+#include "access/appendonly_visimap_cache.h"
 #include "cdb/cdblocaldistribxact.h"
 #include "cdb/cdbvars.h"
 #include "commands/async.h"
@@ -56,6 +57,7 @@
 #include "postmaster/backoff.h"
 #include "cdb/memquota.h"
 #include "executor/instrument.h"
+#include "executor/nodeShareInputScan.h"
 #include "executor/spi.h"
 #include "utils/workfile_mgr.h"
 #include "utils/session_state.h"
@@ -129,6 +131,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, LockShmemSize());
 		size = add_size(size, PredicateLockShmemSize());
 		size = add_size(size, workfile_mgr_shmem_size());
+		size = add_size(size, WorkfileReuse_ShmemSize());
 		if (Gp_role == GP_ROLE_DISPATCH)
 			size = add_size(size, AppendOnlyWriterShmemSize());
 
@@ -160,6 +163,8 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, BTreeShmemSize());
 		size = add_size(size, SyncScanShmemSize());
 		size = add_size(size, AsyncShmemSize());
+		size = add_size(size, AppendOnlyVisimapCache_ShmemSize());
+		size = add_size(size, ShareInputChannel_ShmemSize());
 #ifdef EXEC_BACKEND
 		size = add_size(size, ShmemBackendArraySize());
 #endif
@@ -323,7 +328,10 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	BTreeShmemInit();
 	SyncScanShmemInit();
 	AsyncShmemInit();
+	AppendOnlyVisimapCache_ShmemInit();
+	ShareInputChannel_ShmemInit();
 	workfile_mgr_cache_init();
+	WorkfileReuse_ShmemInit();
 	BackendCancelShmemInit();
 
 	/*
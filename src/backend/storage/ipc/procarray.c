@@ -1539,7 +1539,7 @@ FillInDistributedSnapshot(Snapshot snapshot)
 				Assert(ds->xminAllDistributedSnapshots);
 				Assert(ds->xminAllDistributedSnapshots <= ds->xmin);
 
-				DistributedSnapshot_Copy(&snapshot->distribSnapshotWithLocalMapping.ds, ds);
+				DistributedSnapshotWithLocalMapping_Install(&snapshot->distribSnapshotWithLocalMapping, ds);
 			}
 			else
 			{
@@ -2041,6 +2041,10 @@ GetSnapshotData(Snapshot snapshot)
 					(TransactionId*)malloc(maxCount * sizeof(TransactionId));
 				if (snapshot->distribSnapshotWithLocalMapping.inProgressMappedLocalXids == NULL)
 					ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY), errmsg("out of memory")));
+				snapshot->distribSnapshotWithLocalMapping.inProgressMappedDistribXids =
+					(DistributedTransactionId*)malloc(maxCount * sizeof(DistributedTransactionId));
+				if (snapshot->distribSnapshotWithLocalMapping.inProgressMappedDistribXids == NULL)
+					ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY), errmsg("out of memory")));
 
 				snapshot->distribSnapshotWithLocalMapping.maxLocalXidsCount = maxCount;
 			}
@@ -3368,6 +3372,91 @@ MinimumActiveBackends(int min)
 	return count >= min;
 }
 
+/*
+ * MinimumActiveDistributedTransactions --- count distributed transactions
+ * that may commit soon
+ *
+ * Like MinimumActiveBackends, but for the QD, where a distributed transaction
+ * that only wrote on the segments has no local XID.
+ */
+bool
+MinimumActiveDistributedTransactions(int min)
+{
+	ProcArrayStruct *arrayP = procArray;
+	int			count = 0;
+	int			index;
+
+	if (min == 0)
+		return true;
+
+	/* As in MinimumActiveBackends, we don't bother with ProcArrayLock */
+	for (index = 0; index < arrayP->numProcs; index++)
+	{
+		int			pgprocno = arrayP->pgprocnos[index];
+		volatile PGPROC *proc = &allProcs[pgprocno];
+		volatile TMGXACT *gxact = &allTmGxact[pgprocno];
+		DtxState	state;
+
+		if (proc == MyProc)
+			continue;			/* do not count myself */
+		if (gxact->gxid == InvalidDistributedTransactionId)
+			continue;
+		if (proc->waitLock != NULL)
+			continue;			/* do not count if blocked on a lock */
+
+		state = gxact->state;
+		if (state != DTX_STATE_ACTIVE_DISTRIBUTED &&
+			state != DTX_STATE_ONE_PHASE_COMMIT &&
+			state != DTX_STATE_PREPARING &&
+			state != DTX_STATE_PREPARED)
+			continue;			/* not writing, or past its commit record */
+
+		count++;
+		if (count >= min)
+			break;
+	}
+
+	return count >= min;
+}
+
+/*
+ * DistributedTransactionIsActive -- is a backend on this segment still
+ * working on the given distributed transaction?
+ *
+ * A backend's distributed transaction only changes from active after its
+ * commit, if any, is recorded in the DistributedLog.
+ */
+bool
+DistributedTransactionIsActive(DistributedTransactionTimeStamp distribTimeStamp,
+							   DistributedTransactionId distribXid)
+{
+	ProcArrayStruct *arrayP = procArray;
+	bool		result = false;
+	int			index;
+
+	Assert(!IS_QUERY_DISPATCHER());
+
+	LWLockAcquire(ProcArrayLock, LW_SHARED);
+
+	for (index = 0; index < arrayP->numProcs; index++)
+	{
+		int			pgprocno = arrayP->pgprocnos[index];
+		volatile PGPROC *proc = &allProcs[pgprocno];
+
+		if (proc->localDistribXactData.state == LOCALDISTRIBXACT_STATE_ACTIVE &&
+			proc->localDistribXactData.distribTimeStamp == distribTimeStamp &&
+			proc->localDistribXactData.distribXid == distribXid)
+		{
+			result = true;
+			break;
+		}
+	}
+
+	LWLockRelease(ProcArrayLock);
+
+	return result;
+}
+
 /*
  * CountDBBackends --- count backends that are using specified database
  */
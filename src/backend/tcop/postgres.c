@@ -90,6 +90,7 @@
 #include "cdb/cdbtm.h"
 #include "cdb/cdbdtxcontextinfo.h"
 #include "cdb/cdbdisp_query.h"
+#include "cdb/cdbdisp_plancache.h"
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbgang.h"
 #include "cdb/ml_ipc.h"
@@ -1033,7 +1034,10 @@ pg_plan_queries(List *querytrees, int cursorOptions, ParamListInfo boundParams)
  *
  * query_string -- optional query text (C string).
  * serializedQuerytree[len]  -- Query node or (NULL,0) if plan provided.
- * serializedPlantree[len] -- PlannedStmt node, or (NULL,0) if query provided.
+ * serializedPlantree[len] -- PlannedStmt node, or (NULL,0) if query provided
+ *		or the plan is to be taken from the dispatched plan cache.
+ * planCacheSlot, planId -- where the plan goes in the dispatched plan cache,
+ *		or where to take it from; planCacheSlot is -1 if it's not cached.
  * serializedParams[len] -- optional parameters
  * serializedQueryDispatchDesc[len] -- QueryDispatchDesc node, or (NULL,0) if query provided.
  * localSlice -- slice table index
@@ -1045,6 +1049,7 @@ static void
 exec_mpp_query(const char *query_string,
 			   const char * serializedQuerytree, int serializedQuerytreelen,
 			   const char * serializedPlantree, int serializedPlantreelen,
+			   int planCacheSlot, uint32 planId,
 			   const char * serializedParams, int serializedParamslen,
 			   const char * serializedQueryDispatchDesc, int serializedQueryDispatchDesclen,
 			   int localSlice)
@@ -1128,7 +1133,12 @@ exec_mpp_query(const char *query_string,
 		plan = (PlannedStmt *) deserializeNode(serializedPlantree,serializedPlantreelen);
 		if (!plan || !IsA(plan, PlannedStmt))
 			elog(ERROR, "MPPEXEC: receive invalid planned statement");
+
+		if (planCacheSlot >= 0)
+			cdbdisp_cacheReceivedPlan(planCacheSlot, planId, plan);
     }
+	else if (planCacheSlot >= 0)
+		plan = cdbdisp_getCachedPlan(planCacheSlot, planId);
 
 	/*
      * Deserialize the extra execution information (a QueryDispatchDesc node), if there is one.
@@ -5191,6 +5201,8 @@ PostgresMain(int argc, char *argv[],
 					int serializedDtxContextInfolen = 0;
 					int serializedQuerytreelen = 0;
 					int serializedPlantreelen = 0;
+					int planCacheSlot;
+					uint32 planId;
 					int serializedParamslen = 0;
 					int serializedQueryDispatchDesclen = 0;
 					int resgroupInfoLen = 0;
@@ -5244,6 +5256,10 @@ PostgresMain(int argc, char *argv[],
 					/* get the transaction options */
 					unusedFlags = pq_getmsgint(&input_message, 4);
 
+					/* where the plan is in the dispatched plan cache, if it's there */
+					planCacheSlot = pq_getmsgint(&input_message, 4);
+					planId = pq_getmsgint(&input_message, 4);
+
 					/* get the query string and kick off processing. */
 					if (query_string_len > 0)
 						query_string = pq_getmsgbytes(&input_message,query_string_len);
@@ -5306,7 +5322,7 @@ PostgresMain(int argc, char *argv[],
 					if (cuid > 0)
 						SetUserIdAndContext(cuid, false); /* Set current userid */
 
-					if (serializedQuerytreelen==0 && serializedPlantreelen==0)
+					if (serializedQuerytreelen==0 && serializedPlantreelen==0 && planCacheSlot < 0)
 					{
 						if (strncmp(query_string, "BEGIN", 5) == 0)
 						{
@@ -5337,6 +5353,7 @@ PostgresMain(int argc, char *argv[],
 						exec_mpp_query(query_string,
 									   serializedQuerytree, serializedQuerytreelen,
 									   serializedPlantree, serializedPlantreelen,
+									   planCacheSlot, planId,
 									   serializedParams, serializedParamslen,
 									   serializedQueryDispatchDesc, serializedQueryDispatchDesclen,
 									   localSlice);
@@ -862,12 +862,18 @@ datumstreamread_close_file(DatumStreamRead * ds)
 	ds->need_close_file = false;
 }
 
+/*
+ * Format the current block into the storage write buffer, and return its
+ * content length. The block then still needs to be finished, either with
+ * AppendOnlyStorageWrite_FinishBuffer or through a compression task, and
+ * datumstreamwrite_block_done.
+ */
 static int64
-datumstreamwrite_block_orig(DatumStreamWrite * acc)
+datumstreamwrite_block_format(DatumStreamWrite * acc, int32 *rowCount)
 {
 	int64		writesz = 0;
 	uint8	   *buffer = NULL;
-	int32		rowCount;
+	AoHeaderKind aoHeaderKind;
 
 	/*
 	 * Set the BlockFirstRowNum. Need to set this before
@@ -876,12 +882,41 @@ datumstreamwrite_block_orig(DatumStreamWrite * acc)
 	AppendOnlyStorageWrite_SetFirstRowNum(&acc->ao_write,
 										  acc->blockFirstRowNum);
 
-	rowCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
-	Assert(rowCount <= MAXDATUM_PER_AOCS_ORIG_BLOCK);
+	*rowCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
+
+	switch (acc->datumStreamVersion)
+	{
+		case DatumStreamVersion_Original:
+			Assert(*rowCount <= MAXDATUM_PER_AOCS_ORIG_BLOCK);
+			aoHeaderKind = AoHeaderKind_SmallContent;
+			break;
+
+		case DatumStreamVersion_Dense:
+		case DatumStreamVersion_Dense_Enhanced:
+			if (*rowCount <= AOSmallContentHeader_MaxRowCount)
+			{
+				aoHeaderKind = AoHeaderKind_SmallContent;
+			}
+			else if (acc->ao_attr.compress)
+			{
+				aoHeaderKind = AoHeaderKind_BulkDenseContent;
+			}
+			else
+			{
+				aoHeaderKind = AoHeaderKind_NonBulkDenseContent;
+			}
+			break;
+
+		default:
+			elog(ERROR, "Unexpected datum stream version %d",
+				 acc->datumStreamVersion);
+			return 0;
+			/* Never reaches here. */
+	}
 
 	buffer = AppendOnlyStorageWrite_GetBuffer(
 											  &acc->ao_write,
-											  AoHeaderKind_SmallContent);
+											  aoHeaderKind);
 
 	writesz = DatumStreamBlockWrite_Block(
 										  &acc->blockWrite,
@@ -890,59 +925,50 @@ datumstreamwrite_block_orig(DatumStreamWrite * acc)
 	acc->ao_write.logicalBlockStartOffset =
 		BufferedAppendNextBufferPosition(&(acc->ao_write.bufferedAppend));
 
-	/* Write it out */
-	AppendOnlyStorageWrite_FinishBuffer(
-										&acc->ao_write,
-										(int32) writesz,
-										AOCSBK_BLOCK,
-										rowCount);
+	return writesz;
+}
 
+/*
+ * Get ready for the next block after the current one was written out, and
+ * insert an entry for it to the block directory.
+ */
+static void
+datumstreamwrite_block_done(DatumStreamWrite * acc,
+							int itemCount,
+							AppendOnlyBlockDirectory *blockDirectory,
+							int columnGroupNo,
+							bool addColAction)
+{
 	/* Set up our write block information */
 	DatumStreamBlockWrite_GetReady(&acc->blockWrite);
 
-	return writesz;
+	/* Insert an entry to the block directory */
+	AppendOnlyBlockDirectory_InsertEntry(
+		blockDirectory,
+		columnGroupNo,
+		acc->blockFirstRowNum,
+		AppendOnlyStorageWrite_LogicalBlockStartOffset(&acc->ao_write),
+		itemCount,
+		addColAction);
 }
 
-static int64
-datumstreamwrite_block_dense(DatumStreamWrite * acc)
+int64
+datumstreamwrite_block(DatumStreamWrite *acc,
+					   AppendOnlyBlockDirectory *blockDirectory,
+					   int columnGroupNo,
+					   bool addColAction)
 {
-	int64		writesz = 0;
-	uint8	   *buffer = NULL;
+	int64		writesz;
 	int32		rowCount;
-	AoHeaderKind aoHeaderKind;
+	int			itemCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
 
-	/*
-	 * Set the BlockFirstRowNum. Need to set this before
-	 * calling AppendOnlyStorageWrite_GetBuffer.
-	 */
-	AppendOnlyStorageWrite_SetFirstRowNum(&acc->ao_write,
-										  acc->blockFirstRowNum);
-
-	rowCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
-
-	if (rowCount <= AOSmallContentHeader_MaxRowCount)
-	{
-		aoHeaderKind = AoHeaderKind_SmallContent;
-	}
-	else if (acc->ao_attr.compress)
-	{
-		aoHeaderKind = AoHeaderKind_BulkDenseContent;
-	}
-	else
+	/* Nothing to write, this is just no op */
+	if (itemCount == 0)
 	{
-		aoHeaderKind = AoHeaderKind_NonBulkDenseContent;
+		return 0;
 	}
 
-	buffer = AppendOnlyStorageWrite_GetBuffer(
-											  &acc->ao_write,
-											  aoHeaderKind);
-
-	writesz = DatumStreamBlockWrite_Block(
-										  &acc->blockWrite,
-										  buffer);
-
-	acc->ao_write.logicalBlockStartOffset =
-		BufferedAppendNextBufferPosition(&(acc->ao_write.bufferedAppend));
+	writesz = datumstreamwrite_block_format(acc, &rowCount);
 
 	/* Write it out */
 	AppendOnlyStorageWrite_FinishBuffer(
@@ -951,20 +977,34 @@ datumstreamwrite_block_dense(DatumStreamWrite * acc)
 										AOCSBK_BLOCK,
 										rowCount);
 
-	/* Set up our write block information */
-	DatumStreamBlockWrite_GetReady(&acc->blockWrite);
+	datumstreamwrite_block_done(acc, itemCount, blockDirectory, columnGroupNo,
+								addColAction);
 
 	return writesz;
 }
 
+/*
+ * First half of datumstreamwrite_block, for compressing the blocks of
+ * several columns together with AppendOnlyDecompress_Run.
+ *
+ * If the block can be compressed by a helper thread, only sets up 'task' for
+ * it and sets *deferred; the caller must then run the task and call
+ * datumstreamwrite_block_complete, before using this datum stream again.
+ * Otherwise the block is written out as usual.
+ */
 int64
-datumstreamwrite_block(DatumStreamWrite *acc,
-					   AppendOnlyBlockDirectory *blockDirectory,
-					   int columnGroupNo,
-					   bool addColAction)
+datumstreamwrite_block_prepare(DatumStreamWrite *acc,
+							   AppendOnlyDecompressTask *task,
+							   bool *deferred,
+							   AppendOnlyBlockDirectory *blockDirectory,
+							   int columnGroupNo,
+							   bool addColAction)
 {
-	int64 writesz;
-	int itemCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
+	int64		writesz;
+	int32		rowCount;
+	int			itemCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
+
+	*deferred = false;
 
 	/* Nothing to write, this is just no op */
 	if (itemCount == 0)
@@ -972,34 +1012,134 @@ datumstreamwrite_block(DatumStreamWrite *acc,
 		return 0;
 	}
 
-	switch (acc->datumStreamVersion)
+	writesz = datumstreamwrite_block_format(acc, &rowCount);
+
+	if (AppendOnlyStorageWrite_PrepareCompress(&acc->ao_write,
+											   (int32) writesz,
+											   task))
 	{
-		case DatumStreamVersion_Original:
-			writesz = datumstreamwrite_block_orig(acc);
-			break;
+		*deferred = true;
+		return writesz;
+	}
 
-		case DatumStreamVersion_Dense:
-		case DatumStreamVersion_Dense_Enhanced:
-			writesz = datumstreamwrite_block_dense(acc);
-			break;
+	AppendOnlyStorageWrite_FinishBuffer(
+										&acc->ao_write,
+										(int32) writesz,
+										AOCSBK_BLOCK,
+										rowCount);
 
-		default:
-			elog(ERROR, "Unexpected datum stream version %d",
-				 acc->datumStreamVersion);
-			return 0;
-			/* Never reaches here. */
-	}
+	datumstreamwrite_block_done(acc, itemCount, blockDirectory, columnGroupNo,
+								addColAction);
+
+	return writesz;
+}
+
+/*
+ * Second half of datumstreamwrite_block, after the task set up by
+ * datumstreamwrite_block_prepare has run.
+ */
+void
+datumstreamwrite_block_complete(DatumStreamWrite *acc,
+								AppendOnlyDecompressTask *task,
+								AppendOnlyBlockDirectory *blockDirectory,
+								int columnGroupNo,
+								bool addColAction)
+{
+	int			itemCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
+
+	AppendOnlyStorageWrite_FinishCompressedBuffer(&acc->ao_write,
+												  task->uncompressedLen,
+												  AOCSBK_BLOCK,
+												  itemCount,
+												  task);
+
+	datumstreamwrite_block_done(acc, itemCount, blockDirectory, columnGroupNo,
+								addColAction);
+}
+
+static bool
+datumstream_same_storage(AppendOnlyStorageAttributes *a,
+						 AppendOnlyStorageAttributes *b)
+{
+	if (a->compress != b->compress ||
+		a->checksum != b->checksum)
+		return false;
+
+	if (a->compress &&
+		(a->compressLevel != b->compressLevel ||
+		 pg_strcasecmp(a->compressType, b->compressType) != 0))
+		return false;
+
+	return true;
+}
+
+/*
+ * Append the block of 'src' whose header was just read with
+ * datumstreamread_block_header to 'acc' without decoding it: its content is
+ * copied as it is stored, still compressed, and only gets a new header. The
+ * rows of the block get row numbers starting at firstRowNum.
+ *
+ * Whatever was put into 'acc' before is written out as a block of its own
+ * first. Afterwards, the next datum put into 'acc' starts a block at row
+ * number firstRowNum + the block's row count.
+ *
+ * Returns false, without doing anything, if the block can't be copied:
+ * large objects, or a source stored differently than 'acc' would store it.
+ * The caller should then read the block with datumstreamread_block_content.
+ */
+bool
+datumstreamwrite_copy_block(DatumStreamWrite *acc,
+							DatumStreamRead *src,
+							int64 firstRowNum,
+							AppendOnlyBlockDirectory *blockDirectory,
+							int columnGroupNo)
+{
+	uint8	   *content;
+	int			headerKind;
+	int32		compressedLen;
+	int			rowCount = src->getBlockInfo.rowCnt;
+
+	if (src->getBlockInfo.execBlockKind != AOCSBK_BLOCK ||
+		src->getBlockInfo.isLarge)
+		return false;
+
+	if (src->datumStreamVersion != acc->datumStreamVersion ||
+		src->maxAoBlockSize != acc->maxAoBlockSize ||
+		src->ao_read.formatVersion != acc->ao_write.formatVersion ||
+		!datumstream_same_storage(&src->ao_attr, &acc->ao_attr))
+		return false;
+
+	/* Write out the rows put so far, they precede the copied ones */
+	datumstreamwrite_block(acc, blockDirectory, columnGroupNo, false);
+
+	content = AppendOnlyStorageRead_GetStoredContent(&src->ao_read,
+													 &headerKind,
+													 &compressedLen);
+
+	AppendOnlyStorageWrite_SetFirstRowNum(&acc->ao_write, firstRowNum);
+
+	acc->ao_write.logicalBlockStartOffset =
+		BufferedAppendNextBufferPosition(&(acc->ao_write.bufferedAppend));
+
+	AppendOnlyStorageWrite_StoredContent(&acc->ao_write,
+										 headerKind,
+										 content,
+										 src->getBlockInfo.contentLen,
+										 compressedLen,
+										 AOCSBK_BLOCK,
+										 rowCount);
 
-	/* Insert an entry to the block directory */
 	AppendOnlyBlockDirectory_InsertEntry(
 		blockDirectory,
 		columnGroupNo,
-		acc->blockFirstRowNum,
+		firstRowNum,
 		AppendOnlyStorageWrite_LogicalBlockStartOffset(&acc->ao_write),
-		itemCount,
-		addColAction);
+		rowCount,
+		false);
 
-	return writesz;
+	acc->blockFirstRowNum = firstRowNum + rowCount;
+
+	return true;
 }
 
 static void
@@ -1159,6 +1299,32 @@ datumstreamread_block_get_ready(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Make sure large_object_buffer can hold the content of the current block.
+ */
+static void
+datumstreamread_grow_buffer(DatumStreamRead * acc)
+{
+	if (acc->large_object_buffer_size < acc->getBlockInfo.contentLen)
+	{
+		MemoryContext oldCtxt;
+
+		oldCtxt = MemoryContextSwitchTo(acc->memctxt);
+
+		if (acc->large_object_buffer)
+		{
+			pfree(acc->large_object_buffer);
+			acc->large_object_buffer = NULL;
+
+			SIMPLE_FAULT_INJECTOR(MallocFailure);
+		}
+
+		acc->large_object_buffer_size = acc->getBlockInfo.contentLen;
+		acc->large_object_buffer = palloc(acc->getBlockInfo.contentLen);
+		MemoryContextSwitchTo(oldCtxt);
+	}
+}
+
 void
 datumstreamread_block_content(DatumStreamRead * acc)
 {
@@ -1181,24 +1347,7 @@ datumstreamread_block_content(DatumStreamRead * acc)
 		if (acc->getBlockInfo.isCompressed)
 		{
 			/* Compressed, need to decompress to our own buffer.  */
-			if (acc->large_object_buffer_size < acc->getBlockInfo.contentLen)
-			{
-				MemoryContext oldCtxt;
-
-				oldCtxt = MemoryContextSwitchTo(acc->memctxt);
-
-				if (acc->large_object_buffer)
-				{
-					pfree(acc->large_object_buffer);
-					acc->large_object_buffer = NULL;
-
-					SIMPLE_FAULT_INJECTOR(MallocFailure);
-				}
-
-				acc->large_object_buffer_size = acc->getBlockInfo.contentLen;
-				acc->large_object_buffer = palloc(acc->getBlockInfo.contentLen);
-				MemoryContextSwitchTo(oldCtxt);
-			}
+			datumstreamread_grow_buffer(acc);
 
 			AppendOnlyStorageRead_Content(
 										  &acc->ao_read,
@@ -1283,10 +1432,16 @@ datumstreamread_block_content(DatumStreamRead * acc)
 }
 
 
-int
-datumstreamread_block(DatumStreamRead * acc,
-					  AppendOnlyBlockDirectory *blockDirectory,
-					  int colGroupNo)
+/*
+ * Read the header of the next block, and set up the block position fields
+ * for it. Returns false at the end of the segment file.
+ *
+ * The caller must then either read the block's content with
+ * datumstreamread_block_content, or consume the block some other way, e.g.
+ * with datumstreamwrite_copy_block.
+ */
+bool
+datumstreamread_block_header(DatumStreamRead * acc)
 {
 	bool		readOK = false;
 
@@ -1302,7 +1457,7 @@ datumstreamread_block(DatumStreamRead * acc,
 												&acc->getBlockInfo.isLarge,
 											&acc->getBlockInfo.isCompressed);
 	if (!readOK)
-		return -1;
+		return false;
 
 	if (Debug_appendonly_print_datumstream)
 		elog(LOG,
@@ -1344,8 +1499,14 @@ datumstreamread_block(DatumStreamRead * acc,
 			 acc->blockFileOffset,
 			 acc->blockRowCount);
 
-	datumstreamread_block_content(acc);
+	return true;
+}
 
+static void
+datumstreamread_block_directory_insert(DatumStreamRead * acc,
+									   AppendOnlyBlockDirectory *blockDirectory,
+									   int colGroupNo)
+{
 	if (blockDirectory)
 	{
 		AppendOnlyBlockDirectory_InsertEntry(blockDirectory,
@@ -1355,10 +1516,102 @@ datumstreamread_block(DatumStreamRead * acc,
 											 acc->blockRowCount,
 											 false);
 	}
+}
+
+int
+datumstreamread_block(DatumStreamRead * acc,
+					  AppendOnlyBlockDirectory *blockDirectory,
+					  int colGroupNo)
+{
+	if (!datumstreamread_block_header(acc))
+		return -1;
+
+	datumstreamread_block_content(acc);
+
+	datumstreamread_block_directory_insert(acc, blockDirectory, colGroupNo);
 
 	return 0;
 }
 
+/*
+ * First half of datumstreamread_block, for decompressing the blocks of
+ * several columns together with AppendOnlyDecompress_Run.
+ *
+ * If the next block is a compressed block that can be decompressed by a
+ * helper thread, only sets up 'task' for it and sets *deferred; the caller
+ * must then run the task and call datumstreamread_block_complete before
+ * using this datum stream again. Otherwise the block is read as usual.
+ *
+ * Returns -1 at the end of the segment file, like datumstreamread_block.
+ */
+int
+datumstreamread_block_prepare(DatumStreamRead * acc,
+							  AppendOnlyDecompressTask *task,
+							  bool *deferred)
+{
+	*deferred = false;
+
+	if (!datumstreamread_block_header(acc))
+		return -1;
+
+	if (acc->getBlockInfo.execBlockKind == AOCSBK_BLOCK &&
+		acc->getBlockInfo.isCompressed &&
+		!acc->getBlockInfo.isLarge)
+	{
+		DatumStreamBlockRead_Reset(&acc->blockRead);
+		acc->largeObjectState = DatumStreamLargeObjectState_None;
+
+		datumstreamread_grow_buffer(acc);
+
+		*deferred = AppendOnlyStorageRead_PrepareDecompress(&acc->ao_read,
+															(uint8 *) acc->large_object_buffer,
+															acc->getBlockInfo.contentLen,
+															task);
+	}
+
+	if (!*deferred)
+		datumstreamread_block_content(acc);
+
+	return 0;
+}
+
+/*
+ * Second half of datumstreamread_block. 'task' is the task set up by
+ * datumstreamread_block_prepare, or NULL if the block wasn't deferred.
+ */
+void
+datumstreamread_block_complete(DatumStreamRead * acc,
+							   AppendOnlyDecompressTask *task,
+							   AppendOnlyBlockDirectory *blockDirectory,
+							   int colGroupNo)
+{
+	if (task != NULL)
+	{
+		AppendOnlyStorageRead_FinishDecompress(&acc->ao_read, task);
+
+		acc->buffer_beginp = acc->large_object_buffer;
+
+		datumstreamread_block_get_ready(acc);
+	}
+
+	datumstreamread_block_directory_insert(acc, blockDirectory, colGroupNo);
+}
+
+/*
+ * Give up a block that datumstreamread_block_prepare deferred, without
+ * decompressing it.  The task is cleared, so that nothing is left pointing
+ * into the read buffers, and the stream has no current block.
+ */
+void
+datumstreamread_block_discard(DatumStreamRead * acc,
+							  AppendOnlyDecompressTask *task)
+{
+	MemSet(task, 0, sizeof(AppendOnlyDecompressTask));
+
+	DatumStreamBlockRead_Reset(&acc->blockRead);
+	acc->largeObjectState = DatumStreamLargeObjectState_None;
+}
+
 void
 datumstreamread_rewind_block(DatumStreamRead * datumStream)
 {
@@ -20,6 +20,7 @@
 
 #include "catalog/gp_segment_config.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "catalog/indexing.h"
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbutil.h"
@@ -28,6 +29,8 @@
 #include "postmaster/startup.h"
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
+#include "utils/timestamp.h"
+#include "funcapi.h"
 
 #define MASTER_ONLY 0x1
 #define UTILITY_MODE 0x2
@@ -848,3 +851,81 @@ gp_request_fts_probe_scan(PG_FUNCTION_ARGS)
 
 	PG_RETURN_BOOL(true);
 }
+
+/*
+ * Return the probe statistics FTS keeps of each primary-mirror pair it has
+ * probed, one row per content.
+ */
+Datum
+gp_get_fts_probe_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	int		   *content;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+		MemoryContext oldcontext;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(9, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "content",
+						   INT2OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "dbid",
+						   INT2OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "last_probe_time",
+						   TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "last_latency_ms",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "probe_interval",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "next_probe_time",
+						   TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "troubled",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "probes",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "troubled_probes",
+						   INT8OID, -1, 0);
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		content = palloc(sizeof(int));
+		*content = 0;
+		funcctx->user_fctx = content;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	content = (int *) funcctx->user_fctx;
+
+	/* FTS only runs on the master */
+	while (ftsProbeStats != NULL && *content < ftsNumProbeStats)
+	{
+		volatile FtsProbeStats *stats = &ftsProbeStats[(*content)++];
+		Datum		values[9];
+		bool		nulls[9];
+		HeapTuple	tuple;
+
+		if (stats->dbid == 0)
+			continue;
+
+		MemSet(nulls, false, sizeof(nulls));
+		values[0] = Int16GetDatum(*content - 1);
+		values[1] = Int16GetDatum(stats->dbid);
+		values[2] = TimestampTzGetDatum(time_t_to_timestamptz(stats->lastProbeTime));
+		values[3] = Int32GetDatum(stats->lastLatency);
+		values[4] = Int32GetDatum(stats->interval);
+		values[5] = TimestampTzGetDatum(time_t_to_timestamptz(stats->nextProbeTime));
+		values[6] = Int32GetDatum(stats->troubled);
+		values[7] = Int64GetDatum(stats->probes);
+		values[8] = Int64GetDatum(stats->troubledProbes);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
@@ -23,6 +23,7 @@
 #include "access/url.h"
 #include "access/xlog_internal.h"
 #include "cdb/cdbappendonlyam.h"
+#include "cdb/cdbappendonlydecompress.h"
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbsreh.h"
 #include "cdb/cdbvars.h"
@@ -47,6 +48,7 @@
 #include "utils/resgroup.h"
 #include "utils/resource_manager.h"
 #include "utils/vmem_tracker.h"
+#include "utils/workfile_mgr.h"
 #include "utils/gdd.h"
 
 /*
@@ -89,6 +91,7 @@ static void assign_gp_default_storage_options(const char *newval, void *extra);
 
 static bool check_pljava_classpath_insecure(bool *newval, void **extra, GucSource source);
 static void assign_pljava_classpath_insecure(bool newval, void *extra);
+static void assign_gp_workfile_reuse(bool newval, void *extra);
 static bool check_gp_resource_group_bypass(bool *newval, void **extra, GucSource source);
 
 extern struct config_generic *find_option(const char *name, bool create_placeholders, int elevel);
@@ -143,6 +146,10 @@ bool		gp_appendonly_verify_block_checksums = true;
 bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_compaction = true;
 int			gp_appendonly_compaction_threshold = 0;
+bool		gp_appendonly_compaction_reuse_blocks = false;
+int			gp_aocs_decompress_threads = 0;
+int			gp_aocs_compress_threads = 0;
+int			gp_appendonly_visimap_cache_entries = 128;
 bool		gp_heap_require_relhasoids_match = true;
 bool		Debug_appendonly_rezero_quicklz_compress_scratch = false;
 bool		Debug_appendonly_rezero_quicklz_decompress_scratch = false;
@@ -329,6 +336,8 @@ bool		gp_enable_multiphase_agg = true;
 bool		gp_enable_preunique = TRUE;
 bool		gp_eager_preunique = FALSE;
 bool		gp_hashagg_streambottom = true;
+bool		gp_hashagg_open_addressing = false;
+double		gp_hashagg_bypass_min_reduction = 0.1;
 bool		gp_enable_agg_distinct = true;
 bool		gp_enable_dqa_pruning = true;
 bool		gp_eager_dqa_pruning = FALSE;
@@ -484,6 +493,11 @@ bool		gp_external_enable_filter_pushdown = true;
 /* Executor */
 bool		gp_enable_mk_sort = true;
 bool		gp_enable_motion_mk_sort = true;
+bool		gp_enable_mk_radix_sort = false;
+bool		gp_enable_window_segment_tree = true;
+bool		gp_enable_expr_steps = false;
+int			gp_shareinput_channels = 16;
+int			gp_shareinput_channel_size = 256;
 
 static const struct config_enum_entry gp_log_format_options[] = {
 	{"text", 0},
@@ -505,6 +519,8 @@ static const struct config_enum_entry debug_dtm_action_protocol_options[] = {
 	{"subtransaction_begin", DTX_PROTOCOL_COMMAND_SUBTRANSACTION_BEGIN_INTERNAL},
 	{"subtransaction_release", DTX_PROTOCOL_COMMAND_SUBTRANSACTION_RELEASE_INTERNAL},
 	{"subtransaction_rollback", DTX_PROTOCOL_COMMAND_SUBTRANSACTION_ROLLBACK_INTERNAL},
+	{"commit_onephase", DTX_PROTOCOL_COMMAND_COMMIT_ONEPHASE},
+	{"retry_commit_onephase", DTX_PROTOCOL_COMMAND_RETRY_COMMIT_ONEPHASE},
 	{NULL, 0}
 };
 
@@ -558,6 +574,18 @@ static const struct config_enum_entry gp_autostats_modes[] = {
 	{NULL, 0}
 };
 
+static const struct config_enum_entry gp_dispatch_compress_algorithms[] = {
+	{"none", DISPATCH_COMPRESS_NONE},
+	{"zlib", DISPATCH_COMPRESS_ZLIB},
+#ifdef HAVE_LIBLZ4
+	{"lz4", DISPATCH_COMPRESS_LZ4},
+#endif
+#ifdef HAVE_LIBZSTD
+	{"zstd", DISPATCH_COMPRESS_ZSTD},
+#endif
+	{NULL, 0}
+};
+
 static const struct config_enum_entry gp_interconnect_fc_methods[] = {
 	{"loss", INTERCONNECT_FC_METHOD_LOSS},
 	{"capacity", INTERCONNECT_FC_METHOD_CAPACITY},
@@ -694,6 +722,38 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_enable_one_phase_commit", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Commit distributed transactions that only wrote on one segment in one phase."),
+			gettext_noop("Such a transaction is committed on its segment directly, without a "
+						 "prepare or a distributed commit record. Segments that wrote nothing "
+						 "commit when asked to prepare, and skip the second phase."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_enable_one_phase_commit,
+		false,
+		NULL, NULL, NULL
+	},
+	{
+		{"gp_dispatch_slice_plans", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Send each gang only the part of the plan its slice executes."),
+			gettext_noop("The subtrees of other slices, and the subplans they use, are left out "
+						 "of the plan sent to a gang. Requires execute_pruned_plan.")
+		},
+		&gp_dispatch_slice_plans,
+		false,
+		NULL, NULL, NULL
+	},
+	{
+		{"gp_dispatch_pipelined", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Set up the master's interconnect while the plan is still being sent to the segments."),
+			gettext_noop("Only with the UDPIFC interconnect, where QEs that start first "
+						 "keep the packets sent to processes not set up yet.")
+		},
+		&gp_dispatch_pipelined,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_enable_predicate_propagation", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("When two expressions are equivalent (such as with "
@@ -716,6 +776,36 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_workfile_reuse", PGC_SIGHUP, QUERY_TUNING_OTHER,
+			gettext_noop("Keep the spilled output of sorts, hash aggregates and materializations "
+				"and reuse it in later queries that run the same subplan over unchanged tables."),
+			gettext_noop("Writes to tables are only tracked while this is on.")
+		},
+		&gp_workfile_reuse,
+		false,
+		NULL, assign_gp_workfile_reuse, NULL
+	},
+	{
+		{"gp_workfile_async_io", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Compress, write and read ahead executor work files on a helper thread."),
+			gettext_noop("Only applies to work files that are uncompressed or compressed with lz4."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_workfile_async_io,
+		false,
+		NULL, NULL, NULL
+	},
+	{
+		{"gp_enable_memory_broker", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Allows hash, aggregate, sort and material operators to borrow memory before spilling."),
+			gettext_noop("Operators borrow from the memory that other operators of the same query have released."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_enable_memory_broker,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"force_bitmap_table_scan", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Forces bitmap table scan instead of bitmap heap/ao/aoco scan."),
@@ -941,6 +1031,39 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_enable_mk_radix_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable radix sort of in-memory multi-key sorts."),
+			gettext_noop("Used when the leading sort key is an integer, date, timestamp or string type."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_enable_mk_radix_sort,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_window_segment_tree", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable segment trees for aggregates over sliding ROWS window frames."),
+			gettext_noop("Used for aggregates that have a combine function but no inverse transition function."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_enable_window_segment_tree,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_expr_steps", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable evaluation of expressions as flattened steps."),
+			gettext_noop("Quals and projections are evaluated in a single loop over their steps instead of recursively."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_enable_expr_steps,
+		false,
+		NULL, NULL, NULL
+	},
+
 
 #ifdef USE_ASSERT_CHECKING
 	{
@@ -966,6 +1089,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_hashagg_open_addressing", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Use an open-addressing hash table for hashagg."),
+			gettext_noop("Keeps hash values, and short pass-by-value grouping keys, in a dense array instead of hash chains."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&gp_hashagg_open_addressing,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_enable_motion_deadlock_sanity", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enable verbose check at planning time."),
@@ -1109,6 +1243,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_compaction_reuse_blocks", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Copy blocks without deleted rows as they are when compacting column-oriented tables."),
+			gettext_noop("Only the blocks containing deleted rows are decompressed and rewritten.")
+		},
+		&gp_appendonly_compaction_reuse_blocks,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_heap_require_relhasoids_match", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Issue an error on discovery of a mismatch between relhasoids and a tuple header."),
@@ -3045,6 +3189,18 @@ struct config_bool ConfigureNamesBool_gp[] =
 		check_gp_resource_group_bypass, NULL, NULL
 	},
 
+	{
+		{"gp_fts_probe_spread", PGC_SIGHUP, GP_ARRAY_TUNING,
+			gettext_noop("Probe each segment when its own probe interval expires, instead of all segments at once."),
+			gettext_noop("Probes are spread over gp_fts_probe_interval, and segments whose probes "
+						 "recently timed out or needed retries are probed more often. "
+						 "Used by the fts-probe process.")
+		},
+		&gp_fts_probe_spread,
+		false,
+		NULL, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, false, NULL, NULL
@@ -3200,6 +3356,28 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_shareinput_channels", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Number of shared-memory channels for streaming cross-slice shared scans."),
+			gettext_noop("0 makes readers wait for the whole shared input to be written to disk."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_shareinput_channels,
+		16, 0, 1024,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_shareinput_channel_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the buffer size of each shared-memory channel for cross-slice shared scans."),
+			gettext_noop("Tuples that don't fit are spilled to the shared workfile."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_shareinput_channel_size,
+		256, 8, MAX_KILOBYTES / 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_max_plan_size", PGC_SUSET, RESOURCES_MEM,
 			gettext_noop("Sets the maximum size of a plan to be dispatched."),
@@ -3211,6 +3389,28 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_dispatch_plan_cache_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the number of dispatched plans to keep, on the master and on the segments, per session."),
+			gettext_noop("A plan dispatched again to the same segment processes is sent by reference. "
+						 "Use 0 to disable.")
+		},
+		&gp_dispatch_plan_cache_size,
+		0, 0, MAX_GP_DISPATCH_PLAN_CACHE_SIZE,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_dispatch_compress_threshold", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the size below which dispatched plans are sent uncompressed."),
+			NULL,
+			GUC_UNIT_KB
+		},
+		&gp_dispatch_compress_threshold,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_max_partition_level", PGC_SUSET, PRESET_OPTIONS,
 			gettext_noop("Sets the maximum number of levels allowed when creating a partitioned table."),
@@ -3233,6 +3433,38 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_aocs_decompress_threads", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Maximum number of helper threads a column-oriented table scan uses to decompress blocks."),
+			gettext_noop("0 decompresses all blocks in the scanning process itself. "
+						 "Under resource groups, the number is further limited by the group's CPU cores.")
+		},
+		&gp_aocs_decompress_threads,
+		0, 0, MAX_AOCS_DECOMPRESS_THREADS,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_compress_threads", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Maximum number of helper threads a bulk load into a column-oriented table uses to compress blocks."),
+			gettext_noop("0 compresses all blocks in the loading process itself. "
+						 "Under resource groups, the number is further limited by the group's CPU cores.")
+		},
+		&gp_aocs_compress_threads,
+		0, 0, MAX_AOCS_DECOMPRESS_THREADS,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_visimap_cache_entries", PGC_POSTMASTER, APPENDONLY_TABLES,
+			gettext_noop("Number of decoded append-only visibility map entries cached in shared memory."),
+			gettext_noop("Each entry takes about 8 kB. 0 disables the cache.")
+		},
+		&gp_appendonly_visimap_cache_entries,
+		128, 0, 65536,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_max_entries", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the maximum number of entries that can be stored in the workfile directory"),
@@ -3255,6 +3487,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_workfile_reuse_limit", PGC_SIGHUP, RESOURCES,
+			gettext_noop("Maximum disk space (in KB) kept for reusable workfiles per segment."),
+			gettext_noop("The least recently used workfiles are deleted to stay under the limit."),
+			GUC_UNIT_KB
+		},
+		&gp_workfile_reuse_limit,
+		10485760, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_idle_resource_timeout", PGC_USERSET, CLIENT_CONN_OTHER,
 			gettext_noop("Sets the time a session can be idle (in milliseconds) before we release gangs on the segment DBs to free resources."),
@@ -3620,6 +3863,19 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_dtx_group_commit_delay", PGC_SUSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the delay in microseconds before flushing a distributed commit record."),
+			gettext_noop("Each committer waits this long before the flush, when at least commit_siblings "
+						 "other distributed transactions are active, so that their commit records "
+						 "are flushed together. Use 0 to disable."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_dtx_group_commit_delay,
+		0, 0, MAX_GP_DTX_GROUP_COMMIT_DELAY,
+		NULL, NULL, NULL
+	},
+
 
 	{
 #ifdef USE_ASSERT_CHECKING
@@ -3752,6 +4008,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_fts_probe_max_concurrency", PGC_SIGHUP, GP_ARRAY_TUNING,
+			gettext_noop("Maximum number of segments FTS probes at the same time."),
+			gettext_noop("0 probes all segments at the same time. "
+						 "Used by the fts-probe process.")
+		},
+		&gp_fts_probe_max_concurrency,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_fts_mark_mirror_down_grace_period", PGC_SIGHUP, GP_ARRAY_TUNING,
 			gettext_noop("Time (in seconds) allowed to mirror after disconnection, to reconnect before being marked as down in configuration by FTS."),
@@ -4353,6 +4620,17 @@ struct config_real ConfigureNamesReal_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_hashagg_bypass_min_reduction", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Stop aggregating in a streaming first stage hashagg that reduces its input by less than this fraction."),
+			gettext_noop("Checked each time the hash table fills up. 0 disables the bypass."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&gp_hashagg_bypass_min_reduction,
+		0.1, 0.0, 1.0,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_limit_per_segment", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Maximum disk space (in KB) used for workfiles per segment."),
@@ -4536,7 +4814,7 @@ struct config_string ConfigureNamesString_gp[] =
 	{
 		{"gp_workfile_compress_algorithm", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Specify the compression algorithm that work files in the query executor use."),
-			gettext_noop("Valid values are \"NONE\", \"ZLIB\"."),
+			gettext_noop("Valid values are \"NONE\", \"ZLIB\" and, if built with LZ4 support, \"LZ4\"."),
 			GUC_GPDB_ADDOPT
 		},
 		&gp_workfile_compress_algorithm_str,
@@ -5013,6 +5291,16 @@ struct config_enum ConfigureNamesEnum_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_dispatch_compress_algorithm", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the compression algorithm for dispatched plans."),
+			gettext_noop("Valid values are \"none\", \"zlib\" and, if built with support for them, \"lz4\" and \"zstd\".")
+		},
+		&gp_dispatch_compress_algorithm,
+		DISPATCH_COMPRESS_ZLIB, gp_dispatch_compress_algorithms,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_fc_method", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the flow control method used for UDP interconnect."),
@@ -5157,6 +5445,12 @@ assign_pljava_classpath_insecure(bool newval, void *extra)
 	}
 }
 
+static void
+assign_gp_workfile_reuse(bool newval, void *extra)
+{
+	workfile_reuse_assign(newval);
+}
+
 static bool
 check_gp_resource_group_bypass(bool *newval, void **extra, GucSource source)
 {
@@ -237,17 +237,38 @@ MemoryAccounting_Reset()
  * 		Memory Account's quota and allocated amount.
  * 		This should only be called when a MemoryAccount is certain that it will not
  * 		allocate any more memory
+ *
+ * 		With gp_enable_memory_broker, the quota includes any memory the account
+ * 		acquired from the pool, and the difference is taken with its current balance.
+ * 		It can then be called again once the account has freed more; only the memory
+ * 		not relinquished before is added to the pool.
  */
 uint64
 MemoryAccounting_DeclareDone()
 {
 	MemoryAccount *currentAccount = MemoryAccounting_ConvertIdToAccount(ActiveMemoryAccountId);
 	uint64 relinquished = 0;
-	if (currentAccount->maxLimit > 0 && currentAccount->maxLimit > currentAccount->allocated)
+
+	if (!gp_enable_memory_broker)
 	{
-		relinquished = currentAccount->maxLimit - currentAccount->allocated;
-		RelinquishedPoolMemoryAccount->allocated += relinquished;
-		currentAccount->relinquishedMemory = relinquished;
+		if (currentAccount->maxLimit > 0 && currentAccount->maxLimit > currentAccount->allocated)
+		{
+			relinquished = currentAccount->maxLimit - currentAccount->allocated;
+			RelinquishedPoolMemoryAccount->allocated += relinquished;
+			currentAccount->relinquishedMemory = relinquished;
+		}
+	}
+	else
+	{
+		uint64 quota = currentAccount->maxLimit + currentAccount->acquiredMemory;
+		uint64 kept = MemoryAccounting_GetBalance(currentAccount) + currentAccount->relinquishedMemory;
+
+		if (currentAccount->maxLimit > 0 && quota > kept)
+		{
+			relinquished = quota - kept;
+			RelinquishedPoolMemoryAccount->allocated += relinquished;
+			currentAccount->relinquishedMemory += relinquished;
+		}
 	}
 
 	elog(DEBUG2, "Memory Account %d relinquished %lu bytes of memory", currentAccount->ownerType, relinquished);
@@ -265,6 +286,43 @@ MemoryAccounting_RequestQuotaIncrease()
 	return result;
 }
 
+/*
+ * MemoryAccounting_RequestQuota
+ *		Moves up to 'wanted' bytes of relinquished memory to the quota of the
+ *		current Memory Account, and returns how much was moved.
+ */
+uint64
+MemoryAccounting_RequestQuota(uint64 wanted)
+{
+	MemoryAccount *currentAccount = MemoryAccounting_ConvertIdToAccount(ActiveMemoryAccountId);
+
+	uint64 result = Min(wanted, RelinquishedPoolMemoryAccount->allocated);
+	currentAccount->acquiredMemory += result;
+	RelinquishedPoolMemoryAccount->allocated -= result;
+
+	elog(DEBUG2, "Memory Account %d acquired %lu of %lu bytes of memory", currentAccount->ownerType, result, wanted);
+	return result;
+}
+
+/*
+ * MemoryAccounting_ReclaimQuota
+ *		Takes back from the pool the memory the current Memory Account gave to it,
+ *		for an operator that is about to run again, as far as other accounts have
+ *		not acquired it meanwhile. Returns the number of bytes still lent out.
+ */
+uint64
+MemoryAccounting_ReclaimQuota()
+{
+	MemoryAccount *currentAccount = MemoryAccounting_ConvertIdToAccount(ActiveMemoryAccountId);
+
+	uint64 result = Min(currentAccount->relinquishedMemory, RelinquishedPoolMemoryAccount->allocated);
+	currentAccount->relinquishedMemory -= result;
+	RelinquishedPoolMemoryAccount->allocated -= result;
+
+	elog(DEBUG2, "Memory Account %d reclaimed %lu bytes of memory, %lu still lent", currentAccount->ownerType, result, currentAccount->relinquishedMemory);
+	return currentAccount->relinquishedMemory;
+}
+
 /*
  * MemoryAccounting_CreateAccount
  *		Public method to create a memory account. We use this to force outside
@@ -1043,6 +1043,135 @@ test__MemoryAccounting_GetBalance__Validate(void **state)
 	}
 }
 
+/*
+ * Tests that MemoryAccounting_DeclareDone gives the unused part of an
+ * account's quota to the relinquished pool only once, and that
+ * MemoryAccounting_RequestQuota hands out no more than the pool has
+ */
+void
+test__MemoryAccounting_RequestQuota__BorrowsRelinquishedMemory(void **state)
+{
+	uint64 pool = RelinquishedPoolMemoryAccount->allocated;
+
+	MemoryAccountIdType doneId = CreateMemoryAccountImpl(1000, MEMORY_OWNER_TYPE_Exec_Hash, ActiveMemoryAccountId);
+	MemoryAccountIdType borrowerId = CreateMemoryAccountImpl(100, MEMORY_OWNER_TYPE_Exec_Sort, ActiveMemoryAccountId);
+	MemoryAccount *done = MemoryAccounting_ConvertIdToAccount(doneId);
+	MemoryAccount *borrower = MemoryAccounting_ConvertIdToAccount(borrowerId);
+	MemoryAccountIdType oldAccountId;
+
+	gp_enable_memory_broker = true;
+
+	done->allocated = 400;
+	done->freed = 100;
+
+	oldAccountId = MemoryAccounting_SwitchAccount(doneId);
+	assert_true(MemoryAccounting_DeclareDone() == 700);
+	assert_true(MemoryAccounting_DeclareDone() == 0);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == pool + 700);
+
+	MemoryAccounting_SwitchAccount(borrowerId);
+	assert_true(MemoryAccounting_RequestQuota(500) == 500);
+	assert_true(MemoryAccounting_RequestQuota(pool + 500) == pool + 200);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == 0);
+	assert_true(borrower->acquiredMemory == pool + 700);
+
+	/* What was borrowed goes back with the account's own quota */
+	assert_true(MemoryAccounting_DeclareDone() == pool + 800);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == pool + 800);
+
+	MemoryAccounting_SwitchAccount(oldAccountId);
+	gp_enable_memory_broker = false;
+}
+
+/*
+ * Tests that an account that is rescanned takes back what it relinquished,
+ * except for what another account has acquired meanwhile
+ */
+void
+test__MemoryAccounting_ReclaimQuota__TakesBackRelinquishedMemory(void **state)
+{
+	uint64 pool = RelinquishedPoolMemoryAccount->allocated;
+
+	MemoryAccountIdType sortId = CreateMemoryAccountImpl(1000, MEMORY_OWNER_TYPE_Exec_Sort, ActiveMemoryAccountId);
+	MemoryAccountIdType borrowerId = CreateMemoryAccountImpl(100, MEMORY_OWNER_TYPE_Exec_Agg, ActiveMemoryAccountId);
+	MemoryAccount *sort = MemoryAccounting_ConvertIdToAccount(sortId);
+	MemoryAccountIdType oldAccountId;
+
+	gp_enable_memory_broker = true;
+
+	sort->allocated = 200;
+	sort->freed = 200;
+
+	oldAccountId = MemoryAccounting_SwitchAccount(sortId);
+	assert_true(MemoryAccounting_DeclareDone() == 1000);
+
+	/* Nobody borrowed it: the rescan gets it all back */
+	assert_true(MemoryAccounting_ReclaimQuota() == 0);
+	assert_true(sort->relinquishedMemory == 0);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == pool);
+
+	/* Done again, but another account borrows some before the rescan */
+	assert_true(MemoryAccounting_DeclareDone() == 1000);
+	MemoryAccounting_SwitchAccount(borrowerId);
+	assert_true(MemoryAccounting_RequestQuota(pool + 300) == pool + 300);
+
+	MemoryAccounting_SwitchAccount(sortId);
+	assert_true(MemoryAccounting_ReclaimQuota() == 300);
+	assert_true(sort->relinquishedMemory == 300);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == 0);
+
+	/* Once the borrower is done, the rest can be reclaimed too */
+	MemoryAccounting_SwitchAccount(borrowerId);
+	assert_true(MemoryAccounting_DeclareDone() == pool + 400);
+	MemoryAccounting_SwitchAccount(sortId);
+	assert_true(MemoryAccounting_ReclaimQuota() == 0);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == pool + 100);
+
+	MemoryAccounting_SwitchAccount(oldAccountId);
+	gp_enable_memory_broker = false;
+}
+
+/*
+ * Tests that without gp_enable_memory_broker, MemoryAccounting_DeclareDone
+ * and MemoryAccounting_RequestQuotaIncrease work as they always did:
+ * the quota minus what was ever allocated is relinquished, and an increase
+ * takes the whole pool
+ */
+void
+test__MemoryAccounting_DeclareDone__BrokerOff(void **state)
+{
+	uint64 pool = RelinquishedPoolMemoryAccount->allocated;
+
+	MemoryAccountIdType doneId = CreateMemoryAccountImpl(1000, MEMORY_OWNER_TYPE_Exec_Hash, ActiveMemoryAccountId);
+	MemoryAccountIdType aggId = CreateMemoryAccountImpl(100, MEMORY_OWNER_TYPE_Exec_Agg, ActiveMemoryAccountId);
+	MemoryAccount *done = MemoryAccounting_ConvertIdToAccount(doneId);
+	MemoryAccount *agg = MemoryAccounting_ConvertIdToAccount(aggId);
+	MemoryAccountIdType oldAccountId;
+
+	assert_false(gp_enable_memory_broker);
+
+	done->allocated = 400;
+	done->freed = 100;
+
+	oldAccountId = MemoryAccounting_SwitchAccount(doneId);
+	assert_true(MemoryAccounting_DeclareDone() == 600);
+	assert_true(done->relinquishedMemory == 600);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == pool + 600);
+
+	/* Declaring done again relinquishes the same amount again */
+	assert_true(MemoryAccounting_DeclareDone() == 600);
+	assert_true(done->relinquishedMemory == 600);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == pool + 1200);
+
+	MemoryAccounting_SwitchAccount(aggId);
+	assert_true(MemoryAccounting_RequestQuotaIncrease() == pool + 1200);
+	assert_true(MemoryAccounting_RequestQuotaIncrease() == 0);
+	assert_true(agg->acquiredMemory == 0);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == 0);
+
+	MemoryAccounting_SwitchAccount(oldAccountId);
+}
+
 /*
  * Tests if the MemoryAccounting_ToString is correctly converting
  * a memory accounting tree to string
@@ -1429,6 +1558,9 @@ main(int argc, char* argv[])
 		unit_test_setup_teardown(test__ConvertIdToUniversalArrayIndex__Validate, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__MemoryAccounting_GetAccountCurrentBalance__ResetPeakBalance, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__MemoryAccounting_Optimizer_Oustanding_Balance_Rollover, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__MemoryAccounting_RequestQuota__BorrowsRelinquishedMemory, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__MemoryAccounting_ReclaimQuota__TakesBackRelinquishedMemory, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__MemoryAccounting_DeclareDone__BrokerOff, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 	};
 
 	return run_tests(tests);
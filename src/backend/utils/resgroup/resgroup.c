@@ -956,6 +956,37 @@ ResGroupGetMaxChunksPerQuery(void)
 				(1024.0 * (1 << (pResGroupControl->chunkSizeInBits - BITS_IN_MB))));
 }
 
+/*
+ * Approximate number of CPU cores the current resource group may keep busy
+ * on this segment: the size of its cpuset, or its cpu_rate_limit share of
+ * the cores given to resource groups.
+ *
+ * Used to size helper thread pools so that a query doesn't run more threads
+ * than its group has cores to run them on. Returns at least 1.
+ */
+int
+ResGroupGetCpuCoreLimit(void)
+{
+	int			ncores = ResGroupOps_GetCpuCores();
+	int			limit;
+
+	if (!selfIsAssigned())
+		return ncores;
+
+	if (self->caps.cpuRateLimit == CPU_RATE_LIMIT_DISABLED)
+	{
+		Bitmapset  *bms = CpusetToBitset(self->caps.cpuset, MaxCpuSetLength);
+
+		limit = bms_num_members(bms);
+		bms_free(bms);
+	}
+	else
+		limit = (int) (ncores * gp_resource_group_cpu_limit *
+					   self->caps.cpuRateLimit / 100.0);
+
+	return Max(limit, 1);
+}
+
 /*
  *  Retrieve statistic information of type from resource group
  */
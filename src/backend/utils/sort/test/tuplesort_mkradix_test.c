@@ -0,0 +1,373 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include "cmockery.h"
+
+#include "../tuplesort_mkradix.c"
+
+#include "portability/instr_time.h"
+
+/*
+ * Checks the radix sort on rows of two int4 keys: that it puts them in
+ * order, and in the same order as the multi level key quick sort.  The
+ * benchmark case also reports how long each sort took on a million rows:
+ * run the test program and read the timings.
+ */
+
+#define NKEYS 2
+
+typedef struct TestRow
+{
+	int32		k[NKEYS];
+	bool		isnull[NKEYS];
+} TestRow;
+
+static Datum
+test_fetch_datum(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut)
+{
+	TestRow    *row = (TestRow *) a->ptr;
+
+	*isNullOut = row->isnull[lvctxt->attno - 1];
+	return Int32GetDatum(row->k[lvctxt->attno - 1]);
+}
+
+static void
+test_free_tuple(MKEntry *e)
+{
+}
+
+static void
+init_context(MKContext *ctxt, int nkeys, int flags)
+{
+	int			i;
+
+	MemSet(ctxt, 0, sizeof(MKContext));
+	ctxt->total_lv = nkeys;
+	ctxt->lvctxt = palloc0(nkeys * sizeof(MKLvContext));
+	ctxt->fetchForPrep = test_fetch_datum;
+	ctxt->cpfr = tupsort_cpfr;
+	ctxt->freeTup = test_free_tuple;
+
+	for (i = 0; i < nkeys; i++)
+	{
+		MKLvContext *lvctxt = ctxt->lvctxt + i;
+
+		lvctxt->typByVal = true;
+		lvctxt->typLen = sizeof(int32);
+		lvctxt->lvtype = MKLV_TYPE_INT32;
+		lvctxt->normkey = MKNK_INT32;
+		lvctxt->scanKey.sk_flags = flags;
+		lvctxt->attno = i + 1;
+		lvctxt->mkctxt = ctxt;
+	}
+}
+
+static TestRow *
+make_rows(int n, int ndistinct, int nullpct)
+{
+	TestRow    *rows = palloc(n * sizeof(TestRow));
+	int			i,
+				k;
+
+	for (i = 0; i < n; i++)
+	{
+		for (k = 0; k < NKEYS; k++)
+		{
+			rows[i].k[k] = (int32) (random() % ndistinct) - ndistinct / 2;
+			rows[i].isnull[k] = (random() % 100) < nullpct;
+		}
+	}
+	return rows;
+}
+
+static MKEntry *
+make_entries(TestRow *rows, int n)
+{
+	MKEntry    *entries = palloc(n * sizeof(MKEntry));
+	int			i;
+
+	for (i = 0; i < n; i++)
+	{
+		mke_blank(entries + i);
+		entries[i].d = 0;
+		entries[i].ptr = rows + i;
+	}
+	return entries;
+}
+
+/*
+ * Compare two rows on their first nkeys keys, the way the sort is asked to
+ * order them.
+ */
+static int
+compare_rows(TestRow *a, TestRow *b, int nkeys, int flags)
+{
+	int			k;
+
+	for (k = 0; k < nkeys; k++)
+	{
+		int			cmp;
+
+		if (a->isnull[k] || b->isnull[k])
+		{
+			if (a->isnull[k] && b->isnull[k])
+				continue;
+			cmp = a->isnull[k] ? 1 : -1;
+			if ((flags & SK_BT_NULLS_FIRST) != 0)
+				cmp = -cmp;
+			return cmp;
+		}
+
+		if (a->k[k] == b->k[k])
+			continue;
+		cmp = a->k[k] < b->k[k] ? -1 : 1;
+		if ((flags & SK_BT_DESC) != 0)
+			cmp = -cmp;
+		return cmp;
+	}
+	return 0;
+}
+
+/*
+ * Sort the rows with both sorts, and check that the radix sort put each row
+ * once, in order, and in the same order as the quick sort.
+ */
+static void
+check_sort_rows(TestRow *rows, int n, int nkeys, int flags)
+{
+	MKContext	ctxt;
+	MKEntry    *expected = make_entries(rows, n);
+	MKEntry    *actual = make_entries(rows, n);
+	bool	   *seen = palloc0(n * sizeof(bool));
+	int			i,
+				k;
+
+	init_context(&ctxt, nkeys, flags);
+
+	mk_qsort(expected, n, &ctxt);
+	mk_radix_sort(actual, n, &ctxt);
+
+	for (i = 0; i < n; i++)
+	{
+		TestRow    *e = (TestRow *) expected[i].ptr;
+		TestRow    *a = (TestRow *) actual[i].ptr;
+
+		assert_false(seen[a - rows]);
+		seen[a - rows] = true;
+
+		if (i > 0)
+			assert_true(compare_rows((TestRow *) actual[i - 1].ptr, a, nkeys, flags) <= 0);
+
+		for (k = 0; k < nkeys; k++)
+		{
+			assert_int_equal(a->isnull[k], e->isnull[k]);
+			if (!e->isnull[k])
+				assert_int_equal(a->k[k], e->k[k]);
+		}
+	}
+
+	pfree(seen);
+	pfree(expected);
+	pfree(actual);
+	pfree(ctxt.lvctxt);
+}
+
+static void
+check_sort(int n, int ndistinct, int nullpct, int nkeys, int flags)
+{
+	TestRow    *rows = make_rows(n, ndistinct, nullpct);
+
+	check_sort_rows(rows, n, nkeys, flags);
+	pfree(rows);
+}
+
+void
+test__mk_radix_sort__small(void **state)
+{
+	/* Below MK_RADIX_MIN_ENTRIES, falls back to the quick sort */
+	check_sort(100, 10, 10, NKEYS, 0);
+}
+
+void
+test__mk_radix_sort__one_key(void **state)
+{
+	check_sort(10000, 1000, 0, 1, 0);
+	check_sort(10000, 1000, 10, 1, SK_BT_NULLS_FIRST);
+	check_sort(10000, 1000, 10, 1, SK_BT_DESC);
+}
+
+void
+test__mk_radix_sort__two_keys(void **state)
+{
+	check_sort(10000, 50, 5, NKEYS, 0);
+	check_sort(10000, 50, 5, NKEYS, SK_BT_DESC | SK_BT_NULLS_FIRST);
+}
+
+/*
+ * All leading keys equal: every radix pass is skipped, and the second key
+ * decides.
+ */
+void
+test__mk_radix_sort__duplicates(void **state)
+{
+	check_sort(1000, 1, 0, 1, 0);
+	check_sort(1000, 1, 0, NKEYS, 0);
+	check_sort(1000, 3, 0, NKEYS, SK_BT_DESC);
+}
+
+/*
+ * Nulls go to the requested end, and are sorted on the next key there.
+ */
+void
+test__mk_radix_sort__nulls(void **state)
+{
+	check_sort(1000, 100, 100, 1, 0);
+	check_sort(1000, 100, 100, NKEYS, SK_BT_NULLS_FIRST);
+	check_sort(1000, 100, 50, NKEYS, 0);
+	check_sort(1000, 100, 50, NKEYS, SK_BT_NULLS_FIRST);
+	check_sort(1000, 100, 50, NKEYS, SK_BT_DESC);
+}
+
+/*
+ * Input that is already in order, or in reverse order.
+ */
+void
+test__mk_radix_sort__presorted(void **state)
+{
+	int			n = 1000;
+	TestRow    *rows = palloc0(n * sizeof(TestRow));
+	int			i;
+
+	for (i = 0; i < n; i++)
+	{
+		rows[i].k[0] = i - n / 2;
+		rows[i].k[1] = i % 7;
+	}
+
+	check_sort_rows(rows, n, NKEYS, 0);
+	check_sort_rows(rows, n, NKEYS, SK_BT_DESC);
+
+	for (i = 0; i < n; i++)
+		rows[i].k[0] = n / 2 - i;
+
+	check_sort_rows(rows, n, NKEYS, 0);
+	check_sort_rows(rows, n, NKEYS, SK_BT_DESC);
+
+	pfree(rows);
+}
+
+/*
+ * Negative keys and the extremes of int4 sort below the positive ones,
+ * although their sign bit is set.
+ */
+void
+test__mk_radix_sort__negative_keys(void **state)
+{
+	static const int32 keys[] = {
+		PG_INT32_MAX, -1, 0, PG_INT32_MIN, 1, -256, 255, PG_INT32_MIN + 1
+	};
+	int			nkeys = lengthof(keys);
+	int			n = 1000;
+	TestRow    *rows = palloc0(n * sizeof(TestRow));
+	int			i;
+
+	for (i = 0; i < n; i++)
+	{
+		rows[i].k[0] = keys[i % nkeys];
+		rows[i].k[1] = -i;
+	}
+
+	check_sort_rows(rows, n, 1, 0);
+	check_sort_rows(rows, n, NKEYS, 0);
+	check_sort_rows(rows, n, NKEYS, SK_BT_DESC);
+
+	pfree(rows);
+}
+
+/*
+ * Time both sorts on the same rows, and check that they agree.
+ */
+static void
+benchmark_sort(int n, int ndistinct, int nullpct, int nkeys, int flags)
+{
+	MKContext	ctxt;
+	TestRow    *rows = make_rows(n, ndistinct, nullpct);
+	MKEntry    *expected = make_entries(rows, n);
+	MKEntry    *actual = make_entries(rows, n);
+	instr_time	start;
+	instr_time	qsort_time;
+	instr_time	radix_time;
+	int			i;
+
+	init_context(&ctxt, nkeys, flags);
+
+	INSTR_TIME_SET_CURRENT(start);
+	mk_qsort(expected, n, &ctxt);
+	INSTR_TIME_SET_CURRENT(qsort_time);
+	INSTR_TIME_SUBTRACT(qsort_time, start);
+
+	INSTR_TIME_SET_CURRENT(start);
+	mk_radix_sort(actual, n, &ctxt);
+	INSTR_TIME_SET_CURRENT(radix_time);
+	INSTR_TIME_SUBTRACT(radix_time, start);
+
+	printf("%d rows, %d distinct, %d%% null, %d key(s), flags %d: "
+		   "mk_qsort %.3f ms, mk_radix_sort %.3f ms\n",
+		   n, ndistinct, nullpct, nkeys, flags,
+		   INSTR_TIME_GET_MILLISEC(qsort_time),
+		   INSTR_TIME_GET_MILLISEC(radix_time));
+
+	for (i = 0; i < n; i++)
+		assert_int_equal(compare_rows((TestRow *) expected[i].ptr,
+									  (TestRow *) actual[i].ptr,
+									  nkeys, flags), 0);
+
+	pfree(rows);
+	pfree(expected);
+	pfree(actual);
+	pfree(ctxt.lvctxt);
+}
+
+void
+test__mk_radix_sort__benchmark(void **state)
+{
+	benchmark_sort(1 << 20, INT_MAX, 0, 1, 0);
+	benchmark_sort(1 << 20, 1 << 16, 0, 1, 0);
+	benchmark_sort(1 << 20, 1 << 10, 1, NKEYS, 0);
+}
+
+/*
+ * The memory the radix sort asks for, which the sort checks against its
+ * budget before taking the radix path.
+ */
+void
+test__mk_radix_sort_space(void **state)
+{
+	assert_int_equal(mk_radix_sort_space(MK_RADIX_MIN_ENTRIES - 1), 0);
+	assert_int_equal(mk_radix_sort_space(1000),
+					 1000 * (2 * sizeof(MKRadixItem) + sizeof(int32)));
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const		UnitTest tests[] = {
+		unit_test(test__mk_radix_sort__small),
+		unit_test(test__mk_radix_sort__one_key),
+		unit_test(test__mk_radix_sort__two_keys),
+		unit_test(test__mk_radix_sort__duplicates),
+		unit_test(test__mk_radix_sort__nulls),
+		unit_test(test__mk_radix_sort__presorted),
+		unit_test(test__mk_radix_sort__negative_keys),
+		unit_test(test__mk_radix_sort__benchmark),
+		unit_test(test__mk_radix_sort_space)
+	};
+
+	MemoryContextInit();
+	srandom(1);
+
+	return run_tests(tests);
+}
@@ -253,6 +253,7 @@ struct Tuplesortstate
 	long        availMemMin;    /* CDB: availMem low water mark (bytes) */
 	long        availMemMin01;  /* MPP-1559: initial low water mark */
 	long		allowedMem;		/* total memory allowed, in bytes */
+	ScanState  *ss;				/* CDB: plan node of the sort, if any */
 	int			maxTapes;		/* number of tapes (Knuth's T) */
 	int			tapeRange;		/* maxTapes-1 (Knuth's P) */
 	MemoryContext sortcontext;	/* memory context holding all sort data */
@@ -691,6 +692,8 @@ tuplesort_begin_heap(ScanState *ss, TupleDesc tupDesc,
 
 	oldcontext = MemoryContextSwitchTo(state->sortcontext);
 
+	state->ss = ss;
+
 	AssertArg(nkeys > 0);
 
 	if (trace_sort)
@@ -889,6 +892,8 @@ tuplesort_begin_datum(ScanState *ss,
 
 	oldcontext = MemoryContextSwitchTo(state->sortcontext);
 
+	state->ss = ss;
+
 	if (trace_sort)
 		elog(LOG,
 			 "begin datum sort: workMem = %d, randomAccess = %c",
@@ -1078,6 +1083,26 @@ grow_memtuples(Tuplesortstate *state)
 	return true;
 }
 
+/*
+ * Ask the memory broker for as much memory again as the sort is allowed,
+ * before switching to tape-based operation.  Only sorts that belong to a plan
+ * node can do that.  Returns TRUE if allowedMem was raised.
+ */
+static bool
+grow_allowed_mem(Tuplesortstate *state)
+{
+	uint64		granted;
+
+	if (state->ss == NULL)
+		return false;
+
+	granted = ExecRequestOperatorMem((PlanState *) state->ss, state->allowedMem);
+	state->allowedMem += granted;
+	state->availMem += granted;
+
+	return granted > 0;
+}
+
 /*
  * Accept one tuple while collecting input data for sort.
  *
@@ -1277,6 +1302,17 @@ puttuple_common(Tuplesortstate *state, SortTuple *tuple)
 			if (state->memtupcount < state->memtupsize && !LACKMEM(state))
 				return;
 
+			/*
+			 * See if the memory broker can let us have more before giving up.
+			 */
+			if (grow_allowed_mem(state))
+			{
+				if (state->memtupcount >= state->memtupsize)
+					(void) grow_memtuples(state);
+				if (state->memtupcount < state->memtupsize && !LACKMEM(state))
+					return;
+			}
+
 			state->memUsedBeforeSpill = MemoryContextGetPeakSpace(state->sortcontext);
 
 			/*
@@ -4039,6 +4075,17 @@ tuplesort_sorted_insert(Tuplesortstate *state, SortTuple *tuple,
 }
 
 
+/*
+ * tuplesort_spilled
+ *
+ * Did the sort run out of memory and go to tape?
+ */
+bool
+tuplesort_spilled(Tuplesortstate *state)
+{
+	return state->tapeset != NULL;
+}
+
 /*
  * tuplesort_finalize_stats
  *
@@ -112,6 +112,7 @@
 #include "executor/nodeSort.h"	/* gpmon */
 #include "miscadmin.h"
 #include "pg_trace.h"
+#include "utils/date.h"
 #include "utils/datum.h"
 #include "executor/execWorkfile.h"
 #include "utils/logtape.h"
@@ -119,6 +120,7 @@
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
 #include "utils/syscache.h"
+#include "utils/timestamp.h"
 #include "utils/tuplesort.h"
 #include "utils/pg_locale.h"
 #include "utils/builtins.h"
@@ -517,6 +519,7 @@ static void tuplesort_inmem_limit_insert(Tuplesortstate_mk *state, MKEntry *e);
 static void tuplesort_inmem_nolimit_insert(Tuplesortstate_mk *state, MKEntry *e);
 static void tuplesort_heap_insert(Tuplesortstate_mk *state, MKEntry *e);
 static void tuplesort_limit_sort(Tuplesortstate_mk *state);
+static void tuplesort_sort_entries(Tuplesortstate_mk *state);
 
 static void tupsort_refcnt(void *vp, int ref);
 
@@ -759,6 +762,30 @@ create_mksort_context(MKContext *mkctxt,
 			sinfo->typByVal = tbyv;
 			sinfo->typLen = tlen;
 		}
+
+		sinfo->normkey = MKNK_NONE;
+		if (sinfo->lvtype == MKLV_TYPE_CHAR || sinfo->lvtype == MKLV_TYPE_TEXT)
+			sinfo->normkey = MKNK_XFRM_PREFIX;
+		else if (sinfo->scanKey.sk_func.fn_addr == btint2cmp)
+			sinfo->normkey = MKNK_INT16;
+		else if (sinfo->scanKey.sk_func.fn_addr == btint4cmp ||
+				 sinfo->scanKey.sk_func.fn_addr == date_cmp)
+			sinfo->normkey = MKNK_INT32;
+		else if (sinfo->scanKey.sk_func.fn_addr == btint8cmp)
+			sinfo->normkey = MKNK_INT64;
+#ifdef HAVE_INT64_TIMESTAMP
+		else if (sinfo->scanKey.sk_func.fn_addr == timestamp_cmp)
+			sinfo->normkey = MKNK_INT64;
+#endif
+		else if (OidIsValid(sinfo->scanKey.sk_collation) &&
+				 lc_collate_is_c(sinfo->scanKey.sk_collation))
+		{
+			if (sinfo->scanKey.sk_func.fn_addr == bttextcmp)
+				sinfo->normkey = MKNK_TEXT_PREFIX;
+			else if (sinfo->scanKey.sk_func.fn_addr == bpcharcmp)
+				sinfo->normkey = MKNK_BPCHAR_PREFIX;
+		}
+
 		sinfo->mkctxt = mkctxt;
 	}
 }
@@ -1069,6 +1096,17 @@ tuplesort_end_mk(Tuplesortstate_mk *state)
 	MemoryContextDelete(state->sortcontext);
 }
 
+/*
+ * tuplesort_spilled_mk
+ *
+ * Did the sort run out of memory and go to tape?
+ */
+bool
+tuplesort_spilled_mk(Tuplesortstate_mk *state)
+{
+	return state->tapeset != NULL;
+}
+
 /*
  * tuplesort_finalize_stats_mk
  *
@@ -1234,6 +1272,26 @@ tuplesort_putdatum_mk(Tuplesortstate_mk *state, Datum val, bool isNull)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * grow_mem_allowed
+ *	 Ask the memory broker for as much memory again as the sort is allowed,
+ *	 before switching to disk mode.  Only sorts that belong to a plan node
+ *	 can do that.  Returns true if memAllowed was raised.
+ */
+static bool
+grow_mem_allowed(Tuplesortstate_mk *state)
+{
+	uint64		granted;
+
+	if (state->ss == NULL)
+		return false;
+
+	granted = ExecRequestOperatorMem((PlanState *) state->ss, state->memAllowed);
+	state->memAllowed += granted;
+
+	return granted > 0;
+}
+
 /*
  * grow_unsorted_array
  *	 Grow the unsorted array to allow more entries to be inserted later.
@@ -1304,6 +1362,10 @@ puttuple_common(Tuplesortstate_mk *state, MKEntry *e)
 			if (!state->mkheap && state->entry_count >= state->entry_allocsize - 1)
 			{
 				growSucceed = grow_unsorted_array(state);
+
+				/* Try again with memory from the broker, before spilling */
+				if (!growSucceed && grow_mem_allowed(state))
+					growSucceed = grow_unsorted_array(state);
 			}
 
 			/* full sort? */
@@ -1382,7 +1444,7 @@ tuplesort_performsort_mk(Tuplesortstate_mk *state)
 			 * amount of memory.  Just qsort 'em and we're done.
 			 */
 			if (!state->mkctxt.bounded)
-				mk_qsort(state->entries, state->entry_count, &state->mkctxt);
+				tuplesort_sort_entries(state);
 			else
 				tuplesort_limit_sort(state);
 
@@ -3407,6 +3469,48 @@ bcTruelen(char *p, int len)
 	return i + 1;
 }
 
+/*
+ * Normalized key of a string level: its first eight bytes, big-endian and
+ * zero padded, so that the keys order like memcmp() of the strings.  The
+ * entry must have been prepared for the level, and not be null.
+ */
+uint64
+tupsort_prefix_key(MKEntry *e, MKLvContext *lvctxt)
+{
+	char	   *p;
+	int			len;
+	void	   *tofree = NULL;
+	uint64		key = 0;
+	int			i;
+
+	Assert(!mke_is_null(e));
+
+	if (lvctxt->normkey == MKNK_XFRM_PREFIX)
+	{
+		refcnt_locale_str *lstr = (refcnt_locale_str *) DatumGetPointer(e->d);
+
+		p = lstr->data + lstr->xfrm_pos;
+		len = strnlen(p, sizeof(uint64));
+	}
+	else
+	{
+		Assert(lvctxt->normkey == MKNK_TEXT_PREFIX ||
+			   lvctxt->normkey == MKNK_BPCHAR_PREFIX);
+
+		varattrib_untoast_ptr_len(e->d, &p, &len, &tofree);
+		if (lvctxt->normkey == MKNK_BPCHAR_PREFIX)
+			len = bcTruelen(p, len);
+	}
+
+	for (i = 0; i < len && i < sizeof(uint64); i++)
+		key |= ((uint64) (unsigned char) p[i]) << (8 * (sizeof(uint64) - 1 - i));
+
+	if (tofree)
+		pfree(tofree);
+
+	return key;
+}
+
 /**
  * should only be called for non-null Datum (caller must check the isnull flag from the fetch)
  */
@@ -3739,6 +3843,22 @@ tuplesort_heap_insert(Tuplesortstate_mk *state, MKEntry *e)
 	}
 }
 
+/*
+ * Sort the in-memory entries, with the radix sort if it is enabled, the
+ * leading key has a normalized form, and the radix sort's arrays fit in the
+ * memory the sort is allowed.
+ */
+static void
+tuplesort_sort_entries(Tuplesortstate_mk *state)
+{
+	if (gp_enable_mk_radix_sort && mk_radix_sortable(&state->mkctxt) &&
+		MemoryContextGetCurrentSpace(state->sortcontext) +
+		mk_radix_sort_space(state->entry_count) <= state->memAllowed)
+		mk_radix_sort(state->entries, state->entry_count, &state->mkctxt);
+	else
+		mk_qsort(state->entries, state->entry_count, &state->mkctxt);
+}
+
 static void
 tuplesort_limit_sort(Tuplesortstate_mk *state)
 {
@@ -3748,7 +3868,7 @@ tuplesort_limit_sort(Tuplesortstate_mk *state)
 	if (!state->mkheap)
 	{
 		Assert(state->entry_count <= state->mkctxt.bound);
-		mk_qsort(state->entries, state->entry_count, &state->mkctxt);
+		tuplesort_sort_entries(state);
 		return;
 	}
 	else
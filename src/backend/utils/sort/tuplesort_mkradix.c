@@ -0,0 +1,300 @@
+/*-------------------------------------------------------------------------
+ *
+ * tuplesort_mkradix.c
+ *	  Radix sort of multi level key entries on normalized keys.
+ *
+ * The leading level of each entry is turned into a normalized key: an
+ * unsigned 64-bit integer that orders like the level's comparator (see
+ * MKNormKey).  The keys are sorted with a least significant digit first
+ * radix sort, one byte per pass, skipping the passes in which all keys have
+ * the same byte, and the entries are then permuted into key order.
+ *
+ * Runs of equal keys are handed to the multi level key quick sort: at the
+ * next level if the key is exact, or at the leading level if the key is
+ * only a string prefix.  Uniqueness checks are left to it as well.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/sort/tuplesort_mkradix.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "access/nbtree.h"
+#include "utils/memutils.h"
+#include "utils/tuplesort.h"
+#include "utils/tuplesort_mk.h"
+#include "utils/tuplesort_mk_details.h"
+
+#include "miscadmin.h"
+
+/* Below this many entries, the quick sort is as fast */
+#define MK_RADIX_MIN_ENTRIES	256
+
+#define MK_RADIX_BITS			8
+#define MK_RADIX_BUCKETS		(1 << MK_RADIX_BITS)
+#define MK_RADIX_PASSES			(64 / MK_RADIX_BITS)
+
+typedef struct MKRadixItem
+{
+	uint64		key;
+	int32		idx;			/* position of the entry in the input */
+} MKRadixItem;
+
+/*
+ * Normalized key of a non-null entry prepared at the leading level.
+ */
+static inline uint64
+mk_radix_key(MKEntry *e, MKLvContext *lvctxt)
+{
+	uint64		key;
+
+	switch (lvctxt->normkey)
+	{
+		case MKNK_INT16:
+			key = ((uint64) ((uint16) DatumGetInt16(e->d) ^ 0x8000)) << 48;
+			break;
+		case MKNK_INT32:
+			key = ((uint64) ((uint32) DatumGetInt32(e->d) ^ 0x80000000)) << 32;
+			break;
+		case MKNK_INT64:
+			key = ((uint64) DatumGetInt64(e->d)) ^ (UINT64CONST(1) << 63);
+			break;
+		default:
+			key = tupsort_prefix_key(e, lvctxt);
+			break;
+	}
+
+	if ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0)
+		key = ~key;
+
+	return key;
+}
+
+static inline bool
+mk_radix_key_exact(MKLvContext *lvctxt)
+{
+	return lvctxt->normkey == MKNK_INT16 ||
+		lvctxt->normkey == MKNK_INT32 ||
+		lvctxt->normkey == MKNK_INT64;
+}
+
+/*
+ * LSD radix sort of items[0 .. n-1] on their keys, using tmp as the other
+ * buffer.  Returns the buffer that holds the result.
+ */
+static MKRadixItem *
+mk_radix_sort_items(MKRadixItem *items, MKRadixItem *tmp, int n)
+{
+	uint32		(*counts)[MK_RADIX_BUCKETS];
+	MKRadixItem *src = items;
+	MKRadixItem *dst = tmp;
+	int			pass;
+	int			i;
+
+	counts = palloc0(MK_RADIX_PASSES * sizeof(*counts));
+
+	/* Histograms of all digits in one go */
+	for (i = 0; i < n; i++)
+	{
+		uint64		key = items[i].key;
+
+		for (pass = 0; pass < MK_RADIX_PASSES; pass++)
+			counts[pass][(key >> (pass * MK_RADIX_BITS)) & (MK_RADIX_BUCKETS - 1)]++;
+	}
+
+	for (pass = 0; pass < MK_RADIX_PASSES; pass++)
+	{
+		uint32	   *count = counts[pass];
+		int			shift = pass * MK_RADIX_BITS;
+		uint32		offset = 0;
+		int			b;
+		MKRadixItem *swap;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/* All keys have the same digit here, the pass would be a copy */
+		if (count[(src[0].key >> shift) & (MK_RADIX_BUCKETS - 1)] == n)
+			continue;
+
+		for (b = 0; b < MK_RADIX_BUCKETS; b++)
+		{
+			uint32		c = count[b];
+
+			count[b] = offset;
+			offset += c;
+		}
+
+		for (i = 0; i < n; i++)
+			dst[count[(src[i].key >> shift) & (MK_RADIX_BUCKETS - 1)]++] = src[i];
+
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	pfree(counts);
+
+	return src;
+}
+
+/*
+ * Reorder the entries so that a[i] becomes the entry that was at a[perm[i]].
+ * perm is clobbered.
+ */
+static void
+mk_radix_permute(MKEntry *a, int32 *perm, int n)
+{
+	int			i;
+
+	for (i = 0; i < n; i++)
+	{
+		MKEntry		first;
+		int			j;
+
+		if (perm[i] == i)
+			continue;
+
+		/* Follow the cycle through i, marking its positions done */
+		first = a[i];
+		j = i;
+		for (;;)
+		{
+			int			k = perm[j];
+
+			perm[j] = j;
+			if (k == i)
+			{
+				a[j] = first;
+				break;
+			}
+			a[j] = a[k];
+			j = k;
+		}
+	}
+}
+
+/*
+ * Sort a[left .. right], all equal in their normalized keys, on the
+ * remaining levels.
+ */
+static void
+mk_radix_sort_ties(MKEntry *a, int left, int right, bool exact, bool isnull,
+				   MKContext *ctxt)
+{
+	if (right <= left)
+		return;
+
+	if (exact && ctxt->total_lv > 1)
+		mk_qsort_impl(a, left, right, 1, true, ctxt, isnull);
+	else if (!exact || ((ctxt->unique || ctxt->enforceUnique) && !isnull))
+		mk_qsort_impl(a, left, right, 0, false, ctxt, isnull);
+}
+
+/*
+ * Memory mk_radix_sort allocates to sort n entries, on top of the entries
+ * themselves.
+ */
+Size
+mk_radix_sort_space(int n)
+{
+	if (n < MK_RADIX_MIN_ENTRIES)
+		return 0;
+	return (Size) n * (2 * sizeof(MKRadixItem) + sizeof(int32));
+}
+
+/*
+ * Sort the n entries of a, like mk_qsort.  The leading level must have a
+ * normalized key, see mk_radix_sortable.  The caller checks that
+ * mk_radix_sort_space(n) bytes fit in its memory.
+ */
+void
+mk_radix_sort(MKEntry *a, int n, MKContext *ctxt)
+{
+	MKLvContext *lvctxt = ctxt->lvctxt;
+	bool		exact = mk_radix_key_exact(lvctxt);
+	bool		nullsfirst = (lvctxt->scanKey.sk_flags & SK_BT_NULLS_FIRST) != 0;
+	MKRadixItem *items;
+	MKRadixItem *tmp;
+	MKRadixItem *sorted;
+	int32	   *perm;
+	int			nnotnull = 0;
+	int			nnull = 0;
+	int			first;
+	int			i;
+
+	Assert(mk_radix_sortable(ctxt));
+
+	if (n < MK_RADIX_MIN_ENTRIES ||
+		(Size) n * sizeof(MKRadixItem) > MaxAllocSize)
+	{
+		mk_qsort(a, n, ctxt);
+		return;
+	}
+
+	mk_prepare_array(a, 0, n - 1, 0, ctxt);
+
+	items = palloc(n * sizeof(MKRadixItem));
+	tmp = palloc(n * sizeof(MKRadixItem));
+	perm = palloc(n * sizeof(int32));
+
+	/*
+	 * Keys of the non-null entries go to items; nulls all sort together, at
+	 * one end, in their input order.
+	 */
+	for (i = 0; i < n; i++)
+	{
+		if (mke_is_null(a + i))
+		{
+			perm[nnull++] = i;
+			continue;
+		}
+		items[nnotnull].key = mk_radix_key(a + i, lvctxt);
+		items[nnotnull].idx = i;
+		nnotnull++;
+	}
+
+	if (QueryFinishPending)
+		goto done;
+
+	sorted = (nnotnull > 0 ? mk_radix_sort_items(items, tmp, nnotnull) : items);
+
+	/* Lay out the final order in perm, nulls first or last */
+	first = 0;
+	if (nullsfirst)
+		first = nnull;
+	else if (nnull > 0)
+		memmove(perm + nnotnull, perm, nnull * sizeof(int32));
+	for (i = 0; i < nnotnull; i++)
+		perm[first + i] = sorted[i].idx;
+
+	mk_radix_permute(a, perm, n);
+
+	/* Now sort the runs of equal keys on whatever they didn't decide */
+	i = 0;
+	while (i < nnotnull)
+	{
+		int			j = i + 1;
+
+		while (j < nnotnull && sorted[j].key == sorted[i].key)
+			j++;
+		mk_radix_sort_ties(a, first + i, first + j - 1, exact, false, ctxt);
+
+		if (QueryFinishPending)
+			goto done;
+		i = j;
+	}
+
+	if (nullsfirst)
+		mk_radix_sort_ties(a, 0, nnull - 1, true, true, ctxt);
+	else
+		mk_radix_sort_ties(a, nnotnull, n - 1, true, true, ctxt);
+
+done:
+	pfree(items);
+	pfree(tmp);
+	pfree(perm);
+}
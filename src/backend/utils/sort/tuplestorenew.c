@@ -259,6 +259,9 @@ struct NTupleStore
 
 	/* instrumentation for explain analyze */
 	Instrumentation *instrument;
+
+	/* plan node to ask the memory broker for more pages, if any */
+	PlanState *planstate;
 };
 
 bool ntuplestore_is_readerwriter_reader(NTupleStore *nts) { return nts->rwflag == NTS_IS_READER; }
@@ -295,6 +298,11 @@ void ntuplestore_setinstrument(NTupleStore *st, struct Instrumentation *instr)
 	st->instrument = instr;
 }
 
+void ntuplestore_setplanstate(NTupleStore *st, struct PlanState *ps)
+{
+	st->planstate = ps;
+}
+
 static inline void init_page(NTupleStorePage *page)
 {
 	nts_page_set_blockn(page, -1);
@@ -472,6 +480,15 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 	if(nts->pfile)
 		page_max >>= 2;
 
+	/* before we start spilling, ask the memory broker for as many pages again */
+	if(nts->page_cnt >= page_max && !nts->pfile && nts->planstate)
+	{
+		uint64 granted = ExecRequestOperatorMem(nts->planstate, (uint64) nts->page_max * BLCKSZ);
+
+		nts->page_max += granted / BLCKSZ;
+		page_max = nts->page_max;
+	}
+
 	if(nts->page_cnt >= page_max)
 	{
 		if(!nts->pfile)
@@ -755,6 +772,7 @@ ntuplestore_create(int64 maxBytes)
 	store->fwacc = false;
 
 	store->instrument = NULL;
+	store->planstate = NULL;
 
 	return store;
 }
@@ -848,6 +866,7 @@ ntuplestore_init_reader(NTupleStore *store, int maxBytes)
 	store->fwacc = false;
 
 	store->instrument = NULL;
+	store->planstate = NULL;
 
 }
 
@@ -896,6 +915,15 @@ ntuplestore_flush(NTupleStore *ts)
 	}
 }
 
+/*
+ * Did the tuplestore run out of memory and write to workfiles?
+ */
+bool
+ntuplestore_spilled(NTupleStore *ts)
+{
+	return ts->workfiles_created;
+}
+
 NTupleStoreAccessor* 
 ntuplestore_create_accessor(NTupleStore *ts, bool isWriter)
 {
@@ -360,7 +360,7 @@ CopySnapshot(Snapshot snapshot)
 		size += snapshot->distribSnapshotWithLocalMapping.ds.count *
 			sizeof(DistributedTransactionId);
 		size += snapshot->distribSnapshotWithLocalMapping.currentLocalXidsCount *
-			sizeof(TransactionId);
+			(sizeof(TransactionId) + sizeof(DistributedTransactionId));
 	}
 
 	newsnap = (Snapshot) MemoryContextAlloc(TopTransactionContext, size);
@@ -423,6 +423,7 @@ CopySnapshot(Snapshot snapshot)
 		if (IS_QUERY_DISPATCHER())
 		{
 			newsnap->distribSnapshotWithLocalMapping.inProgressMappedLocalXids = NULL;
+			newsnap->distribSnapshotWithLocalMapping.inProgressMappedDistribXids = NULL;
 			newsnap->distribSnapshotWithLocalMapping.maxLocalXidsCount = 0;
 			newsnap->distribSnapshotWithLocalMapping.currentLocalXidsCount = 0;
 		}
@@ -434,6 +435,14 @@ CopySnapshot(Snapshot snapshot)
 				   snapshot->distribSnapshotWithLocalMapping.inProgressMappedLocalXids,
 				   snapshot->distribSnapshotWithLocalMapping.currentLocalXidsCount *
 				   sizeof(TransactionId));
+			dsoff += snapshot->distribSnapshotWithLocalMapping.currentLocalXidsCount *
+				sizeof(TransactionId);
+			newsnap->distribSnapshotWithLocalMapping.inProgressMappedDistribXids =
+				(DistributedTransactionId*) ((char *) newsnap + dsoff);
+			memcpy(newsnap->distribSnapshotWithLocalMapping.inProgressMappedDistribXids,
+				   snapshot->distribSnapshotWithLocalMapping.inProgressMappedDistribXids,
+				   snapshot->distribSnapshotWithLocalMapping.currentLocalXidsCount *
+				   sizeof(DistributedTransactionId));
 			newsnap->distribSnapshotWithLocalMapping.maxLocalXidsCount =
 				snapshot->distribSnapshotWithLocalMapping.currentLocalXidsCount;
 		}
@@ -314,6 +314,7 @@ workfile_mgr_populate_set(const void *resource, const void *param)
 	work_set->no_files = 0;
 	work_set->size = 0L;
 	work_set->in_progress_size = 0L;
+	INSTR_TIME_SET_ZERO(work_set->io_wait_time);
 	work_set->node_type = set_info->nodeType;
 	work_set->metadata.type = set_info->file_type;
 	work_set->metadata.bfz_compress_type = gp_workfile_compress_algorithm;
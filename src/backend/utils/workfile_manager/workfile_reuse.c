@@ -0,0 +1,1365 @@
+/*-------------------------------------------------------------------------
+ *
+ * workfile_reuse.c
+ *	  Reuse of the spilled output of a subplan across queries.
+ *
+ * A Sort, hashed Agg or Material node whose subplan only reads tables
+ * writes its output to a workfile as it returns it.  If the node ran out of
+ * memory and spilled, the file is kept at the end of the query
+ * and published in a shared cache, keyed by the text of the subplan and by
+ * the versions of the tables it reads.  A later query that runs the same
+ * subplan over the same table versions reads the file back instead of
+ * executing the subplan.
+ *
+ * The version of a table is tracked in a slot of shared memory picked by
+ * its OID (several tables may share a slot).  A transaction that writes to
+ * the table holds the slot's writer count up until it ends, bumping the
+ * slot's generation when it starts and ends.  When it ends, the outputs
+ * cached from the slot's tables are dropped, and the slot settles at the
+ * next XID, and at the writer's distributed XID, which come after every
+ * writer that ended so far.  A query can use or fill the cache only if no
+ * one is writing to the tables, its snapshot is newer than where their
+ * slots settled, locally and distributed, so that it sees all the writers
+ * as finished, and the generations stay put while it runs.  Writers that
+ * commit out of order, or share a slot, only move the settling point
+ * ahead.  TRUNCATE and table rewrites change the relfilenode, which is part
+ * of the key as well.
+ *
+ * gp_workfile_reuse is set cluster-wide, and writes aren't tracked while it
+ * is off.  So when it is turned on or off, the cached outputs are dropped,
+ * and queries don't fill the cache again until the transactions that may
+ * have written untracked are over.
+ *
+ * The cached files live in the temporary file directory, so they go away
+ * at restart along with the cache.  The space they take is limited by
+ * gp_workfile_reuse_limit, the least recently used ones are deleted to make
+ * room.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/workfile_manager/workfile_reuse.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/heapam.h"
+#include "access/memtup.h"
+#include "access/transam.h"
+#include "access/twophase_rmgr.h"
+#include "access/xact.h"
+#include "catalog/pg_aggregate.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_proc.h"
+#include "cdb/cdbtm.h"
+#include "cdb/cdbvars.h"
+#include "executor/executor.h"
+#include "miscadmin.h"
+#include "optimizer/clauses.h"
+#include "parser/parsetree.h"
+#include "storage/buffile.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "utils/faultinjector.h"
+#include "utils/memutils.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+#include "utils/tqual.h"
+#include "utils/workfile_mgr.h"
+
+#define WORKFILE_REUSE_ENTRIES		256
+#define WORKFILE_REUSE_REL_SLOTS	1024
+#define WORKFILE_REUSE_MAX_RELS		16
+#define WORKFILE_REUSE_NAMELEN		64
+
+#define WORKFILE_REUSE_PREFIX		"workfile_reuse"
+#define WORKFILE_REUSE_MAGIC		0x57465255
+
+typedef struct WorkfileReuseRelSlot
+{
+	uint32		generation;		/* bumped when a writer starts or ends */
+	int			writers;		/* transactions writing to it right now */
+	TransactionId settled_xid;	/* next XID when the last writer ended */
+	DistributedTransactionTimeStamp settled_dts;
+	DistributedTransactionId settled_dxid;	/* latest distributed writer to end */
+} WorkfileReuseRelSlot;
+
+/* What a prepared transaction records of the slots it holds */
+typedef struct WorkfileReuseTwoPhaseRecord
+{
+	DistributedTransactionId dxid;
+	uint16		slots[WORKFILE_REUSE_REL_SLOTS];
+} WorkfileReuseTwoPhaseRecord;
+
+#define WorkfileReuseTwoPhaseRecordSize(nslots) \
+	(offsetof(WorkfileReuseTwoPhaseRecord, slots) + (nslots) * sizeof(uint16))
+
+/* What a cached output is the output of */
+typedef struct WorkfileReuseKey
+{
+	Oid			dbid;
+	uint32		plan_hash;		/* of the subplan's nodeToString() */
+	uint32		plan_len;
+	uint32		epoch;			/* of gp_workfile_reuse being turned on */
+	int			nrels;
+	Oid			relids[WORKFILE_REUSE_MAX_RELS];
+	Oid			relfilenodes[WORKFILE_REUSE_MAX_RELS];
+	uint32		generations[WORKFILE_REUSE_MAX_RELS];
+} WorkfileReuseKey;
+
+typedef struct WorkfileReuseEntry
+{
+	bool		inuse;
+	bool		valid;			/* can be looked up */
+	int			pins;			/* queries reading the file */
+	uint64		last_used;
+	int64		size;
+	WorkfileReuseKey key;
+	char		name[WORKFILE_REUSE_NAMELEN];
+} WorkfileReuseEntry;
+
+/* All of it is protected by WorkfileReuseLock */
+typedef struct WorkfileReuseShared
+{
+	WorkfileReuseRelSlot relslots[WORKFILE_REUSE_REL_SLOTS];
+	uint32		epoch;			/* bumped when gp_workfile_reuse changes */
+	TransactionId tracked_xid;	/* writes are tracked from this XID on */
+
+	uint64		clock;			/* LRU clock, and file name counter */
+	int64		total_size;
+	WorkfileReuseEntry entries[WORKFILE_REUSE_ENTRIES];
+} WorkfileReuseShared;
+
+typedef enum WorkfileReuseMode
+{
+	WORKFILE_REUSE_INIT,		/* not looked up yet */
+	WORKFILE_REUSE_OFF,			/* subplan not eligible, or gave up */
+	WORKFILE_REUSE_RECORD,		/* writing the output to the file */
+	WORKFILE_REUSE_REPLAY,		/* reading the output from the file */
+	WORKFILE_REUSE_DONE			/* output published */
+} WorkfileReuseMode;
+
+struct WorkfileReuse
+{
+	PlanState  *ps;
+	WorkfileReuseMode mode;
+	WorkfileReuseKey key;
+	char		name[WORKFILE_REUSE_NAMELEN];
+	int			entry;			/* pinned while replaying */
+
+	BufFile    *file;
+	int64		data_start;		/* offset of the first tuple */
+	int64		size;
+
+	/* replayed tuples */
+	MemoryContext mcxt;
+	TupleTableSlot *slot;
+	char	   *buf;
+	uint32		buflen;
+};
+
+static WorkfileReuseShared *reuseShared = NULL;
+
+/*
+ * Reuse states of the running queries.  They live in TopMemoryContext so
+ * that the end of transaction can release their pins and files when the
+ * executor didn't get to.
+ */
+static List *active_reuses = NIL;
+
+/* Relation slots this transaction holds as a writer */
+static bool held_slots[WORKFILE_REUSE_REL_SLOTS];
+static int	nheld_slots = 0;
+static DistributedTransactionId held_dxid = InvalidDistributedTransactionId;
+
+static bool callback_registered = false;
+
+static void workfile_reuse_xact_callback(XactEvent event, void *arg);
+static void workfile_reuse_release_slots(uint16 *slots, int nslots,
+							 DistributedTransactionId dxid);
+static bool workfile_reuse_settled(WorkfileReuseKey *key, Snapshot snapshot);
+static bool workfile_reuse_plan_ok(Plan *plan, EState *estate,
+					   WorkfileReuseKey *key);
+static bool workfile_reuse_expr_ok(Node *node);
+static bool contain_param_walker(Node *node, void *context);
+static bool contain_mutable_aggs_walker(Node *node, void *context);
+static bool workfile_reuse_func_mutable(Oid funcid);
+static char *workfile_reuse_plan_string(Plan *plan);
+static void workfile_reuse_invalidate(int entry, List **names);
+static void workfile_reuse_delete_files(List *names);
+static void workfile_reuse_unpin(int entry);
+static void workfile_reuse_abandon(WorkfileReuse *wr);
+static void workfile_reuse_publish(WorkfileReuse *wr);
+static void workfile_reuse_delete_file(const char *name);
+
+Size
+WorkfileReuse_ShmemSize(void)
+{
+	return sizeof(WorkfileReuseShared);
+}
+
+void
+WorkfileReuse_ShmemInit(void)
+{
+	bool		found;
+
+	reuseShared = (WorkfileReuseShared *)
+		ShmemInitStruct("Workfile Reuse", WorkfileReuse_ShmemSize(), &found);
+
+	if (!found)
+		MemSet(reuseShared, 0, WorkfileReuse_ShmemSize());
+}
+
+/* ----------------------------------------------------------------
+ *		Writer tracking
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Note that the current transaction is about to write to a relation.
+ *
+ * Called for every result relation.
+ */
+void
+workfile_reuse_note_writer(Oid relid)
+{
+	WorkfileReuseRelSlot *slot;
+	int			i = relid % WORKFILE_REUSE_REL_SLOTS;
+
+	if (!gp_workfile_reuse || relid < FirstNormalObjectId || reuseShared == NULL)
+		return;
+
+	if (!callback_registered)
+	{
+		RegisterXactCallback(workfile_reuse_xact_callback, NULL);
+		callback_registered = true;
+	}
+
+	slot = &reuseShared->relslots[i];
+
+	LWLockAcquire(WorkfileReuseLock, LW_EXCLUSIVE);
+	slot->generation++;
+	if (!held_slots[i])
+		slot->writers++;
+	LWLockRelease(WorkfileReuseLock);
+
+	if (!held_slots[i])
+	{
+		held_slots[i] = true;
+		nheld_slots++;
+	}
+
+	if (held_dxid == InvalidDistributedTransactionId)
+		held_dxid = getDistributedTransactionId();
+}
+
+/*
+ * gp_workfile_reuse is about to change in this backend, on a reload.
+ *
+ * Either way, what is cached may be missing writes that this backend won't
+ * track, or didn't: drop it all.  The transactions running now may have
+ * written untracked, so the cache is only used by snapshots taken after
+ * they are all over.  Every backend does this as it gets to the reload, so
+ * nothing cached while some of them still had it off survives.
+ */
+void
+workfile_reuse_assign(bool newval)
+{
+	TransactionId next_xid;
+
+	/* The postmaster, and backends not started yet, don't count */
+	if (!IsUnderPostmaster || MyProc == NULL || reuseShared == NULL ||
+		newval == gp_workfile_reuse)
+		return;
+
+	next_xid = ReadNewTransactionId();
+
+	LWLockAcquire(WorkfileReuseLock, LW_EXCLUSIVE);
+	reuseShared->epoch++;
+	if (!TransactionIdIsValid(reuseShared->tracked_xid) ||
+		TransactionIdFollows(next_xid, reuseShared->tracked_xid))
+		reuseShared->tracked_xid = next_xid;
+	LWLockRelease(WorkfileReuseLock);
+}
+
+/*
+ * Let go of relation slots held as a writer, by a transaction that has just
+ * committed or aborted, with distributed XID dxid if any.  What was cached
+ * from the slots' tables is dropped.
+ */
+static void
+workfile_reuse_release_slots(uint16 *slots, int nslots,
+							 DistributedTransactionId dxid)
+{
+	bool		released[WORKFILE_REUSE_REL_SLOTS];
+	TransactionId next_xid = ReadNewTransactionId();
+	DistributedTransactionTimeStamp dts = getDtxStartTime();
+	List	   *stale = NIL;
+	int			i,
+				j;
+
+	MemSet(released, 0, sizeof(released));
+
+	LWLockAcquire(WorkfileReuseLock, LW_EXCLUSIVE);
+	for (i = 0; i < nslots; i++)
+	{
+		WorkfileReuseRelSlot *slot = &reuseShared->relslots[slots[i]];
+
+		Assert(slot->writers > 0);
+		slot->writers--;
+		slot->generation++;
+
+		/* Our XID, if we had one, comes before next_xid */
+		if (!TransactionIdIsValid(slot->settled_xid) ||
+			TransactionIdFollows(next_xid, slot->settled_xid))
+			slot->settled_xid = next_xid;
+		if (dxid != InvalidDistributedTransactionId &&
+			(slot->settled_dts != dts || dxid > slot->settled_dxid))
+		{
+			slot->settled_dts = dts;
+			slot->settled_dxid = dxid;
+		}
+
+		released[slots[i]] = true;
+	}
+
+	for (i = 0; i < WORKFILE_REUSE_ENTRIES; i++)
+	{
+		WorkfileReuseEntry *e = &reuseShared->entries[i];
+
+		if (!e->inuse || !e->valid)
+			continue;
+
+		for (j = 0; j < e->key.nrels; j++)
+		{
+			if (released[e->key.relids[j] % WORKFILE_REUSE_REL_SLOTS])
+			{
+				workfile_reuse_invalidate(i, &stale);
+				break;
+			}
+		}
+	}
+	LWLockRelease(WorkfileReuseLock);
+
+	workfile_reuse_delete_files(stale);
+}
+
+/*
+ * Collect the relation slots this transaction holds, and forget them.
+ */
+static int
+workfile_reuse_take_slots(uint16 *slots)
+{
+	int			n = 0;
+	int			i;
+
+	for (i = 0; i < WORKFILE_REUSE_REL_SLOTS && n < nheld_slots; i++)
+	{
+		if (held_slots[i])
+		{
+			slots[n++] = i;
+			held_slots[i] = false;
+		}
+	}
+	nheld_slots = 0;
+
+	return n;
+}
+
+/*
+ * PREPARE TRANSACTION: the slots stay held until COMMIT/ROLLBACK PREPARED,
+ * which may run in another backend.  Record them in the state file.
+ */
+void
+AtPrepare_WorkfileReuse(void)
+{
+	WorkfileReuseTwoPhaseRecord rec;
+	int			n;
+
+	if (nheld_slots == 0)
+		return;
+
+	rec.dxid = held_dxid;
+	held_dxid = InvalidDistributedTransactionId;
+	n = workfile_reuse_take_slots(rec.slots);
+	RegisterTwoPhaseRecord(TWOPHASE_RM_WORKFILE_REUSE_ID, 0,
+						   &rec, WorkfileReuseTwoPhaseRecordSize(n));
+}
+
+/*
+ * 2PC processing routines
+ */
+void
+workfile_reuse_twophase_recover(TransactionId xid, uint16 info,
+								void *recdata, uint32 len)
+{
+	WorkfileReuseTwoPhaseRecord *rec = (WorkfileReuseTwoPhaseRecord *) recdata;
+	int			n = (len - WorkfileReuseTwoPhaseRecordSize(0)) / sizeof(uint16);
+	int			i;
+
+	/* Shared memory was reset, hold the slots again */
+	LWLockAcquire(WorkfileReuseLock, LW_EXCLUSIVE);
+	for (i = 0; i < n; i++)
+	{
+		reuseShared->relslots[rec->slots[i]].writers++;
+		reuseShared->relslots[rec->slots[i]].generation++;
+	}
+	LWLockRelease(WorkfileReuseLock);
+}
+
+void
+workfile_reuse_twophase_postcommit(TransactionId xid, uint16 info,
+								   void *recdata, uint32 len)
+{
+	WorkfileReuseTwoPhaseRecord *rec = (WorkfileReuseTwoPhaseRecord *) recdata;
+
+	workfile_reuse_release_slots(rec->slots,
+								 (len - WorkfileReuseTwoPhaseRecordSize(0)) / sizeof(uint16),
+								 rec->dxid);
+}
+
+void
+workfile_reuse_twophase_postabort(TransactionId xid, uint16 info,
+								  void *recdata, uint32 len)
+{
+	workfile_reuse_twophase_postcommit(xid, info, recdata, len);
+}
+
+static void
+workfile_reuse_xact_callback(XactEvent event, void *arg)
+{
+	uint16		slots[WORKFILE_REUSE_REL_SLOTS];
+	int			n;
+
+	if (event != XACT_EVENT_COMMIT &&
+		event != XACT_EVENT_ABORT &&
+		event != XACT_EVENT_PREPARE)
+		return;
+
+	if (nheld_slots > 0)
+	{
+		n = workfile_reuse_take_slots(slots);
+		workfile_reuse_release_slots(slots, n, held_dxid);
+	}
+	held_dxid = InvalidDistributedTransactionId;
+
+	/*
+	 * Queries that didn't get to end their reuse, on error.  Their files
+	 * were closed by the resource owner, and the memory they pointed to is
+	 * gone already.
+	 */
+	while (active_reuses != NIL)
+	{
+		WorkfileReuse *wr = (WorkfileReuse *) linitial(active_reuses);
+
+		if (wr->mode == WORKFILE_REUSE_REPLAY)
+			workfile_reuse_unpin(wr->entry);
+		else if (wr->mode == WORKFILE_REUSE_RECORD)
+			workfile_reuse_delete_file(wr->name);
+
+		active_reuses = list_delete_first(active_reuses);
+		pfree(wr);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		Eligibility
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Does the subplan depend on nothing but the contents of the tables it
+ * scans?  Collects the tables in the key.
+ */
+static bool
+workfile_reuse_plan_ok(Plan *plan, EState *estate, WorkfileReuseKey *key)
+{
+	ListCell   *lc;
+
+	if (plan == NULL)
+		return true;
+
+	if (!bms_is_empty(plan->extParam) || !bms_is_empty(plan->allParam) ||
+		plan->initPlan != NIL)
+		return false;
+
+	if (!workfile_reuse_expr_ok((Node *) plan->targetlist) ||
+		!workfile_reuse_expr_ok((Node *) plan->qual))
+		return false;
+
+	switch (nodeTag(plan))
+	{
+		case T_SeqScan:
+		case T_AppendOnlyScan:
+		case T_AOCSScan:
+		case T_TableScan:
+		case T_IndexScan:
+		case T_IndexOnlyScan:
+		case T_BitmapIndexScan:
+		case T_BitmapHeapScan:
+		case T_BitmapAppendOnlyScan:
+		case T_BitmapTableScan:
+			{
+				RangeTblEntry *rte = rt_fetch(((Scan *) plan)->scanrelid,
+											  estate->es_range_table);
+				int			i;
+
+				if (rte->rtekind != RTE_RELATION ||
+					rte->relid < FirstNormalObjectId)
+					return false;
+
+				for (i = 0; i < key->nrels; i++)
+				{
+					if (key->relids[i] == rte->relid)
+						break;
+				}
+				if (i == key->nrels)
+				{
+					if (key->nrels == WORKFILE_REUSE_MAX_RELS)
+						return false;
+					key->relids[key->nrels++] = rte->relid;
+				}
+			}
+			break;
+
+		case T_Result:
+		case T_Append:
+		case T_MergeAppend:
+		case T_BitmapAnd:
+		case T_BitmapOr:
+		case T_ValuesScan:
+		case T_SubqueryScan:
+		case T_NestLoop:
+		case T_MergeJoin:
+		case T_HashJoin:
+		case T_Hash:
+		case T_Agg:
+		case T_WindowAgg:
+		case T_Unique:
+		case T_SetOp:
+		case T_Limit:
+			break;
+
+		case T_Material:
+			if (((Material *) plan)->share_type != SHARE_NOTSHARED)
+				return false;
+			break;
+
+		case T_Sort:
+			if (((Sort *) plan)->share_type != SHARE_NOTSHARED)
+				return false;
+			break;
+
+		default:
+			/* Motions, function scans, ShareInputScans and such */
+			return false;
+	}
+
+	/* Expressions and subplans of the particular node types */
+	switch (nodeTag(plan))
+	{
+		case T_IndexScan:
+			if (!workfile_reuse_expr_ok((Node *) ((IndexScan *) plan)->indexqualorig) ||
+				!workfile_reuse_expr_ok((Node *) ((IndexScan *) plan)->indexorderbyorig))
+				return false;
+			break;
+		case T_IndexOnlyScan:
+			if (!workfile_reuse_expr_ok((Node *) ((IndexOnlyScan *) plan)->indexqual) ||
+				!workfile_reuse_expr_ok((Node *) ((IndexOnlyScan *) plan)->indexorderby))
+				return false;
+			break;
+		case T_BitmapIndexScan:
+			if (!workfile_reuse_expr_ok((Node *) ((BitmapIndexScan *) plan)->indexqualorig))
+				return false;
+			break;
+		case T_BitmapHeapScan:
+		case T_BitmapTableScan:
+			if (!workfile_reuse_expr_ok((Node *) ((BitmapHeapScan *) plan)->bitmapqualorig))
+				return false;
+			break;
+		case T_BitmapAppendOnlyScan:
+			if (!workfile_reuse_expr_ok((Node *) ((BitmapAppendOnlyScan *) plan)->bitmapqualorig))
+				return false;
+			break;
+		case T_ValuesScan:
+			if (!workfile_reuse_expr_ok((Node *) ((ValuesScan *) plan)->values_lists))
+				return false;
+			break;
+		case T_SubqueryScan:
+			if (!workfile_reuse_plan_ok(((SubqueryScan *) plan)->subplan, estate, key))
+				return false;
+			break;
+		case T_Result:
+			if (!workfile_reuse_expr_ok(((Result *) plan)->resconstantqual))
+				return false;
+			break;
+		case T_Append:
+			foreach(lc, ((Append *) plan)->appendplans)
+			{
+				if (!workfile_reuse_plan_ok((Plan *) lfirst(lc), estate, key))
+					return false;
+			}
+			break;
+		case T_MergeAppend:
+			foreach(lc, ((MergeAppend *) plan)->mergeplans)
+			{
+				if (!workfile_reuse_plan_ok((Plan *) lfirst(lc), estate, key))
+					return false;
+			}
+			break;
+		case T_BitmapAnd:
+			foreach(lc, ((BitmapAnd *) plan)->bitmapplans)
+			{
+				if (!workfile_reuse_plan_ok((Plan *) lfirst(lc), estate, key))
+					return false;
+			}
+			break;
+		case T_BitmapOr:
+			foreach(lc, ((BitmapOr *) plan)->bitmapplans)
+			{
+				if (!workfile_reuse_plan_ok((Plan *) lfirst(lc), estate, key))
+					return false;
+			}
+			break;
+		case T_NestLoop:
+			if (((NestLoop *) plan)->nestParams != NIL)
+				return false;
+			/* fall through */
+		case T_MergeJoin:
+		case T_HashJoin:
+			if (!workfile_reuse_expr_ok((Node *) ((Join *) plan)->joinqual))
+				return false;
+			if (IsA(plan, MergeJoin) &&
+				!workfile_reuse_expr_ok((Node *) ((MergeJoin *) plan)->mergeclauses))
+				return false;
+			if (IsA(plan, HashJoin) &&
+				(!workfile_reuse_expr_ok((Node *) ((HashJoin *) plan)->hashclauses) ||
+				 !workfile_reuse_expr_ok((Node *) ((HashJoin *) plan)->hashqualclauses)))
+				return false;
+			break;
+		case T_WindowAgg:
+			if (!workfile_reuse_expr_ok(((WindowAgg *) plan)->startOffset) ||
+				!workfile_reuse_expr_ok(((WindowAgg *) plan)->endOffset))
+				return false;
+			break;
+		case T_Limit:
+			if (!workfile_reuse_expr_ok(((Limit *) plan)->limitOffset) ||
+				!workfile_reuse_expr_ok(((Limit *) plan)->limitCount))
+				return false;
+			break;
+		default:
+			break;
+	}
+
+	return workfile_reuse_plan_ok(plan->lefttree, estate, key) &&
+		workfile_reuse_plan_ok(plan->righttree, estate, key);
+}
+
+/*
+ * An expression gives the same results in every query if it has no
+ * parameters, subplans or volatile or stable functions.
+ */
+static bool
+workfile_reuse_expr_ok(Node *node)
+{
+	if (node == NULL)
+		return true;
+
+	return !contain_param_walker(node, NULL) &&
+		!contain_subplans(node) &&
+		!contain_mutable_functions(node) &&
+		!contain_mutable_aggs_walker(node, NULL);
+}
+
+static bool
+contain_param_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Param))
+		return true;
+	return expression_tree_walker(node, contain_param_walker, context);
+}
+
+/*
+ * contain_mutable_functions() goes by the volatility of an aggregate's own
+ * pg_proc entry.  Look at the functions it is made of as well.
+ */
+static bool
+contain_mutable_aggs_walker(Node *node, void *context)
+{
+	Oid			aggfnoid = InvalidOid;
+
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Aggref))
+		aggfnoid = ((Aggref *) node)->aggfnoid;
+	else if (IsA(node, WindowFunc))
+		aggfnoid = ((WindowFunc *) node)->winfnoid;
+
+	if (OidIsValid(aggfnoid))
+	{
+		HeapTuple	tuple;
+
+		tuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggfnoid));
+		if (HeapTupleIsValid(tuple))
+		{
+			Form_pg_aggregate agg = (Form_pg_aggregate) GETSTRUCT(tuple);
+			bool		mutable;
+
+			mutable = workfile_reuse_func_mutable(agg->aggtransfn) ||
+				workfile_reuse_func_mutable(agg->aggfinalfn) ||
+				workfile_reuse_func_mutable(agg->aggcombinefn) ||
+				workfile_reuse_func_mutable(agg->aggserialfn) ||
+				workfile_reuse_func_mutable(agg->aggdeserialfn) ||
+				workfile_reuse_func_mutable(agg->aggmtransfn) ||
+				workfile_reuse_func_mutable(agg->aggminvtransfn) ||
+				workfile_reuse_func_mutable(agg->aggmfinalfn);
+			ReleaseSysCache(tuple);
+
+			if (mutable)
+				return true;
+		}
+	}
+
+	return expression_tree_walker(node, contain_mutable_aggs_walker, context);
+}
+
+static bool
+workfile_reuse_func_mutable(Oid funcid)
+{
+	return OidIsValid(funcid) && func_volatile(funcid) != PROVOLATILE_IMMUTABLE;
+}
+
+/*
+ * The text of a subplan, without the parse locations of its expressions,
+ * which differ between queries that run the same subplan.
+ */
+static char *
+workfile_reuse_plan_string(Plan *plan)
+{
+	char	   *str = nodeToString(plan);
+	char	   *src = str;
+	char	   *dst = str;
+	static const char field[] = " :location ";
+
+	while (*src)
+	{
+		if (strncmp(src, field, sizeof(field) - 1) == 0)
+		{
+			src += sizeof(field) - 1;
+			if (*src == '-')
+				src++;
+			while (isdigit((unsigned char) *src))
+				src++;
+			continue;
+		}
+		*dst++ = *src++;
+	}
+	*dst = '\0';
+
+	return str;
+}
+
+/* ----------------------------------------------------------------
+ *		Cache entries
+ * ----------------------------------------------------------------
+ */
+
+static bool
+workfile_reuse_key_equal(WorkfileReuseKey *a, WorkfileReuseKey *b)
+{
+	if (a->dbid != b->dbid ||
+		a->plan_hash != b->plan_hash ||
+		a->plan_len != b->plan_len ||
+		a->nrels != b->nrels)
+		return false;
+
+	return memcmp(a->relids, b->relids, a->nrels * sizeof(Oid)) == 0 &&
+		memcmp(a->relfilenodes, b->relfilenodes, a->nrels * sizeof(Oid)) == 0;
+}
+
+static bool
+workfile_reuse_generations_equal(WorkfileReuseKey *a, WorkfileReuseKey *b)
+{
+	return a->epoch == b->epoch &&
+		memcmp(a->generations, b->generations, a->nrels * sizeof(uint32)) == 0;
+}
+
+/*
+ * Take an entry out of the cache.  Its file is deleted by the last query
+ * to unpin it, or right away, into *names, if none has it pinned.
+ *
+ * Caller must hold WorkfileReuseLock.
+ */
+static void
+workfile_reuse_invalidate(int entry, List **names)
+{
+	WorkfileReuseEntry *e = &reuseShared->entries[entry];
+
+	e->valid = false;
+	if (e->pins == 0)
+	{
+		*names = lappend(*names, pstrdup(e->name));
+		reuseShared->total_size -= e->size;
+		e->inuse = false;
+	}
+}
+
+static void
+workfile_reuse_delete_files(List *names)
+{
+	ListCell   *lc;
+
+	foreach(lc, names)
+		workfile_reuse_delete_file((char *) lfirst(lc));
+	list_free_deep(names);
+}
+
+static void
+workfile_reuse_unpin(int entry)
+{
+	WorkfileReuseEntry *e = &reuseShared->entries[entry];
+	char		name[WORKFILE_REUSE_NAMELEN];
+	bool		delete = false;
+
+	LWLockAcquire(WorkfileReuseLock, LW_EXCLUSIVE);
+	Assert(e->pins > 0);
+	e->pins--;
+	if (!e->valid && e->pins == 0)
+	{
+		strlcpy(name, e->name, sizeof(name));
+		reuseShared->total_size -= e->size;
+		e->inuse = false;
+		delete = true;
+	}
+	LWLockRelease(WorkfileReuseLock);
+
+	if (delete)
+		workfile_reuse_delete_file(name);
+}
+
+static void
+workfile_reuse_delete_file(const char *name)
+{
+	BufFile    *file = BufFileOpenNamedTemp(name, true /* delOnClose */ ,
+											false /* interXact */ );
+
+	if (file)
+		BufFileClose(file);
+}
+
+/* ----------------------------------------------------------------
+ *		Executor interface
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Set up workfile reuse for the output of a plan node.  Returns NULL if it
+ * is disabled.  Nothing is looked up until workfile_reuse_start().
+ */
+WorkfileReuse *
+workfile_reuse_create(PlanState *ps)
+{
+	WorkfileReuse *wr;
+	MemoryContext oldcxt;
+
+	if (!gp_workfile_reuse || reuseShared == NULL)
+		return NULL;
+
+	wr = MemoryContextAllocZero(TopMemoryContext, sizeof(WorkfileReuse));
+	wr->ps = ps;
+	wr->mode = WORKFILE_REUSE_INIT;
+	wr->entry = -1;
+	wr->mcxt = CurrentMemoryContext;
+
+	if (!callback_registered)
+	{
+		RegisterXactCallback(workfile_reuse_xact_callback, NULL);
+		callback_registered = true;
+	}
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	active_reuses = lcons(wr, active_reuses);
+	MemoryContextSwitchTo(oldcxt);
+
+	return wr;
+}
+
+/*
+ * Can a query with this snapshot use or fill the cache for the key's tables?
+ * Only if no one is writing to them, and the snapshot sees every writer
+ * that ended as finished.  Records the generations of the tables in the
+ * key.
+ *
+ * Caller must hold WorkfileReuseLock exclusively.
+ */
+static bool
+workfile_reuse_settled(WorkfileReuseKey *key, Snapshot snapshot)
+{
+	int			i;
+
+	/* Transactions that may have written untracked are still running */
+	if (TransactionIdIsValid(reuseShared->tracked_xid))
+	{
+		if (TransactionIdPrecedes(snapshot->xmin, reuseShared->tracked_xid))
+			return false;
+
+		/* They are all over, no need to check again */
+		reuseShared->tracked_xid = InvalidTransactionId;
+	}
+
+	key->epoch = reuseShared->epoch;
+	for (i = 0; i < key->nrels; i++)
+	{
+		WorkfileReuseRelSlot *slot =
+		&reuseShared->relslots[key->relids[i] % WORKFILE_REUSE_REL_SLOTS];
+
+		if (slot->writers > 0)
+			return false;
+
+		if (TransactionIdIsValid(slot->settled_xid) &&
+			TransactionIdPrecedes(snapshot->xmin, slot->settled_xid))
+			return false;
+
+		/*
+		 * A writer that committed here may still be in progress to a
+		 * distributed snapshot.
+		 */
+		if (slot->settled_dxid != InvalidDistributedTransactionId &&
+			snapshot->haveDistribSnapshot)
+		{
+			DistributedSnapshot *ds = &snapshot->distribSnapshotWithLocalMapping.ds;
+
+			if (ds->distribTransactionTimeStamp != slot->settled_dts ||
+				ds->xmin <= slot->settled_dxid)
+				return false;
+		}
+
+		key->generations[i] = slot->generation;
+	}
+
+	return true;
+}
+
+/*
+ * Look the node's output up in the cache, on its first execution.  Returns
+ * true if it is to be read with workfile_reuse_next() rather than computed.
+ * Otherwise the node passes its output tuples to workfile_reuse_put(), and
+ * calls workfile_reuse_finish() when there are no more.
+ */
+bool
+workfile_reuse_start(WorkfileReuse *wr)
+{
+	EState	   *estate = wr->ps->state;
+	Snapshot	snapshot = estate->es_snapshot;
+	WorkfileReuseKey *key = &wr->key;
+	List	   *stale = NIL;
+	MemoryContext oldcxt;
+	char	   *plan_str;
+	bool		settled;
+	uint64		seq;
+	uint32		header[2];
+	int			i;
+
+	if (wr->mode != WORKFILE_REUSE_INIT)
+		return wr->mode == WORKFILE_REUSE_REPLAY;
+
+	wr->mode = WORKFILE_REUSE_OFF;
+
+	/* Our own changes aren't in anyone else's cached output */
+	if (!IsMVCCSnapshot(snapshot) ||
+		TransactionIdIsValid(GetTopTransactionIdIfAny()) ||
+		nheld_slots > 0)
+		return false;
+
+	if (!workfile_reuse_plan_ok(wr->ps->plan, estate, key) || key->nrels == 0)
+		return false;
+
+	for (i = 0; i < key->nrels; i++)
+	{
+		Relation	rel = relation_open(key->relids[i], NoLock);
+
+		key->relfilenodes[i] = rel->rd_node.relNode;
+		relation_close(rel, NoLock);
+	}
+
+	oldcxt = MemoryContextSwitchTo(wr->mcxt);
+
+	plan_str = workfile_reuse_plan_string(wr->ps->plan);
+	key->dbid = MyDatabaseId;
+	key->plan_len = strlen(plan_str);
+	key->plan_hash = DatumGetUInt32(hash_any((unsigned char *) plan_str,
+											 key->plan_len));
+
+	LWLockAcquire(WorkfileReuseLock, LW_EXCLUSIVE);
+	settled = workfile_reuse_settled(key, snapshot);
+	for (i = 0; i < WORKFILE_REUSE_ENTRIES && settled; i++)
+	{
+		WorkfileReuseEntry *e = &reuseShared->entries[i];
+
+		if (!e->inuse || !e->valid || !workfile_reuse_key_equal(&e->key, key))
+			continue;
+
+		if (!workfile_reuse_generations_equal(&e->key, key))
+		{
+			workfile_reuse_invalidate(i, &stale);
+			continue;
+		}
+
+		e->pins++;
+		e->last_used = ++reuseShared->clock;
+		strlcpy(wr->name, e->name, sizeof(wr->name));
+		wr->entry = i;
+		break;
+	}
+	seq = ++reuseShared->clock;
+	LWLockRelease(WorkfileReuseLock);
+
+	workfile_reuse_delete_files(stale);
+
+	/* Some of the tables may have changed without the snapshot seeing it */
+	if (!settled)
+	{
+		pfree(plan_str);
+		MemoryContextSwitchTo(oldcxt);
+		return false;
+	}
+
+	if (wr->entry >= 0)
+	{
+		wr->file = BufFileOpenNamedTemp(wr->name, false /* delOnClose */ ,
+										false /* interXact */ );
+
+		/*
+		 * The file starts with the subplan it holds the output of, in case
+		 * two subplans hash alike.
+		 */
+		if (wr->file &&
+			BufFileRead(wr->file, header, sizeof(header)) == sizeof(header) &&
+			header[0] == WORKFILE_REUSE_MAGIC &&
+			header[1] == key->plan_len)
+		{
+			char	   *stored = palloc(key->plan_len);
+
+			if (BufFileRead(wr->file, stored, key->plan_len) == key->plan_len &&
+				memcmp(stored, plan_str, key->plan_len) == 0)
+			{
+				wr->mode = WORKFILE_REUSE_REPLAY;
+				wr->data_start = sizeof(header) + key->plan_len;
+				wr->slot = MakeSingleTupleTableSlot(ExecGetResultType(wr->ps));
+
+				SIMPLE_FAULT_INJECTOR(WorkfileReuseReplay);
+			}
+			pfree(stored);
+		}
+
+		if (wr->mode != WORKFILE_REUSE_REPLAY)
+		{
+			if (wr->file)
+				BufFileClose(wr->file);
+			wr->file = NULL;
+			workfile_reuse_unpin(wr->entry);
+			wr->entry = -1;
+		}
+
+		elog(gp_workfile_caching_loglevel, "workfile reuse: %s %s",
+			 wr->mode == WORKFILE_REUSE_REPLAY ? "reading" : "could not read",
+			 wr->name);
+	}
+	else
+	{
+		snprintf(wr->name, sizeof(wr->name), "%s_" UINT64_FORMAT,
+				 WORKFILE_REUSE_PREFIX, seq);
+		wr->file = BufFileCreateNamedTemp(wr->name, false /* delOnClose */ ,
+										  false /* interXact */ );
+
+		header[0] = WORKFILE_REUSE_MAGIC;
+		header[1] = key->plan_len;
+		if (BufFileWrite(wr->file, header, sizeof(header)) != sizeof(header) ||
+			BufFileWrite(wr->file, plan_str, key->plan_len) != key->plan_len)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file \"%s\": %m",
+							wr->name)));
+
+		wr->mode = WORKFILE_REUSE_RECORD;
+		wr->size = sizeof(header) + key->plan_len;
+	}
+
+	pfree(plan_str);
+	MemoryContextSwitchTo(oldcxt);
+
+	return wr->mode == WORKFILE_REUSE_REPLAY;
+}
+
+/*
+ * Next tuple of a replayed output, or NULL at the end of it.
+ */
+TupleTableSlot *
+workfile_reuse_next(WorkfileReuse *wr)
+{
+	uint32		len;
+
+	Assert(wr->mode == WORKFILE_REUSE_REPLAY);
+
+	if (BufFileRead(wr->file, &len, sizeof(len)) != sizeof(len))
+	{
+		ExecClearTuple(wr->slot);
+		return NULL;
+	}
+
+	if (len > wr->buflen)
+	{
+		ExecClearTuple(wr->slot);
+		if (wr->buf)
+			pfree(wr->buf);
+		wr->buflen = Max(len, 2 * wr->buflen);
+		wr->buf = MemoryContextAlloc(wr->mcxt, wr->buflen);
+	}
+
+	if (BufFileRead(wr->file, wr->buf, len) != len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from temporary file \"%s\": %m",
+						wr->name)));
+
+	return ExecStoreMinimalTuple((MemTuple) wr->buf, wr->slot, false);
+}
+
+/*
+ * Append an output tuple to the file being recorded.
+ */
+void
+workfile_reuse_put(WorkfileReuse *wr, TupleTableSlot *slot)
+{
+	MemTuple	mtup;
+	uint32		len;
+
+	if (wr == NULL || wr->mode != WORKFILE_REUSE_RECORD)
+		return;
+
+	mtup = ExecFetchSlotMemTuple(slot, true /* inline_toast */ );
+	len = memtuple_get_size(mtup);
+
+	/* Don't bother with outputs that would never fit */
+	if (wr->size + sizeof(len) + len > (int64) gp_workfile_reuse_limit * 1024L)
+	{
+		workfile_reuse_abandon(wr);
+		return;
+	}
+
+	if (BufFileWrite(wr->file, &len, sizeof(len)) != sizeof(len) ||
+		BufFileWrite(wr->file, mtup, len) != len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to temporary file \"%s\": %m",
+						wr->name)));
+	wr->size += sizeof(len) + len;
+}
+
+/*
+ * The node has returned all of its output: keep the file if the node ran
+ * out of memory computing it, otherwise it is cheap enough to compute again.
+ */
+void
+workfile_reuse_finish(WorkfileReuse *wr, bool spilled)
+{
+	if (wr == NULL || wr->mode != WORKFILE_REUSE_RECORD)
+		return;
+
+	BufFileFlush(wr->file);
+	BufFileClose(wr->file);
+	wr->file = NULL;
+
+	if (!spilled)
+	{
+		workfile_reuse_delete_file(wr->name);
+		wr->mode = WORKFILE_REUSE_OFF;
+		return;
+	}
+
+	workfile_reuse_publish(wr);
+}
+
+/*
+ * Add a recorded output to the cache, evicting the least recently used
+ * ones to make room.
+ */
+static void
+workfile_reuse_publish(WorkfileReuse *wr)
+{
+	WorkfileReuseKey *key = &wr->key;
+	int64		limit = (int64) gp_workfile_reuse_limit * 1024L;
+	List	   *evicted = NIL;
+	bool		published = false;
+	bool		changed;
+	int			i;
+
+	LWLockAcquire(WorkfileReuseLock, LW_EXCLUSIVE);
+
+	/*
+	 * Tables written to while we ran, or gp_workfile_reuse changed: the
+	 * output may be a mix.
+	 */
+	changed = (reuseShared->epoch != key->epoch);
+	for (i = 0; i < key->nrels && !changed; i++)
+	{
+		WorkfileReuseRelSlot *slot =
+		&reuseShared->relslots[key->relids[i] % WORKFILE_REUSE_REL_SLOTS];
+
+		if (slot->generation != key->generations[i])
+			changed = true;
+	}
+
+	if (!changed && wr->size <= limit)
+	{
+		for (i = 0; i < WORKFILE_REUSE_ENTRIES; i++)
+		{
+			WorkfileReuseEntry *e = &reuseShared->entries[i];
+
+			/* Someone beat us to it */
+			if (e->inuse && e->valid &&
+				workfile_reuse_key_equal(&e->key, key) &&
+				workfile_reuse_generations_equal(&e->key, key))
+				break;
+		}
+
+		if (i == WORKFILE_REUSE_ENTRIES)
+		{
+			int			free_entry = -1;
+
+			for (;;)
+			{
+				int			victim = -1;
+
+				for (i = 0; i < WORKFILE_REUSE_ENTRIES && free_entry < 0; i++)
+				{
+					if (!reuseShared->entries[i].inuse)
+						free_entry = i;
+				}
+
+				if (free_entry >= 0 &&
+					reuseShared->total_size + wr->size <= limit)
+					break;
+
+				for (i = 0; i < WORKFILE_REUSE_ENTRIES; i++)
+				{
+					WorkfileReuseEntry *e = &reuseShared->entries[i];
+
+					if (e->inuse && e->valid && e->pins == 0 &&
+						(victim < 0 ||
+						 e->last_used < reuseShared->entries[victim].last_used))
+						victim = i;
+				}
+				if (victim < 0)
+					break;
+
+				workfile_reuse_invalidate(victim, &evicted);
+			}
+
+			if (free_entry >= 0 &&
+				reuseShared->total_size + wr->size <= limit)
+			{
+				WorkfileReuseEntry *e = &reuseShared->entries[free_entry];
+
+				e->inuse = true;
+				e->valid = true;
+				e->pins = 0;
+				e->last_used = ++reuseShared->clock;
+				e->size = wr->size;
+				memcpy(&e->key, key, sizeof(WorkfileReuseKey));
+				strlcpy(e->name, wr->name, sizeof(e->name));
+				reuseShared->total_size += wr->size;
+				published = true;
+			}
+		}
+	}
+
+	LWLockRelease(WorkfileReuseLock);
+
+	workfile_reuse_delete_files(evicted);
+
+	elog(gp_workfile_caching_loglevel, "workfile reuse: %s %s, " INT64_FORMAT " bytes",
+		 published ? "kept" : "discarded", wr->name, wr->size);
+
+	if (published)
+	{
+		wr->mode = WORKFILE_REUSE_DONE;
+		SIMPLE_FAULT_INJECTOR(WorkfileReusePublish);
+	}
+	else
+	{
+		workfile_reuse_delete_file(wr->name);
+		wr->mode = WORKFILE_REUSE_OFF;
+	}
+}
+
+/*
+ * Stop recording, and throw away what was recorded.
+ */
+static void
+workfile_reuse_abandon(WorkfileReuse *wr)
+{
+	Assert(wr->mode == WORKFILE_REUSE_RECORD);
+
+	BufFileClose(wr->file);
+	wr->file = NULL;
+	workfile_reuse_delete_file(wr->name);
+	wr->mode = WORKFILE_REUSE_OFF;
+}
+
+/*
+ * The node is being rescanned: replay from the start, or stop recording as
+ * the output would be read more than once.
+ */
+void
+workfile_reuse_rescan(WorkfileReuse *wr)
+{
+	if (wr == NULL)
+		return;
+
+	if (wr->mode == WORKFILE_REUSE_REPLAY)
+	{
+		ExecClearTuple(wr->slot);
+		if (BufFileSeek(wr->file, 0, wr->data_start, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in temporary file \"%s\": %m",
+							wr->name)));
+	}
+	else if (wr->mode == WORKFILE_REUSE_RECORD)
+		workfile_reuse_abandon(wr);
+}
+
+/*
+ * End of the node: unpin the entry replayed, or drop an unfinished
+ * recording.
+ */
+void
+workfile_reuse_end(WorkfileReuse *wr)
+{
+	if (wr == NULL)
+		return;
+
+	if (wr->mode == WORKFILE_REUSE_REPLAY)
+	{
+		ExecDropSingleTupleTableSlot(wr->slot);
+		BufFileClose(wr->file);
+		workfile_reuse_unpin(wr->entry);
+	}
+	else if (wr->mode == WORKFILE_REUSE_RECORD)
+		workfile_reuse_abandon(wr);
+
+	if (wr->buf)
+		pfree(wr->buf);
+
+	active_reuses = list_delete_ptr(active_reuses, wr);
+	pfree(wr);
+}
@@ -0,0 +1,34 @@
+/*------------------------------------------------------------------------------
+ *
+ * appendonly_visimap_cache
+ *   shared-memory cache of decoded visibility map bitmaps.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/access/appendonly_visimap_cache.h
+ *
+ *------------------------------------------------------------------------------
+*/
+#ifndef APPENDONLY_VISIMAP_CACHE_H
+#define APPENDONLY_VISIMAP_CACHE_H
+
+#include "nodes/bitmapset.h"
+#include "storage/relfilenode.h"
+
+extern Size AppendOnlyVisimapCache_ShmemSize(void);
+extern void AppendOnlyVisimapCache_ShmemInit(void);
+
+extern bool AppendOnlyVisimapCache_Lookup(const RelFileNode *visimapNode,
+							  int32 segmentFileNum,
+							  int64 firstRowNum,
+							  const struct varlena *data,
+							  Bitmapset **bitmap);
+extern void AppendOnlyVisimapCache_Insert(const RelFileNode *visimapNode,
+							  int32 segmentFileNum,
+							  int64 firstRowNum,
+							  const struct varlena *data,
+							  const Bitmapset *bitmap);
+
+#endif
@@ -18,6 +18,7 @@
 #include "access/appendonlytid.h"
 #include "access/htup.h"
 #include "nodes/bitmapset.h"
+#include "storage/relfilenode.h"
 #include "utils/tqual.h"
 #include "utils/bitmap_compression.h"
 
@@ -101,7 +102,8 @@ void AppendOnlyVisimapEntry_Reset(
 void AppendOnlyVisimapEntry_Copyout(
 							   AppendOnlyVisimapEntry *visi_map_entry,
 							   HeapTuple tuple,
-							   TupleDesc tupleDesc);
+							   TupleDesc tupleDesc,
+							   const RelFileNode *visimapNode);
 
 void AppendOnlyVisimapEntry_New(
 						   AppendOnlyVisimapEntry *visiMapEntry,
@@ -123,6 +125,11 @@ bool AppendOnlyVisimapEntry_IsVisible(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
 
+bool AppendOnlyVisimapEntry_IsRangeVisible(
+									  AppendOnlyVisimapEntry *visiMapEntry,
+									  int64 firstRowNum,
+									  int64 rowCount);
+
 HTSU_Result AppendOnlyVisimapEntry_HideTuple(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
@@ -943,6 +943,25 @@ heap_getattr(HeapTuple tup, int attnum, TupleDesc tupleDesc, bool *isnull)
     return result;
 }                               /* heap_getattr */
 
+/*
+ * Deforming plan of a tuple descriptor, for slot_deform_tuple.  The leading
+ * fixed-width attributes are at the same offsets in every tuple that has no
+ * null among them, so they can be fetched without working out the alignment
+ * and length of each in turn.
+ */
+typedef struct HeapTupleDeformAttr
+{
+	int32		off;			/* offset in the tuple data */
+	int16		len;			/* attlen, > 0 */
+	bool		byval;			/* attbyval */
+} HeapTupleDeformAttr;
+
+typedef struct HeapTupleDeform
+{
+	int			nfixed;			/* number of leading fixed-width attributes */
+	HeapTupleDeformAttr *attrs;	/* and their offsets, lengths and byval */
+} HeapTupleDeform;
+
 /* prototypes for functions in common/heaptuple.c */
 extern Size heap_compute_data_size(TupleDesc tupleDesc,
 					   Datum *values, bool *isnull);
@@ -979,6 +998,8 @@ extern HeapTuple heap_modify_tuple(HeapTuple tuple,
 				  bool *doReplace);
 extern void heap_deform_tuple(HeapTuple tuple, TupleDesc tupleDesc,
 				  Datum *values, bool *isnull);
+extern HeapTupleDeform *create_heaptuple_deform(TupleDesc tupdesc);
+extern void destroy_heaptuple_deform(HeapTupleDeform *deform);
 
 /* these three are deprecated versions of the three above: */
 extern HeapTuple heap_formtuple(TupleDesc tupleDescriptor,
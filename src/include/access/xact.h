@@ -163,10 +163,23 @@ typedef struct xl_xact_commit
  */
 #define XACT_COMPLETION_UPDATE_RELCACHE_FILE	0x01
 #define XACT_COMPLETION_FORCE_SYNC_COMMIT		0x02
+#define XACT_COMPLETION_ONE_PHASE_DISTRIBUTED	0x04
 
 /* Access macros for above flags */
 #define XactCompletionRelcacheInitFileInval(xinfo)	(xinfo & XACT_COMPLETION_UPDATE_RELCACHE_FILE)
 #define XactCompletionForceSyncCommit(xinfo)		(xinfo & XACT_COMPLETION_FORCE_SYNC_COMMIT)
+#define XactCompletionOnePhaseDistributed(xinfo)	(xinfo & XACT_COMPLETION_ONE_PHASE_DISTRIBUTED)
+
+/*
+ * A segment committing a distributed transaction in one phase appends this
+ * after the invalidation messages of its commit record, so that redo can
+ * update the DistributedLog the way it does for COMMIT_PREPARED.
+ */
+typedef struct xl_xact_one_phase_distrib
+{
+	DistributedTransactionTimeStamp distribTimeStamp;
+	DistributedTransactionId        distribXid;
+} xl_xact_one_phase_distrib;
 
 typedef struct xl_xact_abort
 {
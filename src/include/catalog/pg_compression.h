@@ -79,6 +79,8 @@ DATA(insert OID = 7063 ( none gp_dummy_compression_constructor gp_dummy_compress
 
 DATA(insert OID = 7070 ( zstd gp_zstd_constructor gp_zstd_destructor gp_zstd_compress gp_zstd_decompress gp_zstd_validator PGUID ));
 
+DATA(insert OID = 7077 ( lz4 gp_lz4_constructor gp_lz4_destructor gp_lz4_compress gp_lz4_decompress gp_lz4_validator PGUID ));
+
 #define NUM_COMPRESS_FUNCS 5
 
 #define COMPRESSION_CONSTRUCTOR 0
@@ -97,6 +99,22 @@ typedef struct CompressionState
 	 */
 	size_t (*desired_sz)(size_t input);
 
+	/*
+	 * Optional. A compressor and decompressor that may be called from a
+	 * helper thread: they must not allocate memory with palloc, elog or
+	 * otherwise touch backend state. They return false on failure, in which
+	 * case the caller is expected to retry through the regular function to
+	 * report the error. Like the regular compressor, threadsafe_compress
+	 * reports data that doesn't compress by setting *dst_used to src_sz.
+	 * Constructors set only the one matching their is_compress argument.
+	 */
+	bool (*threadsafe_compress)(struct CompressionState *cs,
+								const void *src, int32 src_sz,
+								void *dst, int32 dst_sz, int32 *dst_used);
+	bool (*threadsafe_decompress)(struct CompressionState *cs,
+								  const void *src, int32 src_sz,
+								  void *dst, int32 dst_sz, int32 *dst_used);
+
 	void *opaque; /* algorithm specific stuff opaque to the caller */
 } CompressionState;
 
@@ -272,6 +272,12 @@
 
  CREATE FUNCTION gp_request_fts_probe_scan() RETURNS bool LANGUAGE internal VOLATILE AS 'gp_request_fts_probe_scan' EXECUTE ON MASTER WITH (OID=5035, DESCRIPTION="Request a FTS probe scan and wait for response");
 
+ CREATE FUNCTION gp_get_fts_probe_stats(OUT content int2, OUT dbid int2, OUT last_probe_time timestamptz, OUT last_latency_ms int4, OUT probe_interval int4, OUT next_probe_time timestamptz, OUT troubled int4, OUT probes int8, OUT troubled_probes int8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_get_fts_probe_stats' EXECUTE ON MASTER WITH (OID=5052, DESCRIPTION="Statistics of FTS probes of each primary segment");
+
+ CREATE FUNCTION gp_get_session_gang_stats(OUT gangs_allocated int4, OUT gangs_reused int4, OUT gangs_created int4, OUT gang_create_time_ms float8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_get_session_gang_stats' EXECUTE ON MASTER WITH (OID=5053, DESCRIPTION="Statistics of the gangs of the current session");
+
+ CREATE FUNCTION gp_get_dtx_group_commit_stats(OUT commit_records int8, OUT flushes int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_get_dtx_group_commit_stats' EXECUTE ON MASTER WITH (OID=5054, DESCRIPTION="Distributed commit records flushed, and the WAL flushes they took");
+
 
  CREATE FUNCTION cosh(float8) RETURNS float8 LANGUAGE internal IMMUTABLE AS 'dcosh' WITH (OID=7539, DESCRIPTION="Hyperbolic cosine function");
 
@@ -323,6 +329,16 @@
 
  CREATE FUNCTION gp_zstd_validator(internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'zstd_validator' WITH(OID=7075, DESCRIPTION="zstdcompression validator");
 
+ CREATE FUNCTION gp_lz4_constructor(internal, internal, bool) RETURNS internal LANGUAGE internal VOLATILE AS 'lz4_constructor' WITH (OID=7078, DESCRIPTION="lz4 compressor and decompressor constructor");
+
+ CREATE FUNCTION gp_lz4_destructor(internal) RETURNS void LANGUAGE internal VOLATILE AS 'lz4_destructor' WITH(OID=7079, DESCRIPTION="lz4 compressor and decompressor destructor");
+
+ CREATE FUNCTION gp_lz4_compress(internal, int4, internal, int4, internal, internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'lz4_compress' WITH(OID=7091, DESCRIPTION="lz4 compressor");
+
+ CREATE FUNCTION gp_lz4_decompress(internal, int4, internal, int4, internal, internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'lz4_decompress' WITH(OID=7092, DESCRIPTION="lz4 decompressor");
+
+ CREATE FUNCTION gp_lz4_validator(internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'lz4_validator' WITH(OID=7093, DESCRIPTION="lz4 compression validator");
+
  CREATE FUNCTION gp_dummy_compression_constructor(internal, internal, bool) RETURNS internal LANGUAGE internal VOLATILE AS 'dummy_compression_constructor' WITH (OID=7064, DESCRIPTION="Dummy compression destructor");
 
  CREATE FUNCTION gp_dummy_compression_destructor(internal) RETURNS internal LANGUAGE internal VOLATILE AS 'dummy_compression_destructor' WITH (OID=7065, DESCRIPTION="Dummy compression destructor");
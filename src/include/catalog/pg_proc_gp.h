@@ -22,7 +22,7 @@
 
    WARNING: DO NOT MODIFY THE FOLLOWING SECTION: 
    Generated by catullus.pl version 8
-   on Mon Sep  3 23:10:02 2018
+   on Sun Oct 18 16:22:25 2026
 
    Please make your changes in pg_proc.sql
 */
@@ -551,6 +551,18 @@ DESCR("Remove a primary segment from the system catalog");
 DATA(insert OID = 5035 ( gp_request_fts_probe_scan  PGNSP PGUID 12 1 0 0 0 f f f f f f v 0 0 16 "" _null_ _null_ _null_ _null_ gp_request_fts_probe_scan _null_ _null_ _null_ n m ));
 DESCR("Request a FTS probe scan and wait for response");
 
+/* gp_get_fts_probe_stats(OUT content int2, OUT dbid int2, OUT last_probe_time timestamptz, OUT last_latency_ms int4, OUT probe_interval int4, OUT next_probe_time timestamptz, OUT troubled int4, OUT probes int8, OUT troubled_probes int8) => SETOF pg_catalog.record */
+DATA(insert OID = 5052 ( gp_get_fts_probe_stats  PGNSP PGUID 12 1 1000 0 0 f f f f f t v 0 0 2249 "" "{21,21,1184,23,23,1184,23,20,20}" "{o,o,o,o,o,o,o,o,o}" "{content,dbid,last_probe_time,last_latency_ms,probe_interval,next_probe_time,troubled,probes,troubled_probes}" _null_ gp_get_fts_probe_stats _null_ _null_ _null_ n m ));
+DESCR("Statistics of FTS probes of each primary segment");
+
+/* gp_get_session_gang_stats(OUT gangs_allocated int4, OUT gangs_reused int4, OUT gangs_created int4, OUT gang_create_time_ms float8) => pg_catalog.record */
+DATA(insert OID = 5053 ( gp_get_session_gang_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v 0 0 2249 "" "{23,23,23,701}" "{o,o,o,o}" "{gangs_allocated,gangs_reused,gangs_created,gang_create_time_ms}" _null_ gp_get_session_gang_stats _null_ _null_ _null_ n m ));
+DESCR("Statistics of the gangs of the current session");
+
+/* gp_get_dtx_group_commit_stats(OUT commit_records int8, OUT flushes int8) => pg_catalog.record */
+DATA(insert OID = 5054 ( gp_get_dtx_group_commit_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v 0 0 2249 "" "{20,20}" "{o,o}" "{commit_records,flushes}" _null_ gp_get_dtx_group_commit_stats _null_ _null_ _null_ n m ));
+DESCR("Distributed commit records flushed, and the WAL flushes they took");
+
 /* cosh(float8) => float8 */
 DATA(insert OID = 7539 ( cosh  PGNSP PGUID 12 1 0 0 0 f f f f f f i 1 0 701 "701" _null_ _null_ _null_ _null_ dcosh _null_ _null_ _null_ n a ));
 DESCR("Hyperbolic cosine function");
@@ -651,6 +663,26 @@ DESCR("zstd decompressor");
 DATA(insert OID = 7075 ( gp_zstd_validator  PGNSP PGUID 12 1 0 0 0 f f f f f f i 1 0 2278 "2281" _null_ _null_ _null_ _null_ zstd_validator _null_ _null_ _null_ n a ));
 DESCR("zstdcompression validator");
 
+/* gp_lz4_constructor(internal, internal, bool) => internal */
+DATA(insert OID = 7078 ( gp_lz4_constructor  PGNSP PGUID 12 1 0 0 0 f f f f f f v 3 0 2281 "2281 2281 16" _null_ _null_ _null_ _null_ lz4_constructor _null_ _null_ _null_ n a ));
+DESCR("lz4 compressor and decompressor constructor");
+
+/* gp_lz4_destructor(internal) => void */
+DATA(insert OID = 7079 ( gp_lz4_destructor  PGNSP PGUID 12 1 0 0 0 f f f f f f v 1 0 2278 "2281" _null_ _null_ _null_ _null_ lz4_destructor _null_ _null_ _null_ n a ));
+DESCR("lz4 compressor and decompressor destructor");
+
+/* gp_lz4_compress(internal, int4, internal, int4, internal, internal) => void */
+DATA(insert OID = 7091 ( gp_lz4_compress  PGNSP PGUID 12 1 0 0 0 f f f f f f i 6 0 2278 "2281 23 2281 23 2281 2281" _null_ _null_ _null_ _null_ lz4_compress _null_ _null_ _null_ n a ));
+DESCR("lz4 compressor");
+
+/* gp_lz4_decompress(internal, int4, internal, int4, internal, internal) => void */
+DATA(insert OID = 7092 ( gp_lz4_decompress  PGNSP PGUID 12 1 0 0 0 f f f f f f i 6 0 2278 "2281 23 2281 23 2281 2281" _null_ _null_ _null_ _null_ lz4_decompress _null_ _null_ _null_ n a ));
+DESCR("lz4 decompressor");
+
+/* gp_lz4_validator(internal) => void */
+DATA(insert OID = 7093 ( gp_lz4_validator  PGNSP PGUID 12 1 0 0 0 f f f f f f i 1 0 2278 "2281" _null_ _null_ _null_ _null_ lz4_validator _null_ _null_ _null_ n a ));
+DESCR("lz4 compression validator");
+
 /* gp_dummy_compression_constructor(internal, internal, bool) => internal */
 DATA(insert OID = 7064 ( gp_dummy_compression_constructor  PGNSP PGUID 12 1 0 0 0 f f f f f f v 3 0 2281 "2281 2281 16" _null_ _null_ _null_ _null_ dummy_compression_constructor _null_ _null_ _null_ n a ));
 DESCR("Dummy compression destructor");
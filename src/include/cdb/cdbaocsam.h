@@ -67,6 +67,17 @@ typedef struct AOCSInsertDescData
 	 * Certain statistics are then counted differently.
 	 */ 
 	bool update_mode;
+
+	/*
+	 * Helper threads for compressing the full blocks of several columns in
+	 * parallel in aocs_insert_values_multi(), see cdbappendonlydecompress.c.
+	 * 0 if blocks are compressed serially; the arrays are only allocated
+	 * otherwise.
+	 */
+	int			compressThreads;
+	struct AppendOnlyDecompressTask *compressTasks;
+	int		   *compressTaskCols;	/* column of each task */
+	int		   *bulkRowPos;			/* next row to add, per column */
 } AOCSInsertDescData;
 
 typedef AOCSInsertDescData *AOCSInsertDesc;
@@ -126,6 +137,27 @@ typedef struct AOCSScanDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * The block whose rows were last checked against the visibility map as a
+	 * whole: rows [visimapBlockFirstRowNum, visimapBlockEndRowNum) of segment
+	 * file visimapBlockSegno. visimapBlockAllVisible tells whether the
+	 * per-row checks can be skipped for it.
+	 */
+	int			visimapBlockSegno;
+	int64		visimapBlockFirstRowNum;
+	int64		visimapBlockEndRowNum;
+	bool		visimapBlockAllVisible;
+
+	/*
+	 * Helper threads for decompressing the blocks of several columns in
+	 * parallel, see cdbappendonlydecompress.c. 0 if the scan decompresses
+	 * serially; the arrays are only allocated otherwise.
+	 */
+	int			decompressThreads;
+	struct AppendOnlyDecompressTask *decompressTasks;
+	int		   *decompressBlockAttnos;	/* columns that need a new block */
+	int		   *decompressTaskAttnos;	/* column of each task */
+
 }	AOCSScanDescData;
 
 typedef AOCSScanDescData *AOCSScanDesc;
@@ -214,6 +246,12 @@ extern void aocs_endscan(AOCSScanDesc scan);
 extern void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno, bool update_mode);
 extern Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
+extern void aocs_insert_values_multi(AOCSInsertDesc idesc, Datum **values,
+									 bool **nulls, int nrows,
+									 AOTupleId *aoTupleIds);
+extern int64 aocs_insert_segfile(AOCSInsertDesc idesc,
+								 AOCSFileSegInfo *segInfo,
+								 AppendOnlyVisimap *visiMap);
 static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
 {
 	Oid oid;
@@ -221,6 +221,12 @@ typedef struct AppendOnlyScanDescData
 	 */ 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * True if the visibility map hides no row of the current block, so the
+	 * per-tuple checks can be skipped.
+	 */
+	bool		blockAllVisible;
+
 }	AppendOnlyScanDescData;
 
 typedef AppendOnlyScanDescData *AppendOnlyScanDesc;
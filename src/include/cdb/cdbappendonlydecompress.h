@@ -0,0 +1,53 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbappendonlydecompress.h
+ *	  Compression and decompression of append-only storage blocks on helper
+ *	  threads.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbappendonlydecompress.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef CDBAPPENDONLYDECOMPRESS_H
+#define CDBAPPENDONLYDECOMPRESS_H
+
+#include "catalog/pg_compression.h"
+
+/* Upper limit of gp_aocs_decompress_threads and gp_aocs_compress_threads */
+#define MAX_AOCS_DECOMPRESS_THREADS 32
+
+/*
+ * One block to decompress, or to compress. Everything a helper thread needs
+ * is in here: the buffers are allocated, and the compression state
+ * constructed, by the backend before the task is handed over, and the result
+ * is only looked at by the backend afterwards.
+ *
+ * When compressing, compressedLen is the size of the output buffer, and
+ * resultLen the length of the compressed data; a resultLen equal to
+ * uncompressedLen means the block didn't compress.
+ */
+typedef struct AppendOnlyDecompressTask
+{
+	bool		compress;
+
+	uint8	   *compressed;
+	int32		compressedLen;
+	uint8	   *uncompressed;
+	int32		uncompressedLen;
+
+	CompressionState *compressionState;
+
+	/* Output */
+	int32		resultLen;
+	bool		succeeded;
+} AppendOnlyDecompressTask;
+
+extern int	AppendOnlyDecompress_NumThreads(int maxThreads, int numColumns);
+extern void AppendOnlyDecompress_Run(AppendOnlyDecompressTask *tasks,
+						 int numTasks, int numThreads);
+
+#endif   /* CDBAPPENDONLYDECOMPRESS_H */
@@ -16,6 +16,7 @@
 
 #include "catalog/pg_appendonly.h"
 #include "catalog/pg_compression.h"
+#include "cdb/cdbappendonlydecompress.h"
 #include "cdb/cdbappendonlystorage.h"
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbbufferedread.h"
@@ -221,6 +222,13 @@ extern int64 AppendOnlyStorageRead_OverallBlockLen(AppendOnlyStorageRead *storag
 extern uint8 *AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead);
 extern void AppendOnlyStorageRead_Content(AppendOnlyStorageRead *storageRead,
 							  uint8 *contentOut, int32 contentLen);
+extern bool AppendOnlyStorageRead_PrepareDecompress(AppendOnlyStorageRead *storageRead,
+										uint8 *contentOut, int32 contentLen,
+										AppendOnlyDecompressTask *task);
+extern void AppendOnlyStorageRead_FinishDecompress(AppendOnlyStorageRead *storageRead,
+									   AppendOnlyDecompressTask *task);
+extern uint8 *AppendOnlyStorageRead_GetStoredContent(AppendOnlyStorageRead *storageRead,
+									   int *headerKind, int32 *compressedLen);
 extern void AppendOnlyStorageRead_SkipCurrentBlock(AppendOnlyStorageRead *storageRead);
 
 extern char *AppendOnlyStorageRead_ContextStr(AppendOnlyStorageRead *storageRead);
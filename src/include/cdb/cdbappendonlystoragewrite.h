@@ -16,6 +16,7 @@
 
 #include "catalog/pg_appendonly.h"
 #include "catalog/pg_compression.h"
+#include "cdb/cdbappendonlydecompress.h"
 #include "cdb/cdbappendonlystorage.h"
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbbufferedappend.h"
@@ -219,6 +220,21 @@ extern void AppendOnlyStorageWrite_FinishBuffer(
 									int executorBlockKind,
 									int rowCount);
 
+extern bool AppendOnlyStorageWrite_PrepareCompress(AppendOnlyStorageWrite *storageWrite,
+									   int32 contentLen,
+									   AppendOnlyDecompressTask *task);
+extern void AppendOnlyStorageWrite_FinishCompressedBuffer(AppendOnlyStorageWrite *storageWrite,
+											  int32 contentLen,
+											  int executorBlockKind,
+											  int rowCount,
+											  AppendOnlyDecompressTask *task);
+extern void AppendOnlyStorageWrite_StoredContent(AppendOnlyStorageWrite *storageWrite,
+									 int aoHeaderKind,
+									 uint8 *storedContent,
+									 int32 contentLen,
+									 int32 compressedLen,
+									 int executorBlockKind,
+									 int rowCount);
 extern void AppendOnlyStorageWrite_CancelLastBuffer(AppendOnlyStorageWrite *storageWrite);
 
 extern void AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
@@ -16,6 +16,7 @@
 #ifndef CDBCONN_H
 #define CDBCONN_H
 
+#include "cdb/cdbvars.h"
 
 /* --------------------------------------------------------------------------------------------------
  * Structure for segment database definition and working values
@@ -63,6 +64,13 @@ typedef struct SegmentDatabaseDescriptor
     int4					backendPid;
     char                   *whoami;         /* QE identifier for msgs */
 
+	/*
+	 * Id of the plan this QE holds in each slot of its dispatched plan
+	 * cache, 0 if none.  See cdbdisp_plancache.c.
+	 */
+	uint32					cachedPlanIds[MAX_GP_DISPATCH_PLAN_CACHE_SIZE];
+
+
 } SegmentDatabaseDescriptor;
 
 
@@ -53,6 +53,7 @@ typedef struct CdbDispatcherState
 	bool recycleGang;
 	struct CdbDispatchResults *primaryResults;
 	void *dispatchParams;
+	bool dispatchPending; /* commands not all sent yet, see gp_dispatch_pipelined */
 } CdbDispatcherState;
 
 typedef struct DispatcherInternalFuncs
@@ -65,6 +66,7 @@ typedef struct DispatcherInternalFuncs
 	void (*dispatchToGang)(struct CdbDispatcherState *ds, struct Gang *gp,
 			int sliceIndex, CdbDispatchDirectDesc *direct);
 	void (*waitDispatchFinish)(struct CdbDispatcherState *ds);
+	void (*setQueryText)(struct CdbDispatcherState *ds, char *queryText, int queryTextLen);
 
 }DispatcherInternalFuncs;
 
@@ -164,6 +166,13 @@ cdbdisp_cancelDispatch(CdbDispatcherState *ds);
  */
 CdbDispatcherState * cdbdisp_makeDispatcherState(bool isExtendedQuery);
 
+/*
+ * Change the command sent by the following cdbdisp_dispatchToGang calls, to
+ * send each gang a command of its own.  The text must stay around until the
+ * dispatch is finished.
+ */
+void cdbdisp_setDispatchQueryText(CdbDispatcherState *ds, char *queryText, int queryTextLen);
+
 /*
  * Free memory in CdbDispatcherState
  *
@@ -0,0 +1,27 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbdisp_plancache.h
+ *	  Per-session cache of dispatched plans, on the QD and on the QEs.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbdisp_plancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef CDBDISP_PLANCACHE_H
+#define CDBDISP_PLANCACHE_H
+
+#include "nodes/plannodes.h"
+
+/* QD side */
+extern char *cdbdisp_compressPlan(char *flat, int flat_len, int *size,
+					 int *slot, uint32 *planId);
+
+/* QE side */
+extern void cdbdisp_cacheReceivedPlan(int slot, uint32 planId, PlannedStmt *stmt);
+extern PlannedStmt *cdbdisp_getCachedPlan(int slot, uint32 planId);
+
+#endif   /* CDBDISP_PLANCACHE_H */
@@ -57,13 +57,17 @@ typedef struct DistributedSnapshotWithLocalMapping
 
 	/*
 	 * Cache to perform quick check for localXid, populated after reverse
-	 * mapping distributed xid to local xid.
+	 * mapping distributed xid to local xid.  The distributed xid of each
+	 * cached local xid is kept alongside, so that the entries still in
+	 * progress can be carried over to the next distributed snapshot (see
+	 * DistributedSnapshotWithLocalMapping_Install).
 	 */
 	TransactionId minCachedLocalXid;
 	TransactionId maxCachedLocalXid;
 	int32 currentLocalXidsCount;
 	int32 maxLocalXidsCount;
 	TransactionId *inProgressMappedLocalXids;
+	DistributedTransactionId *inProgressMappedDistribXids;
 } DistributedSnapshotWithLocalMapping;
 
 typedef enum
@@ -79,6 +83,14 @@ extern DistributedSnapshotCommitted DistributedSnapshotWithLocalMapping_Committe
 	TransactionId 							localXid,
 	bool isVacuumCheck);
 
+extern void DistributedSnapshotWithLocalMapping_Install(
+	DistributedSnapshotWithLocalMapping		*dslm,
+	DistributedSnapshot						*source);
+
+extern bool DistributedSnapshot_IsInProgress(
+	DistributedSnapshot *ds,
+	DistributedTransactionId distribXid);
+
 extern void DistributedSnapshot_Reset(
 	DistributedSnapshot *distributedSnapshot);
 
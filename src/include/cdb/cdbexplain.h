@@ -63,6 +63,30 @@ cdbexplain_agg_avg(CdbExplain_Agg *agg)
 }
 
 
+/*
+ * cdbexplain_addDispatchTime
+ *    Called by qDisp after dispatching a plan, to add the time spent
+ *    allocating gangs for it, and flattening, compressing and sending it
+ *    to the statement statistics.
+ */
+void
+cdbexplain_addDispatchTime(struct CdbExplain_ShowStatCtx *showstatctx,
+                           instr_time                     gangs,
+                           instr_time                     serialize,
+                           instr_time                     compress,
+                           instr_time                     send);
+
+/*
+ * cdbexplain_addInterconnectSetupTime
+ *    Called by qDisp after setting up its end of the interconnect, to add
+ *    the time it took, and the time then spent finishing sending a pipelined
+ *    dispatch, to the statement statistics.
+ */
+void
+cdbexplain_addInterconnectSetupTime(struct CdbExplain_ShowStatCtx *showstatctx,
+                                    instr_time                     setup,
+                                    instr_time                     send);
+
 /*
  * cdbexplain_localExecStats
  *    Called by qDisp to build NodeSummary and SliceSummary blocks
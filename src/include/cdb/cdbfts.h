@@ -7,6 +7,7 @@
 #ifndef CDBFTS_H
 #define CDBFTS_H
 
+#include "pgtime.h"
 #include "storage/lwlock.h"
 #include "cdb/cdbconn.h"
 #include "utils/guc.h"
@@ -39,13 +40,35 @@ typedef struct FtsProbeInfo
 
 #define FTS_MAX_TRANSIENT_STATE 100
 
+/*
+ * Probe statistics and schedule of one primary-mirror pair, indexed by
+ * content id.  There is one for each content in the cluster, as given by
+ * gp_num_contents_in_cluster when the server started.  Only the FTS process writes them, without a lock; readers
+ * may see a probe half recorded, which is fine for monitoring.
+ */
+typedef struct FtsProbeStats
+{
+	int16		dbid;			/* primary last probed, 0 if never probed */
+	int32		interval;		/* seconds between probes of this pair */
+	int32		troubled;		/* consecutive probes timed out or retried */
+	int32		lastLatency;	/* milliseconds the last probe took */
+	pg_time_t	lastProbeTime;
+	pg_time_t	nextProbeTime;
+	int64		probes;
+	int64		troubledProbes;
+} FtsProbeStats;
+
 typedef struct FtsControlBlock
 {
 	LWLockId	ControlLock;
 	FtsProbeInfo fts_probe_info;
+	int			num_probe_stats;
+	FtsProbeStats fts_probe_stats[1];	/* VARIABLE LENGTH ARRAY */
 }	FtsControlBlock;
 
 extern volatile FtsProbeInfo *ftsProbeInfo;
+extern volatile FtsProbeStats *ftsProbeStats;
+extern int	ftsNumProbeStats;
 
 extern int	FtsShmemSize(void);
 extern void FtsShmemInit(void);
@@ -79,6 +79,8 @@ extern Gang *AllocateWriterGang(struct CdbDispatcherState *ds);
 
 extern void AllocateAllIdleReaderGangs(struct CdbDispatcherState *ds);
 
+extern void CreateMissingReaderGangs(int numNeeded);
+
 extern List *getCdbProcessList(Gang *gang, int sliceIndex, struct DirectDispatchInfo *directDispatch);
 
 extern bool GangOK(Gang *gp);
@@ -178,9 +180,11 @@ typedef struct CdbProcess
 } CdbProcess;
 
 typedef Gang *(*CreateGangFunc)(GangType type, int gang_id, int size, int content);
+typedef void (*CreateReaderGangsFunc)(Gang **gangs, int ngangs);
 
 extern void cdbgang_setAsync(bool async);
 extern void cdbgang_resetPrimaryWriterGang(void);
 extern void cdbgang_decreaseNumReaderGang(void);
 extern void AvailableWriterGangValidation(void);
+extern void logGangStats(void);
 #endif   /* _CDBGANG_H_ */
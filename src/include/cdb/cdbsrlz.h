@@ -19,8 +19,21 @@
 #define CDBSRLZ_H
 
 #include "nodes/nodes.h"
+#include "portability/instr_time.h"
+
+struct PlannedStmt;
+struct Bitmapset;
+
+/* Time spent flattening and compressing nodes in this backend */
+extern instr_time serializeNodeTime;
+extern instr_time compressNodeTime;
 
 extern char *serializeNode(Node *node, int *size, int *uncompressed_size);
+extern char *serializeNodeUncompressed(Node *node, int *size);
+extern char *serializePlanForSliceUncompressed(struct PlannedStmt *stmt,
+								  struct Bitmapset *motions,
+								  struct Bitmapset *subplans, int *size);
+extern char *compressSerializedNode(const char *pszNode, int uncompressed_size, int *size);
 extern Node *deserializeNode(const char *strNode, int size);
 
 #endif   /* CDBSRLZ_H */
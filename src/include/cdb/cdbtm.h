@@ -40,6 +40,12 @@ typedef enum
 	 */
 	DTX_STATE_ACTIVE_DISTRIBUTED,
 
+	/**
+	 * Only one segment took part in the transaction, and it is being told to
+	 *   commit without a prepare (gp_enable_one_phase_commit)
+	 */
+	DTX_STATE_ONE_PHASE_COMMIT,
+
 	/**
 	 * For two-phase commit, the first phase is about to run
 	 */
@@ -108,7 +114,19 @@ typedef enum
 	DTX_PROTOCOL_COMMAND_SUBTRANSACTION_ROLLBACK_INTERNAL,
 	DTX_PROTOCOL_COMMAND_SUBTRANSACTION_RELEASE_INTERNAL,
 
-	DTX_PROTOCOL_COMMAND_LAST = DTX_PROTOCOL_COMMAND_SUBTRANSACTION_RELEASE_INTERNAL
+	/**
+	 * Commit the transaction on the only segment that took part in it,
+	 *   without preparing it first
+	 */
+	DTX_PROTOCOL_COMMAND_COMMIT_ONEPHASE,
+
+	/**
+	 * Ask a segment whether a one-phase commit, whose reply was lost, went
+	 *   through there
+	 */
+	DTX_PROTOCOL_COMMAND_RETRY_COMMIT_ONEPHASE,
+
+	DTX_PROTOCOL_COMMAND_LAST = DTX_PROTOCOL_COMMAND_RETRY_COMMIT_ONEPHASE
 } DtxProtocolCommand;
 
 /* DTX Context above xact.c */
@@ -265,6 +283,10 @@ typedef struct TmControlBlock
 	uint32						NextSnapshotId;
 	int							num_committed_xacts;
 
+	/* distributed commit records flushed, and the WAL flushes that took */
+	uint64						commitRecordsFlushed;
+	uint64						commitFlushes;
+
     /* Array [0..max_tm_gxacts-1] of TMGXACT_LOG ptrs is appended starting here */
 	TMGXACT_LOG  			    committed_gxact_array[1];
 }	TmControlBlock;
@@ -296,6 +318,8 @@ extern void initGxact(TMGXACT *gxact);
 extern void setCurrentGxact(void);
 extern void	prepareDtxTransaction(void);
 extern bool isPreparedDtxTransaction(void);
+extern bool getOnePhaseDtxCommitInfo(DistributedTransactionTimeStamp *distribTimeStamp,
+									 DistributedTransactionId *distribXid);
 extern void getDtxLogInfo(TMGXACT_LOG *gxact_log);
 extern bool notifyCommittedDtxTransactionIsNeeded(void);
 extern void notifyCommittedDtxTransaction(void);
@@ -305,6 +329,8 @@ extern DistributedTransactionId getMaxDistributedXid(void);
 extern bool includeInCheckpointIsNeeded(TMGXACT *gxact);
 extern void insertingDistributedCommitted(void);
 extern void insertedDistributedCommitted(void);
+extern void flushDistributedCommitted(XLogRecPtr recptr);
+extern void logDistributedCommitFlushStats(void);
 
 extern void redoDtxCheckPoint(TMGXACT_CHECKPOINT *gxact_checkpoint);
 extern void redoDistributedCommitRecord(TMGXACT_LOG *gxact_log);
@@ -329,6 +329,8 @@ extern int	gp_snapshotadd_timeout; /* GUC var - timeout specifier for snapshot-c
 extern int	gp_fts_probe_retries; /* GUC var - specifies probe number of retries for FTS */
 extern int	gp_fts_probe_timeout; /* GUC var - specifies probe timeout for FTS */
 extern int	gp_fts_probe_interval; /* GUC var - specifies polling interval for FTS */
+extern int	gp_fts_probe_max_concurrency; /* GUC var - max probes in flight */
+extern bool	gp_fts_probe_spread; /* GUC var - probe segments on their own schedule */
 extern int gp_fts_mark_mirror_down_grace_period;
 
 extern int gp_gang_creation_retry_count; /* How many retries ? */
@@ -496,6 +498,19 @@ extern bool gp_enable_fast_sri;
 /* Enable single-mirror pair dispatch. */
 extern bool gp_enable_direct_dispatch;
 
+/*
+ * Commit a distributed transaction that wrote on a single segment in one
+ * phase, and let segments that wrote nothing skip the second phase.
+ */
+extern bool gp_enable_one_phase_commit;
+
+/*
+ * How long, in microseconds, the backend flushing a distributed commit record
+ * waits for the commit records of concurrent distributed transactions.
+ */
+extern int gp_dtx_group_commit_delay;
+#define MAX_GP_DTX_GROUP_COMMIT_DELAY 100000
+
 /* Name of pseudo-function to access any table as if it was randomly distributed. */
 #define GP_DIST_RANDOM_NAME "GP_DIST_RANDOM"
 
@@ -742,6 +757,17 @@ extern bool gp_enable_sort_distinct;
 /* Greenplum MK Sort */
 extern bool gp_enable_mk_sort;
 extern bool gp_enable_motion_mk_sort;
+extern bool gp_enable_mk_radix_sort;
+
+/* Evaluate window aggregates over sliding ROWS frames with segment trees */
+extern bool gp_enable_window_segment_tree;
+
+/* Evaluate quals and projections as flattened steps, see execSteps.c */
+extern bool gp_enable_expr_steps;
+
+/* Shared-memory channels of cross-slice ShareInputScans, see nodeShareInputScan.c */
+extern int gp_shareinput_channels;
+extern int gp_shareinput_channel_size;
 
 #ifdef USE_ASSERT_CHECKING
 extern bool gp_mk_sort_check;
@@ -778,9 +804,52 @@ extern int gp_segworker_relative_priority;
 /*  Max size of dispatched plans; 0 if no limit */
 extern int gp_max_plan_size;
 
+/*
+ * Number of dispatched plans the QD and its QEs keep per session, so that a
+ * plan dispatched again is sent by reference; 0 to disable.
+ */
+#define MAX_GP_DISPATCH_PLAN_CACHE_SIZE 32
+extern int gp_dispatch_plan_cache_size;
+
+/*
+ * How serialized plans and query trees are compressed for dispatch, and the
+ * size in kB below which they are sent uncompressed.  See cdbsrlz.c.
+ */
+typedef enum DispatchCompressAlgorithm
+{
+	DISPATCH_COMPRESS_NONE = 0,
+	DISPATCH_COMPRESS_ZLIB,
+	DISPATCH_COMPRESS_LZ4,
+	DISPATCH_COMPRESS_ZSTD
+} DispatchCompressAlgorithm;
+
+extern int gp_dispatch_compress_algorithm;
+extern int gp_dispatch_compress_threshold;
+
+/*
+ * Send each gang a plan of its own, without the subtrees of the slices it
+ * doesn't execute.  Only takes effect with execute_pruned_plan.
+ */
+extern bool gp_dispatch_slice_plans;
+
+/*
+ * Set up the QD's end of the interconnect before waiting for the plan to be
+ * sent to every QE.  Only takes effect with the UDPIFC interconnect.
+ */
+extern bool gp_dispatch_pipelined;
+
 /* If we use two stage hashagg, we can stream the bottom half */
 extern bool gp_hashagg_streambottom;
 
+/* Use the open-addressing layout for hashagg's hash table */
+extern bool gp_hashagg_open_addressing;
+
+/*
+ * A streaming bottom stage hashagg whose hash table reduces its input by less
+ * than this fraction stops aggregating and passes its input rows through.
+ */
+extern double gp_hashagg_bypass_min_reduction;
+
 /* The default number of batches to use when the hybrid hashed aggregation
  * algorithm (re-)spills in-memory groups to disk.
  */
@@ -834,6 +903,14 @@ extern int gp_sessionstate_loglevel;
 extern int gp_workfile_bytes_to_checksum;
 /* The type of work files that HashJoin should use */
 extern int gp_workfile_type_hashjoin;
+/* Reuse the spilled output of identical subplans across queries */
+extern bool gp_workfile_reuse;
+/* Disk space (in KB) kept for reusable workfiles per segment */
+extern int gp_workfile_reuse_limit;
+/* Do workfile I/O on a helper thread */
+extern bool gp_workfile_async_io;
+/* Let operators borrow memory that other operators of the query gave back */
+extern bool gp_enable_memory_broker;
 
 extern bool coredump_on_memerror;
 
@@ -49,6 +49,26 @@ typedef struct HashAggEntry
 
 typedef HashAggEntry* HashAggBucket;
 
+/* Number of grouping columns that can be stored in a HashAggSlot */
+#define HHA_INLINE_KEYS 2
+
+/*
+ * A slot of the open-addressing hash table (gp_hashagg_open_addressing).
+ *
+ * The slots form one dense array probed linearly. Each slot keeps a copy of
+ * its entry's hash value, so that a probe doesn't have to touch the entry
+ * unless the hash values match, and, when all grouping columns are passed by
+ * value and there are at most HHA_INLINE_KEYS of them, the grouping key
+ * itself, so that matching the key doesn't have to touch the entry either.
+ */
+typedef struct HashAggSlot
+{
+	HashAggEntry *entry;		/* NULL if the slot is free */
+	HashKey		hashvalue;		/* entry->hashvalue */
+	uint32		keynulls;		/* bit i set if inline key column i is NULL */
+	Datum		keys[HHA_INLINE_KEYS];	/* inline grouping key */
+} HashAggSlot;
+
 /* A SpillFile controls access to a temporary file used to hold  
  * transition tuples spilled from the hash table in order to free 
  * up space.
@@ -157,6 +177,14 @@ typedef struct HashAggTable
 	HashAggBucket  *buckets;
 	uint64 *bloom;
 
+	/*
+	 * With the open-addressing layout, the table is the slots array instead
+	 * of buckets and bloom, and nbuckets is the number of slots.
+	 */
+	bool open_addressing;
+	bool inline_keys;	/* grouping keys are stored in the slots */
+	HashAggSlot *slots;
+
 	/* hashkey bitshift amount to determine bucket - used when spilling */
 	unsigned pshift;
 
@@ -207,6 +235,16 @@ typedef struct HashAggTable
 	bool expandable;  /* hash table buckets still have space to grow */
 	struct TupleTableSlot *prev_slot; /* a slot that is read previously. */
 
+	/*
+	 * A streaming table that stopped aggregating because a full table
+	 * reduced its input too little.  The input tuples and groups of that
+	 * fill are kept for EXPLAIN ANALYZE.
+	 */
+	bool bypass;
+	uint64 bypass_fill_tuples;
+	uint64 bypass_fill_groups;
+	uint64 num_bypass_tuples; /* number of input tuples passed through */
+
 	/* Statistics used for EXPLAIN ANALYZE */
 	CdbExplain_Agg      chainlength;
 	uint64 total_buckets; /* total of nbuckets across spills and reloads */
@@ -215,6 +253,9 @@ typedef struct HashAggTable
 extern HashAggTable *create_agg_hash_table(AggState *aggstate);
 extern bool agg_hash_initial_pass(AggState *aggstate);
 extern bool agg_hash_stream(AggState *aggstate);
+extern void agg_hash_start_bypass(AggState *aggstate);
+extern AggStatePerGroup agg_hash_bypass_next(AggState *aggstate,
+											 struct TupleTableSlot **outerslot);
 extern bool agg_hash_next_pass(AggState *aggstate);
 extern bool agg_hash_continue_pass(AggState *aggstate);
 extern void destroy_agg_hash_table(AggState *aggstate);
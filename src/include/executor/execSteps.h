@@ -0,0 +1,142 @@
+/*-------------------------------------------------------------------------
+ *
+ * execSteps.h
+ *	  Flattened, step-based form of expression state trees.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/executor/execSteps.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECSTEPS_H
+#define EXECSTEPS_H
+
+#include "fmgr.h"
+#include "nodes/execnodes.h"
+
+/*
+ * Step opcodes.  Keep in step with the dispatch table in ExecEvalExprSteps.
+ */
+typedef enum ExprStepOp
+{
+	STEP_DONE,
+
+	/* deform the slot up to the last attribute any Var of it needs */
+	STEP_DEFORM_INNER,
+	STEP_DEFORM_OUTER,
+	STEP_DEFORM_SCAN,
+
+	STEP_INNER_VAR,
+	STEP_OUTER_VAR,
+	STEP_SCAN_VAR,
+
+	STEP_CONST,
+
+	/* looks the function up on first use, and turns into one of the below */
+	STEP_FUNC_INIT,
+	STEP_FUNC,
+	STEP_FUNC_STRICT,
+	STEP_FUNC_FUSAGE,
+
+	STEP_BOOL_AND_FIRST,
+	STEP_BOOL_AND,
+	STEP_BOOL_AND_LAST,
+	STEP_BOOL_OR_FIRST,
+	STEP_BOOL_OR,
+	STEP_BOOL_OR_LAST,
+	STEP_BOOL_NOT,
+
+	STEP_NULLTEST_ISNULL,
+	STEP_NULLTEST_ISNOTNULL,
+
+	/* evaluate a subtree that isn't flattened the ordinary way */
+	STEP_EVAL_EXPRSTATE,
+
+	/* strict comparisons of two fixed width arguments */
+	STEP_INT2_EQ, STEP_INT2_NE, STEP_INT2_LT, STEP_INT2_LE, STEP_INT2_GT, STEP_INT2_GE,
+	STEP_INT4_EQ, STEP_INT4_NE, STEP_INT4_LT, STEP_INT4_LE, STEP_INT4_GT, STEP_INT4_GE,
+	STEP_INT8_EQ, STEP_INT8_NE, STEP_INT8_LT, STEP_INT8_LE, STEP_INT8_GT, STEP_INT8_GE,
+	STEP_FLOAT4_EQ, STEP_FLOAT4_NE, STEP_FLOAT4_LT, STEP_FLOAT4_LE, STEP_FLOAT4_GT, STEP_FLOAT4_GE,
+	STEP_FLOAT8_EQ, STEP_FLOAT8_NE, STEP_FLOAT8_LT, STEP_FLOAT8_LE, STEP_FLOAT8_GT, STEP_FLOAT8_GE,
+
+	STEP_LAST
+} ExprStepOp;
+
+typedef struct ExprStep
+{
+	/* ExprStepOp, or the address of its code when direct threaded */
+	intptr_t	opcode;
+
+	/* where to store the result */
+	Datum	   *resvalue;
+	bool	   *resnull;
+
+	union
+	{
+		/* STEP_DEFORM_* */
+		struct
+		{
+			int			last_attnum;
+			bool		checked;	/* Var types checked against the slot */
+			int			nvars;
+			AttrNumber *attnums;
+			Oid		   *vartypes;
+		}			deform;
+
+		/* STEP_*_VAR */
+		struct
+		{
+			AttrNumber	attnum;
+		}			var;
+
+		/* STEP_CONST */
+		struct
+		{
+			Datum		value;
+			bool		isnull;
+		}			constval;
+
+		/* STEP_FUNC_*, and the comparisons */
+		struct
+		{
+			Oid			foid;
+			Oid			inputcollid;
+			Expr	   *expr;
+			int			nargs;
+			FmgrInfo   *finfo;
+			FunctionCallInfo fcinfo;
+		}			func;
+
+		/* STEP_BOOL_* */
+		struct
+		{
+			bool	   *anynull;
+			int			jumpdone;	/* step to go to once the result is known */
+		}			boolexpr;
+
+		/* STEP_EVAL_EXPRSTATE */
+		struct
+		{
+			ExprState  *state;
+		}			eval;
+	}			d;
+} ExprStep;
+
+typedef struct ExprSteps
+{
+	int			nsteps;
+	ExprStep   *steps;
+
+	/* result of the whole expression */
+	Datum		resvalue;
+	bool		resnull;
+} ExprSteps;
+
+extern void ExecCompileExprSteps(ExprState *state);
+extern Datum ExecEvalExprSteps(ExprState *state, ExprContext *econtext,
+				  bool *isNull, ExprDoneCond *isDone);
+
+#endif   /* EXECSTEPS_H */
@@ -136,6 +136,7 @@ typedef struct HashJoinTableStats
     int                     nonemptybatches;    /* num of nontrivial batches */
     Size                    workmem_max;        /* work_mem high water mark */
     CdbExplain_Agg          chainlength;        /* hash chain length stats */
+    instr_time              spill_io_wait;      /* waits for async workfile I/O */
 } HashJoinTableStats;
 
 
@@ -74,6 +74,8 @@ typedef struct Instrumentation
 	double		execmemused;	/* CDB: executor memory used (bytes) */
 	double		workmemused;	/* CDB: work_mem actually used (bytes) */
 	double		workmemwanted;	/* CDB: work_mem to avoid scratch i/o (bytes) */
+	double		workmemgranted;	/* CDB: memory borrowed from the broker (bytes) */
+	double		workmemreleased;	/* CDB: memory given back to the broker (bytes) */
 	instr_time	firststart;		/* CDB: Start time of first iteration of node */
 	bool		workfileCreated;	/* TRUE if workfiles are created in this
 									 * node */
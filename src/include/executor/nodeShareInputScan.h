@@ -26,4 +26,7 @@ extern void ExecEagerFreeShareInputScan(ShareInputScanState *node);
 
 extern void ExecSliceDependencyShareInputScan(ShareInputScanState *node);
 
+extern Size ShareInputChannel_ShmemSize(void);
+extern void ShareInputChannel_ShmemInit(void);
+
 #endif   /* NODESHAREINPUTSCAN_H */
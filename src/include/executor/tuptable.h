@@ -108,7 +108,9 @@
  * extraction to treat the case identically to regular physical tuples.
  *
  * tts_slow/tts_off are saved state for slot_deform_tuple, and should not
- * be touched by any other code.
+ * be touched by any other code.  tts_heap_deform is the deforming plan it
+ * uses for the leading fixed-width attributes, built along with the memtuple
+ * binding when the descriptor is set.
  *----------
  */
 
@@ -143,6 +145,7 @@ typedef struct TupleTableSlot
 
 	TupleDesc	tts_tupleDescriptor;	/* slot's tuple descriptor */
 	MemTupleBinding *tts_mt_bind;		/* mem tuple's binding */ 
+	HeapTupleDeform *tts_heap_deform;	/* heap tuple's deforming plan */
 	MemoryContext 	tts_mcxt;		/* slot itself is in this context */
 	Buffer		tts_buffer;		/* tuple's buffer, or InvalidBuffer */
 
@@ -247,11 +250,10 @@ static inline void slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 
 	if(TupHasMemTuple(slot))
 	{
-		int i; 
-		for(i=0; i<attnum; ++i)
-			slot->PRIVATE_tts_values[i] = memtuple_getattr(
-					slot->PRIVATE_tts_memtuple, slot->tts_mt_bind, 
-					i+1, &(slot->PRIVATE_tts_isnull[i]));
+		memtuple_getsomeattrs(slot->PRIVATE_tts_memtuple, slot->tts_mt_bind,
+							  TupHasVirtualTuple(slot) ? slot->PRIVATE_tts_nvalid : 0,
+							  attnum,
+							  slot->PRIVATE_tts_values, slot->PRIVATE_tts_isnull);
 
 		TupSetVirtualTuple(slot);
 		slot->PRIVATE_tts_nvalid = attnum;
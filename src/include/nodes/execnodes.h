@@ -859,6 +859,7 @@ struct ExprState
 	NodeTag		type;
 	Expr	   *expr;			/* associated Expr node */
 	ExprStateEvalFunc evalfunc; /* routine to run to execute node */
+	struct ExprSteps *steps;	/* flattened tree, see execSteps.c */
 };
 
 /* ----------------
@@ -1427,6 +1428,12 @@ typedef struct PlanState
 	 */
 	bool		delayEagerFree;
 
+	/*
+	 * Memory this node gave to the memory broker, and could not take back
+	 * when it was rescanned (bytes).  It may use that much less.
+	 */
+	uint64		operatorMemLent;
+
 	/*
 	 * Other run-time state needed by most if not all node types.
 	 */
@@ -1457,6 +1464,9 @@ extern void EndPlanStateGpmonPkt(PlanState *ps);
 extern void InitPlanNodeGpmonPkt(Plan* plan, gpmon_packet_t *gpmon_pkt, EState *estate);
 
 extern uint64 PlanStateOperatorMemKB(const PlanState *ps);
+extern uint64 ExecRequestOperatorMem(PlanState *ps, uint64 wanted);
+extern void ExecReleaseOperatorMem(PlanState *ps);
+extern void ExecReclaimOperatorMem(PlanState *ps);
 
 static inline void Gpmon_Incr_Rows_Out(gpmon_packet_t *pkt)
 {
@@ -2520,6 +2530,9 @@ typedef struct MaterialState
 	void	   *ts_pos;
 	void	   *ts_markpos;
 	void	   *share_lk_ctxt;
+
+	/* subplan output kept for, or replayed from, other queries */
+	struct WorkfileReuse *workfile_reuse;
 } MaterialState;
 
 /* ----------------
@@ -2548,6 +2561,9 @@ extern void *shareinput_reader_waitready(int share_id, PlanGenerator planGen);
 extern void *shareinput_writer_notifyready(int share_id, int nsharer_xslice_notify_ready, PlanGenerator planGen);
 extern void shareinput_reader_notifydone(void *, int share_id);
 extern void shareinput_writer_waitdone(void *, int share_id, int nsharer_xslice_wait_done);
+extern void *shareinput_writer_openchannel(int share_id, int nsharer_xslice);
+extern bool shareinput_writer_puttuple(void *, TupleTableSlot *slot);
+extern void shareinput_writer_closechannel(void *);
 extern void shareinput_create_bufname_prefix(char* p, int size, int share_id);
 
 /* ----------------
@@ -2568,6 +2584,9 @@ typedef struct SortState
 
 	void	   *share_lk_ctxt;
 
+	/* output kept for, or replayed from, other queries */
+	struct WorkfileReuse *workfile_reuse;
+
 } SortState;
 
 /* ---------------------
@@ -2592,6 +2611,7 @@ typedef enum HashAggStatus
 	HASHAGG_IN_A_PASS,
 	HASHAGG_BETWEEN_PASSES,
 	HASHAGG_STREAMING,
+	HASHAGG_BYPASS,
 	HASHAGG_END_OF_PASSES
 } HashAggStatus;
 
@@ -2640,6 +2660,9 @@ typedef struct AggState
 	/* set if the operator created workfiles */
 	bool		workfiles_created;
 
+	/* output kept for, or replayed from, other queries (hashed only) */
+	struct WorkfileReuse *workfile_reuse;
+
 } AggState;
 
 /* ----------------
@@ -2658,6 +2681,8 @@ typedef struct WindowAggState
 	List	   *funcs;			/* all WindowFunc nodes in targetlist */
 	int			numfuncs;		/* total number of window functions */
 	int			numaggs;		/* number that are plain aggregates */
+	int			numsegtreeaggs;	/* number of those evaluated with a segment
+								 * tree in the current partition */
 
 	WindowStatePerFunc perfunc; /* per-window-function information */
 	WindowStatePerAgg peragg;	/* per-plain-aggregate information */
@@ -636,7 +636,12 @@ extern char *nodeToString(const void *obj);
  * nodes/outfast.c. This special version of nodeToString is only used by serializeNode.
  * It's a quick hack that allocates 8K buffer for StringInfo struct through initStringIinfoSizeOf
  */
+struct PlannedStmt;				/* not to include plannodes.h here */
+struct Bitmapset;
 extern char *nodeToBinaryStringFast(void *obj, int *length);
+extern char *nodeToBinaryStringFastForSlice(struct PlannedStmt *stmt, int *length,
+							   struct Bitmapset *motions,
+							   struct Bitmapset *subplans);
 
 extern Node *readNodeFromBinaryString(const char *str, int len);
 
@@ -111,6 +111,16 @@
  */
 #define ALIGNOF_BUFFER	64
 
+/*
+ * Assumed cache line size.  This doesn't affect correctness, but can be used
+ * to pad data structures that different processes update concurrently, so
+ * that they don't share a cache line.  Too small a value can hurt performance
+ * due to false sharing, while the only downside of too large a value is a few
+ * bytes of wasted memory.  The default is 128, which should be large enough
+ * for all supported platforms.
+ */
+#define PG_CACHE_LINE_SIZE		128
+
 /*
  * Disable UNIX sockets for certain operating systems.
  */
@@ -14,6 +14,7 @@
 #ifndef FTSPROBE_H
 #define FTSPROBE_H
 #include "access/xlogdefs.h"
+#include "datatype/timestamp.h"
 
 typedef struct
 {
@@ -84,6 +85,8 @@ typedef struct
 	int retry_count;
 	XLogRecPtr xlogrecptr;
 	bool recovery_making_progress;
+	TimestampTz probeStartTime;   /* first connection attempt of the probe */
+	bool timedOut;                /* an attempt of the probe timed out */
 } fts_segment_info;
 
 typedef struct
@@ -92,5 +95,7 @@ typedef struct
 	fts_segment_info *perSegInfos;
 } fts_context;
 
-extern bool FtsWalRepMessageSegments(CdbComponentDatabases *context);
+extern bool FtsWalRepMessageSegments(CdbComponentDatabases *context,
+									 bool probeAll);
+extern pg_time_t FtsWalRepNextProbeTime(void);
 #endif
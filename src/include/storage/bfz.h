@@ -1,7 +1,9 @@
 #ifndef BFZ_H
 #define BFZ_H
 
+#include "portability/instr_time.h"
 #include "storage/fd.h"
+#include "utils/pg_crc.h"
 
 #define BFZ_MODE_CLOSED		0
 #define BFZ_MODE_APPEND		1
@@ -10,6 +12,9 @@
 
 #define BFZ_BUFFER_SIZE		(1<<14)
 
+/* Upper limit of the size a buffer takes in the file, once compressed */
+#define BFZ_ENCODED_BUFFER_SIZE	(BFZ_BUFFER_SIZE + 64)
+
 struct bfz;
 
 struct bfz_freeable_stuff
@@ -33,6 +38,25 @@ struct bfz_freeable_stuff
 	void (*write_ex) (struct bfz * thiz, const char *buffer, int size);
 	void (*close_ex) (struct bfz * thiz);
 
+/*
+ * Optional, for asynchronous I/O (see bfz_async.c). These run on a helper
+ * thread: they may not allocate memory or elog, and look at nothing but
+ * their arguments.
+ *
+ * threadsafe_encode turns a buffer into what is stored in the file, in dst
+ * of BFZ_ENCODED_BUFFER_SIZE bytes, and returns its length. If it is NULL,
+ * buffers are stored as is.
+ *
+ * threadsafe_read reads the buffer stored at offset of the kernel file
+ * descriptor fd into dst, using scratch of BFZ_ENCODED_BUFFER_SIZE bytes as
+ * it needs, and sets *stored to the number of bytes it took in the file.
+ * Returns the length of the buffer, 0 at the end of the file, or -1 if
+ * anything is wrong.
+ */
+	int (*threadsafe_encode) (const char *src, int size, char *dst);
+	int (*threadsafe_read) (int fd, off_t offset, char *dst, char *scratch,
+							int *stored);
+
 	char buffer[BFZ_BUFFER_SIZE];
 };
 
@@ -59,14 +83,33 @@ typedef struct bfz
 	int64 numBlocks;
 	int64 blockNo;
 	int64 chosenBlockNo;
+
+	/*
+	 * Asynchronous I/O state, see bfz_async.c. 'async_file' is -1 if the
+	 * file is read and written synchronously. 'io_wait' accumulates the time
+	 * spent waiting for the helper thread.
+	 */
+	int			async_file;
+	uint32		async_generation;
+	instr_time	io_wait;
 }	bfz_t;
 
 /* These functions are internal to bfz. */
 extern void bfz_nothing_init(bfz_t * thiz);
 extern void bfz_zlib_init(bfz_t * thiz);
+extern void bfz_lz4_init(bfz_t * thiz);
 extern void bfz_lzop_init(bfz_t * thiz);
 extern void bfz_write_ex(bfz_t * thiz, const char *buffer, int size);
 extern int	bfz_read_ex(bfz_t * thiz, char *buffer, int size);
+extern pg_crc32 bfz_compute_checksum(const char *buffer, uint32 size,
+					 int bytes_to_checksum);
+
+extern void bfz_async_start(bfz_t *thiz);
+extern void bfz_async_write(bfz_t *thiz, const char *buffer, int size);
+extern void bfz_async_finish_writes(bfz_t *thiz);
+extern void bfz_async_begin_read(bfz_t *thiz);
+extern int	bfz_async_read(bfz_t *thiz, char *buffer);
+extern void bfz_async_stop(bfz_t *thiz);
 
 /* These functions are interface to bfz. */
 extern int	bfz_string_to_compression(const char *string);
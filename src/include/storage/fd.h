@@ -77,6 +77,8 @@ extern File OpenTemporaryFile(bool interXact, const char *filePrefix);
 extern void FileSetTransient(File file);
 extern void FileClose(File file);
 extern int	FilePrefetch(File file, off_t offset, int amount);
+extern int	FileDup(File file);
+extern void FileAccountWrite(File file, off_t newSize);
 extern int	FileRead(File file, char *buffer, int amount);
 extern int	FileWrite(File file, char *buffer, int amount);
 extern int	FileSync(File file);
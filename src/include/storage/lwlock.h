@@ -102,6 +102,9 @@ typedef enum LWLockId
 	RelfilenodeGenLock,
 	TablespaceHashLock,
 	GpReplicationConfigFileLock,
+	AOVisimapCacheLock,
+	ShareInputChannelLock,
+	WorkfileReuseLock,
 	/* must be last except for MaxDynamicLWLock: */
 	NumFixedLWLocks,
 
@@ -125,7 +128,7 @@ extern bool Trace_lwlocks;
 #endif
 
 extern LWLockId LWLockAssign(void);
-extern void LWLockAcquire(LWLockId lockid, LWLockMode mode);
+extern bool LWLockAcquire(LWLockId lockid, LWLockMode mode);
 extern bool LWLockConditionalAcquire(LWLockId lockid, LWLockMode mode);
 extern bool LWLockAcquireOrWait(LWLockId lockid, LWLockMode mode);
 extern void LWLockRelease(LWLockId lockid);
@@ -72,6 +72,9 @@ extern VirtualTransactionId *GetConflictingVirtualXIDs(TransactionId limitXmin,
 extern pid_t CancelVirtualTransaction(VirtualTransactionId vxid, ProcSignalReason sigmode);
 
 extern bool MinimumActiveBackends(int min);
+extern bool MinimumActiveDistributedTransactions(int min);
+extern bool DistributedTransactionIsActive(DistributedTransactionTimeStamp distribTimeStamp,
+							   DistributedTransactionId distribXid);
 extern int	CountDBBackends(Oid databaseid);
 extern void CancelDBBackends(Oid databaseid, ProcSignalReason sigmode, bool conflictPending);
 extern int	CountUserBackends(Oid roleid);
@@ -1308,6 +1308,13 @@ extern Datum gp_remove_segment(PG_FUNCTION_ARGS);
 extern Datum gp_prep_new_segment(PG_FUNCTION_ARGS);
 
 extern Datum gp_request_fts_probe_scan(PG_FUNCTION_ARGS);
+extern Datum gp_get_fts_probe_stats(PG_FUNCTION_ARGS);
+
+/* cdb/dispatcher/cdbgang.c */
+extern Datum gp_get_session_gang_stats(PG_FUNCTION_ARGS);
+
+/* cdb/cdbtm.c */
+extern Datum gp_get_dtx_group_commit_stats(PG_FUNCTION_ARGS);
 
 /* storage/compress.c */
 extern Datum quicklz_constructor(PG_FUNCTION_ARGS);
@@ -1334,6 +1341,12 @@ extern Datum zstd_compress(PG_FUNCTION_ARGS);
 extern Datum zstd_decompress(PG_FUNCTION_ARGS);
 extern Datum zstd_validator(PG_FUNCTION_ARGS);
 
+extern Datum lz4_constructor(PG_FUNCTION_ARGS);
+extern Datum lz4_destructor(PG_FUNCTION_ARGS);
+extern Datum lz4_compress(PG_FUNCTION_ARGS);
+extern Datum lz4_decompress(PG_FUNCTION_ARGS);
+extern Datum lz4_validator(PG_FUNCTION_ARGS);
+
 extern Datum delta_constructor(PG_FUNCTION_ARGS);
 extern Datum delta_destructor(PG_FUNCTION_ARGS);
 extern Datum delta_compress(PG_FUNCTION_ARGS);
@@ -300,14 +300,40 @@ extern int64 datumstreamwrite_block(DatumStreamWrite *ds,
 									AppendOnlyBlockDirectory *blockDirectory,
 									int columnGroupNo,
 									bool addColAction);
+extern int64 datumstreamwrite_block_prepare(DatumStreamWrite *ds,
+											AppendOnlyDecompressTask *task,
+											bool *deferred,
+											AppendOnlyBlockDirectory *blockDirectory,
+											int columnGroupNo,
+											bool addColAction);
+extern void datumstreamwrite_block_complete(DatumStreamWrite *ds,
+											AppendOnlyDecompressTask *task,
+											AppendOnlyBlockDirectory *blockDirectory,
+											int columnGroupNo,
+											bool addColAction);
+extern bool datumstreamwrite_copy_block(DatumStreamWrite *ds,
+										DatumStreamRead *src,
+										int64 firstRowNum,
+										AppendOnlyBlockDirectory *blockDirectory,
+										int columnGroupNo);
 extern int64 datumstreamwrite_lob(DatumStreamWrite *ds,
 								  Datum d,
 								  AppendOnlyBlockDirectory *blockDirectory,
 								  int columnGroupNo,
 								  bool addColAction);
+extern bool datumstreamread_block_header(DatumStreamRead * ds);
 extern int	datumstreamread_block(DatumStreamRead * ds,
 								  AppendOnlyBlockDirectory *blockDirectory,
 								  int colGroupNo);
+extern int	datumstreamread_block_prepare(DatumStreamRead * ds,
+										  AppendOnlyDecompressTask *task,
+										  bool *deferred);
+extern void datumstreamread_block_complete(DatumStreamRead * ds,
+										   AppendOnlyDecompressTask *task,
+										   AppendOnlyBlockDirectory *blockDirectory,
+										   int colGroupNo);
+extern void datumstreamread_block_discard(DatumStreamRead * ds,
+										  AppendOnlyDecompressTask *task);
 extern void datumstreamread_find(DatumStreamRead * datumStream,
 					 int32 rowNumInBlock);
 extern void datumstreamread_rewind_block(DatumStreamRead * datumStream);
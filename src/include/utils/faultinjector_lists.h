@@ -100,6 +100,8 @@ FI_IDENT(TwoPhaseTransactionAbortPrepared, "twophase_transaction_abort_prepared"
 FI_IDENT(DtmBroadcastPrepare, "dtm_broadcast_prepare")
 /* inject fault after commit broadcast */
 FI_IDENT(DtmBroadcastCommitPrepared, "dtm_broadcast_commit_prepared")
+/* inject fault before one-phase commit broadcast */
+FI_IDENT(DtmBroadcastCommitOnePhase, "dtm_broadcast_commit_onephase")
 /* inject fault after abort broadcast */
 FI_IDENT(DtmBroadcastAbortPrepared, "dtm_broadcast_abort_prepared")
 /* inject fault after distributed commit was inserted in xlog */
@@ -134,6 +136,16 @@ FI_IDENT(ExecSortBeforeSorting, "execsort_before_sorting")
 FI_IDENT(ExecSortMKSortMergeRuns, "execsort_mksort_mergeruns")
 /* inject fault after shared input scan retrieved a tuple */
 FI_IDENT(ExecShareInputNext, "execshare_input_next")
+/* inject fault before a shared material writer claims a channel; skip pretends none is free */
+FI_IDENT(ShareInputChannelOpen, "shareinput_channel_open")
+/* inject fault when a shared input reader attaches to the writer's channel */
+FI_IDENT(ShareInputChannelAttach, "shareinput_channel_attach")
+/* inject fault when a shared material writer spills past its channel */
+FI_IDENT(ShareInputChannelSpill, "shareinput_channel_spill")
+/* inject fault when a node reads its output from an earlier query's workfile */
+FI_IDENT(WorkfileReuseReplay, "workfile_reuse_replay")
+/* inject fault when a node's output is kept for later queries */
+FI_IDENT(WorkfileReusePublish, "workfile_reuse_publish")
 /* inject fault after creation of checkpoint when basebackup requested */
 FI_IDENT(BaseBackupPostCreateCheckpoint, "base_backup_post_create_checkpoint")
 /* inject fault after compaction, but before the drop of the
@@ -253,6 +253,15 @@ extern bool gp_appendonly_compaction;
  * 10% of the tuples are hidden.
  */
 extern int  gp_appendonly_compaction_threshold;
+
+/*
+ * Maximum number of helper threads that decompress the blocks of different
+ * columns in parallel during a scan of a column-oriented table. 0 disables.
+ */
+extern int	gp_aocs_decompress_threads;
+extern int	gp_aocs_compress_threads;
+extern bool gp_appendonly_compaction_reuse_blocks;
+extern int	gp_appendonly_visimap_cache_entries;
 extern bool gp_heap_require_relhasoids_match;
 extern bool	Debug_appendonly_rezero_quicklz_compress_scratch;
 extern bool	Debug_appendonly_rezero_quicklz_decompress_scratch;
@@ -253,6 +253,12 @@ MemoryAccounting_DeclareDone(void);
 extern uint64
 MemoryAccounting_RequestQuotaIncrease(void);
 
+extern uint64
+MemoryAccounting_RequestQuota(uint64 wanted);
+
+extern uint64
+MemoryAccounting_ReclaimQuota(void);
+
 extern MemoryAccountExplain *
 MemoryAccounting_ExplainCurrentOptimizerAccountInfo(void);
 
@@ -166,6 +166,7 @@ extern void ResGroupCheckForDrop(Oid groupId, char *name);
 extern int32 ResGroupGetVmemLimitChunks(void);
 extern int32 ResGroupGetVmemChunkSizeInBits(void);
 extern int32 ResGroupGetMaxChunksPerQuery(void);
+extern int ResGroupGetCpuCoreLimit(void);
 
 /* test helper function */
 extern void ResGroupGetMemInfo(int *memLimit, int *slotQuota, int *sharedQuota);
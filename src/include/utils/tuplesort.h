@@ -81,6 +81,7 @@
 #define tuplesort_gettupleslot_pos tuplesort_gettupleslot_pos_pg
 #define tuplesort_flush tuplesort_flush_pg
 #define tuplesort_finalize_stats tuplesort_finalize_stats_pg
+#define tuplesort_spilled tuplesort_spilled_pg
 #define tuplesort_rescan_pos tuplesort_rescan_pos_pg
 #define tuplesort_markpos_pos tuplesort_markpos_pos_pg
 #define tuplesort_restorepos_pos tuplesort_restorepos_pos_pg
@@ -238,6 +239,7 @@ extern int32 ApplySortFunction(FmgrInfo *sortFunction, int sortFlags,
 #undef tuplesort_gettupleslot_pos
 #undef tuplesort_flush
 #undef tuplesort_finalize_stats
+#undef tuplesort_spilled
 #undef tuplesort_rescan_pos
 #undef tuplesort_markpos_pos
 #undef tuplesort_restorepos_pos
@@ -597,6 +599,15 @@ switcheroo_tuplesort_finalize_stats(switcheroo_Tuplesortstate *state)
 		tuplesort_finalize_stats_pg((Tuplesortstate_pg *) state);
 }
 
+static inline bool
+switcheroo_tuplesort_spilled(switcheroo_Tuplesortstate *state)
+{
+	if (state->is_mk_tuplesortstate)
+		return tuplesort_spilled_mk((Tuplesortstate_mk *) state);
+	else
+		return tuplesort_spilled_pg((Tuplesortstate_pg *) state);
+}
+
 static inline void
 switcheroo_tuplesort_rescan_pos(switcheroo_Tuplesortstate *state, TuplesortPos *pos)
 {
@@ -678,6 +689,7 @@ switcheroo_tuplesort_set_gpmon(switcheroo_Tuplesortstate *state,
 #define tuplesort_gettupleslot_pos switcheroo_tuplesort_gettupleslot_pos
 #define tuplesort_flush switcheroo_tuplesort_flush
 #define tuplesort_finalize_stats switcheroo_tuplesort_finalize_stats
+#define tuplesort_spilled switcheroo_tuplesort_spilled
 #define tuplesort_rescan_pos switcheroo_tuplesort_rescan_pos
 #define tuplesort_markpos_pos switcheroo_tuplesort_markpos_pos
 #define tuplesort_restorepos_pos switcheroo_tuplesort_restorepos_pos
@@ -64,6 +64,7 @@ extern bool tuplesort_gettupleslot_pos(struct Tuplesortstate *state, TuplesortPo
 
 extern void tuplesort_flush(struct Tuplesortstate *state);
 extern void tuplesort_finalize_stats(struct Tuplesortstate *state);
+extern bool tuplesort_spilled(struct Tuplesortstate *state);
 
 /*
  * These routines may only be called if randomAccess was specified 'true'.
@@ -223,6 +223,23 @@ typedef enum MKLvType
     MKLV_TYPE_TEXT,  /* this level contains text values */
 } MKLvType;
 
+/*
+ * How to form a normalized key for a level: an unsigned 64-bit integer
+ * whose order agrees with the level's sort order, for the radix sort.
+ * The integer kinds are exact.  The prefix kinds only hold the first eight
+ * bytes of a string, so equal keys still have to be compared.
+ */
+typedef enum MKNormKey
+{
+    MKNK_NONE,          /* no normalized key for this level */
+    MKNK_INT16,         /* int2 */
+    MKNK_INT32,         /* int4, date */
+    MKNK_INT64,         /* int8, timestamp, timestamptz */
+    MKNK_TEXT_PREFIX,   /* text or varchar in the C collation */
+    MKNK_BPCHAR_PREFIX, /* char(n) in the C collation */
+    MKNK_XFRM_PREFIX,   /* strxfrm'ed value of a MKLV_TYPE_CHAR or _TEXT level */
+} MKNormKey;
+
 typedef struct MKLvContext
 {
 	/* Is the type of datums in this level passed by value instead of reference */
@@ -234,6 +251,9 @@ typedef struct MKLvContext
     /* type of datums in this level, converted to our MKLvType enumeration */
     MKLvType lvtype;
 
+    /* normalized key of datums in this level, for radix sort */
+    MKNormKey normkey;
+
 	ScanKeyData	scanKey;
 
     int16 attno;
@@ -317,6 +337,7 @@ static inline void mk_prepare_array(MKEntry *a, int i, int j, int32 lv, struct M
 
 extern void tupsort_cpfr(MKEntry *dst, MKEntry *src, MKLvContext *ctxt);
 extern int tupsort_compare_datum(MKEntry *v1, MKEntry *v2, MKLvContext *ctxt, MKContext *mkContext);
+extern uint64 tupsort_prefix_key(MKEntry *e, MKLvContext *ctxt);
 
 extern void create_mksort_context(
         MKContext *mkctxt,
@@ -332,6 +353,14 @@ static inline void mk_qsort(MKEntry* a, int n, MKContext *ctxt)
     mk_qsort_impl(a, 0, n-1, 0, true, ctxt, false);
 }
 
+/* MK radix sort stuff */
+extern void mk_radix_sort(MKEntry *a, int n, MKContext *ctxt);
+extern Size mk_radix_sort_space(int n);
+static inline bool mk_radix_sortable(MKContext *ctxt)
+{
+    return ctxt->total_lv > 0 && ctxt->lvctxt[0].normkey != MKNK_NONE;
+}
+
 /* MK Heap stuff */
 typedef bool (*MKFlagPtrReader) (void *ctxt, MKEntry *e);
 typedef struct MKHeapReader
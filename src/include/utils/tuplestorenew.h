@@ -24,12 +24,18 @@ typedef struct NTupleStore NTupleStore;
  */
 void ntuplestore_setinstrument(NTupleStore* ts, struct Instrumentation *ins);
 
+/* Let the tuple store ask the memory broker for more memory on behalf of
+ * the given plan node before it spills
+ */
+void ntuplestore_setplanstate(NTupleStore* ts, struct PlanState *ps);
+
 /* Tuple store method */
 extern NTupleStore *ntuplestore_create(int64 maxBytes);
 extern NTupleStore *ntuplestore_create_readerwriter(const char* filename, int64 maxBytes, bool isWriter);
 extern NTupleStore *ntuplestore_create_workset(workfile_set *workSet, int64 maxBytes);
 extern bool ntuplestore_is_readerwriter_reader(NTupleStore* nts);
 extern void ntuplestore_flush(NTupleStore *ts);
+extern bool ntuplestore_spilled(NTupleStore *ts);
 extern void ntuplestore_destroy(NTupleStore *ts);
 
 /* Tuple store accessor method 
@@ -18,6 +18,7 @@
 #define __WORKFILE_MGR_H__
 
 #include "executor/execWorkfile.h"
+#include "portability/instr_time.h"
 #include "utils/sharedcache.h"
 #include "nodes/execnodes.h"
 #include "utils/timestamp.h"
@@ -69,6 +70,9 @@ typedef struct workfile_set
 	/* Real-time size of the set as it is being created (for reporting only) */
 	int64 in_progress_size;
 
+	/* Time spent waiting for asynchronous I/O of closed files in the set */
+	instr_time io_wait_time;
+
 	/* Prefix of files in the workfile set */
 	char path[MAXPGPATH];
 
@@ -169,6 +173,29 @@ void WorkfileQueryspace_ReleaseEntry(void);
 bool WorkfileQueryspace_AddWorkfile(void);
 void WorkfileQueryspace_SubtractWorkfile(int32 nFiles);
 
+/* Workfile reuse across queries */
+typedef struct WorkfileReuse WorkfileReuse;
+
+extern Size WorkfileReuse_ShmemSize(void);
+extern void WorkfileReuse_ShmemInit(void);
+extern void workfile_reuse_note_writer(Oid relid);
+extern void workfile_reuse_assign(bool newval);
+extern void AtPrepare_WorkfileReuse(void);
+extern void workfile_reuse_twophase_recover(TransactionId xid, uint16 info,
+								void *recdata, uint32 len);
+extern void workfile_reuse_twophase_postcommit(TransactionId xid, uint16 info,
+								   void *recdata, uint32 len);
+extern void workfile_reuse_twophase_postabort(TransactionId xid, uint16 info,
+								  void *recdata, uint32 len);
+
+extern WorkfileReuse *workfile_reuse_create(PlanState *ps);
+extern bool workfile_reuse_start(WorkfileReuse *wr);
+extern TupleTableSlot *workfile_reuse_next(WorkfileReuse *wr);
+extern void workfile_reuse_put(WorkfileReuse *wr, TupleTableSlot *slot);
+extern void workfile_reuse_finish(WorkfileReuse *wr, bool spilled);
+extern void workfile_reuse_rescan(WorkfileReuse *wr);
+extern void workfile_reuse_end(WorkfileReuse *wr);
+
 /* Workfile error reporting */
 typedef enum WorkfileError
 {
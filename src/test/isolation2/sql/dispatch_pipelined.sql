@@ -0,0 +1,35 @@
+-- Test an error in the QD's interconnect setup while the plan is still
+-- being sent to the QEs, with gp_dispatch_pipelined.  The QEs that did not
+-- get all of the plan can't be canceled; the query must not hang waiting
+-- for them, and the session must be usable afterwards.
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+
+CREATE TABLE dispatch_pipelined (a int, b text) DISTRIBUTED BY (a);
+INSERT INTO dispatch_pipelined SELECT i, i::text FROM generate_series(1, 10) i;
+
+1: SET gp_dispatch_pipelined = on;
+-- send the plan uncompressed, with a constant too big to be sent at once
+1: SET gp_dispatch_compress_algorithm = none;
+
+SELECT gp_inject_fault('interconnect_setup_palloc', 'error', 1);
+1: SELECT count(*) FROM dispatch_pipelined WHERE b <> repeat('x', 20000000);
+SELECT gp_inject_fault('interconnect_setup_palloc', 'reset', 1);
+
+1: SELECT count(*) FROM dispatch_pipelined WHERE b <> repeat('x', 20000000);
+1: SELECT count(*) FROM dispatch_pipelined;
+
+-- in a transaction block, the error aborts the transaction, and a new one
+-- can start
+SELECT gp_inject_fault('interconnect_setup_palloc', 'error', 1);
+1: BEGIN;
+1: SELECT count(*) FROM dispatch_pipelined WHERE b <> repeat('x', 20000000);
+1: END;
+SELECT gp_inject_fault('interconnect_setup_palloc', 'reset', 1);
+
+1: BEGIN;
+1: INSERT INTO dispatch_pipelined VALUES (11, '11');
+1: SELECT count(*) FROM dispatch_pipelined WHERE b <> repeat('x', 20000000);
+1: END;
+
+1q:
+DROP TABLE dispatch_pipelined;
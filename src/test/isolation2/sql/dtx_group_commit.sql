@@ -0,0 +1,56 @@
+-- Test concurrent distributed commits with gp_dtx_group_commit_delay, so
+-- that each waits for the others before flushing its distributed commit
+-- record.  They all must commit, none may hang, and their commit records
+-- must take fewer flushes than records.
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+
+CREATE TABLE dtx_group_commit (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE dtx_group_commit_stats AS SELECT * FROM gp_dtx_group_commit_stats DISTRIBUTED RANDOMLY;
+
+1: SET gp_dtx_group_commit_delay = 100000;
+1: SET commit_siblings = 1;
+2: SET gp_dtx_group_commit_delay = 100000;
+2: SET commit_siblings = 1;
+3: SET gp_dtx_group_commit_delay = 100000;
+3: SET commit_siblings = 1;
+
+-- hold the commits before the PREPARE broadcast, to release them together
+SELECT gp_inject_fault_infinite('dtm_broadcast_prepare', 'suspend', 1);
+
+1: BEGIN;
+1: INSERT INTO dtx_group_commit SELECT i, 1 FROM generate_series(1, 10) i;
+1&: COMMIT;
+2: BEGIN;
+2: INSERT INTO dtx_group_commit SELECT i, 2 FROM generate_series(1, 10) i;
+2&: COMMIT;
+3: BEGIN;
+3: INSERT INTO dtx_group_commit SELECT i, 3 FROM generate_series(1, 10) i;
+3&: COMMIT;
+
+SELECT gp_wait_until_triggered_fault('dtm_broadcast_prepare', 3, 1);
+
+-- and a checkpoint flushing the WAL at the same time
+4&: CHECKPOINT;
+
+SELECT gp_inject_fault('dtm_broadcast_prepare', 'reset', 1);
+1<:
+2<:
+3<:
+4<:
+
+SELECT b, count(*) FROM dtx_group_commit GROUP BY b ORDER BY b;
+
+-- the three commit records went out with fewer flushes
+SELECT s.commit_records - b.commit_records AS commit_records, s.flushes - b.flushes < s.commit_records - b.commit_records AS grouped FROM gp_dtx_group_commit_stats s, dtx_group_commit_stats b;
+
+-- the group delay is not taken without siblings
+1: SET commit_siblings = 5;
+1: INSERT INTO dtx_group_commit SELECT i, 4 FROM generate_series(1, 10) i;
+1: SELECT count(*) FROM dtx_group_commit;
+
+1q:
+2q:
+3q:
+4q:
+DROP TABLE dtx_group_commit;
+DROP TABLE dtx_group_commit_stats;
@@ -0,0 +1,125 @@
+-- Test committing single-segment distributed transactions in one phase,
+-- with gp_enable_one_phase_commit, and failures on either side while it
+-- happens.
+--
+-- start_matchsubs
+--
+-- m/failed on segment \d+ for gid/
+-- s/segment \d+ for gid = \d+-\d+.*/segment N for gid = DUMMY/
+--
+-- m/debug_dtm_action_protocol = Distributed Commit \(One-Phase\)/
+-- s/\(seg\d+ [0-9.]+:\d+ pid=\d+\)/(segN IP:PORT pid=PID)/
+--
+-- end_matchsubs
+
+-- This function is used to loop until master shutsdown, to make sure
+-- next command executed is only after restart and doesn't go through
+-- while PANIC is still being processed by master, as master continues
+-- to accept connections for a while despite undergoing PANIC.
+CREATE OR REPLACE FUNCTION wait_till_master_shutsdown()
+RETURNS void AS
+$$
+  BEGIN
+    loop
+      PERFORM pg_sleep(.5); /* in func */
+    end loop; /* in func */
+  END; /* in func */
+$$ LANGUAGE plpgsql;
+
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+CREATE TABLE one_phase_commit (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO one_phase_commit SELECT i, 0 FROM generate_series(1, 10) i;
+
+-- The dbid of the primary that holds the row with the given key.
+CREATE FUNCTION one_phase_commit_dbid(key int) RETURNS smallint AS
+$$
+  SELECT dbid FROM gp_segment_configuration
+  WHERE role = 'p' AND content = (SELECT gp_segment_id FROM one_phase_commit WHERE a = key)
+$$ LANGUAGE sql;
+
+-- Scenario 1: a transaction that only changes one row is committed on
+-- its segment in one phase.  Hold it before the commit is sent, to see
+-- that it takes that path, and that nothing was prepared.
+1: SET gp_enable_one_phase_commit = on;
+1: SELECT gp_inject_fault('dtm_broadcast_commit_onephase', 'suspend', 1);
+1: BEGIN;
+1: UPDATE one_phase_commit SET b = 1 WHERE a = 1;
+1&: COMMIT;
+2: SELECT gp_wait_until_triggered_fault('dtm_broadcast_commit_onephase', 1, 1);
+2: SELECT count(*) FROM gp_dist_random('pg_prepared_xacts');
+2: SELECT gp_inject_fault('dtm_broadcast_commit_onephase', 'reset', 1);
+1<:
+1: SELECT a, b FROM one_phase_commit WHERE a = 1;
+
+-- Scenario 2: abort, before the commit and when the segment fails to
+-- commit.
+1: BEGIN;
+1: UPDATE one_phase_commit SET b = 2 WHERE a = 2;
+1: ROLLBACK;
+1: SET debug_dtm_action = "fail_begin_command";
+1: SET debug_dtm_action_target = "protocol";
+1: SET debug_dtm_action_protocol = "commit_onephase";
+1: UPDATE one_phase_commit SET b = 2 WHERE a = 2;
+1: RESET debug_dtm_action;
+1: RESET debug_dtm_action_target;
+1: RESET debug_dtm_action_protocol;
+1: SELECT a, b FROM one_phase_commit WHERE a = 2;
+
+-- Scenario 3: a transaction that writes on one segment and reads on all
+-- is committed in two phases, but only the segment that wrote prepares.
+-- The others commit when asked to prepare.
+1: SELECT gp_inject_fault('dtm_broadcast_commit_prepared', 'suspend', 1);
+1: BEGIN;
+1: UPDATE one_phase_commit SET b = 3 WHERE a = 3;
+1: SELECT count(*) FROM one_phase_commit;
+1&: COMMIT;
+2: SELECT gp_wait_until_triggered_fault('dtm_broadcast_commit_prepared', 1, 1);
+2: SELECT count(*) FROM gp_dist_random('pg_prepared_xacts');
+2: SELECT gp_inject_fault('dtm_broadcast_commit_prepared', 'reset', 1);
+1<:
+1: SELECT a, b FROM one_phase_commit WHERE a = 3;
+1: SELECT count(*) FROM gp_dist_random('pg_prepared_xacts');
+
+-- Scenarios 4 and 5: the segment PANICs while it commits, and the QD
+-- loses the connection to it.  The transaction is in doubt then, and
+-- the QD must ask the segment, once it has recovered, whether it
+-- committed.  Don't let FTS fail the segment over meanwhile.
+1: CHECKPOINT;
+1: SET dtx_phase2_retry_count = 9;
+1: SELECT gp_inject_fault_infinite('fts_probe', 'skip', 1);
+1: SELECT gp_request_fts_probe_scan();
+1: SELECT gp_wait_until_triggered_fault('fts_probe', 1, 1);
+
+-- Scenario 4: the segment crashes before it writes its commit record,
+-- so the transaction aborted.
+1: SELECT gp_inject_fault('onephase_transaction_commit', 'panic', one_phase_commit_dbid(4));
+1: UPDATE one_phase_commit SET b = 4 WHERE a = 4;
+1: SELECT a, b FROM one_phase_commit WHERE a = 4;
+
+-- Scenario 5: the segment crashes after it flushed its commit record.
+-- Its redo marks the transaction committed, also in the distributed
+-- log, and the QD finds that out.
+1: SELECT gp_inject_fault('local_tm_record_transaction_commit', 'panic', one_phase_commit_dbid(5));
+1: UPDATE one_phase_commit SET b = 5 WHERE a = 5;
+1: SELECT a, b FROM one_phase_commit WHERE a = 5;
+1: SELECT count(*) FROM gp_dist_random('pg_prepared_xacts');
+
+1: SELECT gp_inject_fault('fts_probe', 'reset', 1);
+
+-- Scenario 6: the QD crashes before it sends the commit.  Nothing was
+-- written on the QD, so there is nothing to redo there, and the segment
+-- aborts the transaction when the QD goes away.
+3&: SELECT wait_till_master_shutsdown();
+4: SET gp_enable_one_phase_commit = on;
+4: SELECT gp_inject_fault('dtm_broadcast_commit_onephase', 'panic', 1);
+4: UPDATE one_phase_commit SET b = 6 WHERE a = 6;
+3<:
+5: SELECT gp_inject_fault('dtm_broadcast_commit_onephase', 'reset', 1);
+5: SELECT a, b FROM one_phase_commit WHERE a = 6;
+5: SELECT count(*) FROM gp_dist_random('pg_prepared_xacts');
+5: SET gp_enable_one_phase_commit = on;
+5: UPDATE one_phase_commit SET b = 6 WHERE a = 6;
+5: SELECT a, b FROM one_phase_commit ORDER BY a;
+
+5: DROP FUNCTION one_phase_commit_dbid(int);
+5: DROP TABLE one_phase_commit;
@@ -788,3 +788,25 @@ CREATE TABLE co_large_and_bulk_content(a INT,
 INSERT INTO co_large_and_bulk_content SELECT * FROM ao_from_table;
 -- can't do count(*) as CO optimizes to read only first column
 SELECT * FROM co_large_and_bulk_content where a > 1;
+
+-- Scan with the blocks of different columns decompressed on helper threads,
+-- and check that it returns the same rows as a serial scan.
+CREATE TABLE co_decompress_threads (a int, b text, c float8,
+                                    d int ENCODING (compresstype=none),
+                                    e int ENCODING (compresstype=RLE_TYPE, compresslevel=2))
+    WITH (appendonly=true, orientation=column, compresstype=zlib, blocksize=8192)
+    DISTRIBUTED BY (a);
+INSERT INTO co_decompress_threads
+SELECT i, repeat('x', i % 50) || i, i / 7.0, i % 13, i / 100
+FROM generate_series(1, 50000) i;
+SET gp_aocs_decompress_threads = 0;
+CREATE TABLE co_decompress_threads_serial AS
+    SELECT * FROM co_decompress_threads DISTRIBUTED BY (a);
+SET gp_aocs_decompress_threads = 4;
+SELECT count(b), count(c), count(d), count(e) FROM co_decompress_threads;
+(SELECT * FROM co_decompress_threads EXCEPT ALL
+ SELECT * FROM co_decompress_threads_serial)
+UNION ALL
+(SELECT * FROM co_decompress_threads_serial EXCEPT ALL
+ SELECT * FROM co_decompress_threads);
+RESET gp_aocs_decompress_threads;
@@ -0,0 +1,62 @@
+-- Tests for lz4 compression.
+
+CREATE TABLE lz4test (id int4, t text) WITH (appendonly=true, compresstype=lz4, orientation=column) DISTRIBUTED BY (id);
+
+INSERT INTO lz4test SELECT g, 'foo' || g FROM generate_series(1, 100000) g;
+INSERT INTO lz4test SELECT g, 'bar' || g FROM generate_series(1, 100000) g;
+
+-- Check contents, at the beginning of the table and at the end.
+SELECT * FROM lz4test ORDER BY id, t LIMIT 5;
+SELECT * FROM lz4test ORDER BY id DESC, t DESC LIMIT 5;
+
+
+-- Test different compression levels. Level 1 uses the fast compressor,
+-- higher levels use LZ4HC.
+CREATE TABLE lz4test_1 (id int4, t text) WITH (appendonly=true, compresstype=lz4, compresslevel=1) DISTRIBUTED BY (id);
+CREATE TABLE lz4test_12 (id int4, t text) WITH (appendonly=true, compresstype=lz4, compresslevel=12) DISTRIBUTED BY (id);
+
+INSERT INTO lz4test_1 SELECT g, 'foo' || g FROM generate_series(1, 10000) g;
+INSERT INTO lz4test_1 SELECT g, 'bar' || g FROM generate_series(1, 10000) g;
+SELECT * FROM lz4test_1 ORDER BY id, t LIMIT 5;
+SELECT * FROM lz4test_1 ORDER BY id DESC, t DESC LIMIT 5;
+
+INSERT INTO lz4test_12 SELECT g, 'foo' || g FROM generate_series(1, 10000) g;
+INSERT INTO lz4test_12 SELECT g, 'bar' || g FROM generate_series(1, 10000) g;
+SELECT * FROM lz4test_12 ORDER BY id, t LIMIT 5;
+SELECT * FROM lz4test_12 ORDER BY id DESC, t DESC LIMIT 5;
+
+
+-- Test the bounds of compresslevel. None of these are allowed.
+CREATE TABLE lz4test_invalid (id int4) WITH (appendonly=true, compresstype=lz4, compresslevel=-1) DISTRIBUTED BY (id);
+CREATE TABLE lz4test_invalid (id int4) WITH (appendonly=true, compresstype=lz4, compresslevel=0) DISTRIBUTED BY (id);
+CREATE TABLE lz4test_invalid (id int4) WITH (appendonly=true, compresstype=lz4, compresslevel=13) DISTRIBUTED BY (id);
+
+
+-- Spill a hash join to workfiles compressed with lz4, and check that it
+-- reads back the same rows.
+CREATE FUNCTION lz4_spilled(query text) RETURNS bool AS $$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (ANALYZE, VERBOSE) ' || query LOOP
+    IF line LIKE '%spilling%' THEN
+      RETURN true;
+    END IF;
+  END LOOP;
+  RETURN false;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TABLE lz4_spill (i1 int, i2 int, i3 int, i4 int, i5 int, i6 int, i7 int, i8 int) DISTRIBUTED BY (i1);
+INSERT INTO lz4_spill SELECT i, i, i % 1000, i, i, i, i, i FROM
+  (SELECT generate_series(1, nsegments * 15000) AS i FROM
+    (SELECT count(*) AS nsegments FROM gp_segment_configuration WHERE role = 'p' AND content >= 0) foo) bar;
+
+SET statement_mem = 1024;
+SET gp_workfile_type_hashjoin = bfz;
+SET gp_workfile_compress_algorithm = lz4;
+SELECT avg(i3) FROM (SELECT t1.* FROM lz4_spill AS t1 RIGHT JOIN lz4_spill AS t2 ON t1.i1 = t2.i2) foo;
+SELECT lz4_spilled('SELECT t1.* FROM lz4_spill AS t1 RIGHT JOIN lz4_spill AS t2 ON t1.i1 = t2.i2');
+RESET gp_workfile_compress_algorithm;
+RESET gp_workfile_type_hashjoin;
+RESET statement_mem;
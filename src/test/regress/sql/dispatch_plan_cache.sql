@@ -0,0 +1,63 @@
+--
+-- Test plans dispatched again by reference, with gp_dispatch_plan_cache_size
+--
+create schema dispatch_plan_cache;
+set search_path to dispatch_plan_cache;
+
+create table dpc (a int, b int) distributed by (a);
+insert into dpc select i, i % 7 from generate_series(1, 1000) i;
+
+set gp_dispatch_plan_cache_size = 2;
+
+-- The same plan dispatched again, with the same and with other parameters.
+prepare dpc_count(int) as select b, count(*) from dpc where b < $1 group by b order by b;
+execute dpc_count(3);
+execute dpc_count(3);
+execute dpc_count(5);
+
+-- A multi-slice plan.
+prepare dpc_join(int) as
+  select count(*) from dpc t1 join dpc t2 on t1.b = t2.a where t1.b = $1;
+execute dpc_join(1);
+execute dpc_join(1);
+execute dpc_join(2);
+
+-- More plans than slots: the oldest ones are evicted, and sent in full
+-- again.
+prepare dpc_sum(int) as select sum(a) from dpc where b = $1;
+execute dpc_sum(1);
+execute dpc_count(2);
+execute dpc_join(3);
+execute dpc_sum(1);
+execute dpc_count(2);
+
+-- The same statement dispatched many times from a function.
+create function dpc_loop(n int) returns bigint as $$
+declare
+  total bigint := 0;
+begin
+  for i in 1..n loop
+    total := total + (select count(*) from dpc where b = i % 7);
+  end loop;
+  return total;
+end;
+$$ language plpgsql;
+select dpc_loop(14);
+select dpc_loop(14);
+
+-- After an error on a QE, the plan is sent in full again.
+prepare dpc_div(int) as select count(*) from dpc where a / $1 > 0;
+execute dpc_div(1);
+execute dpc_div(0);
+execute dpc_div(1);
+execute dpc_div(1);
+
+-- Turning the cache off in the middle of a session.
+set gp_dispatch_plan_cache_size = 0;
+execute dpc_count(3);
+set gp_dispatch_plan_cache_size = 2;
+execute dpc_count(3);
+execute dpc_count(3);
+
+reset gp_dispatch_plan_cache_size;
+drop schema dispatch_plan_cache cascade;
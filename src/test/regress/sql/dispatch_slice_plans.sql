@@ -0,0 +1,57 @@
+--
+-- Test sending each gang only the plan of its own slice
+-- (gp_dispatch_slice_plans), against sending the whole plan.
+--
+create schema dispatch_slice_plans;
+set search_path to dispatch_slice_plans;
+
+create table t1 (a int, b int) distributed by (a);
+create table t2 (c int, d int) distributed by (c);
+insert into t1 select i, i % 5 from generate_series(1, 20) i;
+insert into t2 select i, i % 3 from generate_series(1, 10) i;
+analyze t1;
+analyze t2;
+
+-- Each branch is a multi-slice plan with InitPlans or SubPlans, whose
+-- results are used in other slices than the one they are evaluated in.
+create view slice_queries as
+  -- InitPlan used in the scan of t1
+  select 1 as q, a from t1 where b = (select max(d) from t2)
+  -- correlated SubPlan over a broadcast of t2
+  union all select 2, a from t1 where a > (select count(*) from t2 where t2.d = t1.b)
+  -- InitPlan used below the Motion of a join
+  union all select 3, t1.a from t1 join t2 on t1.b = t2.c where t2.d >= (select avg(d) from t2)
+  -- semi join, and an InitPlan over the same table
+  union all select 4, a from t1 where exists (select 1 from t2 where t2.c = t1.a + 1)
+                                and b < (select max(b) from t1)
+  -- InitPlan in the HAVING of a two-stage aggregate
+  union all select 5, b from t1 group by b having sum(a) > (select sum(c) from t2) - 15
+  -- correlated SubPlan in the target list
+  union all select 6, (select max(c) from t2 where t2.d = t1.b) from t1
+  -- InitPlan in a subquery that is redistributed for a join
+  union all select 7, t1.a from t1,
+                      (select c, d from t2 where c < (select avg(c) from t2)) s
+                    where t1.a = s.d + s.c * 2;
+
+set gp_dispatch_slice_plans = off;
+create table results_off as select * from slice_queries distributed randomly;
+
+set gp_dispatch_slice_plans = on;
+create table results_on as select * from slice_queries distributed randomly;
+
+-- Both ways must give the same results.
+select count(*) from ((select * from results_on except all select * from results_off)
+                      union all
+                      (select * from results_off except all select * from results_on)) x;
+
+select q, count(*), sum(a) from results_on group by q order by q;
+
+-- The same, straight from the tables, with each gang sent its own slice.
+select q, count(*), sum(a) from slice_queries group by q order by q;
+
+reset gp_dispatch_slice_plans;
+drop table results_off, results_on;
+drop view slice_queries;
+drop table t1, t2;
+reset search_path;
+drop schema dispatch_slice_plans;
@@ -0,0 +1,84 @@
+--
+-- Test evaluating quals and projections as flattened steps
+-- (gp_enable_expr_steps), against evaluating them as trees.
+--
+create schema expr_steps;
+set search_path to expr_steps;
+
+create table t (id int, i2 int2, i4 int4, i8 int8, f4 float4, f8 float8, d date, s text, b bool) distributed by (id);
+insert into t values
+  (1, 1, 10, 100, 1.5, 2.5, '2020-01-01', 'a', true),
+  (2, 2, 20, 200, 'NaN', 'NaN', '2020-02-01', 'b', false),
+  (3, null, 30, null, 3.5, null, null, 'c', null),
+  (4, 4, null, 400, null, 'Infinity', '2020-04-01', null, true),
+  (5, -5, -50, -500, '-Infinity', -5.5, '1999-12-31', 'e', false),
+  (6, null, null, null, null, null, null, null, null);
+
+-- Each branch is a qual of its own: comparisons with steps of their own,
+-- AND/OR short-circuiting on NULLs, NULL tests, and node types that are
+-- evaluated the ordinary way (CASE, COALESCE, IN lists, sublinks).
+create view quals as
+  select 1 as q, id from t where i4 > 15 and i8 < 450
+  union all select 2, id from t where i2 = 2 or f8 > 3
+  union all select 3, id from t where not (f4 < 2)
+  union all select 4, id from t where f8 = 'NaN'::float8
+  union all select 5, id from t where d >= '2020-01-15' or s is null
+  union all select 6, id from t where i2 is null and s is not null
+  union all select 7, id from t where (i4 <> 20) is not true
+  union all select 8, id from t where i8 between -500 and 100 and f4 >= -1e30
+  union all select 9, id from t where i2 < i4
+  union all select 10, id from t where coalesce(i4, 0) in (0, 30)
+  union all select 11, id from t where case when b then i4 else i8 end > 50
+  union all select 12, id from t where upper(s) = 'C' or length(s) > 5
+  union all select 13, id from t where i4 > (select avg(i4) from t)
+  union all select 14, id from t where d < '2020-02-01'::date and f8 < 'Infinity'
+  union all select 15, id from t where f4 = f4
+  union all select 16, id from t where i8 <> 200 and i2 <= 2;
+
+create view projections as
+  select id,
+         i2 + 1 as c1,
+         i4 * 2 as c2,
+         i8 - i4 as c3,
+         f4 < f8 as c4,
+         d < '2020-03-01' as c5,
+         s || 'x' as c6,
+         coalesce(i4, -1) as c7,
+         case when i4 > 15 then 'big' when i4 is null then 'null' else 'small' end as c8,
+         i4 in (10, 30) as c9,
+         b and i4 > 0 as c10,
+         not b as c11,
+         nullif(i2, 2) as c12,
+         s::varchar(5) as c13,
+         f8 = f8 as c14
+  from t;
+
+set gp_enable_expr_steps = off;
+create table quals_off as select * from quals distributed randomly;
+create table projections_off as select * from projections distributed randomly;
+
+set gp_enable_expr_steps = on;
+create table quals_on as select * from quals distributed randomly;
+create table projections_on as select * from projections distributed randomly;
+
+-- Both ways must give the same results.
+select count(*) from ((select * from quals_on except all select * from quals_off)
+                      union all
+                      (select * from quals_off except all select * from quals_on)) x;
+select count(*) from ((select * from projections_on except all select * from projections_off)
+                      union all
+                      (select * from projections_off except all select * from projections_on)) x;
+
+select q, array_agg(id order by id) from quals_on group by q order by q;
+select * from projections_on order by id;
+
+-- The same, straight from the table, with the steps on.
+select q, array_agg(id order by id) from quals group by q order by q;
+select * from projections order by id;
+
+reset gp_enable_expr_steps;
+drop table quals_off, projections_off, quals_on, projections_on;
+drop view quals, projections;
+drop table t;
+reset search_path;
+drop schema expr_steps;
@@ -49,6 +49,54 @@ WHERE et like '%Memory: %';
 
 reset explain_memory_verbosity;
 
+--
+-- Test the "Dispatch:" line of EXPLAIN ANALYZE. It is only shown with VERBOSE.
+--
+create or replace function get_explain_analyze_nonverbose_output(explain_query text) returns setof text as
+$$
+declare
+  explainrow text;
+begin
+  for explainrow in execute 'EXPLAIN ANALYZE ' || explain_query
+  loop
+    return next explainrow;
+  end loop;
+end;
+$$ language plpgsql;
+
+SELECT COUNT(*) from
+  get_explain_analyze_output($$
+    SELECT * FROM explaintest;
+  $$) as et
+WHERE et like 'Dispatch: gangs % ms, serialize % ms, compress % ms, send % ms, interconnect setup % ms';
+
+SELECT COUNT(*) from
+  get_explain_analyze_nonverbose_output($$
+    SELECT * FROM explaintest;
+  $$) as et
+WHERE et like 'Dispatch: %';
+
+-- The plan is dispatched the same way with each compression setting.
+set gp_dispatch_compress_algorithm = none;
+SELECT count(*), sum(id) FROM explaintest;
+SELECT COUNT(*) from
+  get_explain_analyze_output($$
+    SELECT * FROM explaintest;
+  $$) as et
+WHERE et like 'Dispatch: %';
+
+set gp_dispatch_compress_algorithm = zlib;
+set gp_dispatch_compress_threshold = '1MB';
+SELECT count(*), sum(id) FROM explaintest;
+SELECT COUNT(*) from
+  get_explain_analyze_output($$
+    SELECT * FROM explaintest;
+  $$) as et
+WHERE et like 'Dispatch: %';
+
+reset gp_dispatch_compress_threshold;
+reset gp_dispatch_compress_algorithm;
+
 
 -- Verify that the column references are OK. This tests for an old ORCA bug,
 -- where the Filter clause in the IndexScan of this query was incorrectly
@@ -1694,4 +1694,50 @@ explain with CTE as (select i, row_number() over (partition by j) j from window_
 insert into window_preds with CTE as (select i, row_number() over (partition by j) j from window_preds union all select i, row_number() over (partition by j) from window_preds) select * from cte where i = 1;
 
 
+-- Aggregates without an inverse transition function, but with a combine
+-- function, are evaluated over sliding ROWS frames with a segment tree
+create table segtree_t (p int, o int, v int, s text) distributed by (p);
+insert into segtree_t select i % 3, i, (i * 37) % 101, chr(97 + i % 26) from generate_series(1, 300) i;
+create aggregate segtree_cat(text) (sfunc = textcat, combinefunc = textcat, stype = text, initcond = '');
+select o, v, min(v) over w, max(v) over w, segtree_cat(s) over w,
+       min(v) over (order by o rows between 2 preceding and 1 preceding)
+from segtree_t where p = 1 and o <= 25
+window w as (order by o rows between 2 preceding and 1 following)
+order by o;
+set gp_enable_window_segment_tree = off;
+create table segtree_expected as
+select p, o, min(v) over w as mn, max(v) over w as mx, sum(v) over w as sm, segtree_cat(s) over w as cat
+from segtree_t window w as (partition by p order by o rows between 7 preceding and 3 following)
+distributed by (p);
+reset gp_enable_window_segment_tree;
+select count(*) from
+  ((select p, o, min(v) over w, max(v) over w, sum(v) over w, segtree_cat(s) over w
+    from segtree_t window w as (partition by p order by o rows between 7 preceding and 3 following))
+   except all select * from segtree_expected) d;
+select count(*) from
+  (select * from segtree_expected except all
+   (select p, o, min(v) over w, max(v) over w, sum(v) over w, segtree_cat(s) over w
+    from segtree_t window w as (partition by p order by o rows between 7 preceding and 3 following))) d;
+-- Trees that don't fit in the operator's memory are given up, and the
+-- aggregates evaluated the usual way
+create table segtree_big (p int, o int, s text) distributed by (p);
+insert into segtree_big select i % 2, i, chr(97 + i % 26) from generate_series(1, 40000) i;
+set statement_mem = '1MB';
+set gp_enable_window_segment_tree = off;
+create table segtree_big_expected as
+select p, o, segtree_cat(s) over w as cat, max(o) over w as mx
+from segtree_big window w as (partition by p order by o rows between 3 preceding and 2 following)
+distributed by (p);
+reset gp_enable_window_segment_tree;
+select count(*) from
+  ((select p, o, segtree_cat(s) over w, max(o) over w from segtree_big window w as (partition by p order by o rows between 3 preceding and 2 following))
+   except all select * from segtree_big_expected) d;
+select count(*) from
+  (select * from segtree_big_expected except all
+   (select p, o, segtree_cat(s) over w, max(o) over w from segtree_big window w as (partition by p order by o rows between 3 preceding and 2 following))) d;
+reset statement_mem;
+drop table segtree_big, segtree_big_expected;
+drop table segtree_t, segtree_expected;
+drop aggregate segtree_cat(text);
+
 -- End of Test
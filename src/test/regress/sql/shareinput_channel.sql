@@ -0,0 +1,78 @@
+--
+-- Test streaming cross-slice shared scans through shared-memory channels
+-- (gp_shareinput_channels): in the channel alone, spilling past it to the
+-- workfile, and falling back to the FIFO handshake when no channel is free.
+--
+-- start_ignore
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+-- end_ignore
+create schema shareinput_channel;
+set search_path to shareinput_channel;
+
+create table small (a int, b int, c text) distributed by (a);
+insert into small select i, i, repeat('x', 40) from generate_series(1, 30) i;
+create table big (a int, b int, c text) distributed by (a);
+insert into big select i, i, repeat('x', 40) from generate_series(1, 50000) i;
+analyze small;
+analyze big;
+
+-- The planner shares the CTE between the join's two sides, one of which is
+-- redistributed, so one of them reads it from another slice.
+set optimizer = off;
+set gp_cte_sharing = on;
+
+-- Everything fits in the channel.
+select gp_inject_fault('shareinput_channel_attach', 'skip', 2);
+select gp_inject_fault('shareinput_channel_spill', 'skip', 2);
+with cte as (select * from small)
+select count(*), sum(c1.a), sum(length(c2.c)) from cte c1 join cte c2 on c1.b = c2.a;
+select gp_inject_fault('shareinput_channel_attach', 'status', 2);
+select gp_inject_fault('shareinput_channel_spill', 'status', 2);
+select gp_inject_fault('shareinput_channel_attach', 'reset', 2);
+select gp_inject_fault('shareinput_channel_spill', 'reset', 2);
+
+-- The channel fills up, and the rest goes to the workfile.
+select gp_inject_fault('shareinput_channel_attach', 'skip', 2);
+select gp_inject_fault('shareinput_channel_spill', 'skip', 2);
+with cte as (select * from big)
+select count(*), sum(c1.a), sum(length(c2.c)) from cte c1 join cte c2 on c1.b = c2.a;
+select gp_inject_fault('shareinput_channel_attach', 'status', 2);
+select gp_inject_fault('shareinput_channel_spill', 'status', 2);
+select gp_inject_fault('shareinput_channel_attach', 'reset', 2);
+select gp_inject_fault('shareinput_channel_spill', 'reset', 2);
+
+-- No channel is free, so the writer writes the whole workfile first, and
+-- the readers wait for it through the FIFO.
+select gp_inject_fault_infinite('shareinput_channel_open', 'skip', 2);
+select gp_inject_fault('shareinput_channel_attach', 'skip', 2);
+with cte as (select * from small)
+select count(*), sum(c1.a), sum(length(c2.c)) from cte c1 join cte c2 on c1.b = c2.a;
+with cte as (select * from big)
+select count(*), sum(c1.a), sum(length(c2.c)) from cte c1 join cte c2 on c1.b = c2.a;
+select gp_inject_fault('shareinput_channel_attach', 'status', 2);
+select gp_inject_fault('shareinput_channel_attach', 'reset', 2);
+select gp_inject_fault('shareinput_channel_open', 'reset', 2);
+
+-- Channels are let go of at the end of each query: many more queries than
+-- there are channels still find one free.
+do $$
+declare
+  n bigint;
+begin
+  for i in 1..40 loop
+    with cte as (select * from small)
+    select count(*) into n from cte c1 join cte c2 on c1.b = c2.a;
+  end loop;
+end;
+$$;
+select gp_inject_fault('shareinput_channel_attach', 'skip', 2);
+with cte as (select * from small)
+select count(*), sum(c1.a), sum(length(c2.c)) from cte c1 join cte c2 on c1.b = c2.a;
+select gp_inject_fault('shareinput_channel_attach', 'status', 2);
+select gp_inject_fault('shareinput_channel_attach', 'reset', 2);
+
+reset gp_cte_sharing;
+reset optimizer;
+drop table small, big;
+reset search_path;
+drop schema shareinput_channel;
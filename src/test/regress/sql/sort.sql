@@ -110,3 +110,12 @@ select col1, col2, col3, col4, col5 from gpsort_alltypes order by col1, col2, co
 select col1, col2, col3, col4, col5 from gpsort_alltypes order by col3 desc, col2 asc, col1, col4, col5;
 select col1, col2, col3, col4, col5 from gpsort_alltypes order by col5 desc, col3 asc, col2 desc, col4 asc, col1 desc;
 
+-- Radix sort on normalized keys
+set gp_enable_mk_radix_sort = on;
+create table sort_radix(a int, b bigint, c text, d date) distributed by (a);
+insert into sort_radix select i % 97 - 40, (i * 7919) % 1000, 'k' || (i % 300), case when i % 50 = 0 then null else date '2000-01-01' + i % 500 end from generate_series(1, 3000) i;
+select a, b from sort_radix order by a, b offset 1500 limit 5;
+select c from sort_radix order by c collate "C" desc offset 500 limit 3;
+select to_char(d, 'YYYY-MM-DD'), a from sort_radix order by d desc nulls last, a offset 10 limit 3;
+select to_char(d, 'YYYY-MM-DD'), a from sort_radix order by d nulls first, a limit 3;
+reset gp_enable_mk_radix_sort;
@@ -0,0 +1,99 @@
+--
+-- Scans of append-only tables with hidden rows, through the shared cache of
+-- decoded visimap bitmaps and the check of whole blocks against them.  The
+-- cache is on by default (gp_appendonly_visimap_cache_entries).
+--
+create schema uao_visimap_cache;
+set search_path to uao_visimap_cache;
+
+-- Small blocks, so that a table has many of them.
+create table ao_vm_row (a int, b int, c text)
+  with (appendonly=true, blocksize=8192) distributed by (a);
+insert into ao_vm_row select i, i, repeat('x', 20) from generate_series(1, 20000) i;
+create table ao_vm_col (a int, b int, c text)
+  with (appendonly=true, orientation=column, blocksize=8192) distributed by (a);
+insert into ao_vm_col select i, i, repeat('x', 20) from generate_series(1, 20000) i;
+
+--
+-- Row oriented
+--
+-- No rows hidden yet: every block passes the block check.
+select count(*), sum(b) from ao_vm_row;
+
+-- Hide a range of rows.  Blocks within it, around it and past it take
+-- different paths through the block check.  The second scan finds the
+-- decoded bitmaps in the cache.
+delete from ao_vm_row where b between 1001 and 2000;
+select count(*), sum(b) from ao_vm_row;
+select count(*), sum(b) from ao_vm_row;
+select count(*) from ao_vm_row where b between 900 and 2100;
+
+-- A cursor opened before a DELETE keeps seeing the visimap entries of its
+-- snapshot, while the deleting transaction sees its own.
+begin;
+declare c cursor for select count(*), sum(b) from ao_vm_row;
+delete from ao_vm_row where b between 2001 and 3000;
+fetch all from c;
+select count(*), sum(b) from ao_vm_row;
+close c;
+commit;
+select count(*), sum(b) from ao_vm_row;
+
+-- The entries of an aborted DELETE must not be used afterwards.
+begin;
+delete from ao_vm_row where b <= 10000;
+select count(*), sum(b) from ao_vm_row;
+rollback;
+select count(*), sum(b) from ao_vm_row;
+
+-- An UPDATE hides the old versions of the rows it moves.
+update ao_vm_row set b = b + 100000 where b % 1000 = 0;
+select count(*), sum(b) from ao_vm_row;
+select count(*) from ao_vm_row where b > 100000;
+
+-- Compaction moves the visible rows to new segment files.
+vacuum ao_vm_row;
+select count(*), sum(b) from ao_vm_row;
+
+--
+-- Column oriented
+--
+-- No rows hidden yet: every block passes the block check.
+select count(*), sum(b) from ao_vm_col;
+
+-- Hide a range of rows.  Blocks within it, around it and past it take
+-- different paths through the block check.  The second scan finds the
+-- decoded bitmaps in the cache.
+delete from ao_vm_col where b between 1001 and 2000;
+select count(*), sum(b) from ao_vm_col;
+select count(*), sum(b) from ao_vm_col;
+select count(*) from ao_vm_col where b between 900 and 2100;
+
+-- A cursor opened before a DELETE keeps seeing the visimap entries of its
+-- snapshot, while the deleting transaction sees its own.
+begin;
+declare c cursor for select count(*), sum(b) from ao_vm_col;
+delete from ao_vm_col where b between 2001 and 3000;
+fetch all from c;
+select count(*), sum(b) from ao_vm_col;
+close c;
+commit;
+select count(*), sum(b) from ao_vm_col;
+
+-- The entries of an aborted DELETE must not be used afterwards.
+begin;
+delete from ao_vm_col where b <= 10000;
+select count(*), sum(b) from ao_vm_col;
+rollback;
+select count(*), sum(b) from ao_vm_col;
+
+-- An UPDATE hides the old versions of the rows it moves.
+update ao_vm_col set b = b + 100000 where b % 1000 = 0;
+select count(*), sum(b) from ao_vm_col;
+select count(*) from ao_vm_col where b > 100000;
+
+-- Compaction moves the visible rows to new segment files.
+vacuum ao_vm_col;
+select count(*), sum(b) from ao_vm_col;
+
+drop schema uao_visimap_cache cascade;
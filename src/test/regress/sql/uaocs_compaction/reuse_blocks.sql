@@ -0,0 +1,29 @@
+-- @Description Tests compaction that copies the blocks without deleted rows
+CREATE TABLE uaocs_reuse (a INT, b INT, c TEXT) WITH (appendonly=true, orientation=column, compresstype=zlib, compresslevel=1, blocksize=8192) DISTRIBUTED BY (a);
+CREATE INDEX uaocs_reuse_index ON uaocs_reuse(b);
+INSERT INTO uaocs_reuse SELECT i, i, 'row ' || i FROM generate_series(1, 100000) AS i;
+
+DELETE FROM uaocs_reuse WHERE a BETWEEN 1000 AND 1100;
+DELETE FROM uaocs_reuse WHERE a BETWEEN 50000 AND 50010;
+SET gp_appendonly_compaction_reuse_blocks = on;
+VACUUM uaocs_reuse;
+RESET gp_appendonly_compaction_reuse_blocks;
+
+SELECT COUNT(*), SUM(a), SUM(b), COUNT(DISTINCT c) FROM uaocs_reuse;
+SELECT COUNT(*) FROM uaocs_reuse WHERE c <> 'row ' || a;
+SELECT relname, reltuples FROM pg_class WHERE relname = 'uaocs_reuse';
+
+SET enable_seqscan = off;
+SELECT * FROM uaocs_reuse WHERE b = 50005;
+SELECT * FROM uaocs_reuse WHERE b = 70000;
+SELECT COUNT(*) FROM uaocs_reuse WHERE b BETWEEN 900 AND 1200;
+RESET enable_seqscan;
+
+-- Compacting again moves the rows that were copied before
+DELETE FROM uaocs_reuse WHERE a > 99990;
+SET gp_appendonly_compaction_reuse_blocks = on;
+VACUUM uaocs_reuse;
+RESET gp_appendonly_compaction_reuse_blocks;
+SELECT COUNT(*), SUM(a) FROM uaocs_reuse;
+INSERT INTO uaocs_reuse VALUES (42, 42, 'row 42');
+SELECT * FROM uaocs_reuse WHERE b = 42;
@@ -93,4 +93,45 @@ select count(*) from (select i, count(*) from aggspill group by i,j,t having cou
 
 select count(*) from (select i, count(*) from aggspill group by i,j,t having count(*) = 3) g;
 
+-- Same with the open-addressing hash table
+set gp_hashagg_open_addressing = on;
+set statement_mem = '125MB';
+select count(*) from (select i, count(*) from aggspill group by i,j having count(*) = 1) g;
+set statement_mem = '10MB';
+select overflows >= 1 from hashagg_spill.num_hashagg_overflows('explain analyze
+select count(*) from (select i, count(*) from aggspill group by i,j having count(*) = 2) g') overflows;
+select count(*) from (select i, count(*) from aggspill group by i,j having count(*) = 2) g;
+set statement_mem = '5MB';
+select overflows > 1 from hashagg_spill.num_hashagg_overflows('explain analyze
+select count(*) from (select i, count(*) from aggspill group by i,j,t having count(*) = 3) g') overflows;
+select count(*) from (select i, count(*) from aggspill group by i,j,t having count(*) = 3) g;
+reset gp_hashagg_open_addressing;
+
+-- A streaming first stage that hardly reduces its input stops aggregating
+create or replace function hashagg_spill.num_hashagg_bypassed(explain_query text)
+returns int as
+$$
+rv = plpy.execute(explain_query)
+result = 0
+for i in range(len(rv)):
+    if 'Aggregation bypassed' in rv[i]['QUERY PLAN']:
+        result += 1
+return result
+$$
+language plpythonu;
+
+set gp_eager_two_phase_agg = on;
+set gp_hashagg_bypass_min_reduction = 0.5;
+set statement_mem = '10MB';
+select hashagg_spill.num_hashagg_bypassed('explain analyze
+select count(*), sum(c) from (select j, count(*) c from aggspill group by j) g') > 0;
+select count(*), sum(c) from (select j, count(*) c from aggspill group by j) g;
+set gp_hashagg_bypass_min_reduction = 0;
+select hashagg_spill.num_hashagg_bypassed('explain analyze
+select count(*), sum(c) from (select j, count(*) c from aggspill group by j) g');
+select count(*), sum(c) from (select j, count(*) c from aggspill group by j) g;
+reset gp_hashagg_bypass_min_reduction;
+reset gp_eager_two_phase_agg;
+reset statement_mem;
+
 drop schema hashagg_spill cascade;
@@ -0,0 +1,51 @@
+-- Test the memory broker, which lets operators that are about to spill
+-- borrow memory that other operators of the query gave back.  The results
+-- must be the same with it on and off, also when operators are rescanned.
+create schema memory_broker;
+set search_path to memory_broker;
+
+create table mb_outer (a int, b int) distributed by (a);
+create table mb_inner (a int, b int) distributed by (a);
+insert into mb_outer select i, i % 10 from generate_series(1, 20000) i;
+insert into mb_inner select i, i % 5 from generate_series(1, 100) i;
+analyze mb_outer;
+analyze mb_inner;
+
+set statement_mem = '2MB';
+
+set gp_enable_memory_broker = off;
+select b, count(*), count(distinct a) from mb_outer group by b order by b;
+-- a Sort under a correlated subquery, rescanned for each outer row
+select i.b, (select count(*) from (select o.a from mb_outer o where o.b = i.b order by o.a) s) as n
+from mb_inner i where i.a <= 5 order by 1;
+-- a HashAgg under a correlated subquery, rescanned for each outer row
+select i.a, (select count(*) from (select o.b from mb_outer o where o.a <= i.a group by o.b) s) as n
+from mb_inner i where i.a <= 3 order by 1;
+-- a Material on the inner side of a nested loop
+set enable_hashjoin = off;
+set enable_mergejoin = off;
+select count(*) from mb_inner i join mb_outer o on i.b = o.b;
+reset enable_hashjoin;
+reset enable_mergejoin;
+
+set gp_enable_memory_broker = on;
+select b, count(*), count(distinct a) from mb_outer group by b order by b;
+-- a Sort under a correlated subquery, rescanned for each outer row
+select i.b, (select count(*) from (select o.a from mb_outer o where o.b = i.b order by o.a) s) as n
+from mb_inner i where i.a <= 5 order by 1;
+-- a HashAgg under a correlated subquery, rescanned for each outer row
+select i.a, (select count(*) from (select o.b from mb_outer o where o.a <= i.a group by o.b) s) as n
+from mb_inner i where i.a <= 3 order by 1;
+-- a Material on the inner side of a nested loop
+set enable_hashjoin = off;
+set enable_mergejoin = off;
+select count(*) from mb_inner i join mb_outer o on i.b = o.b;
+reset enable_hashjoin;
+reset enable_mergejoin;
+
+reset gp_enable_memory_broker;
+reset statement_mem;
+drop table mb_outer;
+drop table mb_inner;
+reset search_path;
+drop schema memory_broker;
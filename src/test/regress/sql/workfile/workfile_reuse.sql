@@ -0,0 +1,98 @@
+--
+-- Test reusing the spilled output of a subplan in later queries
+-- (gp_workfile_reuse): hits, misses, and invalidation by writes.
+--
+-- The fault injectors on the first segment only count, as markers of
+-- the output being kept and read back there.
+--
+-- start_ignore
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+\! gpconfig -c gp_workfile_reuse -v on --skipvalidation
+\! gpstop -u
+select pg_sleep(2);
+-- end_ignore
+show gp_workfile_reuse;
+
+create schema workfile_reuse;
+set search_path to workfile_reuse;
+
+create table t (a int, b int, c text) distributed by (a);
+insert into t select i % 1000, i, md5(i::text) from generate_series(1, 100000) i;
+analyze t;
+
+-- Make the sorts spill.
+set optimizer = off;
+set statement_mem = '1MB';
+
+-- The first run keeps the sorted output.
+select gp_inject_fault('workfile_reuse_replay', 'skip', 2);
+select gp_inject_fault('workfile_reuse_publish', 'skip', 2);
+select count(*), max(rn), sum(rn)
+from (select row_number() over (partition by a order by c) rn from t) s;
+select gp_inject_fault('workfile_reuse_replay', 'status', 2);
+select gp_inject_fault('workfile_reuse_publish', 'status', 2);
+select gp_inject_fault('workfile_reuse_replay', 'reset', 2);
+select gp_inject_fault('workfile_reuse_publish', 'reset', 2);
+
+-- The second run reads it back, though the query is laid out differently.
+select gp_inject_fault('workfile_reuse_replay', 'skip', 2);
+select count(*), max(rn), sum(rn)
+from (select row_number() over (partition by a order by c) rn
+      from t) s;
+select gp_inject_fault('workfile_reuse_replay', 'status', 2);
+select gp_inject_fault('workfile_reuse_replay', 'reset', 2);
+
+-- Another subplan misses, and is kept in turn.
+select gp_inject_fault('workfile_reuse_replay', 'skip', 2);
+select gp_inject_fault('workfile_reuse_publish', 'skip', 2);
+select count(*), max(rn), sum(rn)
+from (select row_number() over (partition by a order by c desc) rn from t) s;
+select gp_inject_fault('workfile_reuse_replay', 'status', 2);
+select gp_inject_fault('workfile_reuse_publish', 'status', 2);
+select gp_inject_fault('workfile_reuse_replay', 'reset', 2);
+select gp_inject_fault('workfile_reuse_publish', 'reset', 2);
+
+-- A volatile sort key is never kept.
+select gp_inject_fault('workfile_reuse_publish', 'skip', 2);
+select count(*), max(rn), sum(rn)
+from (select row_number() over (partition by a order by c, random()) rn from t) s;
+select gp_inject_fault('workfile_reuse_publish', 'status', 2);
+select gp_inject_fault('workfile_reuse_publish', 'reset', 2);
+
+-- A sort that doesn't spill is cheap to redo, and isn't kept.
+set statement_mem = '125MB';
+select gp_inject_fault('workfile_reuse_publish', 'skip', 2);
+select count(*), max(rn), sum(rn)
+from (select row_number() over (partition by a order by c, b) rn from t) s;
+select gp_inject_fault('workfile_reuse_publish', 'status', 2);
+select gp_inject_fault('workfile_reuse_publish', 'reset', 2);
+set statement_mem = '1MB';
+
+-- Writing to the table makes what was kept stale.
+delete from t where b > 99900;
+select gp_inject_fault('workfile_reuse_replay', 'skip', 2);
+select gp_inject_fault('workfile_reuse_publish', 'skip', 2);
+select count(*), max(rn), sum(rn)
+from (select row_number() over (partition by a order by c) rn from t) s;
+select gp_inject_fault('workfile_reuse_replay', 'status', 2);
+select gp_inject_fault('workfile_reuse_publish', 'status', 2);
+select gp_inject_fault('workfile_reuse_replay', 'reset', 2);
+select gp_inject_fault('workfile_reuse_publish', 'reset', 2);
+
+-- And the new output is read back.
+select gp_inject_fault('workfile_reuse_replay', 'skip', 2);
+select count(*), max(rn), sum(rn)
+from (select row_number() over (partition by a order by c) rn from t) s;
+select gp_inject_fault('workfile_reuse_replay', 'status', 2);
+select gp_inject_fault('workfile_reuse_replay', 'reset', 2);
+
+reset statement_mem;
+reset optimizer;
+drop table t;
+reset search_path;
+drop schema workfile_reuse;
+
+-- start_ignore
+\! gpconfig -r gp_workfile_reuse --skipvalidation
+\! gpstop -u
+-- end_ignore